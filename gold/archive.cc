@@ -26,6 +26,14 @@
 #include <cstring>
 #include <climits>
 #include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include "libiberty.h"
 #include "filenames.h"
 
@@ -41,6 +49,44 @@
 #include "plugin.h"
 #include "incremental.h"
 
+// For systems without mmap support.
+#ifndef HAVE_MMAP
+# define mmap gold_mmap
+# define munmap gold_munmap
+# ifndef MAP_FAILED
+#  define MAP_FAILED (reinterpret_cast<void*>(-1))
+# endif
+# ifndef PROT_READ
+#  define PROT_READ 0
+# endif
+# ifndef MAP_PRIVATE
+#  define MAP_PRIVATE 0
+# endif
+
+# ifndef ENOSYS
+#  define ENOSYS EINVAL
+# endif
+
+static void *
+gold_mmap(void *, size_t, int, int, int, off_t)
+{
+  errno = ENOSYS;
+  return MAP_FAILED;
+}
+
+static int
+gold_munmap(void *, size_t)
+{
+  errno = ENOSYS;
+  return -1;
+}
+
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
 namespace gold
 {
 
@@ -164,6 +210,7 @@ struct Archive::Archive_header
 unsigned int Archive::total_archives;
 unsigned int Archive::total_members;
 unsigned int Archive::total_members_loaded;
+unsigned int Archive::total_members_read_in_parallel;
 
 // Archive methods.
 
@@ -181,9 +228,14 @@ const char Archive::arfmag[2] = { '`', '\n' };
 
 Archive::Archive(const std::string& name, Input_file* input_file,
                  bool is_thin_archive, Dirsearch* dirpath, Task* task)
-  : Library_base(task), name_(name), input_file_(input_file), armap_(),
-    armap_names_(), extended_names_(), armap_checked_(), seen_offsets_(),
-    members_(), is_thin_archive_(is_thin_archive), included_member_(false),
+  : Library_base(task), name_(name), input_file_(input_file), armap_(NULL),
+    armap_count_(0), armap_names_(NULL), armap_storage_(),
+    armap_names_storage_(), extended_names_(), armap_checked_(),
+    seen_offsets_(), armap_buckets_(NULL), armap_nbuckets_(0),
+    armap_chain_(NULL), armap_index_storage_(), armap_cache_(NULL),
+    armap_cache_size_(0), armap_cache_is_mapped_(false),
+    armap_cache_path_(), armap_cache_dev_(0), armap_cache_ino_(0), members_(),
+    read_members_(), is_thin_archive_(is_thin_archive), included_member_(false),
     nested_archives_(), dirpath_(dirpath), num_members_(0),
     included_all_members_(false)
 {
@@ -191,6 +243,17 @@ Archive::Archive(const std::string& name, Input_file* input_file,
     parameters->options().check_excluded_libs(input_file->found_name());
 }
 
+Archive::~Archive()
+{
+  if (this->armap_cache_ != NULL)
+    {
+      if (this->armap_cache_is_mapped_)
+	::munmap(this->armap_cache_, this->armap_cache_size_);
+      else
+	free(this->armap_cache_);
+    }
+}
+
 // Set up the archive: read the symbol map and the extended name
 // table.
 
@@ -266,6 +329,14 @@ Archive::unlock_nested_archives()
 void
 Archive::read_armap(off_t start, section_size_type size)
 {
+  const bool use_cache = parameters->options().archive_index_cache() != NULL;
+  if (use_cache)
+    {
+      this->set_armap_cache_key();
+      if (this->read_armap_cache(start, size))
+	return;
+    }
+
   // To count the total number of archive members, we'll just count
   // the number of times the file offset changes.  Since most archives
   // group the symbols in the armap by object, this ought to give us
@@ -284,20 +355,21 @@ Archive::read_armap(off_t start, section_size_type size)
   const char* pnames = reinterpret_cast<const char*>(pword + nsyms);
   section_size_type names_size =
     reinterpret_cast<const char*>(p) + size - pnames;
-  this->armap_names_.assign(pnames, names_size);
+  this->armap_names_storage_.assign(pnames, names_size);
 
-  this->armap_.resize(nsyms);
+  this->armap_storage_.resize(nsyms);
 
   section_offset_type name_offset = 0;
   for (unsigned int i = 0; i < nsyms; ++i)
     {
-      this->armap_[i].name_offset = name_offset;
-      this->armap_[i].file_offset = elfcpp::Swap<32, true>::readval(pword);
+      Armap_entry& entry(this->armap_storage_[i]);
+      entry.name_offset = name_offset;
+      entry.file_offset = elfcpp::Swap<32, true>::readval(pword);
       name_offset += strlen(pnames + name_offset) + 1;
       ++pword;
-      if (this->armap_[i].file_offset != last_seen_offset)
+      if (entry.file_offset != last_seen_offset)
         {
-          last_seen_offset = this->armap_[i].file_offset;
+          last_seen_offset = entry.file_offset;
           ++this->num_members_;
         }
     }
@@ -306,9 +378,311 @@ Archive::read_armap(off_t start, section_size_type size)
     gold_error(_("%s: bad archive symbol table names"),
 	       this->name().c_str());
 
+  this->armap_ = nsyms == 0 ? NULL : &this->armap_storage_[0];
+  this->armap_count_ = nsyms;
+  this->armap_names_ = this->armap_names_storage_.data();
+
   // This array keeps track of which symbols are for archive elements
   // which we have already included in the link.
   this->armap_checked_.resize(nsyms);
+
+  if (use_cache && nsyms > 0)
+    {
+      this->build_armap_index();
+      this->write_armap_cache(start, size);
+    }
+}
+
+// The archive symbol table index cache.  The cache directory holds a
+// file for each archive, named for a hash of the archive's resolved
+// file name and for its device and inode number.  The file starts
+// with this header, which identifies the archive.  The header is
+// followed by the Armap_entry array, the hash buckets, the hash
+// chain, the symbol names, and the file name of the archive.
+// Everything is in host byte order; a cache is only useful on the
+// host which wrote it.  Reading an archive through the cache only
+// touches the parts of the index and the names which we look up,
+// rather than the whole archive symbol table.
+
+struct Armap_cache_header
+{
+  // "GOLDAIX" followed by a version number.
+  char magic[8];
+  // The size of a hash code, since the hash depends on it.
+  uint32_t hash_size;
+  // The number of entries in the archive symbol table.
+  uint32_t count;
+  // The number of hash buckets.
+  uint32_t nbuckets;
+  // The number of archive members.
+  uint32_t num_members;
+  // The size of the symbol names.
+  uint32_t names_size;
+  // The length of the archive file name, which is absolute with all
+  // symbolic links resolved.
+  uint32_t filename_size;
+  // The device and inode number of the archive.
+  uint64_t file_dev;
+  uint64_t file_ino;
+  // The size and modification time of the archive.
+  uint64_t file_size;
+  int64_t mtime_seconds;
+  int64_t mtime_nanoseconds;
+  // The status change time of the archive.  Unlike the modification
+  // time, this can't be set back, so it catches an archive which is
+  // rewritten with the same size and then given its old modification
+  // time.
+  int64_t ctime_seconds;
+  int64_t ctime_nanoseconds;
+  // The offset and size of the archive symbol table.
+  uint64_t armap_start;
+  uint64_t armap_size;
+};
+
+static const char armap_cache_magic[8] =
+{
+  'G', 'O', 'L', 'D', 'A', 'I', 'X', '3'
+};
+
+// Find the resolved file name, device and inode number of the
+// archive.  The name on the command line is often relative, and the
+// same relative name in different build trees must not share a cache
+// file.  found_name() is only the name given to -l, so we resolve the
+// name of the file we actually opened.
+
+void
+Archive::set_armap_cache_key()
+{
+  char* path = lrealpath(this->input_file_->filename().c_str());
+  this->armap_cache_path_ = path;
+  free(path);
+  this->file().get_file_id(&this->armap_cache_dev_, &this->armap_cache_ino_);
+}
+
+// Return the name of the file in the cache directory for this
+// archive.
+
+std::string
+Archive::armap_cache_filename() const
+{
+  const std::string& path(this->armap_cache_path_);
+  size_t h = gold::string_hash<char>(path.data(), path.length());
+  char buf[100];
+  snprintf(buf, sizeof buf, "/%016llx-%llx-%llx.gold-armap",
+	   static_cast<unsigned long long>(h),
+	   static_cast<unsigned long long>(this->armap_cache_dev_),
+	   static_cast<unsigned long long>(this->armap_cache_ino_));
+  return std::string(parameters->options().archive_index_cache()) + buf;
+}
+
+// Add N elements of ELSIZE bytes to *TOTAL.  Return false if the sum
+// does not fit in a size_t.
+
+static bool
+add_armap_cache_part(size_t* total, size_t n, size_t elsize)
+{
+  const size_t max_size = static_cast<size_t>(-1);
+  if (elsize != 0 && n > (max_size - *total) / elsize)
+    return false;
+  *total += n * elsize;
+  return true;
+}
+
+// Try to read the archive symbol map, with its hash table, from the
+// cache directory.  Return true on success.
+
+bool
+Archive::read_armap_cache(off_t start, section_size_type size)
+{
+  std::string cachename(this->armap_cache_filename());
+  int o = ::open(cachename.c_str(), O_RDONLY | O_BINARY);
+  if (o < 0)
+    return false;
+
+  struct stat st;
+  if (::fstat(o, &st) < 0
+      || static_cast<size_t>(st.st_size) < sizeof(Armap_cache_header))
+    {
+      ::close(o);
+      return false;
+    }
+
+  size_t cache_size = st.st_size;
+  bool is_mapped = true;
+  void* p = ::mmap(NULL, cache_size, PROT_READ, MAP_PRIVATE, o, 0);
+  if (p == MAP_FAILED)
+    {
+      is_mapped = false;
+      p = malloc(cache_size);
+      if (p == NULL || ::read(o, p, cache_size) != st.st_size)
+	{
+	  free(p);
+	  ::close(o);
+	  return false;
+	}
+    }
+  ::close(o);
+
+  const Armap_cache_header* hdr = static_cast<const Armap_cache_header*>(p);
+  const std::string& filename(this->armap_cache_path_);
+  Timespec mtime = this->file().get_mtime();
+  Timespec ctime = this->file().get_ctime();
+  const unsigned char* pdata = static_cast<const unsigned char*>(p);
+  const size_t count = hdr->count;
+  const size_t nbuckets = hdr->nbuckets;
+  size_t expected_size = sizeof(Armap_cache_header);
+  bool size_ok = (add_armap_cache_part(&expected_size, count,
+				       sizeof(Armap_entry))
+		  && add_armap_cache_part(&expected_size, nbuckets,
+					  sizeof(unsigned int))
+		  && add_armap_cache_part(&expected_size, count,
+					  sizeof(unsigned int))
+		  && add_armap_cache_part(&expected_size, hdr->names_size, 1)
+		  && add_armap_cache_part(&expected_size, hdr->filename_size,
+					  1));
+  if (!size_ok
+      || memcmp(hdr->magic, armap_cache_magic, sizeof hdr->magic) != 0
+      || hdr->hash_size != sizeof(size_t)
+      || count == 0
+      || nbuckets == 0
+      || (nbuckets & (nbuckets - 1)) != 0
+      || hdr->file_size != static_cast<uint64_t>(this->file().filesize())
+      || hdr->mtime_seconds != static_cast<int64_t>(mtime.seconds)
+      || hdr->mtime_nanoseconds != static_cast<int64_t>(mtime.nanoseconds)
+      || hdr->ctime_seconds != static_cast<int64_t>(ctime.seconds)
+      || hdr->ctime_nanoseconds != static_cast<int64_t>(ctime.nanoseconds)
+      || hdr->file_dev != this->armap_cache_dev_
+      || hdr->file_ino != this->armap_cache_ino_
+      || hdr->armap_start != static_cast<uint64_t>(start)
+      || hdr->armap_size != static_cast<uint64_t>(size)
+      || expected_size != cache_size
+      || hdr->filename_size != filename.length()
+      || memcmp(pdata + cache_size - filename.length(), filename.data(),
+		filename.length()) != 0)
+    {
+      if (is_mapped)
+	::munmap(p, cache_size);
+      else
+	free(p);
+      return false;
+    }
+
+  pdata += sizeof(Armap_cache_header);
+  const Armap_entry* armap = reinterpret_cast<const Armap_entry*>(pdata);
+  pdata += count * sizeof(Armap_entry);
+  const unsigned int* buckets = reinterpret_cast<const unsigned int*>(pdata);
+  pdata += nbuckets * sizeof(unsigned int);
+  const unsigned int* chain = reinterpret_cast<const unsigned int*>(pdata);
+  pdata += count * sizeof(unsigned int);
+  const char* names = reinterpret_cast<const char*>(pdata);
+
+  // Make sure that a damaged cache can't send us outside the file,
+  // or around a hash chain forever.  Chains are in increasing order.
+  const size_t names_size = hdr->names_size;
+  bool ok = names_size > 0 && names[names_size - 1] == '\0';
+  for (size_t i = 0; ok && i < count; ++i)
+    ok = (armap[i].name_offset < names_size
+	  && armap[i].file_offset < hdr->file_size
+	  && (chain[i] == -1U || (chain[i] > i && chain[i] < count)));
+  if (!ok)
+    {
+      if (is_mapped)
+	::munmap(p, cache_size);
+      else
+	free(p);
+      return false;
+    }
+
+  this->armap_cache_ = p;
+  this->armap_cache_size_ = cache_size;
+  this->armap_cache_is_mapped_ = is_mapped;
+
+  this->armap_ = armap;
+  this->armap_count_ = count;
+  this->armap_buckets_ = buckets;
+  this->armap_nbuckets_ = nbuckets;
+  this->armap_chain_ = chain;
+  this->armap_names_ = names;
+  this->num_members_ = hdr->num_members;
+
+  this->armap_checked_.resize(count);
+
+  return true;
+}
+
+// Write the archive symbol map and its hash table to the cache
+// directory.  We write to a temporary file and rename it, so that
+// links running at the same time never see a partial file.  Failing
+// to write the cache is not an error.
+
+void
+Archive::write_armap_cache(off_t start, section_size_type size)
+{
+  const std::string& filename(this->armap_cache_path_);
+  Timespec mtime = this->file().get_mtime();
+  Timespec ctime = this->file().get_ctime();
+
+  Armap_cache_header hdr;
+  memset(&hdr, 0, sizeof hdr);
+  memcpy(hdr.magic, armap_cache_magic, sizeof hdr.magic);
+  hdr.hash_size = sizeof(size_t);
+  hdr.count = this->armap_count_;
+  hdr.nbuckets = this->armap_nbuckets_;
+  hdr.num_members = this->num_members_;
+  hdr.names_size = this->armap_names_storage_.length();
+  hdr.filename_size = filename.length();
+  hdr.file_dev = this->armap_cache_dev_;
+  hdr.file_ino = this->armap_cache_ino_;
+  hdr.file_size = this->file().filesize();
+  hdr.mtime_seconds = mtime.seconds;
+  hdr.mtime_nanoseconds = mtime.nanoseconds;
+  hdr.ctime_seconds = ctime.seconds;
+  hdr.ctime_nanoseconds = ctime.nanoseconds;
+  hdr.armap_start = start;
+  hdr.armap_size = size;
+
+  std::string cachename(this->armap_cache_filename());
+  std::string tmpname(cachename + ".XXXXXX");
+  std::vector<char> tmpbuf(tmpname.begin(), tmpname.end());
+  tmpbuf.push_back('\0');
+  int o = ::mkstemp(&tmpbuf[0]);
+  if (o < 0)
+    return;
+
+  struct
+  {
+    const void* data;
+    size_t size;
+  } parts[] =
+  {
+    { &hdr, sizeof hdr },
+    { this->armap_, this->armap_count_ * sizeof(Armap_entry) },
+    { this->armap_buckets_, this->armap_nbuckets_ * sizeof(unsigned int) },
+    { this->armap_chain_, this->armap_count_ * sizeof(unsigned int) },
+    { this->armap_names_, this->armap_names_storage_.length() },
+    { filename.data(), filename.length() },
+  };
+  bool ok = true;
+  for (size_t i = 0; ok && i < sizeof parts / sizeof parts[0]; ++i)
+    {
+      const char* pd = static_cast<const char*>(parts[i].data);
+      size_t left = parts[i].size;
+      while (left > 0)
+	{
+	  ssize_t n = ::write(o, pd, left);
+	  if (n <= 0)
+	    {
+	      ok = false;
+	      break;
+	    }
+	  pd += n;
+	  left -= n;
+	}
+    }
+  if (::close(o) < 0)
+    ok = false;
+  if (!ok || ::rename(&tmpbuf[0], cachename.c_str()) < 0)
+    ::unlink(&tmpbuf[0]);
 }
 
 // Read the header of an archive member at OFF.  Fail if something
@@ -726,6 +1100,118 @@ Archive::read_symbols(off_t off)
   this->members_[off] = member;
 }
 
+// Find the members which the first pass of add_symbols will include,
+// unless including an earlier member defines the symbol first, and
+// make objects for them.  Members of nested archives are read here;
+// the others go on *MEMBERS, to be read by other tasks.
+
+void
+Archive::start_reading_members(Symbol_table* symtab, Layout* layout,
+			       std::vector<Archive_member>* members)
+{
+  std::set<size_t> entries;
+  bool all_entries = (this->armap_buckets_ == NULL
+		      || !this->find_undefined_armap_entries(symtab, layout,
+							     &entries));
+
+  std::set<off_t> offsets;
+  char* tmpbuf = NULL;
+  size_t tmpbuflen = 0;
+  std::set<size_t>::const_iterator pe = entries.begin();
+  for (size_t i = 0; i < this->armap_count_; ++i)
+    {
+      if (!all_entries)
+	{
+	  if (pe == entries.end())
+	    break;
+	  i = *pe;
+	  ++pe;
+	}
+
+      off_t off = this->armap_[i].file_offset;
+      if (this->armap_checked_[i]
+	  || offsets.find(off) != offsets.end()
+	  || this->seen_offsets_.find(off) != this->seen_offsets_.end()
+	  || this->members_.find(off) != this->members_.end())
+	continue;
+
+      Symbol* sym;
+      std::string why;
+      if (Archive::should_include_member(symtab, layout, this->armap_name(i),
+					 &sym, &why, &tmpbuf, &tmpbuflen)
+	  == Archive::SHOULD_INCLUDE_YES)
+	offsets.insert(off);
+    }
+  if (tmpbuf != NULL)
+    free(tmpbuf);
+
+  for (std::set<off_t>::const_iterator p = offsets.begin();
+       p != offsets.end();
+       ++p)
+    {
+      bool unconfigured;
+      Object* obj = this->get_elf_object_for_member(*p, &unconfigured);
+      if (obj == NULL)
+	{
+	  // If the target is wrong, include_member will decide what to
+	  // do.  Otherwise we have reported an error, and there is no
+	  // need to report it again.
+	  if (!unconfigured)
+	    {
+	      this->members_[*p] = Archive_member();
+	      this->read_members_.push_back(*p);
+	    }
+	  continue;
+	}
+
+      Read_symbols_data* sd = new Read_symbols_data;
+      Archive_member member(obj, sd);
+      this->members_[*p] = member;
+      this->read_members_.push_back(*p);
+
+      if (obj->offset() != 0 && obj->input_file() != this->input_file_)
+	obj->read_symbols(sd);
+      else
+	{
+	  // A member inside the archive shares our file.  The archive
+	  // stays locked until discard_unused_members, which runs after
+	  // all the Read_archive_member tasks are done; see
+	  // File_read::set_shared.
+	  if (obj->offset() != 0)
+	    this->file().set_shared(true);
+	  members->push_back(member);
+	  ++Archive::total_members_read_in_parallel;
+	}
+    }
+}
+
+// Discard the objects made by start_reading_members which we did not
+// include.  The tasks which read them are done, so the archive need
+// not be shared any more.
+
+void
+Archive::discard_unused_members()
+{
+  for (std::vector<off_t>::const_iterator p = this->read_members_.begin();
+       p != this->read_members_.end();
+       ++p)
+    {
+      std::map<off_t, Archive_member>::iterator pm = this->members_.find(*p);
+      gold_assert(pm != this->members_.end());
+      Object* obj = pm->second.obj_;
+      if (obj != NULL)
+	{
+	  delete pm->second.sd_;
+	  if (obj->offset() == 0)
+	    obj->unlock(this->task_);
+	  delete obj;
+	}
+      this->members_.erase(pm);
+    }
+  this->read_members_.clear();
+  this->file().set_shared(false);
+}
+
 // Select members from the archive and add them to the link.  We walk
 // through the elements in the archive map, and look each one up in
 // the symbol table.  If it exists as a strong undefined symbol, we
@@ -735,9 +1221,32 @@ Archive::read_symbols(off_t off)
 // the normal case, false if the first member we tried to add from
 // this archive had an incompatible target.
 
+// Only the first pass looks at every element of the archive map.
+// Whether a symbol in the map should cause us to include a member can
+// only change if a member we include mentions it, so each later pass
+// only looks at the entries for the symbols named by the members
+// included since that entry was last looked at.  We visit those in
+// the same order as a full pass would, so we select the same members.
+
 bool
 Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 		     Input_objects* input_objects, Mapfile* mapfile)
+{
+  return this->add_group_symbols(symtab, layout, input_objects, mapfile,
+				 true, NULL, 0);
+}
+
+// Search the archive again as part of a group.  If SEARCH_ALL is
+// false, only the objects in *INCLUDED from index START on have been
+// added to the link since this archive was last searched, so the
+// first pass only has to look at the entries for the symbols they
+// mention.  If INCLUDED is not NULL, add the objects we include to it.
+
+bool
+Archive::add_group_symbols(Symbol_table* symtab, Layout* layout,
+			   Input_objects* input_objects, Mapfile* mapfile,
+			   bool search_all, std::vector<Object*>* included,
+			   size_t start)
 {
   ++Archive::total_archives;
 
@@ -749,24 +1258,69 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 
   input_objects->archive_start(this);
 
-  const size_t armap_size = this->armap_.size();
+  const size_t armap_size = this->armap_count_;
 
   // This is a quick optimization, since we usually see many symbols
   // in a row with the same offset.  last_seen_offset holds the last
   // offset we saw that was present in the seen_offsets_ set.
   off_t last_seen_offset = -1;
 
-  // Track which symbols in the symbol table we've already found to be
-  // defined.
+  // The entries to look at in this pass, after the current one, and
+  // in the next pass, if we are not looking at all of them.
+  bool full_pass = true;
+  std::set<size_t> this_pass;
+  std::set<size_t> next_pass;
+
+  if (!search_all)
+    {
+      gold_assert(included != NULL);
+      full_pass = false;
+      for (size_t k = start; k < included->size(); ++k)
+	this->queue_armap_entries((*included)[k], armap_size, NULL,
+				  &this_pass, &full_pass);
+      if (full_pass)
+	this_pass.clear();
+    }
+  else if (this->armap_buckets_ != NULL
+	   && !parameters->options().has_plugins()
+	   && !parameters->incremental())
+    {
+      // We have an index, probably from the cache, so rather than
+      // look at every entry we can look up just the symbols which
+      // could cause us to include a member.
+      if (this->find_undefined_armap_entries(symtab, layout, &this_pass))
+	full_pass = false;
+      else
+	this_pass.clear();
+    }
 
   char* tmpbuf = NULL;
   size_t tmpbuflen = 0;
+  bool included_any = false;
   bool added_new_object;
   do
     {
       added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+      bool next_full_pass = false;
+      size_t pos = 0;
+      while (true)
 	{
+	  size_t i;
+	  if (full_pass)
+	    {
+	      if (pos >= armap_size)
+		break;
+	      i = pos;
+	      ++pos;
+	    }
+	  else
+	    {
+	      if (this_pass.empty())
+		break;
+	      i = *this_pass.begin();
+	      this_pass.erase(this_pass.begin());
+	    }
+
           if (this->armap_checked_[i])
             continue;
 	  if (this->armap_[i].file_offset == last_seen_offset)
@@ -782,8 +1336,7 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 	      continue;
 	    }
 
-	  const char* sym_name = (this->armap_names_.data()
-				  + this->armap_[i].name_offset);
+	  const char* sym_name = this->armap_name(i);
 
           Symbol* sym;
           std::string why;
@@ -802,28 +1355,257 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 	  last_seen_offset = this->armap_[i].file_offset;
 	  this->seen_offsets_.insert(last_seen_offset);
 
+	  Object* obj;
 	  if (!this->include_member(symtab, layout, input_objects,
 				    last_seen_offset, mapfile, sym,
-				    why.c_str()))
+				    why.c_str(), &obj))
 	    {
 	      if (tmpbuf != NULL)
 		free(tmpbuf);
 	      return false;
 	    }
 
+	  this->queue_armap_entries(obj, i, full_pass ? NULL : &this_pass,
+				    &next_pass, &next_full_pass);
+	  if (included != NULL && obj != NULL)
+	    included->push_back(obj);
 	  added_new_object = true;
+	  included_any = true;
 	}
+
+      full_pass = next_full_pass;
+      this_pass.swap(next_pass);
+      next_pass.clear();
+      if (full_pass)
+	this_pass.clear();
     }
   while (added_new_object);
 
   if (tmpbuf != NULL)
     free(tmpbuf);
 
+  // A full pass would have marked all the entries for the members we
+  // included as checked.  That only matters to plugins, which ask
+  // whether the archive defines a symbol.
+  if (included_any && parameters->options().has_plugins())
+    {
+      for (size_t i = 0; i < armap_size; ++i)
+	{
+	  if (!this->armap_checked_[i]
+	      && (this->seen_offsets_.find(this->armap_[i].file_offset)
+		  != this->seen_offsets_.end()))
+	    this->armap_checked_[i] = true;
+	}
+    }
+
   input_objects->archive_stop(this);
 
   return true;
 }
 
+// Return the hash code of the symbol name NAME, ignoring any version.
+
+static size_t
+armap_name_hash(const char* name)
+{
+  size_t len = strcspn(name, "@");
+  return gold::string_hash<char>(name, len);
+}
+
+// Return whether the symbol name in the armap ARMAP_NAME, ignoring
+// any version, is NAME.
+
+static bool
+armap_name_matches(const char* armap_name, const char* name)
+{
+  size_t len = strlen(name);
+  return (strncmp(armap_name, name, len) == 0
+	  && (armap_name[len] == '\0' || armap_name[len] == '@'));
+}
+
+// Build the hash table from symbol names to armap entries.  Entries
+// are chained in order, so each chain is sorted by armap index.
+
+void
+Archive::build_armap_index()
+{
+  const size_t armap_size = this->armap_count_;
+  size_t nbuckets = 16;
+  while (nbuckets < armap_size)
+    nbuckets <<= 1;
+  this->armap_index_storage_.assign(nbuckets + armap_size, -1U);
+  unsigned int* buckets = &this->armap_index_storage_[0];
+  unsigned int* chain = buckets + nbuckets;
+
+  std::vector<unsigned int> last(nbuckets, -1U);
+  for (size_t i = 0; i < armap_size; ++i)
+    {
+      const char* name = this->armap_name(i);
+      size_t bucket = armap_name_hash(name) & (nbuckets - 1);
+      if (last[bucket] == -1U)
+	buckets[bucket] = i;
+      else
+	chain[last[bucket]] = i;
+      last[bucket] = i;
+    }
+
+  this->armap_buckets_ = buckets;
+  this->armap_nbuckets_ = nbuckets;
+  this->armap_chain_ = chain;
+}
+
+// We have included OBJ because of armap entry POS.  The symbols which
+// OBJ defines or refers to are the only ones whose armap entries may
+// now give a different answer.  Add the entries for those symbols
+// which follow POS to *THIS_PASS, unless THIS_PASS is NULL because
+// we are already looking at every entry, and add the ones before POS
+// to *NEXT_PASS.  If we can't tell which symbols OBJ added, set
+// *NEXT_FULL_PASS to look at every entry in the next pass.
+
+void
+Archive::queue_armap_entries(Object* obj, size_t pos,
+			     std::set<size_t>* this_pass,
+			     std::set<size_t>* next_pass,
+			     bool* next_full_pass)
+{
+  if (obj == NULL)
+    return;
+
+  const size_t armap_size = this->armap_count_;
+
+  if (obj->pluginobj() != NULL)
+    {
+      // The symbols of a plugin object are not available as a list.
+      *next_full_pass = true;
+      if (this_pass != NULL)
+	{
+	  for (size_t i = pos + 1; i < armap_size; ++i)
+	    if (!this->armap_checked_[i])
+	      this_pass->insert(i);
+	}
+      return;
+    }
+
+  if (*next_full_pass && this_pass == NULL)
+    return;
+
+  if (this->armap_buckets_ == NULL)
+    this->build_armap_index();
+  const size_t mask = this->armap_nbuckets_ - 1;
+
+  const Object::Symbols* syms = obj->get_global_symbols();
+  for (Object::Symbols::const_iterator p = syms->begin();
+       p != syms->end();
+       ++p)
+    {
+      if (*p == NULL)
+	continue;
+      const char* name = (*p)->name();
+      size_t bucket = gold::string_hash<char>(name, strlen(name)) & mask;
+      for (unsigned int i = this->armap_buckets_[bucket];
+	   i < armap_size;
+	   i = this->armap_chain_[i])
+	{
+	  if (i == pos || this->armap_checked_[i])
+	    continue;
+	  if (!armap_name_matches(this->armap_name(i), name))
+	    continue;
+	  if (i > pos)
+	    {
+	      if (this_pass != NULL)
+		this_pass->insert(i);
+	    }
+	  else if (!*next_full_pass)
+	    next_pass->insert(i);
+	}
+    }
+}
+
+// Add to *ENTRIES the unchecked armap entries for the symbol NAME.
+
+void
+Archive::find_armap_entries(const char* name,
+			    std::set<size_t>* entries) const
+{
+  const size_t armap_size = this->armap_count_;
+  size_t len = strcspn(name, "@");
+  size_t bucket = (gold::string_hash<char>(name, len)
+		   & (this->armap_nbuckets_ - 1));
+  for (unsigned int i = this->armap_buckets_[bucket];
+       i < armap_size;
+       i = this->armap_chain_[i])
+    {
+      if (this->armap_checked_[i])
+	continue;
+      const char* armap_name = this->armap_name(i);
+      if (strncmp(armap_name, name, len) == 0
+	  && (armap_name[len] == '\0' || armap_name[len] == '@'))
+	entries->insert(i);
+    }
+}
+
+// Add to *ENTRIES the armap entries for the symbols which are
+// undefined now, or which are named on the command line or in a
+// script.  Only those entries can cause us to include a member
+// before we have included any member.  Return false if there are
+// more such names than armap entries, in which case it is cheaper to
+// look at every entry.
+
+bool
+Archive::find_undefined_armap_entries(const Symbol_table* symtab,
+				      const Layout* layout,
+				      std::set<size_t>* entries) const
+{
+  const size_t limit = this->armap_count_;
+  size_t count = 0;
+
+  const Symbol_table::Undefined_symbols& undefs(symtab->undefined_symbols());
+  for (Symbol_table::Undefined_symbols::const_iterator p = undefs.begin();
+       p != undefs.end();
+       ++p)
+    {
+      if (!(*p)->is_undefined() && !(*p)->is_forwarder())
+	continue;
+      if (++count > limit)
+	return false;
+      this->find_armap_entries((*p)->name(), entries);
+    }
+
+  const General_options& options(parameters->options());
+  for (options::String_set::const_iterator p = options.undefined_begin();
+       p != options.undefined_end();
+       ++p)
+    {
+      if (++count > limit)
+	return false;
+      this->find_armap_entries(p->c_str(), entries);
+    }
+  for (options::String_set::const_iterator p =
+	 options.export_dynamic_symbol_begin();
+       p != options.export_dynamic_symbol_end();
+       ++p)
+    {
+      if (++count > limit)
+	return false;
+      this->find_armap_entries(p->c_str(), entries);
+    }
+
+  const Script_options* script_options = layout->script_options();
+  for (Script_options::referenced_const_iterator p =
+	 script_options->referenced_begin();
+       p != script_options->referenced_end();
+       ++p)
+    {
+      if (++count > limit)
+	return false;
+      this->find_armap_entries(p->c_str(), entries);
+    }
+
+  this->find_armap_entries(parameters->entry(), entries);
+
+  return true;
+}
+
 // Return whether the archive includes a member which defines the
 // symbol SYM.
 
@@ -832,13 +1614,12 @@ Archive::defines_symbol(Symbol* sym) const
 {
   const char* symname = sym->name();
   size_t symname_len = strlen(symname);
-  size_t armap_size = this->armap_.size();
+  size_t armap_size = this->armap_count_;
   for (size_t i = 0; i < armap_size; ++i)
     {
       if (this->armap_checked_[i])
 	continue;
-      const char* archive_symname = (this->armap_names_.data()
-				     + this->armap_[i].name_offset);
+      const char* archive_symname = this->armap_name(i);
       if (strncmp(archive_symname, symname, symname_len) != 0)
 	continue;
       char c = archive_symname[symname_len];
@@ -883,7 +1664,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->first,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -895,7 +1676,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->off,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -929,16 +1710,25 @@ Archive::count_members()
 bool
 Archive::include_member(Symbol_table* symtab, Layout* layout,
 			Input_objects* input_objects, off_t off,
-			Mapfile* mapfile, Symbol* sym, const char* why)
+			Mapfile* mapfile, Symbol* sym, const char* why,
+			Object** pobj)
 {
   ++Archive::total_members_loaded;
 
-  std::map<off_t, Archive_member>::const_iterator p = this->members_.find(off);
+  if (pobj != NULL)
+    *pobj = NULL;
+
+  std::map<off_t, Archive_member>::iterator p = this->members_.find(off);
   if (p != this->members_.end())
     {
+      // We have already reported any error making the object.
       Object* obj = p->second.obj_;
+      if (obj == NULL)
+	return true;
 
       Read_symbols_data* sd = p->second.sd_;
+      p->second.obj_ = NULL;
+      p->second.sd_ = NULL;
       if (mapfile != NULL)
         mapfile->report_include_archive_member(obj->name(), sym, why);
       if (input_objects->add_object(obj))
@@ -946,8 +1736,16 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
           obj->layout(symtab, layout, sd);
           obj->add_symbols(symtab, sd, layout);
 	  this->included_member_ = true;
+	  if (pobj != NULL)
+	    *pobj = obj;
         }
       delete sd;
+
+      // If this is an external member of a thin archive, unlock the
+      // file for the next task.
+      if (obj->offset() == 0)
+	obj->unlock(this->task_);
+
       return true;
     }
 
@@ -976,6 +1774,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
     {
       pluginobj->add_symbols(symtab, NULL, layout);
       this->included_member_ = true;
+      if (pobj != NULL)
+	*pobj = obj;
       return true;
     }
 
@@ -1004,6 +1804,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
         obj->unlock(this->task_);
 
       this->included_member_ = true;
+      if (pobj != NULL)
+	*pobj = obj;
     }
 
   return true;
@@ -1014,13 +1816,11 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
 void
 Archive::do_for_all_unused_symbols(Symbol_visitor_base* v) const
 {
-  for (std::vector<Armap_entry>::const_iterator p = this->armap_.begin();
-       p != this->armap_.end();
-       ++p)
+  for (size_t i = 0; i < this->armap_count_; ++i)
     {
-      if (this->seen_offsets_.find(p->file_offset)
+      if (this->seen_offsets_.find(this->armap_[i].file_offset)
           == this->seen_offsets_.end())
-        v->visit(this->armap_names_.data() + p->name_offset);
+        v->visit(this->armap_name(i));
     }
 }
 
@@ -1035,6 +1835,8 @@ Archive::print_stats()
           program_name, Archive::total_members);
   fprintf(stderr, _("%s: loaded archive members: %u\n"),
           program_name, Archive::total_members_loaded);
+  fprintf(stderr, _("%s: archive members read in parallel: %u\n"),
+          program_name, Archive::total_members_read_in_parallel);
 }
 
 // Add_archive_symbols methods.
@@ -1055,6 +1857,10 @@ Add_archive_symbols::is_runnable()
 {
   if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
     return this->this_blocker_;
+  // If we read the members in parallel, the task which started that
+  // may still hold the archive.
+  if (this->members_read_ && this->archive_->is_locked())
+    return this->archive_->token();
   return NULL;
 }
 
@@ -1068,6 +1874,11 @@ Add_archive_symbols::locks(Task_locker* tl)
 void
 Add_archive_symbols::run(Workqueue* workqueue)
 {
+  // If we are going to include several members, read their symbols
+  // in parallel, and add them when we come back here.
+  if (!this->members_read_ && this->queue_read_members(workqueue))
+    return;
+
   // For an incremental link, begin recording layout information.
   Incremental_inputs* incremental_inputs = this->layout_->incremental_inputs();
   if (incremental_inputs != NULL)
@@ -1081,6 +1892,8 @@ Add_archive_symbols::run(Workqueue* workqueue)
   bool added = this->archive_->add_symbols(this->symtab_, this->layout_,
 					   this->input_objects_,
 					   this->mapfile_);
+  if (this->members_read_)
+    this->archive_->discard_unused_members();
   this->archive_->unlock_nested_archives();
 
   this->archive_->release();
@@ -1124,6 +1937,82 @@ Add_archive_symbols::run(Workqueue* workqueue)
     }
 }
 
+// Find the members of the archive which we expect to include, and
+// queue tasks to read their symbols in parallel.  Queue a new
+// Add_archive_symbols task, which runs when they are done and adds
+// the symbols in the usual order.  Return false if there is nothing
+// to do in parallel.
+
+bool
+Add_archive_symbols::queue_read_members(Workqueue* workqueue)
+{
+  this->members_read_ = true;
+
+  if (!parameters->options().threads()
+      || parameters->options().has_plugins()
+      || parameters->incremental()
+      || this->archive_->input_file()->options().whole_archive())
+    return false;
+
+  std::vector<Archive_member> members;
+  this->archive_->start_reading_members(this->symtab_, this->layout_,
+					&members);
+  if (members.empty())
+    return false;
+
+  // Every Read_archive_member task must be counted before any is
+  // queued.
+  Task_token* read_blocker = new Task_token(true);
+  read_blocker->add_blockers(members.size());
+
+  // The new task will unblock next_blocker_ in turn.
+  this->next_blocker_->add_blocker();
+  Add_archive_symbols* add = new Add_archive_symbols(this->symtab_,
+						     this->layout_,
+						     this->input_objects_,
+						     this->dirpath_,
+						     this->dirindex_,
+						     this->mapfile_,
+						     this->input_argument_,
+						     this->archive_,
+						     this->input_group_,
+						     read_blocker,
+						     this->next_blocker_);
+  add->members_read_ = true;
+
+  for (std::vector<Archive_member>::const_iterator p = members.begin();
+       p != members.end();
+       ++p)
+    workqueue->queue_soon(new Read_archive_member(*p, read_blocker));
+
+  workqueue->queue_next(add);
+  return true;
+}
+
+// Read_archive_member methods.
+
+// We unblock the Add_archive_symbols task when we are done.  The
+// archive is not locked: nothing else uses it until that task runs,
+// and the file permits several readers while the members are read.
+
+void
+Read_archive_member::locks(Task_locker* tl)
+{
+  tl->add(this, this->next_blocker_);
+}
+
+void
+Read_archive_member::run(Workqueue*)
+{
+  this->member_.obj_->read_symbols(this->member_.sd_);
+}
+
+std::string
+Read_archive_member::get_name() const
+{
+  return "Read_archive_member " + this->member_.obj_->name();
+}
+
 // Class Lib_group static variables.
 unsigned int Lib_group::total_lib_groups;
 unsigned int Lib_group::total_members;
@@ -1142,12 +2031,45 @@ Lib_group::do_filename() const
   return *filename;
 }
 
+// This class records, for each symbol name defined by the members of
+// a lib group, the original indexes of the members which define it.
+
+class Lib_group_name_visitor : public Library_base::Symbol_visitor_base
+{
+ public:
+  typedef Unordered_map<std::string, std::vector<size_t> > Name_index;
+
+  Lib_group_name_visitor(Name_index* index, size_t id)
+    : index_(index), id_(id)
+  { }
+
+  void
+  visit(const char* sym)
+  {
+    // Ignore any version, as should_include_member does.
+    std::string name(sym, strcspn(sym, "@"));
+    std::vector<size_t>& ids((*this->index_)[name]);
+    if (ids.empty() || ids.back() != this->id_)
+      ids.push_back(this->id_);
+  }
+
+ private:
+  Name_index* index_;
+  size_t id_;
+};
+
 // Select members from the lib group and add them to the link.  We walk
 // through the members, and check if each one up should be included.
 // If the object says it should be included, we do so.  We have to do
 // this in a loop, since including one member may create new undefined
 // symbols which may be satisfied by other members.
 
+// As in Archive::add_symbols, only the first pass looks at every member.
+// Later passes only look at the members which define a symbol that
+// was mentioned by a member included since, in order of position.
+// Including a member moves the last member into its place, so we
+// track the members by their original index in IDS and POSITIONS.
+
 void
 Lib_group::add_symbols(Symbol_table* symtab, Layout* layout,
                        Input_objects* input_objects)
@@ -1156,13 +2078,54 @@ Lib_group::add_symbols(Symbol_table* symtab, Layout* layout,
 
   Lib_group::total_members += this->members_.size();
 
+  const size_t removed = static_cast<size_t>(-1);
+  std::vector<size_t> ids(this->members_.size());
+  std::vector<size_t> positions(this->members_.size());
+  for (size_t j = 0; j < this->members_.size(); ++j)
+    {
+      ids[j] = j;
+      positions[j] = j;
+    }
+
+  // The index is built when we first include a member.  We can't tell
+  // which symbols decide whether to include a plugin object, so we
+  // look at those in every pass.
+  Lib_group_name_visitor::Name_index index;
+  bool have_index = false;
+  std::vector<size_t> plugin_ids;
+
+  bool full_pass = true;
+  std::set<size_t> this_pass;
+  std::set<size_t> next_pass;
   bool added_new_object;
   do
     {
       added_new_object = false;
+      bool next_full_pass = false;
+      if (!full_pass)
+	{
+	  for (std::vector<size_t>::const_iterator p = plugin_ids.begin();
+	       p != plugin_ids.end();
+	       ++p)
+	    if (positions[*p] != removed)
+	      this_pass.insert(positions[*p]);
+	}
       unsigned int i = 0;
-      while (i < this->members_.size())
+      while (true)
 	{
+	  if (full_pass)
+	    {
+	      if (i >= this->members_.size())
+		break;
+	    }
+	  else
+	    {
+	      if (this_pass.empty())
+		break;
+	      i = *this_pass.begin();
+	      this_pass.erase(this_pass.begin());
+	    }
+
 	  const Archive_member& member = this->members_[i];
 	  Object* obj = member.obj_;
 	  std::string why;
@@ -1179,13 +2142,75 @@ Lib_group::add_symbols(Symbol_table* symtab, Layout* layout,
 
 	      if (t != Archive::SHOULD_INCLUDE_YES)
 		{
-		  ++i;
+		  if (full_pass)
+		    ++i;
 		  continue;
 		}
 
+	      if (!have_index)
+		{
+		  for (size_t j = 0; j < this->members_.size(); ++j)
+		    {
+		      const Archive_member& m(this->members_[j]);
+		      if (m.obj_ == NULL)
+			continue;
+		      if (m.sd_ == NULL)
+			plugin_ids.push_back(ids[j]);
+		      else if (m.sd_->symbol_names != NULL)
+			{
+			  Lib_group_name_visitor v(&index, ids[j]);
+			  m.obj_->for_all_global_symbols(m.sd_, &v);
+			}
+		    }
+		  have_index = true;
+		}
+
 	      this->include_member(symtab, layout, input_objects, member);
 
 	      added_new_object = true;
+
+	      // Queue up the members which define a symbol that OBJ
+	      // mentions.  Those after I are looked at in this pass,
+	      // unless we are already looking at all of them.
+	      positions[ids[i]] = removed;
+	      if (obj->pluginobj() != NULL)
+		{
+		  next_full_pass = true;
+		  if (!full_pass)
+		    for (size_t j = i + 1; j < this->members_.size(); ++j)
+		      this_pass.insert(j);
+		}
+	      else
+		{
+		  const Object::Symbols* syms = obj->get_global_symbols();
+		  for (Object::Symbols::const_iterator ps = syms->begin();
+		       ps != syms->end();
+		       ++ps)
+		    {
+		      if (*ps == NULL)
+			continue;
+		      Lib_group_name_visitor::Name_index::const_iterator pi =
+			index.find((*ps)->name());
+		      if (pi == index.end())
+			continue;
+		      for (std::vector<size_t>::const_iterator pid =
+			     pi->second.begin();
+			   pid != pi->second.end();
+			   ++pid)
+			{
+			  size_t pos = positions[*pid];
+			  if (pos == removed)
+			    continue;
+			  if (pos > i)
+			    {
+			      if (!full_pass)
+				this_pass.insert(pos);
+			    }
+			  else if (!next_full_pass)
+			    next_pass.insert(pos);
+			}
+		    }
+		}
 	    }
           else
             {
@@ -1198,11 +2223,29 @@ Lib_group::add_symbols(Symbol_table* symtab, Layout* layout,
 		  delete member.sd_;
 		  obj->unlock(this->task_);
 		}
+	      positions[ids[i]] = removed;
             }
 
-	  this->members_[i] = this->members_.back();
+	  // Move the last member into this position.  If it was to be
+	  // looked at in this pass, it is now looked at next.
+	  size_t last = this->members_.size() - 1;
+	  if (last != i)
+	    {
+	      this->members_[i] = this->members_.back();
+	      ids[i] = ids[last];
+	      positions[ids[i]] = i;
+	      if (!full_pass && this_pass.erase(last) > 0)
+		this_pass.insert(i);
+	    }
 	  this->members_.pop_back();
+	  ids.pop_back();
 	}
+
+      full_pass = next_full_pass;
+      this_pass.swap(next_pass);
+      next_pass.clear();
+      if (full_pass)
+	this_pass.clear();
     }
   while (added_new_object);
 }
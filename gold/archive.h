@@ -23,6 +23,7 @@
 #ifndef GOLD_ARCHIVE_H
 #define GOLD_ARCHIVE_H
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -165,6 +166,8 @@ class Archive : public Library_base
   Archive(const std::string& name, Input_file* input_file,
           bool is_thin_archive, Dirsearch* dirpath, Task* task);
 
+  ~Archive();
+
   // The length of the magic string at the start of an archive.
   static const int sarmag = 8;
 
@@ -244,6 +247,32 @@ class Archive : public Library_base
   bool
   add_symbols(Symbol_table*, Layout*, Input_objects*, Mapfile*);
 
+  // Select members from the archive as needed when searching it
+  // again as part of a group.  *INCLUDED holds the objects included
+  // from the archives of the group; unless SEARCH_ALL is true, the
+  // ones from index START on are the only objects added to the link
+  // since this archive was last searched.  Add the objects we include
+  // to *INCLUDED.
+  bool
+  add_group_symbols(Symbol_table*, Layout*, Input_objects*, Mapfile*,
+		    bool search_all, std::vector<Object*>* included,
+		    size_t start);
+
+  // Find the members which we will include in the first pass of
+  // add_symbols, as far as we can tell before including any of
+  // them, and make objects for them.  Add to *MEMBERS the ones whose
+  // symbols may be read in parallel by other tasks; those tasks must
+  // finish before add_symbols is called.
+  void
+  start_reading_members(Symbol_table*, Layout*,
+			std::vector<Archive_member>* members);
+
+  // Once the tasks started by start_reading_members are done and we
+  // have added the symbols, discard the objects which we did not
+  // include.
+  void
+  discard_unused_members();
+
   // Return whether the archive defines the symbol.
   bool
   defines_symbol(Symbol*) const;
@@ -283,6 +312,8 @@ class Archive : public Library_base
   static unsigned int total_members;
   // Number of archive members loaded.
   static unsigned int total_members_loaded;
+  // Number of archive members whose symbols were read in parallel.
+  static unsigned int total_members_read_in_parallel;
 
   // Get a view into the underlying file.
   const unsigned char*
@@ -293,6 +324,31 @@ class Archive : public Library_base
   void
   read_armap(off_t start, section_size_type size);
 
+  // Try to read the archive symbol map at START and SIZE, with its
+  // hash table, from the cache directory.  Return true on success.
+  bool
+  read_armap_cache(off_t start, section_size_type size);
+
+  // Write the archive symbol map and its hash table to the cache
+  // directory.
+  void
+  write_armap_cache(off_t start, section_size_type size);
+
+  // Set the resolved file name, device and inode number which
+  // identify this archive in the cache directory.
+  void
+  set_armap_cache_key();
+
+  // Return the name of the file in the cache directory for this
+  // archive.
+  std::string
+  armap_cache_filename() const;
+
+  // Return the name of armap entry I.
+  const char*
+  armap_name(size_t i) const
+  { return this->armap_names_ + this->armap_[i].name_offset; }
+
   // Read an archive member header at OFF.  CACHE is whether to cache
   // the file view.  Return the size of the member, and set *PNAME to
   // the name.
@@ -331,10 +387,34 @@ class Archive : public Library_base
   bool
   include_all_members(Symbol_table*, Layout*, Input_objects*, Mapfile*);
 
-  // Include an archive member in the link.
+  // Include an archive member in the link.  If POBJ is not NULL, set
+  // *POBJ to the object which was added to the link, or NULL if none
+  // was.
   bool
   include_member(Symbol_table*, Layout*, Input_objects*, off_t off,
-		 Mapfile*, Symbol*, const char* why);
+		 Mapfile*, Symbol*, const char* why, Object** pobj);
+
+  // Build the hash table from symbol names to armap entries.
+  void
+  build_armap_index();
+
+  // Queue up the armap entries which may have been affected by
+  // including OBJ, which was selected by armap entry POS.
+  void
+  queue_armap_entries(Object* obj, size_t pos, std::set<size_t>* this_pass,
+		      std::set<size_t>* next_pass, bool* next_full_pass);
+
+  // Add to *ENTRIES the unchecked armap entries for the symbol NAME,
+  // ignoring any version.
+  void
+  find_armap_entries(const char* name, std::set<size_t>* entries) const;
+
+  // Add to *ENTRIES the armap entries which could cause us to include
+  // a member now.  Return false if that would take longer than
+  // looking at every entry.
+  bool
+  find_undefined_armap_entries(const Symbol_table*, const Layout*,
+			       std::set<size_t>* entries) const;
 
   // Return whether we found this archive by searching a directory.
   bool
@@ -356,13 +436,14 @@ class Archive : public Library_base
   void
   do_for_all_unused_symbols(Symbol_visitor_base* v) const;
 
-  // An entry in the archive map of symbols to object files.
+  // An entry in the archive map of symbols to object files.  This is
+  // also the format of the entries in the cache.
   struct Armap_entry
   {
     // The offset to the symbol name in armap_names_.
-    off_t name_offset;
+    unsigned int name_offset;
     // The file offset to the object in the archive.
-    off_t file_offset;
+    unsigned int file_offset;
   };
 
   // A simple hash code for off_t values.
@@ -380,10 +461,14 @@ class Archive : public Library_base
   std::string name_;
   // For reading the file.
   Input_file* input_file_;
-  // The archive map.
-  std::vector<Armap_entry> armap_;
-  // The names in the archive map.
-  std::string armap_names_;
+  // The archive map, with armap_count_ entries, and the names in it.
+  // These point into armap_storage_ and armap_names_storage_, or
+  // into armap_cache_ if we read the archive map from the cache.
+  const Armap_entry* armap_;
+  size_t armap_count_;
+  const char* armap_names_;
+  std::vector<Armap_entry> armap_storage_;
+  std::string armap_names_storage_;
   // The extended name table.
   std::string extended_names_;
   // Track which symbols in the archive map are for elements which are
@@ -391,8 +476,31 @@ class Archive : public Library_base
   std::vector<bool> armap_checked_;
   // Track which elements have been included by offset.
   Unordered_set<off_t, Seen_hash> seen_offsets_;
+  // A hash table from symbol names, without any version, to entries
+  // in the archive map.  armap_buckets_ holds the first entry for
+  // each of the armap_nbuckets_ hash buckets, and armap_chain_ the
+  // next entry in the same bucket; -1U ends a chain.  Unless we read
+  // it from the cache, this is built in armap_index_storage_ the
+  // first time we need it.
+  const unsigned int* armap_buckets_;
+  size_t armap_nbuckets_;
+  const unsigned int* armap_chain_;
+  std::vector<unsigned int> armap_index_storage_;
+  // The contents of the cache file, if we read one, and its size.
+  void* armap_cache_;
+  size_t armap_cache_size_;
+  // Whether armap_cache_ is mapped, rather than allocated.
+  bool armap_cache_is_mapped_;
+  // The absolute file name of the archive with all symbolic links
+  // resolved, and its device and inode number.  These identify the
+  // archive in the cache directory.
+  std::string armap_cache_path_;
+  uint64_t armap_cache_dev_;
+  uint64_t armap_cache_ino_;
   // Table of objects whose symbols have been pre-read.
   std::map<off_t, Archive_member> members_;
+  // The offsets of the members set up by start_reading_members.
+  std::vector<off_t> read_members_;
   // True if this is a thin archive.
   const bool is_thin_archive_;
   // True if we have included at least one object from this archive.
@@ -426,7 +534,7 @@ class Add_archive_symbols : public Task
       dirpath_(dirpath), dirindex_(dirindex), mapfile_(mapfile),
       input_argument_(input_argument), archive_(archive),
       input_group_(input_group), this_blocker_(this_blocker),
-      next_blocker_(next_blocker)
+      next_blocker_(next_blocker), members_read_(false)
   { }
 
   ~Add_archive_symbols();
@@ -451,6 +559,11 @@ class Add_archive_symbols : public Task
   }
 
  private:
+  // Start tasks to read the symbols of the members we are going to
+  // include, and queue a task to add the symbols once they are done.
+  bool
+  queue_read_members(Workqueue*);
+
   Symbol_table* symtab_;
   Layout* layout_;
   Input_objects* input_objects_;
@@ -462,6 +575,39 @@ class Add_archive_symbols : public Task
   Input_group* input_group_;
   Task_token* this_blocker_;
   Task_token* next_blocker_;
+  // Whether we have already tried to read the symbols of the
+  // members we expect to include in parallel.
+  bool members_read_;
+};
+
+// This task reads the symbols of an archive member, so that the
+// members of an archive may be read in parallel.
+
+class Read_archive_member : public Task
+{
+ public:
+  Read_archive_member(const Archive_member& member, Task_token* next_blocker)
+    : member_(member), next_blocker_(next_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const;
+
+ private:
+  Archive_member member_;
+  Task_token* next_blocker_;
 };
 
 // This class represents the files surrounded by a --start-lib ... --end-lib.
@@ -1493,13 +1493,20 @@ class Arm_relobj : public Sized_relobj_file<32, big_endian>
     : Sized_relobj_file<32, big_endian>(name, input_file, offset, ehdr),
       stub_tables_(), local_symbol_is_thumb_function_(),
       attributes_section_data_(NULL), mapping_symbols_info_(),
-      section_has_cortex_a8_workaround_(NULL), exidx_section_map_(),
-      output_local_symbol_count_needs_update_(false),
+      section_has_cortex_a8_workaround_(NULL), cortex_a8_section_scans_(),
+      exidx_section_map_(), output_local_symbol_count_needs_update_(false),
       merge_flags_and_attributes_(true)
   { }
 
   ~Arm_relobj()
-  { delete this->attributes_section_data_; }
+  {
+    delete this->attributes_section_data_;
+    for (typename Cortex_a8_section_scans::iterator p =
+	   this->cortex_a8_section_scans_.begin();
+	 p != this->cortex_a8_section_scans_.end();
+	 ++p)
+      delete *p;
+  }
 
   // Return the stub table of the SHNDX-th section if there is one.
   Stub_table<big_endian>*
@@ -1683,6 +1690,11 @@ class Arm_relobj : public Sized_relobj_file<32, big_endian>
   void
   do_read_symbols(Read_symbols_data* sd);
 
+  // Read the relocs.  This also finds the candidates for the
+  // Cortex-A8 erratum, since it runs in parallel for each object.
+  void
+  do_read_relocs(Read_relocs_data* rd);
+
   // Process relocs for garbage collection.
   void
   do_gc_process_relocs(Symbol_table*, Layout*, Read_relocs_data*);
@@ -1712,6 +1724,43 @@ class Arm_relobj : public Sized_relobj_file<32, big_endian>
 				     unsigned int, Output_section*,
 				     Target_arm<big_endian>*);
 
+  // The result of scanning a section for the Cortex-A8 erratum.
+  struct Cortex_a8_section_scan
+  {
+    Cortex_a8_section_scan()
+      : spans(), candidates(), page_offset(invalid_address), hits()
+    { }
+
+    // The THUMB code spans of the section.
+    std::vector<std::pair<section_size_type, section_size_type> > spans;
+    // The branches which may trigger the erratum, as found by
+    // Target_arm::find_cortex_a8_erratum_candidates.
+    std::vector<std::pair<section_size_type, unsigned int> > candidates;
+    // The output address of the section modulo the page size when HITS
+    // was computed, or invalid_address.
+    Arm_address page_offset;
+    // The offsets of the candidates which cross a 4K page boundary.
+    std::vector<section_size_type> hits;
+  };
+
+  typedef std::vector<Cortex_a8_section_scan*> Cortex_a8_section_scans;
+
+  // Whether the sections of this object may need to be scanned for the
+  // Cortex-A8 erratum.  This is used before the target has decided.
+  bool
+  may_need_cortex_a8_scanning() const;
+
+  // Find the Cortex-A8 erratum candidates in section SHNDX using the
+  // mapping symbols in MAPPING_SYMBOLS.
+  Cortex_a8_section_scan*
+  make_cortex_a8_section_scan(const Mapping_symbols_info& mapping_symbols,
+			      unsigned int shndx,
+			      section_size_type section_size);
+
+  // Find the Cortex-A8 erratum candidates in all the text sections.
+  void
+  find_cortex_a8_erratum_candidates();
+
   // Find the linked text section of an EXIDX section by looking at the
   // first relocation of the EXIDX section.  PSHDR points to the section
   // headers of a relocation section and PSYMS points to the local symbols.
@@ -1753,6 +1802,9 @@ class Arm_relobj : public Sized_relobj_file<32, big_endian>
   Mapping_symbols_info mapping_symbols_info_;
   // Bitmap to indicate sections with Cortex-A8 workaround or NULL.
   std::vector<bool>* section_has_cortex_a8_workaround_;
+  // The Cortex-A8 erratum scans of the sections, indexed by section
+  // index.  This is either empty or has an entry for each section.
+  Cortex_a8_section_scans cortex_a8_section_scans_;
   // Map a text section to its associated .ARM.exidx section, if there is one.
   Exidx_section_map exidx_section_map_;
   // Whether output local symbol count needs updating.
@@ -2434,11 +2486,25 @@ class Target_arm : public Sized_target<32, big_endian>
   fix_v4bx() const
   { return parameters->options().fix_v4bx(); }
 
-  // Scan a span of THUMB code section for Cortex-A8 erratum.
+  // A branch which may trigger the Cortex-A8 erratum: its offset in
+  // the section, and the index of the THUMB span containing it.
+  typedef std::pair<section_size_type, unsigned int> Cortex_a8_candidate;
+
+  // Find the 32-bit THUMB branches in a span of THUMB code which follow
+  // a 32-bit non-branch instruction.  These are the only branches which
+  // can trigger the Cortex-A8 erratum.  This does not depend on the
+  // address of the code, so it may be done before layout.
+  static void
+  find_cortex_a8_erratum_candidates(const unsigned char*, section_size_type,
+				    section_size_type, unsigned int,
+				    std::vector<Cortex_a8_candidate>*);
+
+  // Check a branch found by find_cortex_a8_erratum_candidates which
+  // straddles a 4K page boundary, and make a stub for it if needed.
   void
-  scan_span_for_cortex_a8_erratum(Arm_relobj<big_endian>*, unsigned int,
-				  section_size_type, section_size_type,
-				  const unsigned char*, Arm_address);
+  scan_cortex_a8_erratum_candidate(Arm_relobj<big_endian>*, unsigned int,
+				   section_size_type, const unsigned char*,
+				   Arm_address);
 
   // Apply Cortex-A8 workaround to a branch.
   void
@@ -2487,7 +2553,8 @@ class Target_arm : public Sized_target<32, big_endian>
   { return !parameters->options().relocatable(); }
 
   bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*);
 
   // Determine whether an object attribute tag takes an integer, a
   // string or both.
@@ -6186,21 +6253,75 @@ Arm_relobj<big_endian>::scan_section_for_cortex_a8_erratum(
   Arm_address output_address =
     this->simple_input_section_output_address(shndx, os);
 
+  // Find the candidates, unless we did so when we read the relocs.
+  if (this->cortex_a8_section_scans_.empty())
+    this->cortex_a8_section_scans_.resize(this->shnum(), NULL);
+  Cortex_a8_section_scan* scan = this->cortex_a8_section_scans_[shndx];
+  if (scan == NULL)
+    {
+      scan = this->make_cortex_a8_section_scan(this->mapping_symbols_info_,
+					       shndx, shdr.get_sh_size());
+      this->cortex_a8_section_scans_[shndx] = scan;
+    }
+
+  // Which candidates cross a 4K page boundary only depends on the
+  // output address modulo the page size.  If the section has not moved
+  // within its page since the last relaxation pass, reuse the result.
+  Arm_address page_offset = output_address & 0xfffU;
+  if (scan->page_offset != page_offset)
+    {
+      scan->hits.clear();
+      for (size_t i = 0; i < scan->candidates.size(); ++i)
+	{
+	  section_size_type offset = scan->candidates[i].first;
+	  section_size_type span_start =
+	    scan->spans[scan->candidates[i].second].first;
+	  section_size_type span_end =
+	    scan->spans[scan->candidates[i].second].second;
+	  if (((span_start + output_address) & ~0xfffUL)
+	      != ((span_end + output_address - 1) & ~0xfffUL)
+	      && ((output_address + offset) & 0xfffU) == 0xffeU)
+	    scan->hits.push_back(offset);
+	}
+      scan->page_offset = page_offset;
+    }
+
+  if (scan->hits.empty())
+    return;
+
   // Get the section contents.
   section_size_type input_view_size = 0;
   const unsigned char* input_view =
     this->section_contents(shndx, &input_view_size, false);
 
-  // We need to go through the mapping symbols to determine what to
-  // scan.  There are two reasons.  First, we should look at THUMB code and
-  // THUMB code only.  Second, we only want to look at the 4K-page boundary
-  // to speed up the scanning.
+  for (size_t i = 0; i < scan->hits.size(); ++i)
+    arm_target->scan_cortex_a8_erratum_candidate(this, shndx, scan->hits[i],
+						 input_view, output_address);
+}
+
+// Find the Cortex-A8 erratum candidates in the THUMB code of section
+// SHNDX, whose size is SECTION_SIZE.  MAPPING_SYMBOLS tells us where
+// the THUMB code is.
+
+template<bool big_endian>
+typename Arm_relobj<big_endian>::Cortex_a8_section_scan*
+Arm_relobj<big_endian>::make_cortex_a8_section_scan(
+    const Mapping_symbols_info& mapping_symbols,
+    unsigned int shndx,
+    section_size_type section_size)
+{
+  Cortex_a8_section_scan* scan = new Cortex_a8_section_scan();
 
-  while (p != this->mapping_symbols_info_.end()
-	&& p->first.first == shndx)
+  // We need to go through the mapping symbols to determine what to
+  // scan, since we should look at THUMB code and THUMB code only.
+  Mapping_symbol_position section_start(shndx, 0);
+  typename Mapping_symbols_info::const_iterator p =
+    mapping_symbols.lower_bound(section_start);
+  const unsigned char* input_view = NULL;
+  while (p != mapping_symbols.end() && p->first.first == shndx)
     {
       typename Mapping_symbols_info::const_iterator next =
-	this->mapping_symbols_info_.upper_bound(p->first);
+	mapping_symbols.upper_bound(p->first);
 
       // Only scan part of a section with THUMB code.
       if (p->second == 't')
@@ -6209,24 +6330,126 @@ Arm_relobj<big_endian>::scan_section_for_cortex_a8_erratum(
 	  section_size_type span_start =
 	    convert_to_section_size_type(p->first.second);
 	  section_size_type span_end;
-	  if (next != this->mapping_symbols_info_.end()
-	      && next->first.first == shndx)
+	  if (next != mapping_symbols.end() && next->first.first == shndx)
 	    span_end = convert_to_section_size_type(next->first.second);
 	  else
-	    span_end = convert_to_section_size_type(shdr.get_sh_size());
+	    span_end = section_size;
 
-	  if (((span_start + output_address) & ~0xfffUL)
-	      != ((span_end + output_address - 1) & ~0xfffUL))
+	  if (input_view == NULL)
 	    {
-	      arm_target->scan_span_for_cortex_a8_erratum(this, shndx,
-							  span_start, span_end,
-							  input_view,
-							  output_address);
+	      section_size_type input_view_size = 0;
+	      input_view = this->section_contents(shndx, &input_view_size,
+						  false);
 	    }
+
+	  scan->spans.push_back(std::make_pair(span_start, span_end));
+	  Target_arm<big_endian>::find_cortex_a8_erratum_candidates(
+	      input_view, span_start, span_end, scan->spans.size() - 1,
+	      &scan->candidates);
 	}
 
       p = next;
     }
+
+  return scan;
+}
+
+// Return whether the sections of this object may need to be scanned
+// for the Cortex-A8 erratum.  This mirrors the test in
+// Target_arm::do_finalize_sections, using this object's attributes.
+
+template<bool big_endian>
+bool
+Arm_relobj<big_endian>::may_need_cortex_a8_scanning() const
+{
+  if (parameters->options().user_set_fix_cortex_a8())
+    return parameters->options().fix_cortex_a8();
+  if (this->attributes_section_data_ == NULL)
+    return false;
+  const Object_attribute* cpu_arch_attr =
+    this->attributes_section_data_->get_attribute(
+	Object_attribute::OBJ_ATTR_PROC, elfcpp::Tag_CPU_arch);
+  const Object_attribute* cpu_arch_profile_attr =
+    this->attributes_section_data_->get_attribute(
+	Object_attribute::OBJ_ATTR_PROC, elfcpp::Tag_CPU_arch_profile);
+  return (cpu_arch_attr->int_value() == elfcpp::TAG_CPU_ARCH_V7
+	  && (cpu_arch_profile_attr->int_value() == 'A'
+	      || cpu_arch_profile_attr->int_value() == 0));
+}
+
+// Find the Cortex-A8 erratum candidates in all the text sections of
+// this object.  This is called from the Read_relocs task, so with
+// --threads the objects are scanned in parallel.  We read the mapping
+// symbols here since count_local_symbols has not run yet.
+
+template<bool big_endian>
+void
+Arm_relobj<big_endian>::find_cortex_a8_erratum_candidates()
+{
+  const unsigned int symtab_shndx = this->symtab_shndx();
+  if (symtab_shndx == 0 || !this->may_need_cortex_a8_scanning())
+    return;
+
+  elfcpp::Shdr<32, big_endian>
+      symtabshdr(this, this->elf_file()->section_header(symtab_shndx));
+  if (symtabshdr.get_sh_type() != elfcpp::SHT_SYMTAB)
+    return;
+  unsigned int strtab_shndx = this->adjust_shndx(symtabshdr.get_sh_link());
+  if (strtab_shndx >= this->shnum())
+    return;
+  elfcpp::Shdr<32, big_endian>
+    strtabshdr(this, this->elf_file()->section_header(strtab_shndx));
+  if (strtabshdr.get_sh_type() != elfcpp::SHT_STRTAB)
+    return;
+
+  const unsigned int loccount = symtabshdr.get_sh_info();
+  const int sym_size = elfcpp::Elf_sizes<32>::sym_size;
+  if (loccount == 0
+      || loccount * sym_size > symtabshdr.get_sh_size())
+    return;
+  const unsigned char* psyms = this->get_view(symtabshdr.get_sh_offset(),
+					      loccount * sym_size, true, false);
+  const char* pnames =
+    reinterpret_cast<const char*>(this->get_view(strtabshdr.get_sh_offset(),
+						 strtabshdr.get_sh_size(),
+						 false, false));
+
+  // Collect the mapping symbols, as do_count_local_symbols does.
+  Mapping_symbols_info mapping_symbols;
+  psyms += sym_size;
+  for (unsigned int i = 1; i < loccount; ++i, psyms += sym_size)
+    {
+      elfcpp::Sym<32, big_endian> sym(psyms);
+      if (sym.get_st_name() >= strtabshdr.get_sh_size())
+	continue;
+      const char* sym_name = pnames + sym.get_st_name();
+      if (!Target_arm<big_endian>::is_mapping_symbol_name(sym_name))
+	continue;
+      bool is_ordinary;
+      unsigned int input_shndx =
+	this->adjust_sym_shndx(i, sym.get_st_shndx(), &is_ordinary);
+      if (!is_ordinary)
+	continue;
+      Mapping_symbol_position msp(input_shndx, sym.get_st_value() & ~1U);
+      mapping_symbols[msp] = sym_name[1];
+    }
+
+  const unsigned int shnum = this->shnum();
+  this->cortex_a8_section_scans_.resize(shnum, NULL);
+  const Relobj::Output_sections& out_sections(this->output_sections());
+  for (unsigned int i = 1; i < shnum; ++i)
+    {
+      elfcpp::Shdr<32, big_endian>
+	shdr(this, this->elf_file()->section_header(i));
+      if (shdr.get_sh_type() != elfcpp::SHT_PROGBITS
+	  || (shdr.get_sh_flags() & elfcpp::SHF_EXECINSTR) == 0
+	  || shdr.get_sh_size() == 0
+	  || out_sections[i] == NULL)
+	continue;
+      this->cortex_a8_section_scans_[i] =
+	this->make_cortex_a8_section_scan(mapping_symbols, i,
+					  shdr.get_sh_size());
+    }
 }
 
 // Scan relocations for stub generation.
@@ -6467,6 +6690,10 @@ Arm_relobj<big_endian>::do_relocate_sections(
 
   for (unsigned int i = 1; i < shnum; ++i)
     {
+      // Skip sections handled by a different call to relocate_range.
+      if ((*pviews)[i].is_in_other_range)
+	continue;
+
       Arm_input_section<big_endian>* arm_input_section =
 	arm_target->find_arm_input_section(this, i);
 
@@ -6830,6 +7057,18 @@ Arm_relobj<big_endian>::do_read_symbols(Read_symbols_data* sd)
     }
 }
 
+// Read the relocs.  We also look for the Cortex-A8 erratum candidates
+// here, so that the expensive part of the scan is done in parallel and
+// only once, rather than on each relaxation pass.
+
+template<bool big_endian>
+void
+Arm_relobj<big_endian>::do_read_relocs(Read_relocs_data* rd)
+{
+  Sized_relobj_file<32, big_endian>::do_read_relocs(rd);
+  this->find_cortex_a8_erratum_candidates();
+}
+
 // Process relocations for garbage collection.  The ARM target uses .ARM.exidx
 // sections for unwinding.  These sections are referenced implicitly by
 // text sections linked in the section headers.  If we ignore these implicit
@@ -11523,6 +11762,7 @@ Target_arm<big_endian>::do_relax(
     const Input_objects* input_objects,
     Symbol_table* symtab,
     Layout* layout,
+    Workqueue*,
     const Task* task)
 {
   // No need to generate stubs if this is a relocatable link.
@@ -11814,17 +12054,36 @@ Target_arm<big_endian>::do_attributes_order(int num) const
   return num;
 }
 
-// Scan a span of THUMB code for Cortex-A8 erratum.
+// Decode a 32-bit THUMB instruction INSN and set *IS_B, *IS_BL,
+// *IS_BLX and *IS_BCC to tell what kind of branch it is.
+
+static inline void
+decode_thumb2_branch(uint32_t insn, bool* is_b, bool* is_bl, bool* is_blx,
+		     bool* is_bcc)
+{
+  // Encoding T4: B<c>.W.
+  *is_b = (insn & 0xf800d000U) == 0xf0009000U;
+  // Encoding T1: BL<c>.W.
+  *is_bl = (insn & 0xf800d000U) == 0xf000d000U;
+  // Encoding T2: BLX<c>.W.
+  *is_blx = (insn & 0xf800d000U) == 0xf000c000U;
+  // Encoding T3: B<c>.W (not permitted in IT block).
+  *is_bcc = ((insn & 0xf800d000U) == 0xf0008000U
+	     && (insn & 0x07f00000U) != 0x03800000U);
+}
+
+// Find the candidates for the Cortex-A8 erratum in the THUMB code
+// between SPAN_START and SPAN_END of VIEW, and add them to CANDIDATES
+// with the span index SPAN_INDEX.
 
 template<bool big_endian>
 void
-Target_arm<big_endian>::scan_span_for_cortex_a8_erratum(
-    Arm_relobj<big_endian>* arm_relobj,
-    unsigned int shndx,
+Target_arm<big_endian>::find_cortex_a8_erratum_candidates(
+    const unsigned char* view,
     section_size_type span_start,
     section_size_type span_end,
-    const unsigned char* view,
-    Arm_address address)
+    unsigned int span_index,
+    std::vector<Cortex_a8_candidate>* candidates)
 {
   // Scan for 32-bit Thumb-2 branches which span two 4K regions, where:
   //
@@ -11833,6 +12092,11 @@ Target_arm<big_endian>::scan_span_for_cortex_a8_erratum(
   // first half of the branch.
   // The instruction before the branch is a 32-bit
   // length non-branch instruction.
+  //
+  // Here we only look for the opcodes and the preceding instruction.
+  // Whether the branch spans two 4K regions, and where its target is,
+  // depend on the layout, and are checked on each relaxation pass by
+  // scan_cortex_a8_erratum_candidate.
   section_size_type i = span_start;
   bool last_was_32bit = false;
   bool last_was_branch = false;
@@ -11849,138 +12113,147 @@ Target_arm<big_endian>::scan_span_for_cortex_a8_erratum(
 	{
 	  // Load the rest of the insn (in manual-friendly order).
 	  insn = (insn << 16) | elfcpp::Swap<16, big_endian>::readval(wv + 1);
-
-	  // Encoding T4: B<c>.W.
-	  is_b = (insn & 0xf800d000U) == 0xf0009000U;
-	  // Encoding T1: BL<c>.W.
-	  is_bl = (insn & 0xf800d000U) == 0xf000d000U;
-	  // Encoding T2: BLX<c>.W.
-	  is_blx = (insn & 0xf800d000U) == 0xf000c000U;
-	  // Encoding T3: B<c>.W (not permitted in IT block).
-	  is_bcc = ((insn & 0xf800d000U) == 0xf0008000U
-		    && (insn & 0x07f00000U) != 0x03800000U);
+	  decode_thumb2_branch(insn, &is_b, &is_bl, &is_blx, &is_bcc);
 	}
 
       bool is_32bit_branch = is_b || is_bl || is_blx || is_bcc;
 
-      // If this instruction is a 32-bit THUMB branch that crosses a 4K
-      // page boundary and it follows 32-bit non-branch instruction,
-      // we need to work around.
-      if (is_32bit_branch
-	  && ((address + i) & 0xfffU) == 0xffeU
-	  && last_was_32bit
-	  && !last_was_branch)
-	{
-	  // Check to see if there is a relocation stub for this branch.
-	  bool force_target_arm = false;
-	  bool force_target_thumb = false;
-	  const Cortex_a8_reloc* cortex_a8_reloc = NULL;
-	  Cortex_a8_relocs_info::const_iterator p =
-	    this->cortex_a8_relocs_info_.find(address + i);
-
-	  if (p != this->cortex_a8_relocs_info_.end())
-	    {
-	      cortex_a8_reloc = p->second;
-	      bool target_is_thumb = (cortex_a8_reloc->destination() & 1) != 0;
-
-	      if (cortex_a8_reloc->r_type() == elfcpp::R_ARM_THM_CALL
-		  && !target_is_thumb)
-		force_target_arm = true;
-	      else if (cortex_a8_reloc->r_type() == elfcpp::R_ARM_THM_CALL
-		       && target_is_thumb)
-		force_target_thumb = true;
-	    }
+      if (is_32bit_branch && last_was_32bit && !last_was_branch)
+	candidates->push_back(Cortex_a8_candidate(i, span_index));
 
-	  off_t offset;
-	  Stub_type stub_type = arm_stub_none;
-
-	  // Check if we have an offending branch instruction.
-	  uint16_t upper_insn = (insn >> 16) & 0xffffU;
-	  uint16_t lower_insn = insn & 0xffffU;
-	  typedef class Arm_relocate_functions<big_endian> RelocFuncs;
-
-	  if (cortex_a8_reloc != NULL
-	      && cortex_a8_reloc->reloc_stub() != NULL)
-	    // We've already made a stub for this instruction, e.g.
-	    // it's a long branch or a Thumb->ARM stub.  Assume that
-	    // stub will suffice to work around the A8 erratum (see
-	    // setting of always_after_branch above).
-	    ;
-	  else if (is_bcc)
-	    {
-	      offset = RelocFuncs::thumb32_cond_branch_offset(upper_insn,
-							      lower_insn);
-	      stub_type = arm_stub_a8_veneer_b_cond;
-	    }
-	  else if (is_b || is_bl || is_blx)
-	    {
-	      offset = RelocFuncs::thumb32_branch_offset(upper_insn,
-							 lower_insn);
-	      if (is_blx)
-		offset &= ~3;
-
-	      stub_type = (is_blx
-			   ? arm_stub_a8_veneer_blx
-			   : (is_bl
-			      ? arm_stub_a8_veneer_bl
-			      : arm_stub_a8_veneer_b));
-	    }
+      i += insn_32bit ? 4 : 2;
+      last_was_32bit = insn_32bit;
+      last_was_branch = is_32bit_branch;
+    }
+}
 
-	  if (stub_type != arm_stub_none)
-	    {
-	      Arm_address pc_for_insn = address + i + 4;
-
-	      // The original instruction is a BL, but the target is
-	      // an ARM instruction.  If we were not making a stub,
-	      // the BL would have been converted to a BLX.  Use the
-	      // BLX stub instead in that case.
-	      if (this->may_use_v5t_interworking() && force_target_arm
-		  && stub_type == arm_stub_a8_veneer_bl)
-		{
-		  stub_type = arm_stub_a8_veneer_blx;
-		  is_blx = true;
-		  is_bl = false;
-		}
-	      // Conversely, if the original instruction was
-	      // BLX but the target is Thumb mode, use the BL stub.
-	      else if (force_target_thumb
-		       && stub_type == arm_stub_a8_veneer_blx)
-		{
-		  stub_type = arm_stub_a8_veneer_bl;
-		  is_blx = false;
-		  is_bl = true;
-		}
+// Check the branch at OFFSET in section SHNDX of ARM_RELOBJ for the
+// Cortex-A8 erratum.  VIEW is the section contents and ADDRESS is the
+// output address of the section.  The caller has checked that the
+// branch is a candidate and that it crosses a 4K page boundary.
 
-	      if (is_blx)
-		pc_for_insn &= ~3;
+template<bool big_endian>
+void
+Target_arm<big_endian>::scan_cortex_a8_erratum_candidate(
+    Arm_relobj<big_endian>* arm_relobj,
+    unsigned int shndx,
+    section_size_type i,
+    const unsigned char* view,
+    Arm_address address)
+{
+  typedef typename elfcpp::Swap<16, big_endian>::Valtype Valtype;
+  const Valtype* wv = reinterpret_cast<const Valtype*>(view + i);
+  uint32_t insn = ((elfcpp::Swap<16, big_endian>::readval(wv) << 16)
+		   | elfcpp::Swap<16, big_endian>::readval(wv + 1));
+  bool is_blx, is_b, is_bl, is_bcc;
+  decode_thumb2_branch(insn, &is_b, &is_bl, &is_blx, &is_bcc);
+  gold_assert(is_b || is_bl || is_blx || is_bcc);
+  gold_assert(((address + i) & 0xfffU) == 0xffeU);
+
+  // Check to see if there is a relocation stub for this branch.
+  bool force_target_arm = false;
+  bool force_target_thumb = false;
+  const Cortex_a8_reloc* cortex_a8_reloc = NULL;
+  Cortex_a8_relocs_info::const_iterator p =
+    this->cortex_a8_relocs_info_.find(address + i);
+
+  if (p != this->cortex_a8_relocs_info_.end())
+    {
+      cortex_a8_reloc = p->second;
+      bool target_is_thumb = (cortex_a8_reloc->destination() & 1) != 0;
+
+      if (cortex_a8_reloc->r_type() == elfcpp::R_ARM_THM_CALL
+	  && !target_is_thumb)
+	force_target_arm = true;
+      else if (cortex_a8_reloc->r_type() == elfcpp::R_ARM_THM_CALL
+	       && target_is_thumb)
+	force_target_thumb = true;
+    }
+
+  off_t offset;
+  Stub_type stub_type = arm_stub_none;
 
-	      // If we found a relocation, use the proper destination,
-	      // not the offset in the (unrelocated) instruction.
-	      // Note this is always done if we switched the stub type above.
-	      if (cortex_a8_reloc != NULL)
-		offset = (off_t) (cortex_a8_reloc->destination() - pc_for_insn);
+  // Check if we have an offending branch instruction.
+  uint16_t upper_insn = (insn >> 16) & 0xffffU;
+  uint16_t lower_insn = insn & 0xffffU;
+  typedef class Arm_relocate_functions<big_endian> RelocFuncs;
 
-	      Arm_address target = (pc_for_insn + offset) | (is_blx ? 0 : 1);
+  if (cortex_a8_reloc != NULL
+      && cortex_a8_reloc->reloc_stub() != NULL)
+    // We've already made a stub for this instruction, e.g.
+    // it's a long branch or a Thumb->ARM stub.  Assume that
+    // stub will suffice to work around the A8 erratum (see
+    // setting of always_after_branch above).
+    ;
+  else if (is_bcc)
+    {
+      offset = RelocFuncs::thumb32_cond_branch_offset(upper_insn,
+						      lower_insn);
+      stub_type = arm_stub_a8_veneer_b_cond;
+    }
+  else if (is_b || is_bl || is_blx)
+    {
+      offset = RelocFuncs::thumb32_branch_offset(upper_insn,
+						 lower_insn);
+      if (is_blx)
+	offset &= ~3;
 
-	      // Add a new stub if destination address in in the same page.
-	      if (((address + i) & ~0xfffU) == (target & ~0xfffU))
-		{
-		  Cortex_a8_stub* stub =
-		    this->stub_factory_.make_cortex_a8_stub(stub_type,
-							    arm_relobj, shndx,
-							    address + i,
-							    target, insn);
-		  Stub_table<big_endian>* stub_table =
-		    arm_relobj->stub_table(shndx);
-		  gold_assert(stub_table != NULL);
-		  stub_table->add_cortex_a8_stub(address + i, stub);
-		}
-	    }
+      stub_type = (is_blx
+		   ? arm_stub_a8_veneer_blx
+		   : (is_bl
+		      ? arm_stub_a8_veneer_bl
+		      : arm_stub_a8_veneer_b));
+    }
+
+  if (stub_type != arm_stub_none)
+    {
+      Arm_address pc_for_insn = address + i + 4;
+
+      // The original instruction is a BL, but the target is
+      // an ARM instruction.  If we were not making a stub,
+      // the BL would have been converted to a BLX.  Use the
+      // BLX stub instead in that case.
+      if (this->may_use_v5t_interworking() && force_target_arm
+	  && stub_type == arm_stub_a8_veneer_bl)
+	{
+	  stub_type = arm_stub_a8_veneer_blx;
+	  is_blx = true;
+	  is_bl = false;
+	}
+      // Conversely, if the original instruction was
+      // BLX but the target is Thumb mode, use the BL stub.
+      else if (force_target_thumb
+	       && stub_type == arm_stub_a8_veneer_blx)
+	{
+	  stub_type = arm_stub_a8_veneer_bl;
+	  is_blx = false;
+	  is_bl = true;
 	}
 
-      i += insn_32bit ? 4 : 2;
-      last_was_32bit = insn_32bit;
-      last_was_branch = is_32bit_branch;
+      if (is_blx)
+	pc_for_insn &= ~3;
+
+      // If we found a relocation, use the proper destination,
+      // not the offset in the (unrelocated) instruction.
+      // Note this is always done if we switched the stub type above.
+      if (cortex_a8_reloc != NULL)
+	offset = (off_t) (cortex_a8_reloc->destination() - pc_for_insn);
+
+      Arm_address target = (pc_for_insn + offset) | (is_blx ? 0 : 1);
+
+      // Add a new stub if destination address in in the same page.
+      if (((address + i) & ~0xfffU) == (target & ~0xfffU))
+	{
+	  Cortex_a8_stub* stub =
+	    this->stub_factory_.make_cortex_a8_stub(stub_type,
+						    arm_relobj, shndx,
+						    address + i,
+						    target, insn);
+	  Stub_table<big_endian>* stub_table =
+	    arm_relobj->stub_table(shndx);
+	  gold_assert(stub_table != NULL);
+	  stub_table->add_cortex_a8_stub(address + i, stub);
+	}
     }
 }
 
@@ -28,8 +28,10 @@
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <unistd.h>
 
 #include <vector>
+#include <map>
 #include <algorithm>
 
 #include "getopt.h"
@@ -45,6 +47,8 @@
 #include "compressed_output.h"
 #include "stringpool.h"
 #include "dwarf_reader.h"
+#include "int_encoding.h"
+#include "workqueue.h"
 
 static void
 usage(FILE* fd, int) ATTRIBUTE_NORETURN;
@@ -91,29 +95,99 @@ struct Unit_set
   { }
 };
 
+// A compilation unit or type unit found while reading an input file.
+
+struct Dwo_unit
+{
+  // The section index of the .debug_info.dwo or .debug_types.dwo section.
+  unsigned int shndx;
+  // The offset and length of the unit within that section.
+  section_offset_type offset;
+  section_size_type length;
+  // The DWO id for a compilation unit, or the type signature for
+  // a type unit.
+  uint64_t signature;
+};
+
+typedef std::vector<Dwo_unit> Dwo_unit_list;
+
 // An input file.
 // This class may represent a .dwo file, a .dwp file
 // produced by an earlier run, or an executable file whose
 // debug section identifies a set of .dwo files to read.
+// Reading a .dwo or .dwp file happens in two steps: read() maps the
+// file and parses its units, and may run in parallel with other
+// input files; add_to_output() then adds the contents to the output
+// file, and must be called for each input file in order.
 
 class Dwo_file
 {
  public:
   Dwo_file(const char* name)
-    : name_(name), obj_(NULL), input_file_(NULL), is_compressed_(),
-      sect_offsets_(), str_offset_map_()
-  { }
+    : name_(name), obj_(NULL), input_file_(NULL), machine_(0), osabi_(0),
+      abiversion_(0), is_compressed_(), sect_offsets_(), str_offset_map_(),
+      debug_types_(), debug_str_(0), debug_cu_index_(0), debug_tu_index_(0),
+      contents_(), units_(), remaps_(), is_update_package_(false),
+      live_cus_(NULL), range_map_()
+  {
+    for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+      this->debug_shndx_[i] = 0;
+  }
 
   ~Dwo_file();
 
+  // Return the filename.
+  const char*
+  name() const
+  { return this->name_; }
+
+  // Note that this is an existing .dwp file being updated.  Any CU in
+  // this file with the same DWO id as a CU from an earlier input file
+  // is replaced by that CU, and only the contributions used by the
+  // remaining units are copied to the output file.  Without an
+  // executable, a CU with the same DW_AT_name and DW_AT_comp_dir as a
+  // CU from an earlier input file is replaced as well.
+  void
+  set_update_package()
+  { this->is_update_package_ = true; }
+
   // Read the input executable file and extract the list of .dwo files
-  // that it references.
+  // that it references.  If DWO_IDS is not NULL, also extract the
+  // DWO id of each of those files.
+  void
+  read_executable(File_list* files, std::vector<uint64_t>* dwo_ids);
+
+  // Set the DWO ids of the CUs that are still used, when updating
+  // a .dwp file for an executable.  Other CUs in the .dwp file are
+  // dropped.
   void
-  read_executable(File_list* files);
+  set_live_cus(const Unordered_set<uint64_t>* live_cus)
+  { this->live_cus_ = live_cus; }
+
+  // Return TRUE if the CU index of this .dwp file has DWO_ID.
+  bool
+  has_cu(uint64_t dwo_id);
 
-  // Read the input file and send its contents to OUTPUT_FILE.
+  // Read the input file on behalf of TASK, collecting the string table
+  // and the list of units.  The file is unlocked on return, but the
+  // section contents remain mapped until the Dwo_file is deleted.
   void
-  read(Dwp_output_file* output_file);
+  read(const Task* task);
+
+  // Send the contents of the input file to OUTPUT_FILE.
+  void
+  add_to_output(Dwp_output_file* output_file);
+
+  // Return true if there are .debug_str_offsets.dwo contributions
+  // waiting for remap_str_offsets().
+  bool
+  has_str_offsets() const
+  { return !this->remaps_.empty(); }
+
+  // Fill in the .debug_str_offsets.dwo contributions added by
+  // add_to_output(), using offsets in the output string table.
+  void
+  remap_str_offsets();
 
  private:
   // Types for mapping input string offsets to output string offsets.
@@ -130,16 +204,38 @@ class Dwo_file
     { return i1.first < i2.first; }
   };
 
+  // The contents of an input section.
+  struct Section_contents
+  {
+    const unsigned char* contents;
+    section_size_type len;
+    // True if CONTENTS was allocated by new[], and must be deleted.
+    bool is_new;
+
+    Section_contents()
+      : contents(NULL), len(0), is_new(false)
+    { }
+  };
+
+  // A .debug_str_offsets.dwo section to be remapped into BUF.
+  struct Str_offsets_remap
+  {
+    const unsigned char* contents;
+    section_size_type len;
+    unsigned char* buf;
+  };
+
+  typedef std::vector<unsigned int> Types_list;
+
   // Create a Sized_relobj_dwo of the given size and endianness,
-  // and record the target info.  P is a pointer to the ELF header
-  // in memory.
+  // and record the target info.  If TASK is not NULL, the input
+  // file is locked by TASK.
   Relobj*
-  make_object(Dwp_output_file* output_file);
+  make_object(const Task* task);
 
   template <int size, bool big_endian>
   Relobj*
-  sized_make_object(const unsigned char* p, Input_file* input_file,
-		    Dwp_output_file* output_file);
+  sized_make_object(const unsigned char* p, Input_file* input_file);
 
   // Return the number of sections in the input object file.
   unsigned int
@@ -157,49 +253,93 @@ class Dwo_file
   { return this->obj_->section_name(shndx); }
 
   // Return a view of the contents of a section, decompressed if necessary.
-  // Set *PLEN to the size.  Set *IS_NEW to true if the contents need to be
-  // deleted by the caller.
+  // Set *PLEN to the size.  The contents are read once, and remain
+  // valid until the Dwo_file is deleted.
   const unsigned char*
-  section_contents(unsigned int shndx, section_size_type* plen, bool* is_new)
-  { return this->obj_->decompressed_section_contents(shndx, plen, is_new); }
+  section_contents(unsigned int shndx, section_size_type* plen);
 
   // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
   // and process the CU or TU sets.
   void
-  read_unit_index(unsigned int, unsigned int *, Dwp_output_file*,
-		  bool is_tu_index);
+  read_unit_index(unsigned int, Dwp_output_file*, bool is_tu_index);
+
+  // Look up DWO_ID in the hash table of the .debug_cu_index section.
+  template <bool big_endian>
+  bool
+  sized_has_cu(uint64_t dwo_id);
+
+  template <bool big_endian>
+  void
+  sized_read_unit_index(unsigned int, Dwp_output_file*, bool is_tu_index);
+
+  // Return the name of the compilation unit at INFO, for matching
+  // CUs when updating a .dwp file without an executable.
+  std::string
+  cu_name(const unsigned char* info, section_size_type info_len,
+	  const unsigned char* abbrevs, section_size_type abbrevs_len,
+	  const unsigned char* str_offsets, section_size_type str_offsets_len);
 
   template <bool big_endian>
+  std::string
+  sized_cu_name(const unsigned char* info, section_size_type info_len,
+		const unsigned char* abbrevs, section_size_type abbrevs_len,
+		const unsigned char* str_offsets,
+		section_size_type str_offsets_len);
+
+  // Return the name of the CU described by a row of a .debug_cu_index
+  // section, given the column headers and the row of offsets and sizes.
+  template <bool big_endian>
+  std::string
+  unit_set_cu_name(const unsigned char* pcolhdrs, unsigned int ncols,
+		   const unsigned char* porow, const unsigned char* psrow);
+
+  // Return the string at OFFSET in the .debug_str.dwo section, or
+  // NULL if OFFSET is out of range.
+  const char*
+  debug_str(section_offset_type offset);
+
+  // Collect the offsets of the strings in the input string table.
   void
-  sized_read_unit_index(unsigned int, unsigned int *, Dwp_output_file*,
-			bool is_tu_index);
+  scan_strings();
 
   // Merge the input string table section into the output file.
   void
-  add_strings(Dwp_output_file*, unsigned int);
+  add_strings(Dwp_output_file*);
 
   // Copy a section from the input file to the output file.
   Section_bounds
   copy_section(Dwp_output_file* output_file, unsigned int shndx,
 	       elfcpp::DW_SECT section_id);
 
+  // Copy a single contribution from a section of a .dwp file being
+  // updated to the output file.
+  section_offset_type
+  copy_contribution(Dwp_output_file* output_file, elfcpp::DW_SECT section_id,
+		    section_offset_type offset, section_size_type len);
+
+  // Add CONTENTS to the output file, remapping string offsets if needed.
+  section_offset_type
+  add_contribution(Dwp_output_file* output_file, elfcpp::DW_SECT section_id,
+		   const unsigned char* contents, section_size_type len);
+
   // Remap the string offsets in the .debug_str_offsets.dwo section.
-  const unsigned char*
-  remap_str_offsets(const unsigned char* contents, section_size_type len);
+  void
+  remap_str_offsets(const Str_offsets_remap&);
 
   template <bool big_endian>
-  const unsigned char*
-  sized_remap_str_offsets(const unsigned char* contents, section_size_type len);
+  void
+  sized_remap_str_offsets(const unsigned char* contents, section_size_type len,
+			  unsigned char* buf);
 
   // Remap a single string offsets from an offset in the input string table
   // to an offset in the output string table.
   unsigned int
   remap_str_offset(section_offset_type val);
 
-  // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-  // to OUTPUT_FILE.
+  // Add the .debug_info.dwo or .debug_types.dwo section SHNDX and related
+  // sections to OUTPUT_FILE.
   void
-  add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
+  add_unit_set(Dwp_output_file* output_file, unsigned int shndx,
 	       bool is_debug_types);
 
   // The filename.
@@ -208,12 +348,43 @@ class Dwo_file
   Relobj* obj_;
   // The Input_file object.
   Input_file* input_file_;
+  // ELF header parameters.
+  int machine_;
+  int osabi_;
+  int abiversion_;
   // Flags indicating which sections are compressed.
   std::vector<bool> is_compressed_;
   // Map input section index onto output section offset and size.
   std::vector<Section_bounds> sect_offsets_;
   // Map input string offsets to output string offsets.
   Str_offset_map str_offset_map_;
+  // Section indexes of the debug sections, indexed by DW_SECT.
+  unsigned int debug_shndx_[elfcpp::DW_SECT_MAX + 1];
+  // Section indexes of the .debug_types.dwo sections.
+  Types_list debug_types_;
+  // Section index of the .debug_str.dwo section.
+  unsigned int debug_str_;
+  // Section indexes of the .debug_cu_index and .debug_tu_index sections.
+  unsigned int debug_cu_index_;
+  unsigned int debug_tu_index_;
+  // Section contents, indexed by section index.
+  std::vector<Section_contents> contents_;
+  // The units in the .debug_info.dwo and .debug_types.dwo sections.
+  Dwo_unit_list units_;
+  // The .debug_str_offsets.dwo sections waiting to be remapped.
+  std::vector<Str_offsets_remap> remaps_;
+  // True if this is an existing .dwp file being updated.
+  bool is_update_package_;
+  // When updating a .dwp file for an executable, the DWO ids of
+  // the CUs still used by the executable.
+  const Unordered_set<uint64_t>* live_cus_;
+  // When updating a .dwp file, map each contribution in the input file,
+  // identified by its section, offset, and size, to its offset in the
+  // output file, so that contributions shared by several units are
+  // only copied once.
+  typedef std::pair<section_offset_type, section_size_type> Range;
+  typedef std::map<std::pair<int, Range>, section_offset_type> Range_map;
+  Range_map range_map_;
 };
 
 // An ELF input file.
@@ -436,12 +607,26 @@ class Dwp_output_file
       abiversion_(0), fd_(NULL), next_file_offset_(0), shnum_(1), sections_(),
       section_id_map_(), shoff_(0), shstrndx_(0), have_strings_(false),
       stringpool_(), shstrtab_(), cu_index_(), tu_index_(), last_type_sig_(0),
-      last_tu_slot_(0)
+      last_tu_slot_(0), streaming_(false), record_cu_names_(false),
+      cu_names_()
   {
     this->section_id_map_.resize(elfcpp::DW_SECT_MAX + 1);
     this->stringpool_.set_no_zero_null();
   }
 
+  // Write each contribution as soon as it is added, instead of saving
+  // it until finalize().
+  void
+  set_streaming()
+  { this->streaming_ = true; }
+
+  // Return true if contributions are written as soon as they are added.
+  // In that case, the caller may free the contents as soon as
+  // add_contribution() returns.
+  bool
+  is_streaming() const
+  { return this->streaming_; }
+
   // Record the target info from an input file.
   void
   record_target_info(const char* name, int machine, int size, bool big_endian,
@@ -452,6 +637,7 @@ class Dwp_output_file
   add_string(const char* str, size_t len);
 
   // Add a section to the output file, and return the new section offset.
+  // CONTENTS must remain valid until the file is finalized.
   section_offset_type
   add_contribution(elfcpp::DW_SECT section_id, const unsigned char* contents,
 		   section_size_type len, int align);
@@ -460,6 +646,32 @@ class Dwp_output_file
   void
   add_cu_set(Unit_set* cu_set);
 
+  // Lookup a DWO id and return TRUE if we have already seen it.
+  bool
+  lookup_cu(uint64_t dwo_id);
+
+  // Record the name of each CU added from a .dwo file, so that a .dwp
+  // file being updated without an executable can drop the CUs that
+  // the .dwo files replace.
+  void
+  set_record_cu_names()
+  { this->record_cu_names_ = true; }
+
+  // Return true if we record the names of the CUs.
+  bool
+  record_cu_names() const
+  { return this->record_cu_names_; }
+
+  // Record the name of a CU added from a .dwo file.
+  void
+  add_cu_name(const std::string& name)
+  { this->cu_names_.insert(name); }
+
+  // Return true if a CU named NAME was added from a .dwo file.
+  bool
+  lookup_cu_name(const std::string& name) const
+  { return this->cu_names_.find(name) != this->cu_names_.end(); }
+
   // Lookup a type signature and return TRUE if we have already seen it.
   bool
   lookup_tu(uint64_t type_sig);
@@ -474,7 +686,8 @@ class Dwp_output_file
   finalize();
 
  private:
-  // Contributions to output sections.
+  // Contributions to output sections.  The contents are owned by
+  // the input file.
   struct Contribution
   {
     section_offset_type output_offset;
@@ -490,9 +703,12 @@ class Dwp_output_file
     section_size_type size;
     int align;
     std::vector<Contribution> contributions;
+    // When streaming, the contributions are written to a temporary
+    // file, and copied to the output file by finalize().
+    FILE* tmp_fd;
 
     Section(const char* n, int a)
-      : name(n), offset(0), size(0), align(a), contributions()
+      : name(n), offset(0), size(0), align(a), contributions(), tmp_fd(NULL)
     { }
   };
 
@@ -661,6 +877,12 @@ class Dwp_output_file
   uint64_t last_type_sig_;
   // Cache of the slot index for the last type signature.
   unsigned int last_tu_slot_;
+  // True if contributions are written as soon as they are added.
+  bool streaming_;
+  // True if we record the names of the CUs added from .dwo files.
+  bool record_cu_names_;
+  // The names of the CUs added from .dwo files.
+  Unordered_set<std::string> cu_names_;
 };
 
 // A specialization of Dwarf_info_reader, for reading dwo_names from
@@ -671,7 +893,7 @@ class Dwo_name_info_reader : public Dwarf_info_reader
  public:
   Dwo_name_info_reader(Relobj* object, unsigned int shndx)
     : Dwarf_info_reader(false, object, NULL, 0, shndx, 0, 0),
-      files_(NULL)
+      files_(NULL), dwo_ids_(NULL)
   { }
 
   ~Dwo_name_info_reader()
@@ -685,6 +907,14 @@ class Dwo_name_info_reader : public Dwarf_info_reader
     this->parse();
   }
 
+  // Get the dwo_names and the matching DWO ids.
+  void
+  get_dwo_names(File_list* files, std::vector<uint64_t>* dwo_ids)
+  {
+    this->dwo_ids_ = dwo_ids;
+    this->get_dwo_names(files);
+  }
+
  protected:
   // Visit a compilation unit.
   virtual void
@@ -693,25 +923,27 @@ class Dwo_name_info_reader : public Dwarf_info_reader
  private:
   // The list of files to populate.
   File_list* files_;
+  // The list of DWO ids to populate, if not NULL.
+  std::vector<uint64_t>* dwo_ids_;
 };
 
 // A specialization of Dwarf_info_reader, for reading DWARF CUs and TUs
-// and adding them to the output file.
+// and collecting the list of units in an input file.
 
 class Unit_reader : public Dwarf_info_reader
 {
  public:
   Unit_reader(bool is_type_unit, Relobj* object, unsigned int shndx)
     : Dwarf_info_reader(is_type_unit, object, NULL, 0, shndx, 0, 0),
-      output_file_(NULL), sections_(NULL)
+      shndx_(shndx), units_(NULL)
   { }
 
   ~Unit_reader()
   { }
 
-  // Read the CUs or TUs and add them to the output file.
+  // Read the CUs or TUs and add them to UNITS.
   void
-  add_units(Dwp_output_file*, unsigned int debug_abbrev, Section_bounds*);
+  read_units(unsigned int debug_abbrev, Dwo_unit_list* units);
 
  protected:
   // Visit a compilation unit.
@@ -724,8 +956,135 @@ class Unit_reader : public Dwarf_info_reader
 		  uint64_t signature, Dwarf_die*);
 
  private:
+  // Record a unit.
+  void
+  add_unit(off_t offset, off_t length, uint64_t signature);
+
+  unsigned int shndx_;
+  Dwo_unit_list* units_;
+};
+
+// A task to read an input file.  The tasks for all of the input files
+// may run in parallel.  When streaming, START_BLOCKER limits how far
+// reading may get ahead of adding the files to the output file.
+
+class Dwo_read_task : public Task
+{
+ public:
+  Dwo_read_task(Dwo_file* dwo_file, Task_token* start_blocker,
+		Task_token* next_blocker)
+    : dwo_file_(dwo_file), start_blocker_(start_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Dwo_read_task()
+  {
+    if (this->start_blocker_ != NULL)
+      delete this->start_blocker_;
+  }
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->start_blocker_ != NULL && this->start_blocker_->is_blocked())
+      return this->start_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->dwo_file_->read(this); }
+
+  std::string
+  get_name() const
+  { return std::string("Dwo_read_task ") + this->dwo_file_->name(); }
+
+ private:
+  Dwo_file* dwo_file_;
+  Task_token* start_blocker_;
+  Task_token* next_blocker_;
+};
+
+// A task to add the contents of an input file to the output file.
+// These tasks run one at a time, in the order of the input files, so
+// that the output file does not depend on the order in which the
+// input files were read.  When the output file is streaming, nothing
+// refers to the input file afterward, so we delete it.
+
+class Dwo_add_task : public Task
+{
+ public:
+  Dwo_add_task(Dwo_file* dwo_file, Dwp_output_file* output_file,
+	       bool verbose, Task_token* read_blocker,
+	       Task_token* this_blocker, Task_token* next_blocker,
+	       Task_token* done_blocker)
+    : dwo_file_(dwo_file), output_file_(output_file), verbose_(verbose),
+      read_blocker_(read_blocker), this_blocker_(this_blocker),
+      next_blocker_(next_blocker), done_blocker_(done_blocker)
+  { }
+
+  ~Dwo_add_task();
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return std::string("Dwo_add_task ") + this->dwo_file_->name(); }
+
+ private:
+  Dwo_file* dwo_file_;
   Dwp_output_file* output_file_;
-  Section_bounds* sections_;
+  bool verbose_;
+  // Blocker for the Dwo_read_task for this file.
+  Task_token* read_blocker_;
+  // Blocker for the Dwo_add_task for the previous file, or NULL.
+  Task_token* this_blocker_;
+  // Blocker for the Dwo_add_task for the next file, or NULL.
+  Task_token* next_blocker_;
+  // Blocker for a later Dwo_read_task when streaming, or NULL.
+  Task_token* done_blocker_;
+};
+
+// A task to remap the .debug_str_offsets.dwo sections of an input file
+// once its strings have been added to the output string table.  This
+// may run in parallel with adding later input files.
+
+class Dwo_remap_task : public Task
+{
+ public:
+  Dwo_remap_task(Dwo_file* dwo_file)
+    : dwo_file_(dwo_file)
+  { }
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*)
+  { this->dwo_file_->remap_str_offsets(); }
+
+  std::string
+  get_name() const
+  { return std::string("Dwo_remap_task ") + this->dwo_file_->name(); }
+
+ private:
+  Dwo_file* dwo_file_;
 };
 
 // Return the name of a DWARF .dwo section.
@@ -783,7 +1142,8 @@ Sized_relobj_dwo<size, big_endian>::do_section_contents(
 
 // Return a view of the uncompressed contents of a section.  Set *PLEN
 // to the size.  Set *IS_NEW to true if the contents need to be deleted
-// by the caller.
+// by the caller.  The view is cached, so that it remains mapped after
+// the file is unlocked.
 
 template <int size, bool big_endian>
 const unsigned char*
@@ -794,7 +1154,7 @@ Sized_relobj_dwo<size, big_endian>::do_decompressed_section_contents(
 {
   section_size_type buffer_size;
   const unsigned char* buffer = this->do_section_contents(shndx, &buffer_size,
-							  false);
+							  true);
 
   std::string sect_name = this->do_section_name(shndx);
   if (!is_prefix_of(".zdebug_", sect_name.c_str()))
@@ -822,6 +1182,11 @@ Sized_relobj_dwo<size, big_endian>::do_decompressed_section_contents(
 
 Dwo_file::~Dwo_file()
 {
+  for (unsigned int i = 0; i < this->contents_.size(); ++i)
+    if (this->contents_[i].is_new)
+      delete[] this->contents_[i].contents;
+  for (unsigned int i = 0; i < this->remaps_.size(); ++i)
+    delete[] this->remaps_[i].buf;
   if (this->obj_ != NULL)
     delete this->obj_;
   if (this->input_file_ != NULL)
@@ -832,7 +1197,7 @@ Dwo_file::~Dwo_file()
 // that it references.
 
 void
-Dwo_file::read_executable(File_list* files)
+Dwo_file::read_executable(File_list* files, std::vector<uint64_t>* dwo_ids)
 {
   this->obj_ = this->make_object(NULL);
 
@@ -870,29 +1235,32 @@ Dwo_file::read_executable(File_list* files)
     {
       Dwo_name_info_reader dwarf_reader(this->obj_, debug_info);
       dwarf_reader.set_abbrev_shndx(debug_abbrev);
-      dwarf_reader.get_dwo_names(files);
+      if (dwo_ids != NULL)
+	dwarf_reader.get_dwo_names(files, dwo_ids);
+      else
+	dwarf_reader.get_dwo_names(files);
     }
 }
 
-// Read the input file and send its contents to OUTPUT_FILE.
+// Read the input file on behalf of TASK.  We find the debug sections,
+// read their contents, collect the offsets of the strings in the
+// string table, and parse the CUs and TUs.  Nothing is sent to the
+// output file until add_to_output() is called.
 
 void
-Dwo_file::read(Dwp_output_file* output_file)
+Dwo_file::read(const Task* task)
 {
-  this->obj_ = this->make_object(output_file);
+  // A .dwp file being updated for an executable is read before
+  // the other input files, to see which .dwo files have changed.
+  if (this->obj_ != NULL)
+    return;
+
+  this->obj_ = this->make_object(task);
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
   this->sect_offsets_.resize(shnum);
-
-  typedef std::vector<unsigned int> Types_list;
-  Types_list debug_types;
-  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
-  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
-    debug_shndx[i] = 0;
-  unsigned int debug_str = 0;
-  unsigned int debug_cu_index = 0;
-  unsigned int debug_tu_index = 0;
+  this->contents_.resize(shnum);
 
   // Scan the section table and collect debug sections.
   // (Section index 0 is a dummy section; skip it.)
@@ -912,75 +1280,147 @@ Dwo_file::read(Dwp_output_file* output_file)
       else
 	continue;
       if (strcmp(suffix, "info.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_INFO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_INFO] = i;
       else if (strcmp(suffix, "types.dwo") == 0)
-	debug_types.push_back(i);
+	this->debug_types_.push_back(i);
       else if (strcmp(suffix, "abbrev.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_ABBREV] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_ABBREV] = i;
       else if (strcmp(suffix, "line.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_LINE] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_LINE] = i;
       else if (strcmp(suffix, "loc.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_LOC] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_LOC] = i;
       else if (strcmp(suffix, "str.dwo") == 0)
-	debug_str = i;
+	this->debug_str_ = i;
       else if (strcmp(suffix, "str_offsets.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_STR_OFFSETS] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_STR_OFFSETS] = i;
       else if (strcmp(suffix, "macinfo.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_MACINFO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_MACINFO] = i;
       else if (strcmp(suffix, "macro.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_MACRO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_MACRO] = i;
       else if (strcmp(suffix, "cu_index") == 0)
-	debug_cu_index = i;
+	this->debug_cu_index_ = i;
       else if (strcmp(suffix, "tu_index") == 0)
-	debug_tu_index = i;
+	this->debug_tu_index_ = i;
     }
 
-  // Merge the input string table into the output string table.
-  this->add_strings(output_file, debug_str);
+  // Read the contents of every section we will send to the output
+  // file.  The views are cached, so they stay mapped after we unlock
+  // the file below, and the output file can write them directly.
+  section_size_type len;
+  for (unsigned int i = 1; i <= elfcpp::DW_SECT_MAX; ++i)
+    if (this->debug_shndx_[i] > 0)
+      this->section_contents(this->debug_shndx_[i], &len);
+  for (Types_list::const_iterator tp = this->debug_types_.begin();
+       tp != this->debug_types_.end();
+       ++tp)
+    this->section_contents(*tp, &len);
 
-  // If we found any .dwp index sections, read those and add the section
-  // sets to the output file.
-  if (debug_cu_index > 0 || debug_tu_index > 0)
+  this->scan_strings();
+
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
     {
-      if (debug_cu_index > 0)
-	this->read_unit_index(debug_cu_index, debug_shndx, output_file, false);
-      if (debug_tu_index > 0)
-        {
-	  if (debug_types.size() != 1)
+      // This is a .dwp file; we will use its index sections when
+      // adding it to the output file.
+      if (this->debug_cu_index_ > 0)
+	this->section_contents(this->debug_cu_index_, &len);
+      if (this->debug_tu_index_ > 0)
+	{
+	  if (this->debug_types_.size() != 1)
 	    gold_fatal(_("%s: .dwp file must have exactly one "
 			 ".debug_types.dwo section"), this->name_);
-	  debug_shndx[elfcpp::DW_SECT_TYPES] = debug_types[0];
-	  this->read_unit_index(debug_tu_index, debug_shndx, output_file, true);
+	  this->section_contents(this->debug_tu_index_, &len);
 	}
+    }
+  else
+    {
+      // If we found no index sections, this is a .dwo file.
+      // Parse the .debug_info.dwo and .debug_types.dwo sections
+      // to find the CUs and TUs.
+      unsigned int debug_abbrev = this->debug_shndx_[elfcpp::DW_SECT_ABBREV];
+      unsigned int debug_info = this->debug_shndx_[elfcpp::DW_SECT_INFO];
+      if ((debug_info > 0 || !this->debug_types_.empty()) && debug_abbrev == 0)
+	gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
+      if (debug_info > 0)
+	{
+	  Unit_reader reader(false, this->obj_, debug_info);
+	  reader.read_units(debug_abbrev, &this->units_);
+	}
+      for (Types_list::const_iterator tp = this->debug_types_.begin();
+	   tp != this->debug_types_.end();
+	   ++tp)
+	{
+	  Unit_reader reader(true, this->obj_, *tp);
+	  reader.read_units(debug_abbrev, &this->units_);
+	}
+    }
+
+  // We are done reading the file, so unlock it.  This lets the
+  // descriptor be closed if we run short of file descriptors.
+  if (task != NULL)
+    this->input_file_->file().unlock(task);
+}
+
+// Send the contents of the input file to OUTPUT_FILE.
+
+void
+Dwo_file::add_to_output(Dwp_output_file* output_file)
+{
+  output_file->record_target_info(this->name_, this->machine_,
+				  this->obj_->elfsize(),
+				  this->obj_->is_big_endian(),
+				  this->osabi_, this->abiversion_);
+
+  // Merge the input string table into the output string table.
+  this->add_strings(output_file);
+
+  // If we found any .dwp index sections, read those and add the section
+  // sets to the output file.
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
+    {
+      if (this->debug_cu_index_ > 0)
+	this->read_unit_index(this->debug_cu_index_, output_file, false);
+      if (this->debug_tu_index_ > 0)
+	this->read_unit_index(this->debug_tu_index_, output_file, true);
       return;
     }
 
   // If we found no index sections, this is a .dwo file.
-  if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
-    this->add_unit_set(output_file, debug_shndx, false);
+  if (this->debug_shndx_[elfcpp::DW_SECT_INFO] > 0)
+    this->add_unit_set(output_file, this->debug_shndx_[elfcpp::DW_SECT_INFO],
+		       false);
 
-  debug_shndx[elfcpp::DW_SECT_INFO] = 0;
-  for (Types_list::const_iterator tp = debug_types.begin();
-       tp != debug_types.end();
+  for (Types_list::const_iterator tp = this->debug_types_.begin();
+       tp != this->debug_types_.end();
        ++tp)
-    {
-      debug_shndx[elfcpp::DW_SECT_TYPES] = *tp;
-      this->add_unit_set(output_file, debug_shndx, true);
-    }
+    this->add_unit_set(output_file, *tp, true);
+}
+
+// Return a view of the contents of a section, decompressed if necessary.
+
+const unsigned char*
+Dwo_file::section_contents(unsigned int shndx, section_size_type* plen)
+{
+  gold_assert(shndx < this->contents_.size());
+  Section_contents& sc(this->contents_[shndx]);
+  if (sc.contents == NULL)
+    sc.contents = this->obj_->decompressed_section_contents(shndx, &sc.len,
+							    &sc.is_new);
+  *plen = sc.len;
+  return sc.contents;
 }
 
 // Create a Sized_relobj_dwo of the given size and endianness,
 // and record the target info.
 
 Relobj*
-Dwo_file::make_object(Dwp_output_file* output_file)
+Dwo_file::make_object(const Task* task)
 {
   // Open the input file.
   Input_file* input_file = new Input_file(this->name_);
   this->input_file_ = input_file;
   Dirsearch dirpath;
   int index;
-  if (!input_file->open(dirpath, NULL, &index))
+  if (!input_file->open(dirpath, task, &index))
     gold_fatal(_("%s: can't open"), this->name_);
   
   // Check that it's an ELF file.
@@ -994,8 +1434,7 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     gold_fatal(_("%s: not an ELF object file"), this->name_);
   
   // Get the size, endianness, machine, etc. info from the header,
-  // make an appropriately-sized Relobj, and pass the target info
-  // to the output object.
+  // and make an appropriately-sized Relobj.
   int size;
   bool big_endian;
   std::string error;
@@ -1007,15 +1446,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_32_BIG
-	return this->sized_make_object<32, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<32, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_32_LITTLE
-	return this->sized_make_object<32, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<32, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1024,15 +1461,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_64_BIG
-	return this->sized_make_object<64, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<64, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_64_LITTLE
-	return this->sized_make_object<64, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<64, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1046,18 +1481,15 @@ Dwo_file::make_object(Dwp_output_file* output_file)
 
 template <int size, bool big_endian>
 Relobj*
-Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
-			    Dwp_output_file* output_file)
+Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file)
 {
   elfcpp::Ehdr<size, big_endian> ehdr(p);
   Sized_relobj_dwo<size, big_endian>* obj =
       new Sized_relobj_dwo<size, big_endian>(this->name_, input_file, ehdr);
   obj->setup();
-  if (output_file != NULL)
-    output_file->record_target_info(
-	this->name_, ehdr.get_e_machine(), size, big_endian,
-	ehdr.get_e_ident()[elfcpp::EI_OSABI],
-	ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
+  this->machine_ = ehdr.get_e_machine();
+  this->osabi_ = ehdr.get_e_ident()[elfcpp::EI_OSABI];
+  this->abiversion_ = ehdr.get_e_ident()[elfcpp::EI_ABIVERSION];
   return obj;
 }
 
@@ -1065,35 +1497,389 @@ Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
 // and process the CU or TU sets.
 
 void
-Dwo_file::read_unit_index(unsigned int shndx, unsigned int *debug_shndx,
-			  Dwp_output_file* output_file, bool is_tu_index)
+Dwo_file::read_unit_index(unsigned int shndx, Dwp_output_file* output_file,
+			  bool is_tu_index)
 {
   if (this->obj_->is_big_endian())
-    this->sized_read_unit_index<true>(shndx, debug_shndx, output_file,
-				      is_tu_index);
+    this->sized_read_unit_index<true>(shndx, output_file, is_tu_index);
   else
-    this->sized_read_unit_index<false>(shndx, debug_shndx, output_file,
-				       is_tu_index);
+    this->sized_read_unit_index<false>(shndx, output_file, is_tu_index);
+}
+
+// Return TRUE if the CU index of this .dwp file has DWO_ID.
+
+bool
+Dwo_file::has_cu(uint64_t dwo_id)
+{
+  if (this->debug_cu_index_ == 0)
+    return false;
+  if (this->obj_->is_big_endian())
+    return this->sized_has_cu<true>(dwo_id);
+  else
+    return this->sized_has_cu<false>(dwo_id);
+}
+
+template <bool big_endian>
+bool
+Dwo_file::sized_has_cu(uint64_t dwo_id)
+{
+  section_size_type index_len;
+  const unsigned char* contents =
+      this->section_contents(this->debug_cu_index_, &index_len);
+  if (index_len < 4 * sizeof(uint32_t))
+    return false;
+
+  unsigned int nslots =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(contents
+						      + 3 * sizeof(uint32_t));
+  if (nslots == 0
+      || (nslots & (nslots - 1)) != 0
+      || (4 * sizeof(uint32_t) + nslots * (sizeof(uint64_t) + sizeof(uint32_t))
+	  > index_len))
+    return false;
+
+  // Probe the hash table the same way the output file builds it.
+  const unsigned char* phash = contents + 4 * sizeof(uint32_t);
+  const unsigned char* pindex = phash + nslots * sizeof(uint64_t);
+  unsigned int mask = nslots - 1;
+  unsigned int slot = static_cast<unsigned int>(dwo_id) & mask;
+  unsigned int step = (static_cast<unsigned int>(dwo_id >> 32) & mask) | 1;
+  for (unsigned int i = 0; i < nslots; ++i)
+    {
+      unsigned int index =
+	  elfcpp::Swap_unaligned<32, big_endian>::readval(pindex
+							  + slot
+							    * sizeof(uint32_t));
+      if (index == 0)
+	return false;
+      uint64_t signature =
+	  elfcpp::Swap_unaligned<64, big_endian>::readval(phash
+							  + slot
+							    * sizeof(uint64_t));
+      if (signature == dwo_id)
+	return true;
+      slot = (slot + step) & mask;
+    }
+  return false;
+}
+
+// Return the string at OFFSET in the .debug_str.dwo section, or NULL
+// if OFFSET is out of range or the string is not terminated.
+
+const char*
+Dwo_file::debug_str(section_offset_type offset)
+{
+  if (this->debug_str_ == 0)
+    return NULL;
+  section_size_type len;
+  const unsigned char* pdata = this->section_contents(this->debug_str_, &len);
+  if (offset < 0 || static_cast<section_size_type>(offset) >= len)
+    return NULL;
+  const char* p = reinterpret_cast<const char*>(pdata + offset);
+  if (memchr(p, '\0', len - offset) == NULL)
+    return NULL;
+  return p;
+}
+
+// Read an unsigned LEB128 value at *PP into *VALUE, and advance *PP
+// past it.  Return false if the value does not end before END.
+
+static bool
+read_bounded_uleb(const unsigned char** pp, const unsigned char* end,
+		  uint64_t* value)
+{
+  const unsigned char* p = *pp;
+  while (p < end && (*p & 0x80) != 0)
+    ++p;
+  if (p >= end)
+    return false;
+  size_t len;
+  *value = read_unsigned_LEB_128(*pp, &len);
+  *pp += len;
+  return true;
+}
+
+// Return the name of the compilation unit at INFO, made of its
+// DW_AT_name and DW_AT_comp_dir attributes.  ABBREVS and STR_OFFSETS
+// are the .debug_abbrev.dwo and .debug_str_offsets.dwo contributions
+// used by the unit.  Return an empty string if the unit has no name,
+// or if we can't read it.
+
+std::string
+Dwo_file::cu_name(const unsigned char* info, section_size_type info_len,
+		  const unsigned char* abbrevs, section_size_type abbrevs_len,
+		  const unsigned char* str_offsets,
+		  section_size_type str_offsets_len)
+{
+  if (this->obj_->is_big_endian())
+    return this->sized_cu_name<true>(info, info_len, abbrevs, abbrevs_len,
+				     str_offsets, str_offsets_len);
+  else
+    return this->sized_cu_name<false>(info, info_len, abbrevs, abbrevs_len,
+				      str_offsets, str_offsets_len);
+}
+
+template <bool big_endian>
+std::string
+Dwo_file::sized_cu_name(const unsigned char* info, section_size_type info_len,
+			const unsigned char* abbrevs,
+			section_size_type abbrevs_len,
+			const unsigned char* str_offsets,
+			section_size_type str_offsets_len)
+{
+  // We only need the attributes of the first DIE, so rather than
+  // setting up a Dwarf_info_reader, we read the unit header and walk
+  // the abbreviation by hand.  Dwarf_info_reader reads whole sections,
+  // with abbreviation offsets relative to the start of the section,
+  // but in a .dwp input the unit and its abbreviations are
+  // contributions within the sections.  Only 32-bit DWARF 2 to 4
+  // units are handled; anything else is never matched.  Every read is
+  // checked against the end of the unit or of the abbreviations, so a
+  // truncated unit simply has no name.
+  if (info_len < 11)
+    return std::string();
+  uint32_t unit_length =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(info);
+  unsigned int version =
+      elfcpp::Swap_unaligned<16, big_endian>::readval(info + 4);
+  uint32_t abbrev_offset =
+      elfcpp::Swap_unaligned<32, big_endian>::readval(info + 6);
+  unsigned int addr_size = info[10];
+  if (unit_length >= 0xfffffff0U
+      || unit_length < 7
+      || unit_length > info_len - 4
+      || version < 2
+      || version > 4
+      || abbrev_offset >= abbrevs_len)
+    return std::string();
+  const unsigned char* pinfo = info + 11;
+  const unsigned char* pinfo_end = info + 4 + unit_length;
+
+  uint64_t code;
+  if (!read_bounded_uleb(&pinfo, pinfo_end, &code) || code == 0)
+    return std::string();
+
+  // Find the abbreviation for the first DIE.
+  const unsigned char* pabbrev = abbrevs + abbrev_offset;
+  const unsigned char* pabbrev_end = abbrevs + abbrevs_len;
+  for (;;)
+    {
+      uint64_t abbrev_code;
+      uint64_t tag;
+      if (!read_bounded_uleb(&pabbrev, pabbrev_end, &abbrev_code)
+	  || abbrev_code == 0
+	  || !read_bounded_uleb(&pabbrev, pabbrev_end, &tag)
+	  || pabbrev >= pabbrev_end)
+	return std::string();
+      // Skip the children flag.
+      ++pabbrev;
+      if (abbrev_code == code)
+	break;
+      // Skip the attribute specifications.
+      for (;;)
+	{
+	  uint64_t attr;
+	  uint64_t form;
+	  if (!read_bounded_uleb(&pabbrev, pabbrev_end, &attr)
+	      || !read_bounded_uleb(&pabbrev, pabbrev_end, &form))
+	    return std::string();
+	  if (attr == 0 && form == 0)
+	    break;
+	}
+    }
+
+  const char* name = NULL;
+  const char* comp_dir = NULL;
+  for (;;)
+    {
+      uint64_t attr;
+      uint64_t form;
+      if (!read_bounded_uleb(&pabbrev, pabbrev_end, &attr)
+	  || !read_bounded_uleb(&pabbrev, pabbrev_end, &form))
+	return std::string();
+      if (attr == 0 && form == 0)
+	break;
+      while (form == elfcpp::DW_FORM_indirect)
+	if (!read_bounded_uleb(&pinfo, pinfo_end, &form))
+	  return std::string();
+
+      const char* str = NULL;
+      uint64_t value;
+      uint64_t skip = 0;
+      switch (form)
+	{
+	case elfcpp::DW_FORM_flag_present:
+	  break;
+	case elfcpp::DW_FORM_data1:
+	case elfcpp::DW_FORM_ref1:
+	case elfcpp::DW_FORM_flag:
+	  skip = 1;
+	  break;
+	case elfcpp::DW_FORM_data2:
+	case elfcpp::DW_FORM_ref2:
+	  skip = 2;
+	  break;
+	case elfcpp::DW_FORM_data4:
+	case elfcpp::DW_FORM_ref4:
+	case elfcpp::DW_FORM_sec_offset:
+	  skip = 4;
+	  break;
+	case elfcpp::DW_FORM_data8:
+	case elfcpp::DW_FORM_ref8:
+	case elfcpp::DW_FORM_ref_sig8:
+	  skip = 8;
+	  break;
+	case elfcpp::DW_FORM_addr:
+	  skip = addr_size;
+	  break;
+	case elfcpp::DW_FORM_ref_addr:
+	  skip = version == 2 ? addr_size : 4;
+	  break;
+	case elfcpp::DW_FORM_udata:
+	case elfcpp::DW_FORM_sdata:
+	case elfcpp::DW_FORM_ref_udata:
+	case elfcpp::DW_FORM_GNU_addr_index:
+	  if (!read_bounded_uleb(&pinfo, pinfo_end, &value))
+	    return std::string();
+	  break;
+	case elfcpp::DW_FORM_block1:
+	  if (pinfo_end - pinfo < 1)
+	    return std::string();
+	  skip = 1 + *pinfo;
+	  break;
+	case elfcpp::DW_FORM_block2:
+	  if (pinfo_end - pinfo < 2)
+	    return std::string();
+	  skip = 2 + elfcpp::Swap_unaligned<16, big_endian>::readval(pinfo);
+	  break;
+	case elfcpp::DW_FORM_block4:
+	  if (pinfo_end - pinfo < 4)
+	    return std::string();
+	  skip = 4 + elfcpp::Swap_unaligned<32, big_endian>::readval(pinfo);
+	  break;
+	case elfcpp::DW_FORM_block:
+	case elfcpp::DW_FORM_exprloc:
+	  if (!read_bounded_uleb(&pinfo, pinfo_end, &skip))
+	    return std::string();
+	  break;
+	case elfcpp::DW_FORM_string:
+	  {
+	    const void* pnul = memchr(pinfo, '\0', pinfo_end - pinfo);
+	    if (pnul == NULL)
+	      return std::string();
+	    str = reinterpret_cast<const char*>(pinfo);
+	    skip = static_cast<const unsigned char*>(pnul) - pinfo + 1;
+	  }
+	  break;
+	case elfcpp::DW_FORM_strp:
+	  if (pinfo_end - pinfo < 4)
+	    return std::string();
+	  str = this->debug_str(
+	      elfcpp::Swap_unaligned<32, big_endian>::readval(pinfo));
+	  skip = 4;
+	  break;
+	case elfcpp::DW_FORM_GNU_str_index:
+	  if (!read_bounded_uleb(&pinfo, pinfo_end, &value))
+	    return std::string();
+	  if (value < str_offsets_len / 4)
+	    str = this->debug_str(
+		elfcpp::Swap_unaligned<32, big_endian>::readval(
+		    str_offsets + value * 4));
+	  break;
+	default:
+	  return std::string();
+	}
+      if (skip > static_cast<uint64_t>(pinfo_end - pinfo))
+	return std::string();
+      pinfo += skip;
+
+      if (attr == elfcpp::DW_AT_name)
+	name = str;
+      else if (attr == elfcpp::DW_AT_comp_dir)
+	comp_dir = str;
+    }
+
+  if (name == NULL || *name == '\0')
+    return std::string();
+  std::string ret(name);
+  ret.push_back('\0');
+  if (comp_dir != NULL)
+    ret.append(comp_dir);
+  return ret;
+}
+
+// Return the name of the CU described by a row of a .debug_cu_index
+// section.  PCOLHDRS points to the NCOLS column headers, and POROW and
+// PSROW point to the offsets and sizes of the row.
+
+template <bool big_endian>
+std::string
+Dwo_file::unit_set_cu_name(const unsigned char* pcolhdrs, unsigned int ncols,
+			   const unsigned char* porow,
+			   const unsigned char* psrow)
+{
+  const unsigned char* contents[elfcpp::DW_SECT_MAX + 1];
+  section_size_type sizes[elfcpp::DW_SECT_MAX + 1];
+  for (int i = 0; i <= elfcpp::DW_SECT_MAX; ++i)
+    {
+      contents[i] = NULL;
+      sizes[i] = 0;
+    }
+
+  for (unsigned int j = 0; j < ncols; j++)
+    {
+      unsigned int dw_sect =
+	  elfcpp::Swap_unaligned<32, big_endian>::readval(pcolhdrs);
+      unsigned int offset =
+	  elfcpp::Swap_unaligned<32, big_endian>::readval(porow);
+      unsigned int size =
+	  elfcpp::Swap_unaligned<32, big_endian>::readval(psrow);
+      pcolhdrs += sizeof(uint32_t);
+      porow += sizeof(uint32_t);
+      psrow += sizeof(uint32_t);
+      if (dw_sect != elfcpp::DW_SECT_INFO
+	  && dw_sect != elfcpp::DW_SECT_ABBREV
+	  && dw_sect != elfcpp::DW_SECT_STR_OFFSETS)
+	continue;
+      if (this->debug_shndx_[dw_sect] == 0)
+	return std::string();
+      section_size_type len;
+      const unsigned char* p =
+	  this->section_contents(this->debug_shndx_[dw_sect], &len);
+      if (offset > len || size > len - offset)
+	return std::string();
+      contents[dw_sect] = p + offset;
+      sizes[dw_sect] = size;
+    }
+
+  if (contents[elfcpp::DW_SECT_INFO] == NULL
+      || contents[elfcpp::DW_SECT_ABBREV] == NULL)
+    return std::string();
+  return this->sized_cu_name<big_endian>(contents[elfcpp::DW_SECT_INFO],
+					 sizes[elfcpp::DW_SECT_INFO],
+					 contents[elfcpp::DW_SECT_ABBREV],
+					 sizes[elfcpp::DW_SECT_ABBREV],
+					 contents[elfcpp::DW_SECT_STR_OFFSETS],
+					 sizes[elfcpp::DW_SECT_STR_OFFSETS]);
 }
 
 template <bool big_endian>
 void
 Dwo_file::sized_read_unit_index(unsigned int shndx,
-				unsigned int *debug_shndx,
 				Dwp_output_file* output_file,
 				bool is_tu_index)
 {
   elfcpp::DW_SECT info_sect = (is_tu_index
 			       ? elfcpp::DW_SECT_TYPES
 			       : elfcpp::DW_SECT_INFO);
-  unsigned int info_shndx = debug_shndx[info_sect];
+  unsigned int info_shndx = (is_tu_index
+			     ? this->debug_types_[0]
+			     : this->debug_shndx_[elfcpp::DW_SECT_INFO]);
 
   gold_assert(shndx > 0 && info_shndx > 0);
 
   section_size_type index_len;
-  bool index_is_new;
-  const unsigned char* contents =
-      this->section_contents(shndx, &index_len, &index_is_new);
+  const unsigned char* contents = this->section_contents(shndx, &index_len);
 
   unsigned int version =
       elfcpp::Swap_unaligned<32, big_endian>::readval(contents);
@@ -1130,19 +1916,20 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 	       this->section_name(shndx).c_str());
 
   // Copy the related sections and track the section offsets and sizes.
+  // When updating a .dwp file, we copy only the contributions used by
+  // the units we keep, below.
   Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
   for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
     {
-      if (debug_shndx[i] > 0)
-	sections[i] = this->copy_section(output_file, debug_shndx[i],
+      if (this->debug_shndx_[i] > 0 && !this->is_update_package_)
+	sections[i] = this->copy_section(output_file, this->debug_shndx_[i],
 					 static_cast<elfcpp::DW_SECT>(i));
     }
 
   // Get the contents of the .debug_info.dwo or .debug_types.dwo section.
   section_size_type info_len;
-  bool info_is_new;
   const unsigned char* info_contents =
-      this->section_contents(info_shndx, &info_len, &info_is_new);
+      this->section_contents(info_shndx, &info_len);
 
   // Loop over the slots of the hash table.
   for (unsigned int i = 0; i < nslots; ++i)
@@ -1151,7 +1938,34 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
           elfcpp::Swap_unaligned<64, big_endian>::readval(phash);
       unsigned int index =
 	  elfcpp::Swap_unaligned<32, big_endian>::readval(pindex);
-      if (index != 0 && (!is_tu_index || !output_file->lookup_tu(signature)))
+      // When updating a .dwp file, a CU that we have already seen
+      // came from a .dwo file that has been rebuilt, and replaces
+      // the one in this file.
+      // A CU that the executable no longer uses is dropped.
+      bool skip = (index == 0
+		   || (is_tu_index
+		       ? output_file->lookup_tu(signature)
+		       : (this->is_update_package_
+			  && ((this->live_cus_ != NULL
+			       && (this->live_cus_->find(signature)
+				   == this->live_cus_->end()))
+			      || output_file->lookup_cu(signature)))));
+      // Without an executable, a rebuilt .dwo file usually has a new
+      // DWO id, so we also drop a CU with the same name as one of the
+      // CUs added from the .dwo files.
+      if (!skip
+	  && !is_tu_index
+	  && this->is_update_package_
+	  && output_file->record_cu_names())
+	skip = output_file->lookup_cu_name(
+	    this->unit_set_cu_name<big_endian>(pcolhdrs, ncols,
+					       (poffsets
+						+ ((index - 1) * ncols
+						   * sizeof(uint32_t))),
+					       (psizes
+						+ ((index - 1) * ncols
+						   * sizeof(uint32_t)))));
+      if (!skip)
 	{
 	  Unit_set* unit_set = new Unit_set();
 	  unit_set->signature = signature;
@@ -1163,35 +1977,45 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 
 	  // Adjust the offset of each contribution within the input section
 	  // by the offset of the input section within the output section.
-	  for (unsigned int j = 0; j <= ncols; j++)
+	  for (unsigned int j = 0; j < ncols; j++)
 	    {
 	      unsigned int dw_sect =
-		  elfcpp::Swap_unaligned<64, big_endian>::readval(pch);
+		  elfcpp::Swap_unaligned<32, big_endian>::readval(pch);
 	      unsigned int offset =
-		  elfcpp::Swap_unaligned<64, big_endian>::readval(porow);
+		  elfcpp::Swap_unaligned<32, big_endian>::readval(porow);
 	      unsigned int size =
-		  elfcpp::Swap_unaligned<64, big_endian>::readval(psrow);
-	      unit_set->sections[dw_sect].offset = (sections[dw_sect].offset
-						    + offset);
+		  elfcpp::Swap_unaligned<32, big_endian>::readval(psrow);
+	      if (dw_sect < elfcpp::DW_SECT_ABBREV
+		  || dw_sect > elfcpp::DW_SECT_MAX)
+		{
+		  if (dw_sect != info_sect)
+		    gold_fatal(_("%s: section %s is corrupt"), this->name_,
+			       this->section_name(shndx).c_str());
+		  unit_set->sections[dw_sect].offset = offset;
+		}
+	      else if (this->is_update_package_)
+		{
+		  if (this->debug_shndx_[dw_sect] == 0)
+		    gold_fatal(_("%s: section %s is corrupt"), this->name_,
+			       this->section_name(shndx).c_str());
+		  elfcpp::DW_SECT sect = static_cast<elfcpp::DW_SECT>(dw_sect);
+		  unit_set->sections[dw_sect].offset =
+		      this->copy_contribution(output_file, sect, offset, size);
+		}
+	      else
+		unit_set->sections[dw_sect].offset = (sections[dw_sect].offset
+						      + offset);
 	      unit_set->sections[dw_sect].size = size;
 	      pch += sizeof(uint32_t);
 	      porow += sizeof(uint32_t);
 	      psrow += sizeof(uint32_t);
 	    }
 
+	  // The section contents stay mapped until we are done
+	  // writing the output file, so there is no need to copy them.
 	  const unsigned char* unit_start =
 	      info_contents + unit_set->sections[info_sect].offset;
 	  section_size_type unit_length = unit_set->sections[info_sect].size;
-
-	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
-	  // section directly to the output file, so we only need to
-	  // duplicate contributions for .debug_types.dwo section.
-	  if (is_tu_index)
-	    {
-	      unsigned char *copy = new unsigned char[unit_length];
-	      memcpy(copy, unit_start, unit_length);
-	      unit_start = copy;
-	    }
 	  section_offset_type off =
 	      output_file->add_contribution(info_sect, unit_start,
 					    unit_length, 1);
@@ -1204,30 +2028,31 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
       phash += sizeof(uint64_t);
       pindex += sizeof(uint32_t);
     }
-
-  if (index_is_new)
-    delete[] contents;
-  if (info_is_new)
-    delete[] info_contents;
 }
 
-// Merge the input string table section into the output file.
+// Collect the offsets of the strings in the input string table.
+// The output offsets are filled in later by add_strings().
 
 void
-Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
+Dwo_file::scan_strings()
 {
+  if (this->debug_str_ == 0)
+    return;
+
   section_size_type len;
-  bool is_new;
-  const unsigned char* pdata = this->section_contents(debug_str, &len, &is_new);
+  const unsigned char* pdata = this->section_contents(this->debug_str_, &len);
   const char* p = reinterpret_cast<const char*>(pdata);
   const char* pend = p + len;
 
+  if (len == 0)
+    return;
+
   // Check that the last string is null terminated.
   if (pend[-1] != '\0')
     gold_fatal(_("%s: last entry in string section '%s' "
 		 "is not null terminated"),
 	       this->name_,
-	       this->section_name(debug_str).c_str());
+	       this->section_name(this->debug_str_).c_str());
 
   // Count the number of strings in the section, and size the map.
   size_t count = 0;
@@ -1235,28 +2060,38 @@ Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
     ++count;
   this->str_offset_map_.reserve(count + 1);
 
+  // Record the offset of each string, followed by the end of the section.
+  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
+    this->str_offset_map_.push_back(std::make_pair(pt - p, 0));
+  this->str_offset_map_.push_back(std::make_pair(pend - p, 0));
+}
+
+// Merge the input string table section into the output file.
+
+void
+Dwo_file::add_strings(Dwp_output_file* output_file)
+{
+  if (this->str_offset_map_.empty())
+    return;
+
+  section_size_type len;
+  const unsigned char* pdata = this->section_contents(this->debug_str_, &len);
+  const char* p = reinterpret_cast<const char*>(pdata);
+
   // Add the strings to the output string table, and record the new offsets
-  // in the map.
-  section_offset_type i = 0;
-  section_offset_type new_offset;
-  while (p < pend)
+  // in the map.  The last entry marks the end of the section.
+  size_t count = this->str_offset_map_.size() - 1;
+  for (size_t i = 0; i < count; ++i)
     {
-      size_t len = strlen(p);
-      new_offset = output_file->add_string(p, len);
-      this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-      p += len + 1;
-      i += len + 1;
+      Str_offset_map_entry& entry(this->str_offset_map_[i]);
+      size_t len = this->str_offset_map_[i + 1].first - entry.first - 1;
+      entry.second = output_file->add_string(p + entry.first, len);
     }
-  new_offset = 0;
-  this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-  if (is_new)
-    delete[] pdata;
 }
 
 // Copy a section from the input file to the output file.
 // Return the offset and length of this input section's contribution
-// in the output section.  If copying .debug_str_offsets.dwo, remap
-// the string offsets for the output string table.
+// in the output section.
 
 Section_bounds
 Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -1267,63 +2102,115 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   if (this->sect_offsets_[shndx].size > 0)
     return this->sect_offsets_[shndx];
 
-  // Get the section contents. Upon return, if IS_NEW is true, the memory
-  // has been allocated via new; if false, the memory is part of the mapped
-  // input file, and we will need to duplicate it so that it will persist
-  // after we close the input file.
   section_size_type len;
-  bool is_new;
-  const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
+  const unsigned char* contents = this->section_contents(shndx, &len);
+  section_offset_type off = this->add_contribution(output_file, section_id,
+						   contents, len);
+
+  // Store the output section bounds.
+  Section_bounds bounds(off, len);
+  this->sect_offsets_[shndx] = bounds;
+
+  return bounds;
+}
+
+// Copy a single contribution from a section of a .dwp file being
+// updated to the output file, and return its offset in the output
+// section.
 
+section_offset_type
+Dwo_file::copy_contribution(Dwp_output_file* output_file,
+			    elfcpp::DW_SECT section_id,
+			    section_offset_type offset, section_size_type len)
+{
+  std::pair<int, Range> key(section_id, Range(offset, len));
+  Range_map::const_iterator p = this->range_map_.find(key);
+  if (p != this->range_map_.end())
+    return p->second;
+
+  section_size_type sect_len;
+  const unsigned char* contents =
+      this->section_contents(this->debug_shndx_[section_id], &sect_len);
+  if (offset < 0
+      || static_cast<section_size_type>(offset) > sect_len
+      || len > sect_len - static_cast<section_size_type>(offset))
+    gold_fatal(_("%s: contribution to section '%s' exceeds section size"),
+	       this->name_, get_dwarf_section_name(section_id));
+
+  section_offset_type off = this->add_contribution(output_file, section_id,
+						   contents + offset, len);
+  this->range_map_[key] = off;
+  return off;
+}
+
+// Add CONTENTS to the output file, and return its offset in the output
+// section.  The output file writes the contribution directly from the
+// input file view.  For .debug_str_offsets.dwo, we allocate a buffer for
+// the remapped string offsets, and fill it in later in remap_str_offsets(),
+// unless the output file is streaming.
+
+section_offset_type
+Dwo_file::add_contribution(Dwp_output_file* output_file,
+			   elfcpp::DW_SECT section_id,
+			   const unsigned char* contents, section_size_type len)
+{
   if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
     {
-      const unsigned char* remapped = this->remap_str_offsets(contents, len);
-      if (is_new)
-	delete[] contents;
-      contents = remapped;
-    }
-  else if (!is_new)
-    {
-      unsigned char* copy = new unsigned char[len];
-      memcpy(copy, contents, len);
-      contents = copy;
+      if ((len & 3) != 0)
+	gold_fatal(_("%s: .debug_str_offsets.dwo section size "
+		     "not a multiple of 4"),
+		   this->name_);
+      Str_offsets_remap remap = { contents, len, new unsigned char[len] };
+      contents = remap.buf;
+      if (!output_file->is_streaming())
+	this->remaps_.push_back(remap);
+      else
+	{
+	  // The contribution will be written right away, so remap the
+	  // string offsets now, and free the buffer once it is written.
+	  this->remap_str_offsets(remap);
+	  section_offset_type off =
+	      output_file->add_contribution(section_id, contents, len, 1);
+	  delete[] remap.buf;
+	  return off;
+	}
     }
 
   // Add the contents of the input section to the output section.
-  // The output file takes ownership of the memory pointed to by CONTENTS.
-  section_offset_type off = output_file->add_contribution(section_id, contents,
-							  len, 1);
+  // Unless the output file is streaming, the memory pointed to by
+  // CONTENTS must remain valid until the output file is finalized.
+  return output_file->add_contribution(section_id, contents, len, 1);
+}
 
-  // Store the output section bounds.
-  Section_bounds bounds(off, len);
-  this->sect_offsets_[shndx] = bounds;
+// Remap the string offsets in the .debug_str_offsets.dwo sections
+// collected by copy_section().
 
-  return bounds;
+void
+Dwo_file::remap_str_offsets()
+{
+  for (unsigned int i = 0; i < this->remaps_.size(); ++i)
+    this->remap_str_offsets(this->remaps_[i]);
 }
 
-// Remap the 
-const unsigned char*
-Dwo_file::remap_str_offsets(const unsigned char* contents,
-			    section_size_type len)
-{
-  if ((len & 3) != 0)
-    gold_fatal(_("%s: .debug_str_offsets.dwo section size not a multiple of 4"),
-	       this->name_);
+// Remap the string offsets in a single .debug_str_offsets.dwo section.
 
+void
+Dwo_file::remap_str_offsets(const Str_offsets_remap& remap)
+{
   if (this->obj_->is_big_endian())
-    return this->sized_remap_str_offsets<true>(contents, len);
+    this->sized_remap_str_offsets<true>(remap.contents, remap.len, remap.buf);
   else
-    return this->sized_remap_str_offsets<false>(contents, len);
+    this->sized_remap_str_offsets<false>(remap.contents, remap.len, remap.buf);
 }
 
 template <bool big_endian>
-const unsigned char*
+void
 Dwo_file::sized_remap_str_offsets(const unsigned char* contents,
-				  section_size_type len)
+				  section_size_type len,
+				  unsigned char* buf)
 {
-  unsigned char* remapped = new unsigned char[len];
   const unsigned char* p = contents;
-  unsigned char* q = remapped;
+  unsigned char* q = buf;
   while (len > 0)
     {
       unsigned int val = elfcpp::Swap_unaligned<32, big_endian>::readval(p);
@@ -1333,7 +2220,6 @@ Dwo_file::sized_remap_str_offsets(const unsigned char* contents,
       p += 4;
       q += 4;
     }
-  return remapped;
 }
 
 unsigned int
@@ -1358,36 +2244,86 @@ Dwo_file::remap_str_offset(section_offset_type val)
   return p->second + (val - p->first);
 }
 
-// Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-// to OUTPUT_FILE.
+// Add the .debug_info.dwo or .debug_types.dwo section SHNDX and related
+// sections to OUTPUT_FILE.
 
 void
-Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
+Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int shndx,
 		       bool is_debug_types)
 {
-  unsigned int shndx = (is_debug_types
-			? debug_shndx[elfcpp::DW_SECT_TYPES]
-			: debug_shndx[elfcpp::DW_SECT_INFO]);
-
   gold_assert(shndx != 0);
 
-  if (debug_shndx[elfcpp::DW_SECT_ABBREV] == 0)
-    gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
-
   // Copy the related sections and track the section offsets and sizes.
   Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
   for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
     {
-      if (debug_shndx[i] > 0)
-	sections[i] = this->copy_section(output_file, debug_shndx[i],
+      if (this->debug_shndx_[i] > 0)
+	sections[i] = this->copy_section(output_file, this->debug_shndx_[i],
 					 static_cast<elfcpp::DW_SECT>(i));
     }
 
-  // Parse the .debug_info or .debug_types section and add each compilation
-  // or type unit to the output file, along with the contributions to the
-  // related sections.
-  Unit_reader reader(is_debug_types, this->obj_, shndx);
-  reader.add_units(output_file, debug_shndx[elfcpp::DW_SECT_ABBREV], sections);
+  section_size_type len;
+  const unsigned char* contents = this->section_contents(shndx, &len);
+  elfcpp::DW_SECT section_id = (is_debug_types
+				? elfcpp::DW_SECT_TYPES
+				: elfcpp::DW_SECT_INFO);
+
+  // The abbreviations and string offsets, for recording CU names.
+  const unsigned char* abbrevs = NULL;
+  section_size_type abbrevs_len = 0;
+  const unsigned char* str_offsets = NULL;
+  section_size_type str_offsets_len = 0;
+  if (!is_debug_types && output_file->record_cu_names())
+    {
+      unsigned int abbrev_shndx = this->debug_shndx_[elfcpp::DW_SECT_ABBREV];
+      if (abbrev_shndx > 0)
+	abbrevs = this->section_contents(abbrev_shndx, &abbrevs_len);
+      unsigned int str_offsets_shndx =
+	  this->debug_shndx_[elfcpp::DW_SECT_STR_OFFSETS];
+      if (str_offsets_shndx > 0)
+	str_offsets = this->section_contents(str_offsets_shndx,
+					     &str_offsets_len);
+    }
+
+  // Add each compilation or type unit found by read() to the output
+  // file, along with the contributions to the related sections.
+  for (Dwo_unit_list::const_iterator p = this->units_.begin();
+       p != this->units_.end();
+       ++p)
+    {
+      if (p->shndx != shndx)
+	continue;
+      if (is_debug_types && output_file->lookup_tu(p->signature))
+	continue;
+
+      if (!is_debug_types && output_file->record_cu_names())
+	{
+	  std::string name(this->cu_name(contents + p->offset, p->length,
+					 abbrevs, abbrevs_len,
+					 str_offsets, str_offsets_len));
+	  if (!name.empty())
+	    output_file->add_cu_name(name);
+	}
+
+      Unit_set* unit_set = new Unit_set();
+      unit_set->signature = p->signature;
+      for (unsigned int i = elfcpp::DW_SECT_ABBREV;
+	   i <= elfcpp::DW_SECT_MAX;
+	   ++i)
+	unit_set->sections[i] = sections[i];
+
+      gold_assert(static_cast<section_size_type>(p->offset) + p->length
+		  <= len);
+      section_offset_type off =
+	  output_file->add_contribution(section_id, contents + p->offset,
+					p->length, 1);
+      Section_bounds bounds(off, p->length);
+      unit_set->sections[section_id] = bounds;
+      if (is_debug_types)
+	output_file->add_tu_set(unit_set);
+      else
+	output_file->add_cu_set(unit_set);
+    }
 }
 
 // Class Dwp_output_file.
@@ -1465,9 +2401,10 @@ Dwp_output_file::add_output_section(const char* section_name, int align)
 // Add a contribution to a section in the output file, and return the offset
 // of the contribution within the output section.  The .debug_info.dwo section
 // is expected to be the largest one, so we will write the contents of this
-// section directly to the output file as we receive contributions, allowing
-// us to free that memory as soon as possible. We will save the remaining
-// contributions until we finalize the layout of the output file.
+// section directly to the output file as we receive contributions.  We will
+// save the remaining contributions until we finalize the layout of the
+// output file.  The contents usually point into a view of the input file,
+// so we never free them here.
 
 section_offset_type
 Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
@@ -1525,6 +2462,25 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
 		   section_name);
       this->next_file_offset_ = file_offset + len;
     }
+  else if (this->streaming_)
+    {
+      // Write the contribution to the temporary file for this section.
+      if (section.tmp_fd == NULL)
+	{
+	  section.tmp_fd = ::tmpfile();
+	  if (section.tmp_fd == NULL)
+	    gold_fatal(_("%s: cannot create temporary file: %s"),
+		       this->name_, strerror(errno));
+	}
+      if (align > section.align)
+	section.align = align;
+      section_offset = align_offset(section.size, align);
+      section.size = section_offset + len;
+      ::fseek(section.tmp_fd, section_offset, SEEK_SET);
+      if (::fwrite(contents, 1, len, section.tmp_fd) < len)
+	gold_fatal(_("%s: error writing section '%s': %s"), this->name_,
+		   section_name, strerror(errno));
+    }
   else
     {
       // Collect the contributions and keep track of the total size.
@@ -1553,7 +2509,17 @@ Dwp_output_file::add_cu_set(Unit_set* cu_set)
 		 this->name_, (unsigned long long)dwo_id);
 }
 
+// Lookup a DWO id and return TRUE if we have already seen it.
+
+bool
+Dwp_output_file::lookup_cu(uint64_t dwo_id)
+{
+  unsigned int slot;
+  return this->cu_index_.find_or_add(dwo_id, &slot);
+}
+
 // Lookup a type signature and return TRUE if we have already seen it.
+
 bool
 Dwp_output_file::lookup_tu(uint64_t type_sig)
 {
@@ -1783,13 +2749,34 @@ Dwp_output_file::finalize()
 void
 Dwp_output_file::write_contributions(const Section& sect)
 {
+  if (sect.tmp_fd != NULL)
+    {
+      // Copy the section from the temporary file.
+      ::fseek(sect.tmp_fd, 0, SEEK_SET);
+      ::fseek(this->fd_, sect.offset, SEEK_SET);
+      unsigned char buf[64 * 1024];
+      section_size_type remaining = sect.size;
+      while (remaining > 0)
+	{
+	  size_t len = std::min<section_size_type>(remaining, sizeof buf);
+	  if (::fread(buf, 1, len, sect.tmp_fd) < len)
+	    gold_fatal(_("%s: error reading temporary file for section '%s'"),
+		       this->name_, sect.name);
+	  if (::fwrite(buf, 1, len, this->fd_) < len)
+	    gold_fatal(_("%s: error writing section '%s'"), this->name_,
+		       sect.name);
+	  remaining -= len;
+	}
+      ::fclose(sect.tmp_fd);
+      return;
+    }
+
   for (unsigned int i = 0; i < sect.contributions.size(); ++i)
     {
       const Contribution& c = sect.contributions[i];
       ::fseek(this->fd_, sect.offset + c.output_offset, SEEK_SET);
       if (::fwrite(c.contents, 1, c.size, this->fd_) < c.size)
 	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
-      delete[] c.contents;
     }
 }
 
@@ -2063,20 +3050,24 @@ Dwo_name_info_reader::visit_compilation_unit(off_t, off_t, Dwarf_die* die)
 {
   const char* dwo_name = die->string_attribute(elfcpp::DW_AT_GNU_dwo_name);
   if (dwo_name != NULL)
+    {
       this->files_->push_back(dwo_name);
+      if (this->dwo_ids_ != NULL)
+	{
+	  uint64_t dwo_id = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
+	  this->dwo_ids_->push_back(dwo_id);
+	}
+    }
 }
 
 // Class Unit_reader.
 
-// Read the CUs or TUs and add them to the output file.
+// Read the CUs or TUs and add them to UNITS.
 
 void
-Unit_reader::add_units(Dwp_output_file* output_file,
-		       unsigned int debug_abbrev,
-		       Section_bounds* sections)
+Unit_reader::read_units(unsigned int debug_abbrev, Dwo_unit_list* units)
 {
-  this->output_file_ = output_file;
-  this->sections_ = sections;
+  this->units_ = units;
   this->set_abbrev_shndx(debug_abbrev);
   this->parse();
 }
@@ -2084,52 +3075,88 @@ Unit_reader::add_units(Dwp_output_file* output_file,
 // Visit a compilation unit.
 
 void
-Unit_reader::visit_compilation_unit(off_t, off_t cu_length, Dwarf_die* die)
+Unit_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
+				    Dwarf_die* die)
 {
   if (cu_length == 0)
     return;
-
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  // Dwp_output_file::add_contribution writes the .debug_info.dwo section
-  // directly to the output file, so we do not need to duplicate the
-  // section contents, and add_contribution does not need to free the memory.
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_INFO,
-					   this->buffer_at_offset(0),
-					   cu_length, 1);
-  Section_bounds bounds(off, cu_length);
-  unit_set->sections[elfcpp::DW_SECT_INFO] = bounds;
-  this->output_file_->add_cu_set(unit_set);
+  this->add_unit(cu_offset, cu_length,
+		 die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id));
 }
 
 // Visit a type unit.
 
 void
-Unit_reader::visit_type_unit(off_t, off_t tu_length, off_t,
+Unit_reader::visit_type_unit(off_t tu_offset, off_t tu_length, off_t,
 			     uint64_t signature, Dwarf_die*)
 {
   if (tu_length == 0)
     return;
-  if (this->output_file_->lookup_tu(signature))
-    return;
+  this->add_unit(tu_offset, tu_length, signature);
+}
+
+// Record a unit.
+
+void
+Unit_reader::add_unit(off_t offset, off_t length, uint64_t signature)
+{
+  Dwo_unit unit;
+  unit.shndx = this->shndx_;
+  unit.offset = offset;
+  unit.length = length;
+  unit.signature = signature;
+  this->units_->push_back(unit);
+}
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = signature;
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
+// Class Dwo_add_task.
 
-  unsigned char* contents = new unsigned char[tu_length];
-  memcpy(contents, this->buffer_at_offset(0), tu_length);
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES, contents,
-					   tu_length, 1);
-  Section_bounds bounds(off, tu_length);
-  unit_set->sections[elfcpp::DW_SECT_TYPES] = bounds;
-  this->output_file_->add_tu_set(unit_set);
+Dwo_add_task::~Dwo_add_task()
+{
+  delete this->read_blocker_;
+  if (this->this_blocker_ != NULL)
+    delete this->this_blocker_;
+}
+
+// We can't run until we have read the file, and until the previous
+// file has been added to the output file.
+
+Task_token*
+Dwo_add_task::is_runnable()
+{
+  if (this->read_blocker_->is_blocked())
+    return this->read_blocker_;
+  if (this->this_blocker_ != NULL && this->this_blocker_->is_blocked())
+    return this->this_blocker_;
+  return NULL;
+}
+
+// We release the next file when we are done.
+
+void
+Dwo_add_task::locks(Task_locker* tl)
+{
+  if (this->next_blocker_ != NULL)
+    tl->add(this, this->next_blocker_);
+  if (this->done_blocker_ != NULL)
+    tl->add(this, this->done_blocker_);
+}
+
+// Add the file to the output file, then queue a task to remap its
+// string offsets, which no longer depends on anything that comes later.
+
+void
+Dwo_add_task::run(Workqueue* workqueue)
+{
+  if (this->verbose_)
+    fprintf(stderr, "%s\n", this->dwo_file_->name());
+  this->dwo_file_->add_to_output(this->output_file_);
+  if (this->output_file_->is_streaming())
+    {
+      gold_assert(!this->dwo_file_->has_str_offsets());
+      delete this->dwo_file_;
+    }
+  else if (this->dwo_file_->has_str_offsets())
+    workqueue->queue_soon(new Dwo_remap_task(this->dwo_file_));
 }
 
 }; // End namespace gold
@@ -2138,16 +3165,42 @@ using namespace gold;
 
 // Options.
 
+enum Dwp_long_options
+  {
+    OPT_THREADS = 256,
+    OPT_NO_THREADS,
+    OPT_THREAD_COUNT,
+    OPT_STREAMING
+  };
+
 struct option dwp_options[] =
   {
     { "exec", required_argument, NULL, 'e' },
     { "help", no_argument, NULL, 'h' },
     { "output", required_argument, NULL, 'o' },
+    { "streaming", no_argument, NULL, OPT_STREAMING },
+    { "threads", no_argument, NULL, OPT_THREADS },
+    { "no-threads", no_argument, NULL, OPT_NO_THREADS },
+    { "thread-count", required_argument, NULL, OPT_THREAD_COUNT },
+    { "update", required_argument, NULL, 'u' },
     { "verbose", no_argument, NULL, 'v' },
     { "version", no_argument, NULL, 'V' },
     { NULL, 0, NULL, 0 }
   };
 
+// Return the number of processors, or 1 if we can't tell.
+
+static int
+processor_count()
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  if (count > 0)
+    return count;
+#endif
+  return 1;
+}
+
 // Print usage message and exit.
 
 static void
@@ -2158,6 +3211,16 @@ usage(FILE* fd, int exit_status)
   fprintf(fd, _("  -e EXE, --exec EXE       Get list of dwo files from EXE"
 		" (defaults output to EXE.dwp)\n"));
   fprintf(fd, _("  -o FILE, --output FILE   Set output dwp file name\n"));
+  fprintf(fd, _("  -u DWP, --update DWP     Update DWP with the given dwo"
+		" files (defaults\n"
+		"                           output to DWP)\n"));
+  fprintf(fd, _("  --streaming              Write sections as input files are"
+		" read, to bound\n"
+		"                           memory use\n"));
+  fprintf(fd, _("  --threads                Read input files in parallel\n"));
+  fprintf(fd, _("  --no-threads             Do not read input files in parallel"
+		" (default)\n"));
+  fprintf(fd, _("  --thread-count COUNT     Number of threads to use\n"));
   fprintf(fd, _("  -v, --verbose            Verbose output\n"));
   fprintf(fd, _("  -V, --version            Print version number\n"));
 
@@ -2204,11 +3267,10 @@ main(int argc, char** argv)
   Errors errors(program_name);
   set_parameters_errors(&errors);
 
-  // Initialize gold's global options.  We don't use these in
-  // this program, but they need to be initialized so that
-  // functions we call from libgold work properly.
-  General_options options;
-  set_parameters_options(&options);
+  // Gold's global options.  We only use --threads, but they need to
+  // be initialized so that functions we call from libgold work properly.
+  // We set them after parsing our own options below.
+  Command_line command_line;
 
   // In libiberty; expands @filename to the args in "filename".
   expandargv(&argc, &argv);
@@ -2217,9 +3279,13 @@ main(int argc, char** argv)
   File_list files;
   std::string output_filename;
   const char* exe_filename = NULL;
+  const char* update_filename = NULL;
   bool verbose = false;
+  bool threads = false;
+  int thread_count = 0;
+  bool streaming = false;
   int c;
-  while ((c = getopt_long(argc, argv, "e:ho:vV", dwp_options, NULL)) != -1)
+  while ((c = getopt_long(argc, argv, "e:ho:u:vV", dwp_options, NULL)) != -1)
     {
       switch (c)
         {
@@ -2231,9 +3297,29 @@ main(int argc, char** argv)
 	  case 'o':
 	    output_filename.assign(optarg);
 	    break;
+	  case 'u':
+	    update_filename = optarg;
+	    break;
 	  case 'v':
 	    verbose = true;
 	    break;
+	  case OPT_STREAMING:
+	    streaming = true;
+	    break;
+	  case OPT_THREADS:
+	    threads = true;
+	    break;
+	  case OPT_NO_THREADS:
+	    threads = false;
+	    break;
+	  case OPT_THREAD_COUNT:
+	    {
+	      char* endptr;
+	      thread_count = strtol(optarg, &endptr, 0);
+	      if (*endptr != '\0' || thread_count < 0)
+		gold_fatal(_("invalid thread count: %s"), optarg);
+	    }
+	    break;
 	  case 'V':
 	    print_version();
 	  case '?':
@@ -2242,40 +3328,158 @@ main(int argc, char** argv)
 	}
     }
 
+  if (threads)
+    {
+      const char* threads_option = "--threads";
+      bool no_more_options = false;
+      command_line.process_one_option(1, &threads_option, 0,
+				      &no_more_options);
+    }
+  const General_options& options(command_line.options());
+  set_parameters_options(&options);
+
   if (output_filename.empty())
     {
-      if (exe_filename == NULL)
+      if (update_filename != NULL)
+	output_filename.assign(update_filename);
+      else if (exe_filename == NULL)
 	gold_fatal(_("no output file specified"));
-      output_filename.assign(exe_filename);
-      output_filename.append(".dwp");
+      else
+	{
+	  output_filename.assign(exe_filename);
+	  output_filename.append(".dwp");
+	}
     }
 
-  Dwp_output_file output_file(output_filename.c_str());
+  // When updating a .dwp file in place, we write a new file and rename
+  // it when we are done, since the old file stays mapped until then.
+  std::string new_filename(output_filename);
+  if (update_filename != NULL && output_filename == update_filename)
+    new_filename.append(".new");
+
+  Dwp_output_file output_file(new_filename.c_str());
+  if (streaming)
+    output_file.set_streaming();
+
+  // When updating a .dwp file, read it first.
+  Dwo_file* update_file = NULL;
+  Unordered_set<uint64_t> live_cus;
+  if (update_filename != NULL)
+    {
+      update_file = new Dwo_file(update_filename);
+      update_file->set_update_package();
+      update_file->read(NULL);
+      // Without an executable to tell us which CUs are still used,
+      // we match the CUs of the .dwo files to the ones they replace
+      // by name.
+      if (exe_filename == NULL)
+	output_file.set_record_cu_names();
+    }
 
-  // Get list of .dwo files from the executable.
+  // Get list of .dwo files from the executable.  When updating a .dwp
+  // file, we keep only the CUs the executable still uses, and we skip
+  // any .dwo file whose CU is already in the .dwp file; a .dwo file
+  // that has been rebuilt has a new DWO id.
   if (exe_filename != NULL)
     {
       Dwo_file exe_file(exe_filename);
-      exe_file.read_executable(&files);
+      if (update_file == NULL)
+	exe_file.read_executable(&files, NULL);
+      else
+	{
+	  File_list exe_files;
+	  std::vector<uint64_t> dwo_ids;
+	  exe_file.read_executable(&exe_files, &dwo_ids);
+	  for (size_t i = 0; i < exe_files.size(); ++i)
+	    {
+	      live_cus.insert(dwo_ids[i]);
+	      if (!update_file->has_cu(dwo_ids[i]))
+		files.push_back(exe_files[i]);
+	    }
+	  update_file->set_live_cus(&live_cus);
+	}
     }
 
   // Add any additional files listed on command line.
   for (int i = optind; i < argc; ++i)
     files.push_back(argv[i]);
 
-  if (exe_filename == NULL && files.empty())
+  if (exe_filename == NULL && update_filename == NULL && files.empty())
     gold_fatal(_("no input files and no executable specified"));
 
+  // The .dwp file being updated comes last, so that the units from
+  // the new .dwo files replace the ones it contains.
+  if (update_file != NULL)
+    files.push_back(update_filename);
+
   // Process each file, adding its contents to the output file.
-  for (File_list::const_iterator f = files.begin(); f != files.end(); ++f)
+  // The files are read in parallel, but are added to the output
+  // file one at a time, in order.  When streaming, we only let
+  // reading get THREAD_COUNT files ahead, so that we don't keep
+  // more than a few input files mapped at once.
+  Workqueue workqueue(options);
+  if (thread_count == 0)
     {
-      if (verbose)
-        fprintf(stderr, "%s\n", f->c_str());
-      Dwo_file dwo_file(f->c_str());
-      dwo_file.read(&output_file);
+      // By default, use one thread per processor.  When streaming,
+      // the thread count also bounds the number of input files mapped
+      // at once, so use no more than a few.
+      thread_count = processor_count();
+      if (streaming)
+	thread_count = std::min(thread_count, 4);
     }
+  workqueue.set_thread_count(thread_count);
+  size_t read_ahead = threads ? thread_count : 1;
+
+  std::vector<Dwo_file*> dwo_files;
+  std::vector<Task_token*> done_blockers(files.size(), NULL);
+  Task_token* this_blocker = NULL;
+  for (size_t i = 0; i < files.size(); ++i)
+    {
+      Dwo_file* dwo_file;
+      if (update_file != NULL && i + 1 == files.size())
+	dwo_file = update_file;
+      else
+	dwo_file = new Dwo_file(files[i].c_str());
+      if (!streaming)
+	dwo_files.push_back(dwo_file);
+
+      Task_token* read_blocker = new Task_token(true);
+      read_blocker->add_blocker();
+      Task_token* next_blocker = NULL;
+      if (i + 1 < files.size())
+	{
+	  next_blocker = new Task_token(true);
+	  next_blocker->add_blocker();
+	}
+      Task_token* done_blocker = NULL;
+      if (streaming && i + read_ahead < files.size())
+	{
+	  done_blocker = new Task_token(true);
+	  done_blocker->add_blocker();
+	  done_blockers[i + read_ahead] = done_blocker;
+	}
+
+      workqueue.queue(new Dwo_read_task(dwo_file, done_blockers[i],
+					read_blocker));
+      workqueue.queue(new Dwo_add_task(dwo_file, &output_file, verbose,
+				       read_blocker, this_blocker,
+				       next_blocker, done_blocker));
+      this_blocker = next_blocker;
+    }
+
+  workqueue.process(0);
 
   output_file.finalize();
 
+  // The output file refers to the input file contents until it is
+  // finalized, so we can't delete the input files until now.
+  for (unsigned int i = 0; i < dwo_files.size(); ++i)
+    delete dwo_files[i];
+
+  if (new_filename != output_filename
+      && ::rename(new_filename.c_str(), output_filename.c_str()) < 0)
+    gold_fatal(_("%s: cannot rename to %s: %s"), new_filename.c_str(),
+	       output_filename.c_str(), strerror(errno));
+
   return EXIT_SUCCESS;
 }
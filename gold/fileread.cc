@@ -47,6 +47,7 @@
 #include "target.h"
 #include "binary.h"
 #include "descriptors.h"
+#include "elfcpp.h"
 #include "gold-threads.h"
 #include "fileread.h"
 
@@ -126,6 +127,29 @@ unsigned long long File_read::total_mapped_bytes;
 unsigned long long File_read::current_mapped_bytes;
 unsigned long long File_read::maximum_mapped_bytes;
 
+// A lock for view_lru and the counts of view bytes used for
+// --max-mapped-input-memory.
+static Lock* view_lru_lock = NULL;
+static Initialize_lock view_lru_initialize_lock(&view_lru_lock);
+
+File_read::View_lru File_read::view_lru;
+unsigned long long File_read::view_bytes;
+unsigned long long File_read::maximum_view_bytes;
+unsigned long long File_read::evicted_views;
+unsigned long long File_read::evicted_bytes;
+unsigned long long File_read::remapped_views;
+
+// Return the limit set by --max-mapped-input-memory, or 0 if there
+// is none.
+
+static inline unsigned long long
+max_mapped_input_memory()
+{
+  if (!parameters->options_valid())
+    return 0;
+  return parameters->options().max_mapped_input_memory();
+}
+
 // Class File_read::View.
 
 File_read::View::~View()
@@ -177,6 +201,7 @@ File_read::View::is_locked()
 File_read::~File_read()
 {
   gold_assert(this->token_.is_writable());
+  this->begin_use();
   if (this->is_descriptor_opened_)
     {
       release_descriptor(this->descriptor_, true);
@@ -185,6 +210,8 @@ File_read::~File_read()
     }
   this->name_.clear();
   this->clear_views(CLEAR_VIEWS_ALL);
+  if (this->lock_ != NULL)
+    delete this->lock_;
 }
 
 // Open the file.
@@ -212,6 +239,9 @@ File_read::open(const Task* task, const std::string& name)
       gold_debug(DEBUG_FILES, "Attempt to open %s succeeded",
 		 this->name_.c_str());
       this->token_.add_writer(task);
+      if (parameters->options_valid()
+	  && parameters->options().prefetch_inputs())
+	Input_prefetch::note_open(this->name_);
     }
 
   return this->descriptor_ >= 0;
@@ -259,6 +289,7 @@ void
 File_read::release()
 {
   gold_assert(this->is_locked());
+  this->begin_use();
 
   if (!parameters->options_valid() || parameters->options().stats())
     {
@@ -285,9 +316,159 @@ File_read::release()
 	}
     }
 
+  this->end_use();
+
   this->released_ = true;
 }
 
+// A task is going to use the views of this file.  Until end_use is
+// called, nothing else may delete them, so take them off view_lru.
+// Tasks which lock the file do not tell us so, which is why this is
+// called before each access to views_.  Return true if the file was
+// already in use, or if there is no --max-mapped-input-memory.
+
+bool
+File_read::begin_use()
+{
+  if (max_mapped_input_memory() == 0)
+    return true;
+
+  view_lru_initialize_lock.initialize();
+  Hold_optional_lock hl(view_lru_lock);
+  if (this->in_use_)
+    return true;
+  this->in_use_ = true;
+  for (Views::iterator p = this->views_.begin();
+       p != this->views_.end();
+       ++p)
+    {
+      View* v = p->second;
+      if (v->is_on_lru())
+	{
+	  File_read::view_lru.erase(v->lru_position());
+	  v->clear_lru_position();
+	}
+    }
+  return false;
+}
+
+// The task which was using this file is done with it.  Its views
+// are now the most recently used ones which may be evicted.  Evict
+// the least recently used views if we are over the limit.
+
+void
+File_read::end_use()
+{
+  unsigned long long limit = max_mapped_input_memory();
+  if (limit == 0)
+    return;
+
+  view_lru_initialize_lock.initialize();
+  Hold_optional_lock hl(view_lru_lock);
+  this->in_use_ = false;
+  for (Views::iterator p = this->views_.begin();
+       p != this->views_.end();
+       ++p)
+    {
+      View* v = p->second;
+      gold_assert(!v->is_on_lru());
+      if (v->is_locked() || v->is_permanent_view())
+	continue;
+      // When several objects share the file, clear_views keeps the
+      // views accessed since it last ran, even with
+      // --no-keep-files-mapped; see the comment there.  Leave them
+      // alone until it clears the mark.
+      if (this->object_count_ > 1 && v->accessed())
+	continue;
+      File_read::view_lru.push_front(v);
+      v->set_lru_position(this, File_read::view_lru.begin());
+    }
+  File_read::evict_views(limit);
+}
+
+// Account for a view V we just made.  This may evict views of other
+// files.
+
+void
+File_read::count_new_view(View* v)
+{
+  unsigned long long limit = max_mapped_input_memory();
+  if (limit == 0)
+    return;
+
+  view_lru_initialize_lock.initialize();
+  Hold_optional_lock hl(view_lru_lock);
+  v->set_is_counted();
+  File_read::view_bytes += v->size();
+  if (this->has_evicted_views_)
+    ++File_read::remapped_views;
+  File_read::evict_views(limit);
+  if (File_read::view_bytes > File_read::maximum_view_bytes)
+    File_read::maximum_view_bytes = File_read::view_bytes;
+}
+
+// Account for a view V we are about to delete.
+
+void
+File_read::uncount_view(const View* v)
+{
+  if (!v->is_counted())
+    return;
+  gold_assert(!v->is_on_lru());
+  view_lru_initialize_lock.initialize();
+  Hold_optional_lock hl(view_lru_lock);
+  gold_assert(File_read::view_bytes >= v->size());
+  File_read::view_bytes -= v->size();
+}
+
+// Delete the least recently used views of files not in use until we
+// are using no more than LIMIT bytes, or there is nothing left we
+// may delete.  end_use only puts a view on view_lru if clear_views
+// would delete it with --no-keep-files-mapped, so deleting it here
+// is safe as long as no task is using the file.  The caller must hold
+// view_lru_lock.
+
+void
+File_read::evict_views(unsigned long long limit)
+{
+  while (File_read::view_bytes > limit && !File_read::view_lru.empty())
+    {
+      View* v = File_read::view_lru.back();
+      File_read::view_lru.pop_back();
+      v->clear_lru_position();
+
+      // begin_use takes the views of a file off view_lru when it
+      // comes into use, so this is only a safeguard: never touch the
+      // views of a file which a task may be using.
+      File_read* file = v->lru_file();
+      if (file->in_use_)
+	continue;
+
+      Views::iterator p =
+	file->views_.find(std::make_pair(v->start(), v->byteshift()));
+      gold_assert(p != file->views_.end() && p->second == v);
+      file->views_.erase(p);
+      if (file->whole_file_view_ == v)
+	file->whole_file_view_ = NULL;
+      file->has_evicted_views_ = true;
+
+      if (v->is_counted())
+	{
+	  gold_assert(File_read::view_bytes >= v->size());
+	  File_read::view_bytes -= v->size();
+	}
+      ++File_read::evicted_views;
+      File_read::evicted_bytes += v->size();
+
+      gold_debug(DEBUG_FILES, "Evicting %lld bytes at %lld of %s",
+		 static_cast<long long>(v->size()),
+		 static_cast<long long>(v->start()),
+		 file->name_.c_str());
+
+      delete v;
+    }
+}
+
 // Lock the file.
 
 void
@@ -319,6 +500,20 @@ File_read::is_locked() const
   return false;
 }
 
+// Set whether the file is shared by several tasks.
+
+void
+File_read::set_shared(bool shared)
+{
+  if (shared && this->lock_ == NULL)
+    this->lock_ = new Lock();
+  else if (!shared && this->lock_ != NULL)
+    {
+      delete this->lock_;
+      this->lock_ = NULL;
+    }
+}
+
 // See if we have a view which covers the file starting at START for
 // SIZE bytes.  Return a pointer to the View if found, NULL if not.
 // If BYTESHIFT is not -1U, the returned View must have the specified
@@ -424,6 +619,8 @@ File_read::do_read(off_t start, section_size_type size, void* p)
 void
 File_read::read(off_t start, section_size_type size, void* p)
 {
+  Hold_optional_lock hl(this->lock_);
+  this->begin_use();
   const File_read::View* pv = this->find_view(start, size, -1U, NULL);
   if (pv != NULL)
     {
@@ -520,6 +717,7 @@ File_read::make_view(off_t start, section_size_type size,
 					   cache, ownership);
 
   this->add_view(v);
+  this->count_new_view(v);
 
   return v;
 }
@@ -541,6 +739,8 @@ File_read::find_or_make_view(off_t offset, off_t start,
 		   static_cast<long long>(size),
 		   static_cast<long long>(start));
 
+  this->begin_use();
+
   unsigned int byteshift;
   if (offset == 0)
     byteshift = 0;
@@ -598,6 +798,7 @@ File_read::find_or_make_view(off_t offset, off_t start,
 			      cache, View::DATA_ALLOCATED_ARRAY);
 
       this->add_view(shifted_view);
+      this->count_new_view(shifted_view);
       return shifted_view;
     }
 
@@ -614,6 +815,7 @@ const unsigned char*
 File_read::get_view(off_t offset, off_t start, section_size_type size,
 		    bool aligned, bool cache)
 {
+  Hold_optional_lock hl(this->lock_);
   File_read::View* pv = this->find_or_make_view(offset, start, size,
 						aligned, cache);
   return pv->data() + (offset + start - pv->start() + pv->byteshift());
@@ -623,6 +825,7 @@ File_view*
 File_read::get_lasting_view(off_t offset, off_t start, section_size_type size,
 			    bool aligned, bool cache)
 {
+  Hold_optional_lock hl(this->lock_);
   File_read::View* pv = this->find_or_make_view(offset, start, size,
 						aligned, cache);
   pv->lock();
@@ -732,6 +935,8 @@ File_read::read_multiple(off_t base, const Read_multiple& rm)
 	this->read(base + i_off, i_entry.size, i_entry.buffer);
       else
 	{
+	  Hold_optional_lock hl(this->lock_);
+	  this->begin_use();
 	  File_read::View* view = this->find_view(base + i_off,
 						  end_off - i_off,
 						  -1U, NULL);
@@ -772,6 +977,7 @@ File_read::clear_view_cache_marks()
   if (this->object_count_ > 1)
     return;
 
+  bool was_in_use = this->begin_use();
   for (Views::iterator p = this->views_.begin();
        p != this->views_.end();
        ++p)
@@ -780,6 +986,8 @@ File_read::clear_view_cache_marks()
        p != this->saved_views_.end();
        ++p)
     (*p)->clear_cache();
+  if (!was_in_use)
+    this->end_use();
 }
 
 // Remove all the file views.  For a file which has multiple
@@ -792,6 +1000,9 @@ File_read::clear_views(Clear_views_mode mode)
 {
   bool keep_files_mapped = (parameters->options_valid()
 			    && parameters->options().keep_files_mapped());
+  // This may be called after the file is released, as for
+  // clear_uncached_views, so put it back the way we found it.
+  bool was_in_use = this->begin_use();
   Views::iterator p = this->views_.begin();
   while (p != this->views_.end())
     {
@@ -815,6 +1026,7 @@ File_read::clear_views(Clear_views_mode mode)
 	{
 	  if (p->second == this->whole_file_view_)
 	    this->whole_file_view_ = NULL;
+	  File_read::uncount_view(p->second);
 	  delete p->second;
 
 	  // map::erase invalidates only the iterator to the deleted
@@ -835,6 +1047,7 @@ File_read::clear_views(Clear_views_mode mode)
     {
       if (!(*q)->is_locked())
 	{
+	  File_read::uncount_view(*q);
 	  delete *q;
 	  q = this->saved_views_.erase(q);
 	}
@@ -844,6 +1057,9 @@ File_read::clear_views(Clear_views_mode mode)
 	  ++q;
 	}
     }
+
+  if (!was_in_use)
+    this->end_use();
 }
 
 // Print statistical information to stderr.  This is used for --stats.
@@ -855,6 +1071,16 @@ File_read::print_stats()
 	  program_name, File_read::total_mapped_bytes);
   fprintf(stderr, _("%s: maximum bytes mapped for read at one time: %llu\n"),
 	  program_name, File_read::maximum_mapped_bytes);
+  if (max_mapped_input_memory() != 0)
+    {
+      fprintf(stderr, _("%s: maximum bytes in input views at one time: %llu\n"),
+	      program_name, File_read::maximum_view_bytes);
+      fprintf(stderr, _("%s: input views evicted: %llu (%llu bytes)\n"),
+	      program_name, File_read::evicted_views,
+	      File_read::evicted_bytes);
+      fprintf(stderr, _("%s: input views remapped after eviction: %llu\n"),
+	      program_name, File_read::remapped_views);
+    }
 }
 
 // Class File_view.
@@ -865,6 +1091,261 @@ File_view::~File_view()
   this->view_->unlock();
 }
 
+// Class Input_prefetch.
+
+// A lock for the Input_prefetch static variables.
+static Lock* prefetch_lock = NULL;
+static Initialize_lock prefetch_initialize_lock(&prefetch_lock);
+
+// The files which have been prefetched but not yet opened, mapped to
+// the number of bytes prefetched.
+typedef Unordered_map<std::string, off_t> Prefetched_files;
+static Prefetched_files prefetched_files;
+
+// The files which have been opened.  We do not prefetch these.
+static Unordered_set<std::string> opened_files;
+
+// Statistics.
+static off_t prefetch_outstanding_bytes;
+static unsigned long long prefetch_file_count;
+static unsigned long long prefetch_byte_count;
+static unsigned long long prefetch_hit_count;
+static unsigned long long prefetch_miss_count;
+
+#ifdef HAVE_POSIX_FADVISE
+
+// Ask the kernel to read LEN bytes at OFFSET in DESCRIPTOR, clipped
+// to the FILESIZE and to *BUDGET.  Subtract the number of bytes
+// requested from *BUDGET.  This does not wait for the data.
+
+static void
+prefetch_range(int descriptor, off_t offset, off_t len, off_t filesize,
+	       off_t* budget)
+{
+  if (offset < 0 || len <= 0 || offset >= filesize)
+    return;
+  if (len > filesize - offset)
+    len = filesize - offset;
+  if (len > *budget)
+    len = *budget;
+  if (len <= 0
+      || ::posix_fadvise(descriptor, offset, len, POSIX_FADV_WILLNEED) != 0)
+    return;
+  *budget -= len;
+}
+
+// Prefetch the section headers and the symbol tables of an ELF file.
+// EHDR_DATA holds the ELF file header.
+
+template<int size, bool big_endian>
+static void
+prefetch_elf(int descriptor, const unsigned char* ehdr_data, off_t filesize,
+	     off_t* budget)
+{
+  elfcpp::Ehdr<size, big_endian> ehdr(ehdr_data);
+  const off_t shoff = ehdr.get_e_shoff();
+  const int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
+  unsigned int shnum = ehdr.get_e_shnum();
+  if (shoff == 0 || ehdr.get_e_shentsize() != shdr_size)
+    return;
+  if (shnum == 0 || static_cast<off_t>(shnum) > filesize / shdr_size)
+    shnum = 1;
+
+  off_t len = static_cast<off_t>(shnum) * shdr_size;
+  if (shoff > filesize || len > filesize - shoff)
+    return;
+
+  // We need to read the section headers ourselves to find the
+  // symbol tables.  This waits for them, so it counts against the
+  // budget like the data we only ask for.
+  if (len > *budget)
+    {
+      prefetch_range(descriptor, shoff, len, filesize, budget);
+      return;
+    }
+  std::vector<unsigned char> shdrs(len);
+  if (::pread(descriptor, &shdrs[0], len, shoff) != len)
+    return;
+  *budget -= len;
+
+  // The real section count is in the first section header if it
+  // did not fit in the ELF header.
+  if (shnum == 1 && ehdr.get_e_shnum() == 0)
+    {
+      elfcpp::Shdr<size, big_endian> shdr0(&shdrs[0]);
+      prefetch_range(descriptor, shoff + len,
+		     (shdr0.get_sh_size() - 1) * shdr_size, filesize, budget);
+      return;
+    }
+
+  for (unsigned int i = 1; i < shnum; ++i)
+    {
+      elfcpp::Shdr<size, big_endian> shdr(&shdrs[i * shdr_size]);
+      unsigned int type = shdr.get_sh_type();
+      if (type != elfcpp::SHT_SYMTAB && type != elfcpp::SHT_DYNSYM)
+	continue;
+      prefetch_range(descriptor, shdr.get_sh_offset(), shdr.get_sh_size(),
+		     filesize, budget);
+      unsigned int link = shdr.get_sh_link();
+      if (link != 0 && link < shnum)
+	{
+	  elfcpp::Shdr<size, big_endian> strtab(&shdrs[link * shdr_size]);
+	  prefetch_range(descriptor, strtab.get_sh_offset(),
+			 strtab.get_sh_size(), filesize, budget);
+	}
+    }
+}
+
+// The number of bytes at the end of a file which we prefetch when we
+// do not read the file headers.  The assembler and the linker put
+// the symbol table, the string tables and the section headers there.
+
+static const off_t prefetch_tail_size = 64 * 1024;
+
+// Prefetch the data in the open file DESCRIPTOR which we will read
+// first: the symbol tables of an ELF file, the armap of an archive,
+// or the start of anything else.  Finding those means reading the
+// file headers, which waits for the disk.  Without threads that
+// would delay the Read_symbols tasks queued behind us, so then we
+// only ask for the start and the end of the file.  Return the number
+// of bytes requested or read, which is no more than BUDGET.
+
+static off_t
+prefetch_descriptor(int descriptor, off_t filesize, off_t budget)
+{
+  const off_t start_budget = budget;
+  prefetch_range(descriptor, 0, 4096, filesize, &budget);
+
+  if (!parameters->options().threads())
+    {
+      if (filesize > 4096 + prefetch_tail_size)
+	prefetch_range(descriptor, filesize - prefetch_tail_size,
+		       prefetch_tail_size, filesize, &budget);
+      return start_budget - budget;
+    }
+
+  // Enough for an ELF header, or for the archive magic string and
+  // the first member header.  This is in the first page, which we
+  // just asked for.
+  unsigned char buf[128];
+  ssize_t got = ::pread(descriptor, buf, sizeof buf, 0);
+  if (got < 0)
+    return start_budget - budget;
+
+  if (got >= elfcpp::Elf_sizes<32>::ehdr_size
+      && buf[elfcpp::EI_MAG0] == elfcpp::ELFMAG0
+      && buf[elfcpp::EI_MAG1] == elfcpp::ELFMAG1
+      && buf[elfcpp::EI_MAG2] == elfcpp::ELFMAG2
+      && buf[elfcpp::EI_MAG3] == elfcpp::ELFMAG3)
+    {
+      bool big_endian = buf[elfcpp::EI_DATA] == elfcpp::ELFDATA2MSB;
+      if (buf[elfcpp::EI_CLASS] == elfcpp::ELFCLASS32)
+	{
+	  if (big_endian)
+	    prefetch_elf<32, true>(descriptor, buf, filesize, &budget);
+	  else
+	    prefetch_elf<32, false>(descriptor, buf, filesize, &budget);
+	}
+      else if (buf[elfcpp::EI_CLASS] == elfcpp::ELFCLASS64
+	       && got >= elfcpp::Elf_sizes<64>::ehdr_size)
+	{
+	  if (big_endian)
+	    prefetch_elf<64, true>(descriptor, buf, filesize, &budget);
+	  else
+	    prefetch_elf<64, false>(descriptor, buf, filesize, &budget);
+	}
+    }
+  else if (got >= 8 + 60 && memcmp(buf, "!<arch>\n", 8) == 0)
+    {
+      // The first member of an archive is normally the armap.  Its
+      // size is a decimal number at offset 48 in the member header.
+      char sizebuf[11];
+      memcpy(sizebuf, buf + 8 + 48, 10);
+      sizebuf[10] = '\0';
+      off_t armap_size = strtoll(sizebuf, NULL, 10);
+      prefetch_range(descriptor, 8 + 60, armap_size, filesize, &budget);
+    }
+
+  return start_budget - budget;
+}
+
+#endif // defined(HAVE_POSIX_FADVISE)
+
+off_t
+Input_prefetch::prefetch(const std::string& name, off_t budget)
+{
+#ifndef HAVE_POSIX_FADVISE
+  return 0;
+#else
+  {
+    prefetch_initialize_lock.initialize();
+    Hold_optional_lock hl(prefetch_lock);
+    if (opened_files.find(name) != opened_files.end()
+	|| prefetched_files.find(name) != prefetched_files.end())
+      return 0;
+  }
+
+  int descriptor = open_descriptor(-1, name.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    return 0;
+  off_t ret = 0;
+  struct stat s;
+  if (::fstat(descriptor, &s) == 0 && S_ISREG(s.st_mode))
+    ret = prefetch_descriptor(descriptor, s.st_size, budget);
+  release_descriptor(descriptor, true);
+
+  if (ret > 0)
+    {
+      Hold_optional_lock hl(prefetch_lock);
+      // The file may have been opened while we were reading it.
+      if (opened_files.find(name) == opened_files.end()
+	  && prefetched_files.insert(std::make_pair(name, ret)).second)
+	{
+	  prefetch_outstanding_bytes += ret;
+	  ++prefetch_file_count;
+	  prefetch_byte_count += ret;
+	}
+    }
+  return ret;
+#endif
+}
+
+void
+Input_prefetch::note_open(const std::string& name)
+{
+  prefetch_initialize_lock.initialize();
+  Hold_optional_lock hl(prefetch_lock);
+  if (!opened_files.insert(name).second)
+    return;
+  Prefetched_files::iterator p = prefetched_files.find(name);
+  if (p == prefetched_files.end())
+    ++prefetch_miss_count;
+  else
+    {
+      ++prefetch_hit_count;
+      prefetch_outstanding_bytes -= p->second;
+      prefetched_files.erase(p);
+    }
+}
+
+off_t
+Input_prefetch::outstanding_bytes()
+{
+  prefetch_initialize_lock.initialize();
+  Hold_optional_lock hl(prefetch_lock);
+  return prefetch_outstanding_bytes;
+}
+
+void
+Input_prefetch::print_stats()
+{
+  fprintf(stderr, _("%s: input files prefetched: %llu (%llu bytes)\n"),
+	  program_name, prefetch_file_count, prefetch_byte_count);
+  fprintf(stderr, _("%s: input files opened after prefetch: %llu of %llu\n"),
+	  program_name, prefetch_hit_count,
+	  prefetch_hit_count + prefetch_miss_count);
+}
+
 // Class Input_file.
 
 // Create a file given just the filename.
@@ -955,6 +1436,41 @@ File_read::get_mtime()
 #endif
 }
 
+// Return the file last status change time.  Calls gold_fatal if the
+// stat system call failed.
+
+Timespec
+File_read::get_ctime()
+{
+  struct stat file_stat;
+  this->reopen_descriptor();
+
+  if (fstat(this->descriptor_, &file_stat) < 0)
+    gold_fatal(_("%s: stat failed: %s"), this->name_.c_str(),
+	       strerror(errno));
+#ifdef HAVE_STAT_ST_MTIM
+  return Timespec(file_stat.st_ctim.tv_sec, file_stat.st_ctim.tv_nsec);
+#else
+  return Timespec(file_stat.st_ctime, 0);
+#endif
+}
+
+// Return the device and inode number of the file.  Calls gold_fatal
+// if the stat system call failed.
+
+void
+File_read::get_file_id(uint64_t* dev, uint64_t* ino)
+{
+  struct stat file_stat;
+  this->reopen_descriptor();
+
+  if (fstat(this->descriptor_, &file_stat) < 0)
+    gold_fatal(_("%s: stat failed: %s"), this->name_.c_str(),
+	       strerror(errno));
+  *dev = file_stat.st_dev;
+  *ino = file_stat.st_ino;
+}
+
 // Try to find a file in the extra search dirs.  Returns true on success.
 
 bool
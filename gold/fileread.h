@@ -62,6 +62,7 @@ class Position_dependent_options;
 class Input_file_argument;
 class Dirsearch;
 class File_view;
+class Lock;
 
 // File_read manages a file descriptor and mappings for a file we are
 // reading.
@@ -72,7 +73,8 @@ class File_read
   File_read()
     : name_(), descriptor_(-1), is_descriptor_opened_(false), object_count_(0),
       size_(0), token_(false), views_(), saved_views_(), mapped_bytes_(0),
-      released_(true), whole_file_view_(NULL)
+      released_(true), whole_file_view_(NULL), lock_(NULL), in_use_(false),
+      has_evicted_views_(false)
   { }
 
   ~File_read();
@@ -137,6 +139,23 @@ class File_read
   filesize() const
   { return this->size_; }
 
+  // Set whether several tasks may call get_view, get_lasting_view,
+  // read and read_multiple at the same time.  This is used to read
+  // the members of an archive in parallel.  Anything else must still
+  // be done by the task which has the file locked.
+  //
+  // The file must stay locked by one task from before this is called
+  // with true until after it is called with false, and only the
+  // tasks which that task is waiting for may use the file in
+  // between.  Since the lock is made and deleted here without any
+  // locking, it must be set before any of those tasks is queued, and
+  // cleared only after all of them are done.  The objects for the
+  // members, and hence the calls to add_object, must be made before
+  // the tasks are queued, and views returned to those tasks must not
+  // be released until they are done.
+  void
+  set_shared(bool);
+
   // Return a view into the file starting at file offset START for
   // SIZE bytes.  OFFSET is the offset into the input file for the
   // file we are reading; this is zero for a normal object file,
@@ -220,6 +239,16 @@ class File_read
   Timespec
   get_mtime();
 
+  // Return the file last status change time.  Calls gold_fatal if the
+  // stat system call failed.
+  Timespec
+  get_ctime();
+
+  // Set *DEV and *INO to the device and inode number of the file.
+  // Calls gold_fatal if the stat system call failed.
+  void
+  get_file_id(uint64_t* dev, uint64_t* ino);
+
  private:
   // Control for what views to clear.
   enum Clear_views_mode
@@ -247,6 +276,28 @@ class File_read
   // --stats.
   static unsigned long long maximum_mapped_bytes;
 
+  class View;
+
+  // A list of views, most recently used first.
+  typedef std::list<View*> View_lru;
+
+  // The views of all files which are not in use, for
+  // --max-mapped-input-memory.  These are the views which may be
+  // evicted.
+  static View_lru view_lru;
+
+  // Bytes held by all views of all files if --max-mapped-input-memory,
+  // and the high water mark.
+  static unsigned long long view_bytes;
+  static unsigned long long maximum_view_bytes;
+
+  // Number of views and bytes evicted because of
+  // --max-mapped-input-memory, and the number of views later made
+  // again for files which had views evicted.
+  static unsigned long long evicted_views;
+  static unsigned long long evicted_bytes;
+  static unsigned long long remapped_views;
+
   // A view into the file.
   class View
   {
@@ -267,7 +318,8 @@ class File_read
 	 unsigned int byteshift, bool cache, Data_ownership data_ownership)
       : start_(start), size_(size), data_(data), lock_count_(0),
 	byteshift_(byteshift), cache_(cache), data_ownership_(data_ownership),
-	accessed_(true)
+	accessed_(true), is_counted_(false), is_on_lru_(false), file_(NULL),
+	lru_position_()
     { }
 
     ~View();
@@ -327,6 +379,44 @@ class File_read
     is_permanent_view() const
     { return this->data_ownership_ == DATA_NOT_OWNED; }
 
+    // Whether this view is counted in view_bytes.
+    bool
+    is_counted() const
+    { return this->is_counted_; }
+
+    void
+    set_is_counted()
+    { this->is_counted_ = true; }
+
+    // Whether this view is on view_lru.
+    bool
+    is_on_lru() const
+    { return this->is_on_lru_; }
+
+    // Return the file which owns this view on view_lru.
+    File_read*
+    lru_file() const
+    { return this->file_; }
+
+    // Return the position of this view on view_lru.
+    View_lru::iterator
+    lru_position() const
+    { return this->lru_position_; }
+
+    // Record that this view of FILE is on view_lru at position P.
+    void
+    set_lru_position(File_read* file, View_lru::iterator p)
+    {
+      this->is_on_lru_ = true;
+      this->file_ = file;
+      this->lru_position_ = p;
+    }
+
+    // Record that this view is no longer on view_lru.
+    void
+    clear_lru_position()
+    { this->is_on_lru_ = false; }
+
    private:
     View(const View&);
     View& operator=(const View&);
@@ -350,6 +440,14 @@ class File_read
     Data_ownership data_ownership_;
     // Whether the view has been accessed recently.
     bool accessed_;
+    // Whether the view is counted in view_bytes.
+    bool is_counted_;
+    // Whether the view is on view_lru.
+    bool is_on_lru_;
+    // The file which owns the view, if it is on view_lru.
+    File_read* file_;
+    // The position of the view on view_lru, if it is there.
+    View_lru::iterator lru_position_;
   };
 
   friend class View;
@@ -392,6 +490,30 @@ class File_read
   void
   clear_views(Clear_views_mode);
 
+  // Note that a task is using the views of this file, so take them
+  // off view_lru.  Return true if the file was already in use, in
+  // which case the caller should not call end_use.
+  bool
+  begin_use();
+
+  // Note that no task is using the views of this file, so put them
+  // on view_lru, and evict views if we are over the limit.
+  void
+  end_use();
+
+  // Account for the view V which was just made.
+  void
+  count_new_view(View* v);
+
+  // Account for the view V which is about to be deleted.
+  static void
+  uncount_view(const View* v);
+
+  // Evict views from view_lru until we are under LIMIT bytes.  This
+  // is called with the view_lru lock held.
+  static void
+  evict_views(unsigned long long limit);
+
   // The size of a file page for buffering data.
   static const off_t page_size = 8192;
 
@@ -442,6 +564,15 @@ class File_read
   // - The contents was specified in the constructor.  Used only for
   //   testing purposes).
   View* whole_file_view_;
+  // A lock for the views, if the file is shared; otherwise NULL.
+  Lock* lock_;
+  // Whether a task may be using the views of this file.  When this
+  // is false the views are on view_lru and may be evicted.  This is
+  // only used with --max-mapped-input-memory, and is protected by
+  // view_lru_lock.
+  bool in_use_;
+  // Whether any views of this file were evicted.
+  bool has_evicted_views_;
 };
 
 // A view of file data that persists even when the file is unlocked.
@@ -476,6 +607,37 @@ class File_view
   const unsigned char* data_;
 };
 
+// Support for --prefetch-inputs.  The Prefetch_inputs task uses this
+// to ask the kernel to start reading the headers and symbol tables
+// of input files before their Read_symbols tasks get to them.  We
+// remember which files were prefetched so that File_read::open can
+// tell how much prefetched data is still waiting to be used.
+
+class Input_prefetch
+{
+ public:
+  // Start reading the parts of the file NAME which Read_symbols will
+  // look at first, asking for no more than BUDGET bytes.  Return the
+  // number of bytes we asked the kernel to read, or 0 if the file has
+  // already been opened or can not be prefetched.  Only hints which
+  // do not block are used, unless we are running with threads.
+  static off_t
+  prefetch(const std::string& name, off_t budget);
+
+  // Note that the file NAME has been opened for reading.
+  static void
+  note_open(const std::string& name);
+
+  // Return the number of bytes prefetched for files which have not
+  // been opened yet.
+  static off_t
+  outstanding_bytes();
+
+  // Dump statistical information to stderr.
+  static void
+  print_stats();
+};
+
 // All the information we hold for a single input file.  This can be
 // an object file, a shared library, or an archive.
 
@@ -22,11 +22,16 @@
 
 #include "gold.h"
 
+#include <algorithm>
+
 #include "gdb-index.h"
 #include "dwarf_reader.h"
 #include "dwarf.h"
 #include "object.h"
 #include "output.h"
+#include "workqueue.h"
+#include "timer.h"
+#include "int_encoding.h"
 #include "demangle.h"
 
 namespace gold
@@ -42,6 +47,12 @@ const int gdb_index_tu_size = 24;
 const int gdb_index_addr_size = 16 + gdb_index_offset_size;
 const int gdb_index_sym_size = 2 * gdb_index_offset_size;
 
+const int debug_names_version = 5;
+
+// Size of the .debug_names header, including the unit length, with an
+// empty augmentation string.
+const int debug_names_hdr_size = 4 + 2 + 2 + 7 * 4;
+
 // This class manages the hashed symbol table for the .gdb_index section.
 // It is essentially equivalent to the hashtab implementation in libiberty,
 // but is copied into gdb sources and here for compatibility because its
@@ -171,6 +182,137 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+// The hash function for names in the .debug_names section.  This is
+// the DJB hash of the name folded to lower case, as described in the
+// DWARF 5 standard.
+
+static unsigned int
+debug_names_string_hash(const unsigned char* str)
+{
+  unsigned int r = 5381;
+  unsigned char c;
+
+  while ((c = *str++) != 0)
+    r = r * 33 + tolower(c);
+
+  return r;
+}
+
+// The results of scanning the .debug_info and .debug_types sections
+// of one object.  A Gdb_index_scan_task fills this in without touching
+// any state shared with other objects, and Gdb_index::merge_scans
+// later adds the results to the index.
+
+class Gdb_index_object_scan
+{
+ public:
+  // A .debug_info or .debug_types section to scan.
+  struct Section
+  {
+    Section(bool is_tu, unsigned int sec_shndx, unsigned int rel_shndx,
+	    unsigned int rel_type)
+      : is_type_unit(is_tu), shndx(sec_shndx), reloc_shndx(rel_shndx),
+	reloc_type(rel_type)
+    { }
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  // A name found in a compilation or type unit, with its hash value.
+  // TAG and DIE_OFFSET identify the DIE for a .debug_names entry.
+  struct Name
+  {
+    Name(const char* sym_name, unsigned int hashval, unsigned int die_tag,
+	 off_t die_off)
+      : name(sym_name), hash(hashval), tag(die_tag), die_offset(die_off)
+    { }
+    std::string name;
+    unsigned int hash;
+    unsigned int tag;
+    off_t die_offset;
+  };
+
+  // A compilation unit or type unit found in one of the sections.
+  // Each name appears at most once in NAMES, in the order in which it
+  // was first seen.  CU_INDEX and FIRST_NAME are set when the scans
+  // are merged.
+  struct Unit
+  {
+    Unit(bool is_tu, off_t off, off_t len, off_t toff, uint64_t sig)
+      : is_type_unit(is_tu), offset(off), length(len), type_offset(toff),
+	signature(sig), ranges(NULL), names(), cu_index(0), first_name(0)
+    { }
+    bool is_type_unit;
+    off_t offset;
+    off_t length;
+    off_t type_offset;
+    uint64_t signature;
+    Dwarf_range_list* ranges;
+    std::vector<Name> names;
+    // The index of the unit in the .gdb_index CU or TU list, negative
+    // for a TU.
+    int cu_index;
+    // The position of the first name of the unit among the names of
+    // all the units of all the objects.
+    size_t first_name;
+  };
+
+  Gdb_index_object_scan(Relobj* obj, unsigned int symtab_sec)
+    : object(obj), symtab_shndx(symtab_sec), sections(), units(),
+      pubnames_shndx(0), pubnames_offset(-1), pubtypes_shndx(0),
+      pubtypes_offset(-1), cu_count(0), cu_nopubnames_count(0),
+      tu_count(0), tu_nopubnames_count(0), scan_time(0)
+  { }
+
+  // Return TRUE if we have already processed the pubnames set at
+  // OFFSET in section SHNDX.
+  bool
+  pubnames_read(unsigned int shndx, off_t offset)
+  {
+    bool ret = (this->pubnames_shndx == shndx
+		&& this->pubnames_offset == offset);
+    this->pubnames_shndx = shndx;
+    this->pubnames_offset = offset;
+    return ret;
+  }
+
+  // Return TRUE if we have already processed the pubtypes set at
+  // OFFSET in section SHNDX.
+  bool
+  pubtypes_read(unsigned int shndx, off_t offset)
+  {
+    bool ret = (this->pubtypes_shndx == shndx
+		&& this->pubtypes_offset == offset);
+    this->pubtypes_shndx = shndx;
+    this->pubtypes_offset = offset;
+    return ret;
+  }
+
+  // The object being scanned.
+  Relobj* object;
+  // The index of the object's symbol table section.
+  unsigned int symtab_shndx;
+  // The sections to scan.
+  std::vector<Section> sections;
+  // The units found.
+  std::vector<Unit> units;
+  // Section index and offset of last read pubnames section.
+  unsigned int pubnames_shndx;
+  off_t pubnames_offset;
+  // Section index and offset of last read pubtypes section.
+  unsigned int pubtypes_shndx;
+  off_t pubtypes_offset;
+  // Statistics, added to the totals when the scan is merged.
+  unsigned int cu_count;
+  unsigned int cu_nopubnames_count;
+  unsigned int tu_count;
+  unsigned int tu_nopubnames_count;
+  // Wall time, in milliseconds, spent scanning this object.
+  long scan_time;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,15 +325,20 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index_object_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), unit_(NULL),
+      debug_names_(parameters->options().debug_names()), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
+  // Add the statistics gathered by SCAN to the totals.
+  static void
+  record_stats(const Gdb_index_object_scan* scan);
+
   // Print usage statistics.
   static void
   print_stats();
@@ -216,15 +363,20 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   // Normally, the names we point to are in a string table, so we don't
   // have to manage them, but when we have a fully-qualified name
   // computed, we put it in the table, and set PARENT_OFFSET_ to -1
-  // indicate a string that we are managing.
+  // indicate a string that we are managing.  LINKAGE_NAME_ is the
+  // linkage name of the declaration, if any, for the .debug_names
+  // section.
   struct Declaration_pair
   {
-    Declaration_pair(off_t parent_offset, const char* name)
-      : parent_offset_(parent_offset), name_(name)
+    Declaration_pair(off_t parent_offset, const char* name,
+		     const char* linkage_name)
+      : parent_offset_(parent_offset), name_(name),
+	linkage_name_(linkage_name)
     { }
 
     off_t parent_offset_;
     const char* name_; 
+    const char* linkage_name_;
   };
   typedef Unordered_map<off_t, Declaration_pair> Declaration_map;
 
@@ -269,6 +421,14 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   std::string
   get_qualified_name(Dwarf_die* die, Dwarf_die* context);
 
+  // Return the unqualified name of DIE, for the .debug_names section.
+  const char*
+  get_simple_name(Dwarf_die* die);
+
+  // Return the linkage name of DIE, for the .debug_names section.
+  const char*
+  get_linkage_name(Dwarf_die* die);
+
   // Record the address ranges for a compilation unit.
   void
   record_cu_ranges(Dwarf_die* die);
@@ -281,10 +441,19 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
-  // The current CU index (negative for a TU).
-  int cu_index_;
+  // Add a name to the current unit.  DIE is the DIE that the name
+  // came from, or NULL if it came from a pubnames table.
+  void
+  add_symbol(const char* sym_name, Dwarf_die* die);
+
+  // The results of the scan.
+  Gdb_index_object_scan* scan_;
+  // The current CU or TU.
+  Gdb_index_object_scan::Unit* unit_;
+  // The names already added to the current unit.
+  Unordered_set<std::string> names_seen_;
+  // Whether we are collecting names for a .debug_names section.
+  bool debug_names_;
   // The language of the current CU or TU.
   unsigned int cu_language_;
   // Map from DIE offset to (parent offset, name) pair,
@@ -317,22 +486,28 @@ void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  ++this->scan_->cu_count;
+  this->scan_->units.push_back(Gdb_index_object_scan::Unit(false, cu_offset,
+							   cu_length, 0, 0));
+  this->unit_ = &this->scan_->units.back();
+  this->names_seen_.clear();
   this->visit_top_die(root_die);
 }
 
 // Process a type unit and parse its child DIE.
 
 void
-Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
+Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t tu_length,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
-  // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  ++this->scan_->tu_count;
+  this->scan_->units.push_back(Gdb_index_object_scan::Unit(true, tu_offset,
+							   tu_length,
+							   type_offset,
+							   signature));
+  this->unit_ = &this->scan_->units.back();
+  this->names_seen_.clear();
   this->visit_top_die(root_die);
 }
 
@@ -367,6 +542,19 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 			 this->object()->name().c_str());
 	    return;
 	  }
+	if (this->debug_names_)
+	  {
+	    // The .debug_names section needs the offset of each DIE,
+	    // which the pubnames tables do not give us, and it has no
+	    // address table.  Type units in .debug_types can not be
+	    // listed in a DWARF 5 index, so we only walk the CUs.
+	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
+	      {
+		++this->scan_->cu_nopubnames_count;
+		this->visit_children(die, NULL);
+	      }
+	    break;
+	  }
 	if (die->tag() == elfcpp::DW_TAG_compile_unit)
 	  this->record_cu_ranges(die);
 	// If there is a pubnames and/or pubtypes section for this
@@ -375,9 +563,9 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 	if (!this->read_pubnames_and_pubtypes(die))
 	  {
 	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
+	      ++this->scan_->cu_nopubnames_count;
 	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	      ++this->scan_->tu_nopubnames_count;
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -432,7 +620,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_, full_name.c_str());
+	      this->add_symbol(full_name.c_str(), die);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -471,8 +659,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str());
+		this->add_symbol(full_name.c_str(), die);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -712,7 +899,8 @@ Gdb_index_info_reader::add_declaration(Dwarf_die* die, Dwarf_die* context)
         name = "(unknown)";
     }
 
-  Declaration_pair decl(parent_offset, name);
+  Declaration_pair decl(parent_offset, name,
+			(this->debug_names_ ? die->linkage_name() : NULL));
   this->declarations_.insert(std::make_pair(die->offset(), decl));
 }
 
@@ -732,7 +920,7 @@ Gdb_index_info_reader::add_declaration_with_full_name(
   memcpy(copy, full_name, len + 1);
 
   // Flag that we now manage the memory this points to.
-  Declaration_pair decl(-1, copy);
+  Declaration_pair decl(-1, copy, NULL);
   this->declarations_.insert(std::make_pair(die->offset(), decl));
 }
 
@@ -806,6 +994,55 @@ Gdb_index_info_reader::get_qualified_name(Dwarf_die* die, Dwarf_die* context)
   return full_name;
 }
 
+// Return the unqualified name of DIE, for the .debug_names section.
+// If DIE has a DW_AT_specification or DW_AT_abstract_origin attribute
+// but no name of its own, use the name from the earlier declaration.
+
+const char*
+Gdb_index_info_reader::get_simple_name(Dwarf_die* die)
+{
+  const char* name = die->name();
+  if (name != NULL)
+    return name;
+
+  off_t spec = die->specification();
+  if (spec == 0)
+    spec = die->abstract_origin();
+  if (spec > 0)
+    {
+      Declaration_map::iterator it = this->declarations_.find(spec);
+      if (it != this->declarations_.end()
+	  && it->second.parent_offset_ != -1)
+	return it->second.name_;
+    }
+
+  if (die->tag() == elfcpp::DW_TAG_namespace)
+    return "(anonymous namespace)";
+  return NULL;
+}
+
+// Return the linkage name of DIE, for the .debug_names section,
+// taking it from the earlier declaration if necessary.
+
+const char*
+Gdb_index_info_reader::get_linkage_name(Dwarf_die* die)
+{
+  const char* linkage_name = die->linkage_name();
+  if (linkage_name != NULL)
+    return linkage_name;
+
+  off_t spec = die->specification();
+  if (spec == 0)
+    spec = die->abstract_origin();
+  if (spec > 0)
+    {
+      Declaration_map::iterator it = this->declarations_.find(spec);
+      if (it != this->declarations_.end())
+	return it->second.linkage_name_;
+    }
+  return NULL;
+}
+
 // Record the address ranges for a compilation unit.
 
 void
@@ -819,8 +1056,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->unit_->ranges = ranges;
       return;
     }
 
@@ -845,8 +1081,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->unit_->ranges = ranges;
         }
     }
 }
@@ -865,8 +1100,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 					     &pubnames_shndx);
   if (pubnames_offset != -1)
     {
-      if (this->gdb_index_->pubnames_read(this->object(), pubnames_shndx,
-                                          pubnames_offset))
+      if (this->scan_->pubnames_read(pubnames_shndx, pubnames_offset))
 	ret = true;
       else
 	{
@@ -880,7 +1114,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 	      const char* name = pubnames.next_name();
 	      if (name == NULL)
 		break;
-	      this->gdb_index_->add_symbol(this->cu_index_, name);
+	      this->add_symbol(name, NULL);
 	    }
 	  ret = true;
 	}
@@ -892,8 +1126,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 					     &pubtypes_shndx);
   if (pubtypes_offset != -1)
     {
-      if (this->gdb_index_->pubtypes_read(this->object(),
-                                          pubtypes_shndx, pubtypes_offset))
+      if (this->scan_->pubtypes_read(pubtypes_shndx, pubtypes_offset))
 	ret = true;
       else
 	{
@@ -907,7 +1140,7 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
 	      const char* name = pubtypes.next_name();
 	      if (name == NULL)
 		break;
-	      this->gdb_index_->add_symbol(this->cu_index_, name);
+	      this->add_symbol(name, NULL);
 	    }
 	  ret = true;
 	}
@@ -932,6 +1165,58 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
+// Add a name to the current unit.  The hash value is computed here,
+// so that the work is done by the scan task rather than the merge.
+// For .debug_names, every DIE gets its own entry under its
+// unqualified name, and another under its linkage name if it has one.
+
+void
+Gdb_index_info_reader::add_symbol(const char* sym_name, Dwarf_die* die)
+{
+  if (this->debug_names_)
+    {
+      gold_assert(die != NULL);
+      const char* name = this->get_simple_name(die);
+      if (name == NULL)
+	return;
+      unsigned int hash = debug_names_string_hash(
+	  reinterpret_cast<const unsigned char*>(name));
+      this->unit_->names.push_back(
+	  Gdb_index_object_scan::Name(name, hash, die->tag(), die->offset()));
+      const char* linkage_name = this->get_linkage_name(die);
+      if (linkage_name != NULL && strcmp(linkage_name, name) != 0)
+	{
+	  hash = debug_names_string_hash(
+	      reinterpret_cast<const unsigned char*>(linkage_name));
+	  this->unit_->names.push_back(
+	      Gdb_index_object_scan::Name(linkage_name, hash, die->tag(),
+					  die->offset()));
+	}
+      return;
+    }
+
+  // A name only needs to be recorded once per unit.
+  if (!this->names_seen_.insert(std::string(sym_name)).second)
+    return;
+  unsigned int hash = mapped_index_string_hash(
+      reinterpret_cast<const unsigned char*>(sym_name));
+  this->unit_->names.push_back(Gdb_index_object_scan::Name(sym_name, hash,
+							   0, 0));
+}
+
+// Add the statistics gathered by SCAN to the totals.
+
+void
+Gdb_index_info_reader::record_stats(const Gdb_index_object_scan* scan)
+{
+  Gdb_index_info_reader::dwarf_cu_count += scan->cu_count;
+  Gdb_index_info_reader::dwarf_cu_nopubnames_count
+    += scan->cu_nopubnames_count;
+  Gdb_index_info_reader::dwarf_tu_count += scan->tu_count;
+  Gdb_index_info_reader::dwarf_tu_nopubnames_count
+    += scan->tu_nopubnames_count;
+}
+
 // Print usage statistics.
 void
 Gdb_index_info_reader::print_stats()
@@ -946,13 +1231,395 @@ Gdb_index_info_reader::print_stats()
           program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
 }
 
+// Class Gdb_index_scan_task.
+
+// This task scans the .debug_info and .debug_types sections of a
+// single object.  It only writes to the Gdb_index_object_scan for that
+// object, so any number of these tasks may run at once.  It unblocks
+// SCAN_BLOCKER when done.
+
+class Gdb_index_scan_task : public Task
+{
+ public:
+  Gdb_index_scan_task(Gdb_index_object_scan* scan, Task_token* scan_blocker)
+    : scan_(scan), scan_blocker_(scan_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    Relobj* object = this->scan_->object;
+    return object->is_locked() ? object->token() : NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  {
+    Task_token* token = this->scan_->object->token();
+    if (token != NULL)
+      tl->add(this, token);
+    tl->add(this, this->scan_blocker_);
+  }
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->scan_->object->name(); }
+
+ private:
+  Gdb_index_object_scan* scan_;
+  Task_token* scan_blocker_;
+};
+
+// Scan the sections.  The symbols were discarded after the object was
+// laid out, so we read them again here for the relocation mapper.
+
+void
+Gdb_index_scan_task::run(Workqueue*)
+{
+  Timer timer;
+  timer.start();
+
+  Relobj* object = this->scan_->object;
+  const unsigned char* symbols = NULL;
+  section_size_type symbols_size = 0;
+  if (this->scan_->symtab_shndx != 0)
+    symbols = object->section_contents(this->scan_->symtab_shndx,
+				       &symbols_size, false);
+
+  for (std::vector<Gdb_index_object_scan::Section>::const_iterator p
+	 = this->scan_->sections.begin();
+       p != this->scan_->sections.end();
+       ++p)
+    {
+      Gdb_index_info_reader dwinfo(p->is_type_unit, object,
+				   symbols, symbols_size,
+				   p->shndx, p->reloc_shndx,
+				   p->reloc_type, this->scan_);
+      dwinfo.parse();
+    }
+
+  object->release();
+
+  this->scan_->scan_time = timer.get_elapsed_time().wall;
+}
+
+// Class Gdb_index_merge_task.
+
+// This task merges the per-object scans into the index once all the
+// Gdb_index_scan_tasks are done.  It also waits for THIS_BLOCKER, so
+// that NEXT_BLOCKER is not unblocked until both the scans and the
+// tasks ahead of us are complete.
+
+class Gdb_index_merge_task : public Task
+{
+ public:
+  Gdb_index_merge_task(Gdb_index* gdb_index, Task_token* this_blocker,
+		       Task_token* scan_blocker, Task_token* next_blocker)
+    : gdb_index_(gdb_index), this_blocker_(this_blocker),
+      scan_blocker_(scan_blocker), next_blocker_(next_blocker)
+  { }
+
+  ~Gdb_index_merge_task()
+  {
+    delete this->this_blocker_;
+    delete this->scan_blocker_;
+  }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->this_blocker_->is_blocked())
+      return this->this_blocker_;
+    if (this->scan_blocker_->is_blocked())
+      return this->scan_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue* workqueue)
+  { this->gdb_index_->merge_scans(workqueue, this->next_blocker_); }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_merge_task"; }
+
+ private:
+  Gdb_index* gdb_index_;
+  Task_token* this_blocker_;
+  Task_token* scan_blocker_;
+  Task_token* next_blocker_;
+};
+
+// Class Gdb_index_symbol_merge.
+
+// This class merges the names found by the scans into the .gdb_index
+// symbol table.  The names are split into shards by hash value, and
+// each shard is merged by its own Gdb_index_symbol_merge_task.  A
+// symbol is recorded at the position of the first occurrence of its
+// name, so that the symbols can then be entered into the hash table
+// in the same order as when the names were added one at a time.
+
+class Gdb_index_symbol_merge
+{
+ public:
+  // A merged symbol.  NAME points into the scan that first saw the
+  // name, and CU_VECTOR lists the units in which it appears.
+  struct Symbol
+  {
+    Symbol()
+      : name(NULL), hash(0), cu_vector(NULL)
+    { }
+    const char* name;
+    unsigned int hash;
+    std::vector<int>* cu_vector;
+  };
+
+  Gdb_index_symbol_merge(const std::vector<Gdb_index_object_scan*>& scans,
+			 size_t name_count, unsigned int shard_count)
+    : scans_(scans), symbols_(name_count), shard_count_(shard_count),
+      merge_time_(0)
+  { }
+
+  ~Gdb_index_symbol_merge()
+  {
+    for (unsigned int i = 0; i < this->scans_.size(); ++i)
+      delete this->scans_[i];
+  }
+
+  // The number of shards.
+  unsigned int
+  shard_count() const
+  { return this->shard_count_; }
+
+  // Merge the names whose hash value falls in shard SHARD.
+  void
+  merge_shard(unsigned int shard);
+
+  // The merged symbols, indexed by the position of the first
+  // occurrence of the name.  Positions which are not the first
+  // occurrence of a name have a NULL name.
+  const std::vector<Symbol>&
+  symbols() const
+  { return this->symbols_; }
+
+  // The total wall time, in milliseconds, of the shard tasks.
+  long
+  merge_time() const
+  { return this->merge_time_; }
+
+ private:
+  // The key of the hash table used to find the names in one shard.
+  struct Key
+  {
+    Key(const char* n, unsigned int h)
+      : name(n), hash(h)
+    { }
+    const char* name;
+    unsigned int hash;
+  };
+
+  struct Key_hash
+  {
+    size_t
+    operator()(const Key& key) const
+    { return key.hash; }
+  };
+
+  struct Key_eq
+  {
+    bool
+    operator()(const Key& k1, const Key& k2) const
+    { return k1.hash == k2.hash && strcmp(k1.name, k2.name) == 0; }
+  };
+
+  // Map from a name to the position of its first occurrence.
+  typedef Unordered_map<Key, size_t, Key_hash, Key_eq> Shard_map;
+
+  // The scans to merge, in the order in which the objects were laid
+  // out.  These are deleted when the merge is done.
+  std::vector<Gdb_index_object_scan*> scans_;
+  // The merged symbols.  Each shard only writes to the entries for
+  // its own names, so the shards may run in parallel.
+  std::vector<Symbol> symbols_;
+  // The number of shards.
+  unsigned int shard_count_;
+  // The wall time of the shard tasks.
+  long merge_time_;
+  // Protects MERGE_TIME_.
+  Lock lock_;
+};
+
+// Merge one shard.  We walk the units in order, so each CU vector
+// lists the units in the same order as the units themselves.
+
+void
+Gdb_index_symbol_merge::merge_shard(unsigned int shard)
+{
+  Timer timer;
+  timer.start();
+
+  Shard_map names;
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    {
+      const Gdb_index_object_scan* scan = this->scans_[i];
+      for (std::vector<Gdb_index_object_scan::Unit>::const_iterator p
+	     = scan->units.begin();
+	   p != scan->units.end();
+	   ++p)
+	{
+	  size_t pos = p->first_name;
+	  for (std::vector<Gdb_index_object_scan::Name>::const_iterator q
+		 = p->names.begin();
+	       q != p->names.end();
+	       ++q, ++pos)
+	    {
+	      if (q->hash % this->shard_count_ != shard)
+		continue;
+
+	      std::pair<Shard_map::iterator, bool> ins =
+		names.insert(std::make_pair(Key(q->name.c_str(), q->hash),
+					    pos));
+	      Symbol* sym = &this->symbols_[ins.first->second];
+	      if (ins.second)
+		{
+		  sym->name = q->name.c_str();
+		  sym->hash = q->hash;
+		  sym->cu_vector = new std::vector<int>();
+		}
+
+	      // We only need to check the last added entry, since the
+	      // units are visited in order.
+	      std::vector<int>* cu_vec = sym->cu_vector;
+	      if (cu_vec->empty() || cu_vec->back() != p->cu_index)
+		cu_vec->push_back(p->cu_index);
+	    }
+	}
+    }
+
+  long elapsed = timer.get_elapsed_time().wall;
+  Hold_lock hl(this->lock_);
+  this->merge_time_ += elapsed;
+}
+
+// Class Gdb_index_symbol_merge_task.
+
+// This task merges one shard of the symbols.  It unblocks
+// SHARD_BLOCKER when done.
+
+class Gdb_index_symbol_merge_task : public Task
+{
+ public:
+  Gdb_index_symbol_merge_task(Gdb_index_symbol_merge* merge,
+			      unsigned int shard, Task_token* shard_blocker)
+    : merge_(merge), shard_(shard), shard_blocker_(shard_blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->shard_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->merge_->merge_shard(this->shard_); }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_symbol_merge_task"; }
+
+ private:
+  Gdb_index_symbol_merge* merge_;
+  unsigned int shard_;
+  Task_token* shard_blocker_;
+};
+
+// Class Gdb_index_add_symbols_task.
+
+// This task adds the merged symbols to the index once all the
+// Gdb_index_symbol_merge_tasks are done, and then unblocks
+// NEXT_BLOCKER.
+
+class Gdb_index_add_symbols_task : public Task
+{
+ public:
+  Gdb_index_add_symbols_task(Gdb_index* gdb_index,
+			     Gdb_index_symbol_merge* merge,
+			     Task_token* shard_blocker,
+			     Task_token* next_blocker)
+    : gdb_index_(gdb_index), merge_(merge), shard_blocker_(shard_blocker),
+      next_blocker_(next_blocker)
+  { }
+
+  ~Gdb_index_add_symbols_task()
+  {
+    delete this->merge_;
+    delete this->shard_blocker_;
+  }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  {
+    if (this->shard_blocker_->is_blocked())
+      return this->shard_blocker_;
+    return NULL;
+  }
+
+  void
+  locks(Task_locker* tl)
+  { tl->add(this, this->next_blocker_); }
+
+  void
+  run(Workqueue*)
+  { this->gdb_index_->add_merged_symbols(this->merge_); }
+
+  std::string
+  get_name() const
+  { return "Gdb_index_add_symbols_task"; }
+
+ private:
+  Gdb_index* gdb_index_;
+  Gdb_index_symbol_merge* merge_;
+  Task_token* shard_blocker_;
+  Task_token* next_blocker_;
+};
+
 // Class Gdb_index.
 
+// The number of shards to use when merging the symbols, if the thread
+// count was not given.
+const unsigned int gdb_index_default_merge_shards = 8;
+
+// Statistics.
+long Gdb_index::scan_time = 0;
+long Gdb_index::merge_time = 0;
+long Gdb_index::symbol_merge_time = 0;
+
 // Construct the .gdb_index section.
 
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
+Gdb_index::Gdb_index(Output_section* gdb_index_section,
+		     Output_section* debug_str_section)
   : Output_section_data(4),
     gdb_index_section_(gdb_index_section),
+    scans_(),
+    last_scan_object_(NULL),
     comp_units_(),
     type_units_(),
     ranges_(),
@@ -964,14 +1631,20 @@ Gdb_index::Gdb_index(Output_section* gdb_index_section)
     symtab_offset_(0),
     cu_pool_offset_(0),
     stringpool_offset_(0),
-    pubnames_object_(NULL),
-    pubnames_shndx_(0),
-    pubnames_offset_(0),
-    pubtypes_object_(NULL),
-    pubtypes_shndx_(0),
-    pubtypes_offset_(0)
+    debug_names_(),
+    debug_name_map_(),
+    debug_str_pool_(),
+    debug_str_data_(NULL),
+    debug_names_contents_(),
+    debug_names_order_(),
+    debug_names_str_offset_(0)
 {
   this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  if (debug_str_section != NULL)
+    {
+      this->debug_str_data_ = new Output_data_strtab(&this->debug_str_pool_);
+      debug_str_section->add_output_section_data(this->debug_str_data_);
+    }
 }
 
 Gdb_index::~Gdb_index()
@@ -981,88 +1654,205 @@ Gdb_index::~Gdb_index()
   // Free the memory used by the CU vectors.
   for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
     delete this->cu_vector_list_[i];
+  // Free any scans that were never merged.
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    delete this->scans_[i];
 }
 
-// Scan a .debug_info or .debug_types input section.
+// Record a .debug_info or .debug_types input section to be scanned.
+// All the sections for one object are recorded consecutively, and
+// are scanned together by a single task.
 
 void
 Gdb_index::scan_debug_info(bool is_type_unit,
 			   Relobj* object,
-			   const unsigned char* symbols,
-			   off_t symbols_size,
+			   unsigned int symtab_shndx,
 			   unsigned int shndx,
 			   unsigned int reloc_shndx,
 			   unsigned int reloc_type)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  dwinfo.parse();
+  if (this->scans_.empty() || this->last_scan_object_ != object)
+    {
+      this->scans_.push_back(new Gdb_index_object_scan(object, symtab_shndx));
+      this->last_scan_object_ = object;
+    }
+  this->scans_.back()->sections.push_back(
+      Gdb_index_object_scan::Section(is_type_unit, shndx, reloc_shndx,
+				     reloc_type));
 }
 
-// Add a symbol.
+// Queue a Gdb_index_scan_task for each object, and a
+// Gdb_index_merge_task to combine the results.
+
+Task_token*
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* this_blocker)
+{
+  Task_token* scan_blocker = new Task_token(true);
+  scan_blocker->add_blockers(this->scans_.size());
+  Task_token* next_blocker = new Task_token(true);
+  next_blocker->add_blocker();
+
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
+    workqueue->queue(new Gdb_index_scan_task(this->scans_[i], scan_blocker));
+
+  workqueue->queue(new Gdb_index_merge_task(this, this_blocker, scan_blocker,
+					    next_blocker));
+  return next_blocker;
+}
+
+// Merge the results of the per-object scans into the index.  We
+// process the objects in the order in which they were laid out, so
+// the CU and TU lists, the address area, and the order in which the
+// symbols are entered into the hash table are the same as when the
+// objects were scanned one at a time.  The units are numbered here;
+// for a .gdb_index section, the symbols are then merged by
+// Gdb_index_symbol_merge_tasks, and a Gdb_index_add_symbols_task
+// unblocks NEXT_BLOCKER once they have been added to the index.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name)
+Gdb_index::merge_scans(Workqueue* workqueue, Task_token* next_blocker)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
-  Gdb_symbol* sym = new Gdb_symbol();
-  this->stringpool_.add(sym_name, true, &sym->name_key);
-  sym->hashval = hash;
-  sym->cu_vector_index = 0;
+  Timer timer;
+  timer.start();
 
-  Gdb_symbol* found = this->gdb_symtab_->add(sym);
-  if (found == sym)
+  size_t name_count = 0;
+  for (unsigned int i = 0; i < this->scans_.size(); ++i)
     {
-      // New symbol -- allocate a new CU index vector.
-      found->cu_vector_index = this->cu_vector_list_.size();
-      this->cu_vector_list_.push_back(new Cu_vector());
+      Gdb_index_object_scan* scan = this->scans_[i];
+      Gdb_index_info_reader::record_stats(scan);
+      Gdb_index::scan_time += scan->scan_time;
+
+      for (std::vector<Gdb_index_object_scan::Unit>::iterator p
+	     = scan->units.begin();
+	   p != scan->units.end();
+	   ++p)
+	{
+	  if (this->is_debug_names())
+	    {
+	      // We do not list type units in .debug_names, so we
+	      // have nowhere to put their names.
+	      if (p->is_type_unit)
+		continue;
+	      unsigned int cu_index = this->add_comp_unit(p->offset,
+							  p->length);
+	      for (std::vector<Gdb_index_object_scan::Name>::const_iterator q
+		     = p->names.begin();
+		   q != p->names.end();
+		   ++q)
+		this->add_debug_name(cu_index, q->name.c_str(), q->hash,
+				     q->tag, q->die_offset);
+	      continue;
+	    }
+
+	  // Use a negative index to flag a TU instead of a CU.
+	  if (p->is_type_unit)
+	    p->cu_index = -1 - this->add_type_unit(p->offset, p->type_offset,
+						   p->signature);
+	  else
+	    p->cu_index = this->add_comp_unit(p->offset, p->length);
+
+	  if (p->ranges != NULL)
+	    this->add_address_range_list(scan->object, p->cu_index,
+					 p->ranges);
+
+	  p->first_name = name_count;
+	  name_count += p->names.size();
+	}
+    }
+
+  if (this->is_debug_names())
+    {
+      for (unsigned int i = 0; i < this->scans_.size(); ++i)
+	delete this->scans_[i];
     }
   else
     {
-      // Found an existing symbol -- append to the existing
-      // CU index vector.
-      delete sym;
+      unsigned int shard_count = 1;
+#ifdef ENABLE_THREADS
+      if (parameters->options().threads())
+	{
+	  int thread_count = parameters->options().thread_count_middle();
+	  shard_count = (thread_count > 0
+			 ? thread_count
+			 : gdb_index_default_merge_shards);
+	}
+#endif
+
+      // The merge takes ownership of the scans.
+      Gdb_index_symbol_merge* merge =
+	new Gdb_index_symbol_merge(this->scans_, name_count, shard_count);
+
+      // Every Gdb_index_symbol_merge_task must be counted before any
+      // is queued.
+      Task_token* shard_blocker = new Task_token(true);
+      shard_blocker->add_blockers(shard_count);
+
+      // The new task will unblock NEXT_BLOCKER in turn.
+      next_blocker->add_blocker();
+      for (unsigned int i = 0; i < shard_count; ++i)
+	workqueue->queue_soon(new Gdb_index_symbol_merge_task(merge, i,
+							      shard_blocker));
+      workqueue->queue_next(new Gdb_index_add_symbols_task(this, merge,
+							    shard_blocker,
+							    next_blocker));
     }
+  this->scans_.clear();
+  this->last_scan_object_ = NULL;
 
-  // Add the CU index to the vector list for this symbol,
-  // if it's not already on the list.  We only need to
-  // check the last added entry.
-  Cu_vector* cu_vec = this->cu_vector_list_[found->cu_vector_index];
-  if (cu_vec->size() == 0 || cu_vec->back() != cu_index)
-    cu_vec->push_back(cu_index);
+  Gdb_index::merge_time += timer.get_elapsed_time().wall;
 }
 
-// Return TRUE if we have already processed the pubnames set at
-// OFFSET in section SHNDX
+// Add the symbols merged by MERGE to the symbol table, in the order
+// in which their names were first seen.
 
-bool
-Gdb_index::pubnames_read(const Relobj* object, unsigned int shndx, off_t offset)
+void
+Gdb_index::add_merged_symbols(const Gdb_index_symbol_merge* merge)
 {
-  bool ret = (this->pubnames_object_ == object
-              && this->pubnames_shndx_ == shndx
-	      && this->pubnames_offset_ == offset);
-  this->pubnames_object_ = object;
-  this->pubnames_shndx_ = shndx;
-  this->pubnames_offset_ = offset;
-  return ret;
+  Timer timer;
+  timer.start();
+
+  const std::vector<Gdb_index_symbol_merge::Symbol>& symbols =
+    merge->symbols();
+  for (std::vector<Gdb_index_symbol_merge::Symbol>::const_iterator p
+	 = symbols.begin();
+       p != symbols.end();
+       ++p)
+    {
+      if (p->name == NULL)
+	continue;
+
+      Gdb_symbol* sym = new Gdb_symbol();
+      this->stringpool_.add(p->name, true, &sym->name_key);
+      sym->hashval = p->hash;
+      sym->cu_vector_index = this->cu_vector_list_.size();
+      Gdb_symbol* found = this->gdb_symtab_->add(sym);
+      gold_assert(found == sym);
+      this->cu_vector_list_.push_back(p->cu_vector);
+    }
+
+  Gdb_index::symbol_merge_time += merge->merge_time();
+  Gdb_index::merge_time += timer.get_elapsed_time().wall;
 }
 
-// Return TRUE if we have already processed the pubtypes set at
-// OFFSET in section SHNDX
+// Add a .debug_names entry.  All the entries for a name are kept
+// together, in the order in which they were added.
 
-bool
-Gdb_index::pubtypes_read(const Relobj* object, unsigned int shndx, off_t offset)
+void
+Gdb_index::add_debug_name(unsigned int cu_index, const char* name,
+			  unsigned int hash, unsigned int tag,
+			  off_t die_offset)
 {
-  bool ret = (this->pubtypes_object_ == object
-              && this->pubtypes_shndx_ == shndx
-	      && this->pubtypes_offset_ == offset);
-  this->pubtypes_object_ = object;
-  this->pubtypes_shndx_ = shndx;
-  this->pubtypes_offset_ = offset;
-  return ret;
+  Stringpool::Key name_key;
+  this->debug_str_pool_.add(name, true, &name_key);
+
+  std::pair<Debug_name_map::iterator, bool> ins =
+    this->debug_name_map_.insert(std::make_pair(name_key,
+						this->debug_names_.size()));
+  if (ins.second)
+    this->debug_names_.push_back(Debug_name(name_key, hash));
+
+  this->debug_names_[ins.first->second].entries.push_back(
+      Debug_names_entry(cu_index, tag, die_offset));
 }
 
 // Set the size of the .gdb_index section.
@@ -1070,6 +1860,12 @@ Gdb_index::pubtypes_read(const Relobj* object, unsigned int shndx, off_t offset)
 void
 Gdb_index::set_final_data_size()
 {
+  if (this->is_debug_names())
+    {
+      this->set_debug_names_data_size();
+      return;
+    }
+
   // Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
@@ -1110,6 +1906,16 @@ Gdb_index::set_final_data_size()
 void
 Gdb_index::do_write(Output_file* of)
 {
+  if (this->is_debug_names())
+    {
+      const off_t off = this->offset();
+      const off_t oview_size = this->data_size();
+      unsigned char* const oview = of->get_output_view(off, oview_size);
+      this->write_debug_names(oview);
+      of->write_output_view(off, oview_size, oview);
+      return;
+    }
+
   const off_t off = this->offset();
   const off_t oview_size = this->data_size();
   unsigned char* const oview = of->get_output_view(off, oview_size);
@@ -1234,12 +2040,202 @@ Gdb_index::do_write(Output_file* of)
   of->write_output_view(off, oview_size, oview);
 }
 
+// Set the size of the .debug_names section.  Everything except the
+// string offsets can be computed now, so we build the contents here.
+// The string offsets depend on where our strings land in .debug_str,
+// which is not known until the output sections have been laid out.
+
+void
+Gdb_index::set_debug_names_data_size()
+{
+  unsigned int name_count = this->debug_names_.size();
+
+  // Choose the number of hash buckets.
+  unsigned int bucket_count;
+  if (name_count > 1024)
+    bucket_count = name_count / 4;
+  else if (name_count > 16)
+    bucket_count = name_count / 2;
+  else
+    bucket_count = name_count;
+
+  // The names in a bucket must be contiguous in the name table.
+  // Within a bucket we keep the names in the order they were added,
+  // so that the output does not depend on the hash table layout.
+  std::vector<std::pair<unsigned int, unsigned int> > sorted;
+  sorted.reserve(name_count);
+  for (unsigned int i = 0; i < name_count; ++i)
+    sorted.push_back(std::make_pair(this->debug_names_[i].hashval
+				    % bucket_count, i));
+  std::sort(sorted.begin(), sorted.end());
+  this->debug_names_order_.clear();
+  this->debug_names_order_.reserve(name_count);
+  for (unsigned int i = 0; i < name_count; ++i)
+    this->debug_names_order_.push_back(sorted[i].second);
+
+  // Build the abbreviation table, with one abbreviation for each DIE
+  // tag, and the entry pool.  Each entry records the index of its
+  // compilation unit and the offset of its DIE within that unit.
+  std::vector<unsigned char> abbrevs;
+  std::vector<unsigned char> entry_pool;
+  std::vector<uint32_t> entry_offsets;
+  entry_offsets.reserve(name_count);
+  Unordered_map<unsigned int, unsigned int> abbrev_codes;
+  for (unsigned int i = 0; i < name_count; ++i)
+    {
+      const Debug_name& name(this->debug_names_[this->debug_names_order_[i]]);
+      entry_offsets.push_back(entry_pool.size());
+      for (unsigned int j = 0; j < name.entries.size(); ++j)
+	{
+	  const Debug_names_entry& entry(name.entries[j]);
+	  std::pair<Unordered_map<unsigned int, unsigned int>::iterator,
+		    bool> ins =
+	    abbrev_codes.insert(std::make_pair(entry.tag,
+					       abbrev_codes.size() + 1));
+	  unsigned int code = ins.first->second;
+	  if (ins.second)
+	    {
+	      write_unsigned_LEB_128(&abbrevs, code);
+	      write_unsigned_LEB_128(&abbrevs, entry.tag);
+	      write_unsigned_LEB_128(&abbrevs, elfcpp::DW_IDX_compile_unit);
+	      write_unsigned_LEB_128(&abbrevs, elfcpp::DW_FORM_udata);
+	      write_unsigned_LEB_128(&abbrevs, elfcpp::DW_IDX_die_offset);
+	      write_unsigned_LEB_128(&abbrevs, elfcpp::DW_FORM_ref4);
+	      write_unsigned_LEB_128(&abbrevs, 0);
+	      write_unsigned_LEB_128(&abbrevs, 0);
+	    }
+	  write_unsigned_LEB_128(&entry_pool, code);
+	  write_unsigned_LEB_128(&entry_pool, entry.cu_index);
+	  insert_into_vector<32>(&entry_pool, entry.die_offset);
+	}
+      // The list of entries for a name ends with a zero code.
+      write_unsigned_LEB_128(&entry_pool, 0);
+    }
+  write_unsigned_LEB_128(&abbrevs, 0);
+
+  unsigned int comp_units_count = this->comp_units_.size();
+  section_size_type data_size = (debug_names_hdr_size
+				 + comp_units_count * 4
+				 + bucket_count * 4
+				 + name_count * 4 * 3
+				 + abbrevs.size()
+				 + entry_pool.size());
+
+  std::vector<unsigned char>& contents(this->debug_names_contents_);
+  contents.clear();
+  contents.reserve(data_size);
+
+  // Write the header.
+  insert_into_vector<32>(&contents, data_size - 4);
+  insert_into_vector<16>(&contents, debug_names_version);
+  insert_into_vector<16>(&contents, 0);
+  insert_into_vector<32>(&contents, comp_units_count);
+  // We do not list any local or foreign type units.
+  insert_into_vector<32>(&contents, 0);
+  insert_into_vector<32>(&contents, 0);
+  insert_into_vector<32>(&contents, bucket_count);
+  insert_into_vector<32>(&contents, name_count);
+  insert_into_vector<32>(&contents, abbrevs.size());
+  // No augmentation string.
+  insert_into_vector<32>(&contents, 0);
+  gold_assert(contents.size() == static_cast<size_t>(debug_names_hdr_size));
+
+  // Write the CU list.
+  for (unsigned int i = 0; i < comp_units_count; ++i)
+    insert_into_vector<32>(&contents, this->comp_units_[i].cu_offset);
+
+  // Write the hash table: for each bucket, the one-based index of the
+  // first name in that bucket, or zero if it is empty, followed by
+  // the hash value of each name.
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < bucket_count; ++i)
+    {
+      if (n < name_count && sorted[n].first == i)
+	{
+	  insert_into_vector<32>(&contents, n + 1);
+	  while (n < name_count && sorted[n].first == i)
+	    ++n;
+	}
+      else
+	insert_into_vector<32>(&contents, 0);
+    }
+  for (unsigned int i = 0; i < name_count; ++i)
+    insert_into_vector<32>(&contents,
+			   this->debug_names_[sorted[i].second].hashval);
+
+  // Leave room for the string offsets.
+  this->debug_names_str_offset_ = contents.size();
+  contents.resize(contents.size() + name_count * 4, 0);
+
+  // Write the entry offsets, the abbreviation table, and the entry pool.
+  for (unsigned int i = 0; i < name_count; ++i)
+    insert_into_vector<32>(&contents, entry_offsets[i]);
+  contents.insert(contents.end(), abbrevs.begin(), abbrevs.end());
+  contents.insert(contents.end(), entry_pool.begin(), entry_pool.end());
+
+  gold_assert(contents.size() == data_size);
+  this->set_data_size(data_size);
+}
+
+// Write the data to a buffer.
+
+void
+Gdb_index::do_write_to_buffer(unsigned char* buffer)
+{
+  // Only a .debug_names section is ever compressed.
+  gold_assert(this->is_debug_names());
+  this->write_debug_names(buffer);
+}
+
+// Write the contents of the .debug_names section to OVIEW.
+
+void
+Gdb_index::write_debug_names(unsigned char* oview)
+{
+  const std::vector<unsigned char>& contents(this->debug_names_contents_);
+  gold_assert(contents.size() == static_cast<size_t>(this->data_size()));
+  memcpy(oview, &contents[0], contents.size());
+
+  // Fill in the offset of each name in the .debug_str section.  Our
+  // strings follow the input .debug_str sections, and since that
+  // section is not allocated, the address of our data is its offset
+  // within the section.
+  const bool big_endian = parameters->target().is_big_endian();
+  const uint64_t str_base = this->debug_str_data_->address();
+  unsigned char* pov = oview + this->debug_names_str_offset_;
+  for (unsigned int i = 0; i < this->debug_names_order_.size(); ++i)
+    {
+      const Debug_name& name(this->debug_names_[this->debug_names_order_[i]]);
+      uint32_t str_offset = (str_base
+			     + this->debug_str_pool_.get_offset_from_key(
+				 name.name_key));
+      if (big_endian)
+	elfcpp::Swap_unaligned<32, true>::writeval(pov, str_offset);
+      else
+	elfcpp::Swap_unaligned<32, false>::writeval(pov, str_offset);
+      pov += 4;
+    }
+}
+
 // Print usage statistics.
 void
 Gdb_index::print_stats()
 {
-  if (parameters->options().gdb_index())
-    Gdb_index_info_reader::print_stats();
+  if (parameters->options().gdb_index()
+      || parameters->options().debug_names())
+    {
+      Gdb_index_info_reader::print_stats();
+      fprintf(stderr, _("%s: DWARF scan time (all tasks): %ld.%03ld\n"),
+	      program_name, Gdb_index::scan_time / 1000,
+	      Gdb_index::scan_time % 1000);
+      fprintf(stderr, _("%s: gdb_index merge time: %ld.%03ld\n"),
+	      program_name, Gdb_index::merge_time / 1000,
+	      Gdb_index::merge_time % 1000);
+      fprintf(stderr, _("%s: gdb_index symbol merge time (all tasks): "
+			"%ld.%03ld\n"),
+	      program_name, Gdb_index::symbol_merge_time / 1000,
+	      Gdb_index::symbol_merge_time % 1000);
+    }
 }
 
 } // End namespace gold.
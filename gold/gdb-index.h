@@ -42,27 +42,58 @@ class Sized_relobj;
 class Dwarf_range_list;
 template <typename T>
 class Gdb_hashtab;
+class Gdb_index_object_scan;
+class Gdb_index_symbol_merge;
+class Workqueue;
+class Task_token;
 
 // This class manages the .gdb_index section, which is a fast
 // lookup table for DWARF information used by the gdb debugger.
 // The format of this section is described in gdb/doc/gdb.texinfo.
+// With --debug-names, the same scan is used to build the standard
+// DWARF 5 .debug_names name index instead, whose strings are
+// appended to the .debug_str section.  The .debug_names section only
+// indexes compilation units; names in type units are left out.
 
 class Gdb_index : public Output_section_data
 {
  public:
-  Gdb_index(Output_section* gdb_index_section);
+  // DEBUG_STR_SECTION is the .debug_str output section when building
+  // a .debug_names section, or NULL when building a .gdb_index section.
+  Gdb_index(Output_section* gdb_index_section,
+	    Output_section* debug_str_section);
 
   ~Gdb_index();
 
-  // Scan a .debug_info or .debug_types input section.
+  // Record a .debug_info or .debug_types input section to be
+  // scanned.  The scan itself is done later by a Gdb_index_scan_task,
+  // one per object, so that objects may be scanned in parallel.
   void scan_debug_info(bool is_type_unit,
 		       Relobj* object,
-		       const unsigned char* symbols,
-		       off_t symbols_size,
+		       unsigned int symtab_shndx,
 		       unsigned int shndx,
 		       unsigned int reloc_shndx,
 		       unsigned int reloc_type);
 
+  // Queue the tasks to scan the recorded sections, followed by a task
+  // to merge the results into the index.  The merge task will not run
+  // until THIS_BLOCKER is unblocked.  Return a blocker that will be
+  // unblocked when the merge is complete.
+  Task_token*
+  queue_scan_tasks(Workqueue* workqueue, Task_token* this_blocker);
+
+  // Merge the results of the per-object scans into the index.  This
+  // is called by Gdb_index_merge_task after all the scans are done.
+  // It may queue more tasks to finish the merge, in which case it
+  // adds a blocker to NEXT_BLOCKER for them.
+  void
+  merge_scans(Workqueue* workqueue, Task_token* next_blocker);
+
+  // Add the symbols merged by the Gdb_index_symbol_merge_tasks to the
+  // symbol table.
+  void
+  add_merged_symbols(const Gdb_index_symbol_merge* merge);
+
   // Add a compilation unit.
   int
   add_comp_unit(off_t cu_offset, off_t cu_length)
@@ -87,19 +118,16 @@ class Gdb_index : public Output_section_data
     this->ranges_.push_back(Per_cu_range_list(object, cu_index, ranges));
   }
 
-  // Add a symbol.
+  // Add a .debug_names entry for the DIE at DIE_OFFSET within
+  // compilation unit CU_INDEX.
   void
-  add_symbol(int cu_index, const char* sym_name);
+  add_debug_name(unsigned int cu_index, const char* name, unsigned int hash,
+		 unsigned int tag, off_t die_offset);
 
-  // Return TRUE if we have already processed the pubnames set for
-  // OBJECT at OFFSET in section SHNDX
+  // Return whether we are building a .debug_names section.
   bool
-  pubnames_read(const Relobj* object, unsigned int shndx, off_t offset);
-
-  // Return TRUE if we have already processed the pubtypes set for
-  // OBJECT at OFFSET in section SHNDX
-  bool
-  pubtypes_read(const Relobj* object,  unsigned int shndx, off_t offset);
+  is_debug_names() const
+  { return this->debug_str_data_ != NULL; }
 
   // Print usage statistics.
   static void
@@ -120,10 +148,19 @@ class Gdb_index : public Output_section_data
   void
   do_write(Output_file*);
 
+  // Write the data to a buffer.  This is used when a .debug_names
+  // section is compressed.
+  void
+  do_write_to_buffer(unsigned char* buffer);
+
   // Write to a map file.
   void
   do_print_to_mapfile(Mapfile* mapfile) const
-  { mapfile->print_output_data(this, _("** gdb_index")); }
+  {
+    mapfile->print_output_data(this, (this->is_debug_names()
+				      ? _("** debug_names")
+				      : _("** gdb_index")));
+  }
 
  private:
   // An entry in the compilation unit list.
@@ -178,8 +215,46 @@ class Gdb_index : public Output_section_data
 
   typedef std::vector<int> Cu_vector;
 
+  // An entry in the .debug_names entry pool.
+  struct Debug_names_entry
+  {
+    Debug_names_entry(unsigned int index, unsigned int t, uint32_t off)
+      : cu_index(index), tag(t), die_offset(off)
+    { }
+    unsigned int cu_index;
+    unsigned int tag;
+    uint32_t die_offset;
+  };
+
+  // A name in the .debug_names name table, with its index entries.
+  struct Debug_name
+  {
+    Debug_name(Stringpool::Key key, unsigned int hash)
+      : name_key(key), hashval(hash), entries()
+    { }
+    Stringpool::Key name_key;
+    unsigned int hashval;
+    std::vector<Debug_names_entry> entries;
+  };
+
+  typedef Unordered_map<Stringpool::Key, unsigned int> Debug_name_map;
+
+  // Set the final data size of a .debug_names section.
+  void
+  set_debug_names_data_size();
+
+  // Write the contents of a .debug_names section to OVIEW.
+  void
+  write_debug_names(unsigned char* oview);
+
   // The .gdb_index section.
   Output_section* gdb_index_section_;
+  // The per-object scans, in the order in which the objects were
+  // laid out.  The merge walks this list in order so that the
+  // resulting index does not depend on the order the scans finish.
+  std::vector<Gdb_index_object_scan*> scans_;
+  // The object most recently passed to scan_debug_info.
+  Relobj* last_scan_object_;
   // The list of DWARF compilation units.
   std::vector<Comp_unit> comp_units_;
   // The list of DWARF type units.
@@ -200,14 +275,31 @@ class Gdb_index : public Output_section_data
   off_t symtab_offset_;
   off_t cu_pool_offset_;
   off_t stringpool_offset_;
-  // Object, section index and offset of last read pubnames section.
-  const Relobj* pubnames_object_;
-  unsigned int pubnames_shndx_;
-  off_t pubnames_offset_;
-  // Object, section index and offset of last read pubtypes section.
-  const Relobj* pubtypes_object_;
-  unsigned int pubtypes_shndx_;
-  off_t pubtypes_offset_;
+  // The .debug_names name table, in the order the names were added.
+  std::vector<Debug_name> debug_names_;
+  // Map from a name to its index in DEBUG_NAMES_.
+  Debug_name_map debug_name_map_;
+  // The strings for the .debug_names section, and the data we add to
+  // the .debug_str section to hold them.
+  Stringpool debug_str_pool_;
+  Output_data_strtab* debug_str_data_;
+  // The contents of the .debug_names section, built by
+  // set_debug_names_data_size, except for the string offsets, which
+  // are filled in when we write the section.
+  std::vector<unsigned char> debug_names_contents_;
+  // The order in which the names are written, and the offset of the
+  // string offsets array within the .debug_names section.
+  std::vector<unsigned int> debug_names_order_;
+  off_t debug_names_str_offset_;
+
+  // Statistics.
+  // Total wall time, in milliseconds, spent in the scan tasks.
+  static long scan_time;
+  // Wall time, in milliseconds, spent merging the scans, not
+  // counting the symbol merge tasks.
+  static long merge_time;
+  // Total wall time, in milliseconds, spent in the symbol merge tasks.
+  static long symbol_merge_time;
 };
 
 } // End namespace gold.
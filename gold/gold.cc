@@ -67,8 +67,15 @@ gold_exit(Exit_status status)
       && parameters->options_valid()
       && parameters->options().has_plugins())
     parameters->options().plugins()->cleanup();
-  if (status != GOLD_OK && parameters != NULL && parameters->options_valid())
-    unlink_if_ordinary(parameters->options().output_file_name());
+  if (parameters != NULL && parameters->options_valid())
+    {
+      // With --rename-output-file, the output file is only replaced
+      // if the link succeeds.
+      if (!Output_file::finish_temporary_output(status == GOLD_OK))
+	status = GOLD_ERR;
+      if (status != GOLD_OK && !Output_file::output_file_untouched())
+	unlink_if_ordinary(parameters->options().output_file_name());
+    }
   exit(status);
 }
 
@@ -167,6 +174,74 @@ Gc_runner::run(Workqueue* workqueue, const Task* task)
 			this->mapfile_);
 }
 
+// Queue up the tasks to read and scan the relocs when the target can
+// prescan them.  The relocs of all the objects are read and prescanned
+// in parallel.  After that, the relocs which may need a GOT or PLT
+// entry or a dynamic reloc are scanned one object at a time, in order,
+// so that those entries are allocated in a deterministic order.
+// FINAL_BLOCKER is unblocked when the last object has been scanned.
+
+static void
+queue_prescan_relocs_tasks(const Input_objects* input_objects,
+			   Symbol_table* symtab, Layout* layout,
+			   Workqueue* workqueue, Task_token* final_blocker)
+{
+  // Every Read_relocs task must be counted before any is queued, or
+  // the first Scan_relocs task could start while others prescan.
+  Task_token* prescan_blocker = new Task_token(true);
+  int remaining = input_objects->number_of_relobjs();
+  for (int i = 0; i < remaining; ++i)
+    prescan_blocker->add_blocker();
+
+  Task_token* this_blocker = prescan_blocker;
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Task_token* next_blocker;
+      if (--remaining == 0)
+	next_blocker = final_blocker;
+      else
+	{
+	  next_blocker = new Task_token(true);
+	  next_blocker->add_blocker();
+	}
+      workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
+				       next_blocker, prescan_blocker));
+      this_blocker = next_blocker;
+    }
+}
+
+// This class queues the tasks to read and prescan the relocs once the
+// common symbols have been allocated, since prescanning looks at the
+// symbols.
+
+class Prescan_runner : public Task_function_runner
+{
+ public:
+  Prescan_runner(const Input_objects* input_objects, Symbol_table* symtab,
+		 Layout* layout, Task_token* final_blocker)
+    : input_objects_(input_objects), symtab_(symtab), layout_(layout),
+      final_blocker_(final_blocker)
+  { }
+
+  void
+  run(Workqueue*, const Task*);
+
+ private:
+  const Input_objects* input_objects_;
+  Symbol_table* symtab_;
+  Layout* layout_;
+  Task_token* final_blocker_;
+};
+
+void
+Prescan_runner::run(Workqueue* workqueue, const Task*)
+{
+  queue_prescan_relocs_tasks(this->input_objects_, this->symtab_,
+			     this->layout_, workqueue, this->final_blocker_);
+}
+
 // Queue up the initial set of tasks for this link job.
 
 void
@@ -191,11 +266,6 @@ queue_initial_tasks(const General_options& options,
       gold_fatal(_("no input files"));
     }
 
-  int thread_count = options.thread_count_initial();
-  if (thread_count == 0)
-    thread_count = cmdline.number_of_input_files();
-  workqueue->set_thread_count(thread_count);
-
   // For incremental links, the base output file.
   Incremental_binary* ibase = NULL;
 
@@ -231,8 +301,13 @@ queue_initial_tasks(const General_options& options,
   Task_token* this_blocker = NULL;
   if (ibase == NULL)
     {
-      // Normal link.  Queue a Read_symbols task for each input file
-      // on the command line.
+      // Normal link.  Start reading ahead of the Read_symbols tasks
+      // if asked.
+      if (options.prefetch_inputs())
+	Prefetch_inputs::queue_initial(workqueue, cmdline);
+
+      // Queue a Read_symbols task for each input file on the command
+      // line.
       for (Command_line::const_iterator p = cmdline.begin();
 	   p != cmdline.end();
 	   ++p)
@@ -304,6 +379,21 @@ queue_initial_tasks(const General_options& options,
 					 this_blocker,
 					 "Task_function Middle_runner"));
     }
+
+  // Start the threads only now that the tasks are queued.  A thread
+  // which finds nothing to do and nothing running exits, so starting
+  // them any earlier can leave the link with just the main thread.
+  int thread_count = options.thread_count_initial();
+  if (thread_count == 0)
+    {
+      thread_count = cmdline.number_of_input_files();
+      // Files which a plugin adds from its all-symbols-read handler
+      // are read while the handler is still running, so keep a thread
+      // free for them.
+      if (options.has_plugins())
+	thread_count = std::max(2, thread_count);
+    }
+  workqueue->set_thread_count(thread_count);
 }
 
 // Process an incremental input file: if it is unchanged from the previous
@@ -454,7 +544,7 @@ queue_middle_gc_tasks(const General_options& options,
       Task_token* next_blocker = new Task_token(true);
       next_blocker->add_blocker();
       workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
-				       next_blocker));
+				       next_blocker, NULL));
       this_blocker = next_blocker;
     }
 
@@ -725,6 +815,29 @@ queue_middle_tasks(const General_options& options,
 	  this_blocker = next_blocker;
 	}
     }
+  else if (parameters->options().threads()
+	   && target->can_prescan_relocs()
+	   && !parameters->options().relocatable()
+	   && input_objects->number_of_relobjs() > 0)
+    {
+      // Read and prescan the relocations of the input files in
+      // parallel, and then scan the relocations which need it one
+      // file at a time.  Prescanning looks at the symbols, so it must
+      // wait for the common symbols to be allocated.
+      Task_token* final_blocker = new Task_token(true);
+      final_blocker->add_blocker();
+      if (this_blocker == NULL)
+	queue_prescan_relocs_tasks(input_objects, symtab, layout, workqueue,
+				   final_blocker);
+      else
+	{
+	  Prescan_runner* runner = new Prescan_runner(input_objects, symtab,
+						      layout, final_blocker);
+	  workqueue->queue(new Task_function(runner, this_blocker,
+					     "Task_function Prescan_runner"));
+	}
+      this_blocker = final_blocker;
+    }
   else
     {
       // Read the relocations of the input files.  We do this to find
@@ -745,7 +858,7 @@ queue_middle_tasks(const General_options& options,
 	  Task_token* next_blocker = new Task_token(true);
 	  next_blocker->add_blocker();
 	  workqueue->queue(new Read_relocs(symtab, layout, *p, this_blocker,
-					   next_blocker));
+					   next_blocker, NULL));
 	  this_blocker = next_blocker;
 	}
     }
@@ -769,6 +882,10 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
+  // When building a .gdb_index section, scan the debug info of each
+  // object in parallel with the relocation scanning.
+  this_blocker = layout->queue_gdb_index_tasks(workqueue, this_blocker);
+
   // When all those tasks are complete, we can start laying out the
   // output file.
   workqueue->queue(new Task_function(new Layout_task_runner(options,
@@ -781,6 +898,100 @@ queue_middle_tasks(const General_options& options,
 				     "Task_function Layout_task_runner"));
 }
 
+// The work of a single Relocate_task: relocate the input sections of
+// OBJECT in the output file range [START, END), writing out the local
+// symbols if IS_LAST.
+
+struct Relocate_work
+{
+  Relocate_work(Relobj* a_object, off_t a_start, off_t a_end,
+		bool a_is_last)
+    : object(a_object), start(a_start), end(a_end), is_last(a_is_last)
+  { }
+
+  Relobj* object;
+  off_t start;
+  off_t end;
+  bool is_last;
+};
+
+// Decide how to split up the relocation work.  Normally there is one
+// Relocate_task for each input object, and each one writes to every
+// output section which the object contributes to.  For a large output
+// file that means that all the threads write to pages all over the
+// file at once.  With --relocation-order=output we instead split the
+// output file into address ranges, and give each object a task for
+// each range which holds some of its input sections.  The tasks are
+// queued range by range, so the threads fill in the output file more
+// or less in order.
+
+static void
+plan_relocate_tasks(const General_options& options,
+		    const Input_objects* input_objects,
+		    const Layout* layout,
+		    int thread_count,
+		    std::vector<Relocate_work>* work)
+{
+  // Each range should be at least this large.
+  const off_t min_range_size = 4 * 1024 * 1024;
+
+  off_t range_count = 1;
+  if (options.threads()
+      && strcmp(options.relocation_order(), "output") == 0
+      && !parameters->options().relocatable()
+      && !parameters->options().emit_relocs()
+      && !parameters->incremental()
+      && !layout->any_postprocessing_sections())
+    range_count = std::min(static_cast<off_t>(thread_count) * 4,
+			   layout->output_file_size() / min_range_size);
+
+  if (range_count <= 1)
+    {
+      for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+	   p != input_objects->relobj_end();
+	   ++p)
+	work->push_back(Relocate_work(*p, 0, -1, true));
+      return;
+    }
+
+  const off_t range_size = ((layout->output_file_size() + range_count - 1)
+			    / range_count);
+  std::vector<std::vector<Relocate_work> > ranges(range_count);
+  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+       p != input_objects->relobj_end();
+       ++p)
+    {
+      Relobj* relobj = *p;
+      std::vector<bool> used(range_count);
+      off_t last = 0;
+      unsigned int shnum = relobj->shnum();
+      for (unsigned int i = 1; i < shnum; ++i)
+	{
+	  off_t off = relobj->output_file_offset(i);
+	  if (off < 0)
+	    continue;
+	  off_t r = std::min(off / range_size, range_count - 1);
+	  used[r] = true;
+	  last = std::max(last, r);
+	}
+      // An object with nothing in the output file still needs a task
+      // to write out its local symbols.
+      used[last] = true;
+
+      for (off_t r = 0; r <= last; ++r)
+	{
+	  if (!used[r])
+	    continue;
+	  off_t start = r * range_size;
+	  off_t end = r == range_count - 1 ? -1 : start + range_size;
+	  ranges[r].push_back(Relocate_work(relobj, start, end, r == last));
+	}
+    }
+
+  for (off_t r = 0; r < range_count; ++r)
+    work->insert(work->end(), ranges[r].begin(), ranges[r].end());
+}
+
 // Queue up the final set of tasks.  This is called at the end of
 // Layout_task.
 
@@ -803,51 +1014,81 @@ queue_final_tasks(const General_options& options,
 
   bool any_postprocessing_sections = layout->any_postprocessing_sections();
 
+  std::vector<Relocate_work> relocate_work;
+  plan_relocate_tasks(options, input_objects, layout, thread_count,
+		      &relocate_work);
+
   // Use a blocker to wait until all the input sections have been
   // written out.
   Task_token* input_sections_blocker = NULL;
   if (!any_postprocessing_sections)
     {
       input_sections_blocker = new Task_token(true);
-      input_sections_blocker->add_blockers(input_objects->number_of_relobjs());
+      input_sections_blocker->add_blockers(relocate_work.size());
     }
 
+  // When using threads, write out output sections with a lot of data
+  // of their own, such as merged string sections, in separate tasks.
+  std::vector<Layout::Section_list> section_groups;
+  layout->group_output_sections_for_writing((options.threads()
+					     ? thread_count
+					     : 1),
+					    &section_groups);
+
   // Use a blocker to block any objects which have to wait for the
   // output sections to complete before they can apply relocations.
   Task_token* output_sections_blocker = new Task_token(true);
-  output_sections_blocker->add_blocker();
+  output_sections_blocker->add_blockers(section_groups.size());
+
+  // When using threads, split a large global symbol table into
+  // ranges which are written out in parallel.  Each range should be
+  // big enough to be worth a task of its own.
+  const size_t min_symbols_per_task = 10000;
+  const size_t symbol_count = symtab->output_symbol_count();
+  size_t symbol_tasks = 1;
+  if (options.threads())
+    symbol_tasks = std::max(static_cast<size_t>(1),
+			    std::min(static_cast<size_t>(thread_count),
+				     symbol_count / min_symbols_per_task));
 
   // Use a blocker to block the final cleanup task.
   Task_token* final_blocker = new Task_token(true);
-  // Write_symbols_task, Write_sections_task, Write_data_task,
+  // Write_symbols_tasks, Write_sections_tasks, Write_data_task,
   // Relocate_tasks.
-  final_blocker->add_blockers(3);
-  final_blocker->add_blockers(input_objects->number_of_relobjs());
+  final_blocker->add_blockers(symbol_tasks + section_groups.size() + 1);
+  final_blocker->add_blockers(relocate_work.size());
   if (!any_postprocessing_sections)
     final_blocker->add_blocker();
 
-  // Queue a task to write out the symbol table.
-  workqueue->queue(new Write_symbols_task(layout,
-					  symtab,
-					  input_objects,
-					  layout->sympool(),
-					  layout->dynpool(),
-					  of,
-					  final_blocker));
-
-  // Queue a task to write out the output sections.
-  workqueue->queue(new Write_sections_task(layout, of, output_sections_blocker,
-					   final_blocker));
+  // Queue tasks to write out the symbol table.
+  for (size_t i = 0; i < symbol_tasks; ++i)
+    workqueue->queue(new Write_symbols_task(layout,
+					    symtab,
+					    input_objects,
+					    layout->sympool(),
+					    layout->dynpool(),
+					    of,
+					    symbol_count * i / symbol_tasks,
+					    (symbol_count * (i + 1)
+					     / symbol_tasks),
+					    final_blocker));
+
+  // Queue tasks to write out the output sections.
+  for (size_t i = 0; i < section_groups.size(); ++i)
+    workqueue->queue(new Write_sections_task(layout, of, section_groups[i],
+					     output_sections_blocker,
+					     final_blocker));
 
   // Queue a task to write out everything else.
   workqueue->queue(new Write_data_task(layout, symtab, of, final_blocker));
 
-  // Queue a task for each input object to relocate the sections and
+  // Queue tasks to relocate the sections of each input object and
   // write out the local symbols.
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
+  for (std::vector<Relocate_work>::const_iterator p = relocate_work.begin();
+       p != relocate_work.end();
        ++p)
-    workqueue->queue(new Relocate_task(symtab, layout, *p, of,
+    workqueue->queue(new Relocate_task(symtab, layout, p->object, of,
+				       p->start, p->end, p->is_last,
 				       input_sections_blocker,
 				       output_sections_blocker,
 				       final_blocker));
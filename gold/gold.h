@@ -308,6 +308,80 @@ is_wildcard_string(const char* s)
   return strpbrk(s, "?*[") != NULL;
 }
 
+// A table mapping small integer handles to pointers, used where a
+// 32-bit handle is stored instead of a pointer.  Handle H refers to
+// entry H - 1, so 0 can stand for NULL.  Handles are at most
+// handle_bits bits wide.  Entries are kept in fixed-size chunks which
+// are never moved, so looking up a handle which has already been
+// returned needs no lock.  The caller must serialize calls to add.
+
+template<typename T, int handle_bits>
+class Handle_table
+{
+ public:
+  // The largest handle which can be allocated.
+  static const unsigned int MAX_HANDLE = (1U << handle_bits) - 1;
+
+  Handle_table()
+    : chunks_(new T**[max_chunks]()), count_(0)
+  { }
+
+  ~Handle_table()
+  {
+    for (unsigned int i = 0; i < max_chunks; ++i)
+      delete[] this->chunks_[i];
+    delete[] this->chunks_;
+  }
+
+  // Return the entry for HANDLE, which must have been returned by
+  // add.
+  T*
+  get(unsigned int handle) const
+  {
+    gold_assert(handle != 0);
+    --handle;
+    return this->chunks_[handle >> chunk_bits][handle & (chunk_size - 1)];
+  }
+
+  // The number of entries.
+  unsigned int
+  size() const
+  { return this->count_; }
+
+  // Whether the table is full.
+  bool
+  full() const
+  { return this->count_ == MAX_HANDLE; }
+
+  // Append P and return its handle.  The table must not be full.
+  unsigned int
+  add(T* p)
+  {
+    gold_assert(!this->full());
+    unsigned int index = this->count_;
+    T**& chunk(this->chunks_[index >> chunk_bits]);
+    if (chunk == NULL)
+      chunk = new T*[chunk_size];
+    chunk[index & (chunk_size - 1)] = p;
+    this->count_ = index + 1;
+    return this->count_;
+  }
+
+ private:
+  Handle_table(const Handle_table&);
+  Handle_table& operator=(const Handle_table&);
+
+  // Entries are allocated chunk_size at a time.
+  static const unsigned int chunk_bits = 13;
+  static const unsigned int chunk_size = 1U << chunk_bits;
+  static const unsigned int max_chunks = (MAX_HANDLE >> chunk_bits) + 1;
+
+  // The chunks, allocated as needed.
+  T*** chunks_;
+  // The number of entries.
+  unsigned int count_;
+};
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_GOLD_H)
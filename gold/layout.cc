@@ -53,6 +53,7 @@
 #include "descriptors.h"
 #include "plugin.h"
 #include "incremental.h"
+#include "timer.h"
 #include "layout.h"
 
 namespace gold
@@ -373,6 +374,7 @@ Layout_task_runner::run(Workqueue* workqueue, const Task* task)
   off_t file_size = layout->finalize(this->input_objects_,
 				     this->symtab_,
 				     this->target_,
+				     workqueue,
 				     task);
 
   // Now we know the final size of the output file and we know where
@@ -469,6 +471,10 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     script_output_section_data_list_(),
     segment_states_(NULL),
     relaxation_debug_check_(NULL),
+    input_section_handles_(new Input_section_handles()),
+    relaxation_pass_times_(),
+    input_local_symbol_count_(0),
+    output_local_symbol_count_(0),
     section_order_map_(),
     section_segment_map_(),
     input_section_position_(),
@@ -491,6 +497,16 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
   // The section name pool is worth optimizing in all cases, because
   // it is small, but there are often overlaps due to .rel sections.
   this->namepool_.set_optimize();
+
+  Output_section::Input_section::set_handles(this->input_section_handles_);
+}
+
+Layout::~Layout()
+{
+  delete this->relaxation_debug_check_;
+  delete this->segment_states_;
+  Output_section::Input_section::set_handles(NULL);
+  delete this->input_section_handles_;
 }
 
 // For incremental links, record the base file to be modified.
@@ -1063,12 +1079,16 @@ Layout::init_fixed_output_section(const char* name,
   if (!can_incremental_update(sh_type))
     return NULL;
 
-  // If we're generating a .gdb_index section, we need to regenerate
-  // it from scratch.
+  // If we're generating a .gdb_index or .debug_names section, we need
+  // to regenerate it from scratch.
   if (parameters->options().gdb_index()
       && sh_type == elfcpp::SHT_PROGBITS
       && strcmp(name, ".gdb_index") == 0)
     return NULL;
+  if (parameters->options().debug_names()
+      && sh_type == elfcpp::SHT_PROGBITS
+      && strcmp(name, ".debug_names") == 0)
+    return NULL;
 
   typename elfcpp::Elf_types<size>::Elf_Addr sh_addr = shdr.get_sh_addr();
   typename elfcpp::Elf_types<size>::Elf_Off sh_offset = shdr.get_sh_offset();
@@ -1530,36 +1550,62 @@ Layout::add_eh_frame_for_plt(Output_data* plt, const unsigned char* cie_data,
     }
 }
 
-// Scan a .debug_info or .debug_types section, and add summary
-// information to the .gdb_index section.
+// Record a .debug_info or .debug_types section to be scanned for
+// summary information for the .gdb_index section.
 
 template<int size, bool big_endian>
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<size, big_endian>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
+			 unsigned int symtab_shndx,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type)
 {
   if (this->gdb_index_data_ == NULL)
     {
-      Output_section* os = this->choose_output_section(NULL, ".gdb_index",
+      // With --debug-names we build a DWARF 5 .debug_names section
+      // instead, whose strings are appended to .debug_str.
+      bool debug_names = parameters->options().debug_names();
+      Output_section* os = this->choose_output_section(NULL,
+						       (debug_names
+							? ".debug_names"
+							: ".gdb_index"),
 						       elfcpp::SHT_PROGBITS, 0,
 						       false, ORDER_INVALID,
 						       false);
       if (os == NULL)
 	return;
 
-      this->gdb_index_data_ = new Gdb_index(os);
+      Output_section* debug_str_os = NULL;
+      if (debug_names)
+	{
+	  debug_str_os = this->choose_output_section(NULL, ".debug_str",
+						     elfcpp::SHT_PROGBITS, 0,
+						     false, ORDER_INVALID,
+						     false);
+	  if (debug_str_os == NULL)
+	    return;
+	}
+
+      this->gdb_index_data_ = new Gdb_index(os, debug_str_os);
       os->add_output_section_data(this->gdb_index_data_);
       os->set_after_input_sections();
     }
 
-  this->gdb_index_data_->scan_debug_info(is_type_unit, object, symbols,
-					 symbols_size, shndx, reloc_shndx,
-					 reloc_type);
+  this->gdb_index_data_->scan_debug_info(is_type_unit, object, symtab_shndx,
+					 shndx, reloc_shndx, reloc_type);
+}
+
+// If building a .gdb_index section, queue the tasks to scan the debug
+// info and merge the results.
+
+Task_token*
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* this_blocker)
+{
+  if (this->gdb_index_data_ == NULL)
+    return this_blocker;
+  return this->gdb_index_data_->queue_scan_tasks(workqueue, this_blocker);
 }
 
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
@@ -2628,7 +2674,7 @@ Layout::read_layout_from_file()
 
 off_t
 Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
-		 Target* target, const Task* task)
+		 Target* target, Workqueue* workqueue, const Task* task)
 {
   target->finalize_sections(this, input_objects, symtab);
 
@@ -2711,16 +2757,36 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   if (target->may_relax())
     this->prepare_for_relaxation();
 
-  // Run the relaxation loop to lay out sections.
+  // Run the relaxation loop to lay out sections.  For --stats we
+  // record how long each pass takes.
+  const bool time_passes = (target->may_relax()
+			    && parameters->options().stats());
+  Timer timer;
+  bool again;
   do
     {
+      if (time_passes)
+	timer.start();
       off = this->relaxation_loop_body(pass, target, symtab, &load_seg,
 				       phdr_seg, segment_headers, file_header,
 				       &shndx);
       pass++;
+      if (!target->may_relax())
+	break;
+
+      long layout_time = 0;
+      if (time_passes)
+	{
+	  layout_time = timer.get_elapsed_time().wall;
+	  timer.start();
+	}
+      again = target->relax(pass, input_objects, symtab, this, workqueue,
+			     task);
+      if (time_passes)
+	this->relaxation_pass_times_.push_back(
+	    std::make_pair(layout_time, timer.get_elapsed_time().wall));
     }
-  while (target->may_relax()
-	 && target->relax(pass, input_objects, symtab, this, task));
+  while (again);
 
   // If there is a load segment that contains the file and program headers,
   // provide a symbol __ehdr_start pointing there.
@@ -3857,6 +3923,7 @@ Layout::count_local_symbols(const Task* task,
        p != input_objects->relobj_end();
        ++p)
     symbol_count += (*p)->local_symbol_count();
+  this->input_local_symbol_count_ = symbol_count;
 
   // Go from "upper bound" to "estimate."  We overcount for two
   // reasons: we double-count symbols that occur in more than one
@@ -3932,6 +3999,7 @@ Layout::create_symtab_sections(const Input_objects* input_objects,
       unsigned int index = (*p)->finalize_local_symbols(local_symbol_index,
 							off, symtab);
       off += (index - local_symbol_index) * symsize;
+      this->output_local_symbol_count_ += index - local_symbol_index;
       local_symbol_index = index;
     }
 
@@ -5207,20 +5275,54 @@ Layout::symtab_section_shndx() const
   return 0;
 }
 
-// Write out the Output_sections.  Most won't have anything to write,
-// since most of the data will come from input sections which are
-// handled elsewhere.  But some Output_sections do have Output_data.
+// Write out the Output_sections in SECTIONS.  Most won't have
+// anything to write, since most of the data will come from input
+// sections which are handled elsewhere.  But some Output_sections do
+// have Output_data.
 
 void
-Layout::write_output_sections(Output_file* of) const
+Layout::write_output_sections(const Section_list& sections,
+			      Output_file* of) const
 {
+  for (Section_list::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    {
+      gold_assert(!(*p)->after_input_sections());
+      (*p)->write(of);
+    }
+}
+
+// Split the output sections which are written by Write_sections_task
+// into groups, each of which may be written by a separate task.
+
+void
+Layout::group_output_sections_for_writing(
+    size_t max_groups,
+    std::vector<Section_list>* groups) const
+{
+  // A section needs at least this much data of its own to be worth a
+  // task of its own.
+  const off_t min_separate_size = 64 * 1024;
+
+  gold_assert(max_groups > 0);
+  groups->clear();
+  groups->push_back(Section_list());
   for (Section_list::const_iterator p = this->section_list_.begin();
        p != this->section_list_.end();
        ++p)
     {
-      if (!(*p)->after_input_sections())
-	(*p)->write(of);
+      if ((*p)->after_input_sections())
+	continue;
+      if (groups->size() < max_groups
+	  && (*p)->output_section_data_size() >= min_separate_size)
+	groups->push_back(Section_list(1, *p));
+      else
+	groups->front().push_back(*p);
     }
+
+  if (groups->front().empty() && groups->size() > 1)
+    groups->erase(groups->begin());
 }
 
 // Write out data not associated with a section or the symbol table.
@@ -5466,6 +5568,38 @@ Layout::print_stats() const
   this->sympool_.print_stats("output symbol name pool");
   this->dynpool_.print_stats("dynamic name pool");
 
+  // Each input local symbol has a Symbol_value, whether or not a
+  // relocation or the output symbol table needs it.
+  size_t value_size;
+  if (parameters->target().get_size() == 32)
+    value_size = sizeof(Symbol_value<32>);
+  else
+    value_size = sizeof(Symbol_value<64>);
+  fprintf(stderr, _("%s: input local symbols: %u (%llu bytes of values)\n"),
+	  program_name, this->input_local_symbol_count_,
+	  (static_cast<unsigned long long>(this->input_local_symbol_count_)
+	   * value_size));
+  fprintf(stderr, _("%s: local symbols in output symbol table: %u\n"),
+	  program_name, this->output_local_symbol_count_);
+
+  if (!this->relaxation_pass_times_.empty())
+    {
+      fprintf(stderr, _("%s: relaxation passes: %u\n"), program_name,
+	      static_cast<unsigned int>(this->relaxation_pass_times_.size()));
+      for (size_t i = 0; i < this->relaxation_pass_times_.size(); ++i)
+	{
+	  long layout_time = this->relaxation_pass_times_[i].first;
+	  long relax_time = this->relaxation_pass_times_[i].second;
+	  fprintf(stderr,
+		  _("%s: relaxation pass %u: layout %ld.%03ld relax "
+		    "%ld.%03ld (wall seconds)\n"),
+		  program_name, static_cast<unsigned int>(i + 1),
+		  layout_time / 1000, layout_time % 1000,
+		  relax_time / 1000, relax_time % 1000);
+	}
+      Output_section::print_relaxation_stats();
+    }
+
   for (Section_list::const_iterator p = this->section_list_.begin();
        p != this->section_list_.end();
        ++p)
@@ -5497,7 +5631,7 @@ Write_sections_task::locks(Task_locker* tl)
 void
 Write_sections_task::run(Workqueue*)
 {
-  this->layout_->write_output_sections(this->of_);
+  this->layout_->write_output_sections(this->sections_, this->of_);
 }
 
 // Write_data_task methods.
@@ -5551,7 +5685,8 @@ Write_symbols_task::run(Workqueue*)
 {
   this->symtab_->write_globals(this->sympool_, this->dynpool_,
 			       this->layout_->symtab_xindex(),
-			       this->layout_->dynsym_xindex(), this->of_);
+			       this->layout_->dynsym_xindex(), this->of_,
+			       this->start_, this->end_);
 }
 
 // Write_after_input_sections_task methods.
@@ -5833,8 +5968,7 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<32, false>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
+			 unsigned int symtab_shndx,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -5845,8 +5979,7 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<32, true>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
+			 unsigned int symtab_shndx,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -5857,8 +5990,7 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<64, false>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
+			 unsigned int symtab_shndx,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -5869,8 +6001,7 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<64, true>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
+			 unsigned int symtab_shndx,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -48,6 +48,7 @@ class Mapfile;
 class Symbol_table;
 class Output_section_data;
 class Output_section;
+class Input_section_handles;
 class Output_section_headers;
 class Output_segment_headers;
 class Output_file_header;
@@ -491,11 +492,7 @@ class Layout
  public:
   Layout(int number_of_input_files, Script_options*);
 
-  ~Layout()
-  {
-    delete this->relaxation_debug_check_;
-    delete this->segment_states_;
-  }
+  ~Layout();
 
   // For incremental links, record the base file to be modified.
   void
@@ -645,13 +642,13 @@ class Layout
 		       size_t fde_length);
 
   // Scan a .debug_info or .debug_types section, and add summary
-  // information to the .gdb_index section.
+  // information to the .gdb_index section, or to the .debug_names
+  // section with --debug-names.
   template<int size, bool big_endian>
   void
   add_to_gdb_index(bool is_type_unit,
 		   Sized_relobj<size, big_endian>* object,
-		   const unsigned char* symbols,
-		   off_t symbols_size,
+		   unsigned int symtab_shndx,
 		   unsigned int shndx,
 		   unsigned int reloc_shndx,
 		   unsigned int reloc_type);
@@ -784,7 +781,8 @@ class Layout
 
   // Finalize the layout after all the input sections have been added.
   off_t
-  finalize(const Input_objects*, Symbol_table*, Target*, const Task*);
+  finalize(const Input_objects*, Symbol_table*, Target*, Workqueue*,
+	   const Task*);
 
   // Return whether any sections require postprocessing.
   bool
@@ -831,10 +829,6 @@ class Layout
   dynamic_data() const
   { return this->dynamic_data_; }
 
-  // Write out the output sections.
-  void
-  write_output_sections(Output_file* of) const;
-
   // Write out data not associated with an input file or the symbol
   // table.
   void
@@ -892,6 +886,13 @@ class Layout
 			  const Output_data_reloc_generic* dyn_rel,
 			  bool add_debug, bool dynrel_includes_plt);
 
+  // If building a .gdb_index section, queue the tasks to scan the
+  // debug info of each object and merge the results.  Return a blocker
+  // that will unblock when they finish, and after THIS_BLOCKER does.
+  // Otherwise return THIS_BLOCKER.
+  Task_token*
+  queue_gdb_index_tasks(Workqueue* workqueue, Task_token* this_blocker);
+
   // If a treehash is necessary to compute the build ID, then queue
   // the necessary tasks and return a blocker that will unblock when
   // they finish.  Otherwise return BUILD_ID_BLOCKER.
@@ -936,6 +937,19 @@ class Layout
   void
   get_executable_sections(Section_list*) const;
 
+  // Split the output sections which write_output_sections writes
+  // into at most MAX_GROUPS groups which may be written in parallel.
+  // Each section with a lot of data of its own gets a group to
+  // itself; the others all go in the first group.
+  void
+  group_output_sections_for_writing(size_t max_groups,
+				    std::vector<Section_list>* groups) const;
+
+  // Write out the output sections in SECTIONS.
+  void
+  write_output_sections(const Section_list& sections,
+			Output_file* of) const;
+
   // Make a section for a linker script to hold data.
   Output_section*
   make_output_section_for_script(const char* name,
@@ -1357,7 +1371,7 @@ class Layout
   bool added_eh_frame_data_;
   // The exception frame header output section if there is one.
   Output_section* eh_frame_hdr_section_;
-  // The data for the .gdb_index section.
+  // The data for the .gdb_index or .debug_names section.
   Gdb_index* gdb_index_data_;
   // The space for the build ID checksum if there is one.
   Output_section_data* build_id_note_;
@@ -1413,6 +1427,16 @@ class Layout
   Segment_states* segment_states_;
   // A relaxation debug checker.  We only create one when in debugging mode.
   Relaxation_debug_check* relaxation_debug_check_;
+  // The tables behind the handles stored in the input section lists
+  // of the output sections.
+  Input_section_handles* input_section_handles_;
+  // For --stats, the wall clock time in milliseconds spent laying out
+  // the sections and in Target::relax for each relaxation pass.
+  std::vector<std::pair<long, long> > relaxation_pass_times_;
+  // For --stats, the number of local symbols in the input objects,
+  // and the number of them written to the output symbol table.
+  unsigned int input_local_symbol_count_;
+  unsigned int output_local_symbol_count_;
   // Plugins specify section_ordering using this map.  This is set in
   // update_section_order in plugin.cc
   std::map<Section_id, unsigned int> section_order_map_;
@@ -1431,18 +1455,19 @@ class Layout
   Free_list free_list_;
 };
 
-// This task handles writing out data in output sections which is not
-// part of an input section, or which requires special handling.  When
-// this is done, it unblocks both output_sections_blocker and
-// final_blocker.
+// This task handles writing out data in a group of output sections
+// which is not part of an input section, or which requires special
+// handling.  When this is done, it unblocks both
+// output_sections_blocker and final_blocker.
 
 class Write_sections_task : public Task
 {
  public:
   Write_sections_task(const Layout* layout, Output_file* of,
+		      const Layout::Section_list& sections,
 		      Task_token* output_sections_blocker,
 		      Task_token* final_blocker)
-    : layout_(layout), of_(of),
+    : layout_(layout), of_(of), sections_(sections),
       output_sections_blocker_(output_sections_blocker),
       final_blocker_(final_blocker)
   { }
@@ -1467,6 +1492,7 @@ class Write_sections_task : public Task
 
   const Layout* layout_;
   Output_file* of_;
+  Layout::Section_list sections_;
   Task_token* output_sections_blocker_;
   Task_token* final_blocker_;
 };
@@ -1504,7 +1530,9 @@ class Write_data_task : public Task
   Task_token* final_blocker_;
 };
 
-// This task handles writing out the global symbols.
+// This task handles writing out the global symbols from START up to
+// but not including END; see Symbol_table::write_globals.  A large
+// symbol table may be split among several of these tasks.
 
 class Write_symbols_task : public Task
 {
@@ -1512,10 +1540,11 @@ class Write_symbols_task : public Task
   Write_symbols_task(const Layout* layout, const Symbol_table* symtab,
 		     const Input_objects* input_objects,
 		     const Stringpool* sympool, const Stringpool* dynpool,
-		     Output_file* of, Task_token* final_blocker)
+		     Output_file* of, size_t start, size_t end,
+		     Task_token* final_blocker)
     : layout_(layout), symtab_(symtab), input_objects_(input_objects),
-      sympool_(sympool), dynpool_(dynpool), of_(of),
-      final_blocker_(final_blocker)
+      sympool_(sympool), dynpool_(dynpool), of_(of), start_(start),
+      end_(end), final_blocker_(final_blocker)
   { }
 
   // The standard Task methods.
@@ -1540,6 +1569,8 @@ class Write_symbols_task : public Task
   const Stringpool* sympool_;
   const Stringpool* dynpool_;
   Output_file* of_;
+  size_t start_;
+  size_t end_;
   Task_token* final_blocker_;
 };
 
@@ -281,6 +281,9 @@ main(int argc, char** argv)
               elapsed.user / 1000, (elapsed.user % 1000) * 1000,
               elapsed.sys / 1000, (elapsed.sys % 1000) * 1000,
               elapsed.wall / 1000, (elapsed.wall % 1000) * 1000);
+      fprintf(stderr,
+	      _("%s: final tasks page faults: %ld minor, %ld major\n"),
+	      program_name, elapsed.minor_faults, elapsed.major_faults);
       elapsed = timer.get_elapsed_time();
       fprintf(stderr,
              _("%s: total run time: " \
@@ -289,6 +292,8 @@ main(int argc, char** argv)
               elapsed.user / 1000, (elapsed.user % 1000) * 1000,
               elapsed.sys / 1000, (elapsed.sys % 1000) * 1000,
               elapsed.wall / 1000, (elapsed.wall % 1000) * 1000);
+      fprintf(stderr, _("%s: total page faults: %ld minor, %ld major\n"),
+	      program_name, elapsed.minor_faults, elapsed.major_faults);
 
 #ifdef HAVE_MALLINFO
       struct mallinfo m = mallinfo();
@@ -296,6 +301,8 @@ main(int argc, char** argv)
 	      program_name, m.arena);
 #endif
       File_read::print_stats();
+      if (command_line.options().prefetch_inputs())
+	Input_prefetch::print_stats();
       Archive::print_stats();
       Lib_group::print_stats();
       fprintf(stderr, _("%s: output file size: %lld bytes\n"),
@@ -26,6 +26,7 @@
 #include <cerrno>
 #include <cstring>
 #include <cstdarg>
+#include <algorithm>
 #include "demangle.h"
 #include "libiberty.h"
 
@@ -342,6 +343,21 @@ Relobj::is_section_name_included(const char* name)
   return false;
 }
 
+// Return the offset in the output file at which the data of input
+// section SHNDX starts, or -1 if it has none.
+
+off_t
+Relobj::output_file_offset(unsigned int shndx) const
+{
+  Output_section* os = this->output_section(shndx);
+  if (os == NULL || os->type() == elfcpp::SHT_NOBITS)
+    return -1;
+  uint64_t off = this->output_section_offset(shndx);
+  if (off == -1ULL)
+    return os->offset();
+  return os->offset() + off;
+}
+
 // Finalize the incremental relocation information.  Allocates a block
 // of relocation entries for each symbol, and sets the reloc_bases_
 // array to point to the first entry in each block.  If CLEAR_COUNTS
@@ -408,6 +424,7 @@ Sized_relobj_file<size, big_endian>::Sized_relobj_file(
     local_symbol_offset_(0),
     local_dynsym_offset_(0),
     local_values_(),
+    local_dynsym_indexes_(),
     local_plt_offsets_(),
     kept_comdat_sections_(),
     has_eh_frame_(false),
@@ -616,33 +633,15 @@ need_decompressed_section(const char* name)
   if (parameters->options().threads())
     {
       // We will need .zdebug_str if this is not an incremental link
-      // (i.e., we are processing string merge sections) or if we need
-      // to build a gdb index.
-      if ((!parameters->incremental() || parameters->options().gdb_index())
-	  && strcmp(name, "str") == 0)
-	return true;
-
-      // We will need these other sections when building a gdb index.
-      if (parameters->options().gdb_index()
-	  && (strcmp(name, "info") == 0
-	      || strcmp(name, "types") == 0
-	      || strcmp(name, "pubnames") == 0
-	      || strcmp(name, "pubtypes") == 0
-	      || strcmp(name, "ranges") == 0
-	      || strcmp(name, "abbrev") == 0))
+      // (i.e., we are processing string merge sections).  The other
+      // sections used to build a gdb index are not read until the
+      // Gdb_index_scan_task, after the decompressed contents have
+      // been discarded, so there is no point decompressing them now.
+      if (!parameters->incremental() && strcmp(name, "str") == 0)
 	return true;
     }
 #endif
 
-  // Even when single-threaded, we will need .zdebug_str if this is
-  // not an incremental link and we are building a gdb index.
-  // Otherwise, we would decompress the section twice: once for
-  // string merge processing, and once for building the gdb index.
-  if (!parameters->incremental()
-      && parameters->options().gdb_index()
-      && strcmp(name, "str") == 0)
-    return true;
-
   return false;
 }
 
@@ -727,7 +726,8 @@ Sized_relobj_file<size, big_endian>::do_find_special_sections(
 				     sd->section_names_size, this);
   return (this->has_eh_frame_
 	  || (!parameters->options().relocatable()
-	      && parameters->options().gdb_index()
+	      && (parameters->options().gdb_index()
+		  || parameters->options().debug_names())
 	      && (memmem(names, sd->section_names_size, "debug_info", 12) == 0
 		  || memmem(names, sd->section_names_size, "debug_types",
 			    13) == 0)));
@@ -1667,11 +1667,12 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 	  this->layout_section(layout, i, name, shdr, reloc_shndx[i],
 			       reloc_type[i]);
 
-	  // When generating a .gdb_index section, we do additional
-	  // processing of .debug_info and .debug_types sections after all
-	  // the other sections for the same reason as above.
+	  // When generating a .gdb_index or .debug_names section, we do
+	  // additional processing of .debug_info and .debug_types sections
+	  // after all the other sections for the same reason as above.
 	  if (!relocatable
-	      && parameters->options().gdb_index()
+	      && (parameters->options().gdb_index()
+		  || parameters->options().debug_names())
 	      && !(shdr.get_sh_flags() & elfcpp::SHF_ALLOC))
 	    {
 	      if (strcmp(name, ".debug_info") == 0
@@ -1761,8 +1762,8 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
 				    reloc_type[i]);
     }
 
-  // When building a .gdb_index section, scan the .debug_info and
-  // .debug_types sections.
+  // When building a .gdb_index section, record the .debug_info and
+  // .debug_types sections to be scanned.
   gold_assert(!is_pass_one
 	      || (debug_info_sections.empty() && debug_types_sections.empty()));
   for (std::vector<unsigned int>::const_iterator p
@@ -1771,7 +1772,7 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
        ++p)
     {
       unsigned int i = *p;
-      layout->add_to_gdb_index(false, this, symbols_data, symbols_size,
+      layout->add_to_gdb_index(false, this, this->symtab_shndx_,
 			       i, reloc_shndx[i], reloc_type[i]);
     }
   for (std::vector<unsigned int>::const_iterator p
@@ -1780,7 +1781,7 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
        ++p)
     {
       unsigned int i = *p;
-      layout->add_to_gdb_index(true, this, symbols_data, symbols_size,
+      layout->add_to_gdb_index(true, this, this->symtab_shndx_,
 			       i, reloc_shndx[i], reloc_type[i]);
     }
 
@@ -2104,6 +2105,15 @@ Sized_relobj_file<size, big_endian>::do_count_local_symbols(Stringpool* pool,
       bool is_ordinary;
       unsigned int shndx = this->adjust_sym_shndx(i, sym.get_st_shndx(),
 						  &is_ordinary);
+      if (shndx > Symbol_value<size>::max_input_shndx)
+	{
+	  // Only an extended section index can be this large, and we
+	  // can't record it.  Treat the symbol as undefined.
+	  this->error(_("local symbol %u section index %u out of range"),
+		      i, shndx);
+	  shndx = elfcpp::SHN_UNDEF;
+	  is_ordinary = true;
+	}
       lv.set_input_shndx(shndx, is_ordinary);
 
       if (sym.get_st_type() == elfcpp::STT_SECTION)
@@ -2427,18 +2437,34 @@ Sized_relobj_file<size, big_endian>::do_set_local_dynsym_indexes(
     unsigned int index)
 {
   const unsigned int loccount = this->local_symbol_count_;
+  this->local_dynsym_indexes_.clear();
   for (unsigned int i = 1; i < loccount; ++i)
     {
       Symbol_value<size>& lv(this->local_values_[i]);
       if (lv.needs_output_dynsym_entry())
 	{
-	  lv.set_output_dynsym_index(index);
+	  this->local_dynsym_indexes_.push_back(std::make_pair(i, index));
 	  ++index;
 	}
     }
   return index;
 }
 
+// Return the index of local symbol SYM in the dynamic symbol table.
+
+template<int size, bool big_endian>
+unsigned int
+Sized_relobj_file<size, big_endian>::dynsym_index(unsigned int sym) const
+{
+  gold_assert(sym < this->local_values_.size());
+  typename Local_dynsym_indexes::const_iterator p =
+    std::lower_bound(this->local_dynsym_indexes_.begin(),
+		     this->local_dynsym_indexes_.end(),
+		     std::make_pair(sym, 0U));
+  gold_assert(p != this->local_dynsym_indexes_.end() && p->first == sym);
+  return p->second;
+}
+
 // Set the offset where local dynamic symbol information will be stored.
 // Returns the count of local symbols contributed to the symbol table by
 // this object.
@@ -2577,8 +2603,8 @@ Sized_relobj_file<size, big_endian>::write_local_symbols(
 	    {
 	      if (lv.has_output_symtab_entry())
 		symtab_xindex->add(lv.output_symtab_index(), st_shndx);
-	      if (lv.has_output_dynsym_entry())
-		dynsym_xindex->add(lv.output_dynsym_index(), st_shndx);
+	      if (lv.needs_output_dynsym_entry())
+		dynsym_xindex->add(this->dynsym_index(i), st_shndx);
 	      st_shndx = elfcpp::SHN_XINDEX;
 	    }
 	}
@@ -2601,7 +2627,7 @@ Sized_relobj_file<size, big_endian>::write_local_symbols(
 	}
 
       // Write the symbol to the output dynamic symbol table.
-      if (lv.has_output_dynsym_entry())
+      if (lv.needs_output_dynsym_entry())
 	{
 	  gold_assert(dyn_ov < dyn_oview + dyn_output_size);
 	  elfcpp::Sym_write<size, big_endian> osym(dyn_ov);
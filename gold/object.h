@@ -112,11 +112,14 @@ struct Symbol_location_info
 struct Section_relocs
 {
   Section_relocs()
-    : contents(NULL)
+    : contents(NULL), deferred(NULL), deferred_count(0)
   { }
 
   ~Section_relocs()
-  { delete this->contents; }
+  {
+    delete this->contents;
+    delete this->deferred;
+  }
 
   // Index of reloc section.
   unsigned int reloc_shndx;
@@ -134,6 +137,11 @@ struct Section_relocs
   bool needs_special_offset_handling;
   // Whether the data section is allocated (has the SHF_ALLOC flag set).
   bool is_data_section_allocated;
+  // If the relocs were prescanned, the relocs which still need to be
+  // scanned; otherwise NULL.
+  std::vector<unsigned char>* deferred;
+  // The number of relocs in DEFERRED.
+  size_t deferred_count;
 };
 
 // Relocations in an object file.  This is read in read_relocs and
@@ -207,49 +215,55 @@ class Xindex
 // A GOT offset list.  A symbol may have more than one GOT offset
 // (e.g., when mixing modules compiled with two different TLS models),
 // but will usually have at most one.  GOT_TYPE identifies the type of
-// GOT entry; its values are specific to each target.
+// GOT entry; its values are specific to each target.  When gold is
+// configured with --enable-symbol-handles, the GOT type is 8 bits
+// and the link to the next entry is a 24-bit handle, allocated by the
+// Symbol_handles of the symbol table, so an entry takes 8 bytes.
 
 class Got_offset_list
 {
  public:
   Got_offset_list()
-    : got_type_(-1U), got_offset_(0), got_next_(NULL)
+    : got_offset_(0), got_type_(NO_GOT_TYPE), got_next_(0)
   { }
 
   Got_offset_list(unsigned int got_type, unsigned int got_offset)
-    : got_type_(got_type), got_offset_(got_offset), got_next_(NULL)
-  { }
+    : got_offset_(got_offset), got_type_(got_type), got_next_(0)
+  { gold_assert(got_type < NO_GOT_TYPE); }
 
   ~Got_offset_list()
   {
+#ifndef ENABLE_SYMBOL_HANDLES
     if (this->got_next_ != NULL)
       {
         delete this->got_next_;
         this->got_next_ = NULL;
       }
+#endif
   }
 
   // Initialize the fields to their default values.
   void
   init()
   {
-    this->got_type_ = -1U;
     this->got_offset_ = 0;
-    this->got_next_ = NULL;
+    this->got_type_ = NO_GOT_TYPE;
+    this->got_next_ = 0;
   }
 
   // Set the offset for the GOT entry of type GOT_TYPE.
   void
   set_offset(unsigned int got_type, unsigned int got_offset)
   {
-    if (this->got_type_ == -1U)
+    if (this->got_type_ == NO_GOT_TYPE)
       {
+        gold_assert(got_type < NO_GOT_TYPE);
         this->got_type_ = got_type;
         this->got_offset_ = got_offset;
       }
     else
       {
-        for (Got_offset_list* g = this; g != NULL; g = g->got_next_)
+        for (Got_offset_list* g = this; g != NULL; g = g->next())
           {
             if (g->got_type_ == got_type)
               {
@@ -257,9 +271,7 @@ class Got_offset_list
                 return;
               }
           }
-        Got_offset_list* g = new Got_offset_list(got_type, got_offset);
-        g->got_next_ = this->got_next_;
-        this->got_next_ = g;
+        this->add_entry(got_type, got_offset);
       }
   }
 
@@ -267,7 +279,7 @@ class Got_offset_list
   unsigned int
   get_offset(unsigned int got_type) const
   {
-    for (const Got_offset_list* g = this; g != NULL; g = g->got_next_)
+    for (const Got_offset_list* g = this; g != NULL; g = g->next())
       {
         if (g->got_type_ == got_type)
           return g->got_offset_;
@@ -279,7 +291,7 @@ class Got_offset_list
   const Got_offset_list*
   get_list() const
   {
-    if (this->got_type_ == -1U)
+    if (this->got_type_ == NO_GOT_TYPE)
       return NULL;
     return this;
   }
@@ -303,16 +315,56 @@ class Got_offset_list
   void
   for_all_got_offsets(Visitor* v) const
   {
-    if (this->got_type_ == -1U)
+    if (this->got_type_ == NO_GOT_TYPE)
       return;
-    for (const Got_offset_list* g = this; g != NULL; g = g->got_next_)
+    for (const Got_offset_list* g = this; g != NULL; g = g->next())
       v->visit(g->got_type_, g->got_offset_);
   }
 
  private:
-  unsigned int got_type_;
+#ifdef ENABLE_SYMBOL_HANDLES
+  // The value of got_type_ for an empty list.
+  static const unsigned int NO_GOT_TYPE = 0xff;
+
+  // Return the next entry in the list, or NULL.
+  Got_offset_list*
+  next() const
+  { return this->got_next_ == 0 ? NULL : next_entry(this->got_next_); }
+
+  // Return the entry for the handle NEXT.
+  static Got_offset_list*
+  next_entry(unsigned int next);
+
+  // Add a new entry after this one.
+  void
+  add_entry(unsigned int got_type, unsigned int got_offset);
+
   unsigned int got_offset_;
+  unsigned int got_type_ : 8;
+  // The handle of the next entry, or 0.
+  unsigned int got_next_ : 24;
+#else
+  // The value of got_type_ for an empty list.
+  static const unsigned int NO_GOT_TYPE = -1U;
+
+  // Return the next entry in the list, or NULL.
+  Got_offset_list*
+  next() const
+  { return this->got_next_; }
+
+  // Add a new entry after this one.
+  void
+  add_entry(unsigned int got_type, unsigned int got_offset)
+  {
+    Got_offset_list* g = new Got_offset_list(got_type, got_offset);
+    g->got_next_ = this->got_next_;
+    this->got_next_ = g;
+  }
+
+  unsigned int got_offset_;
+  unsigned int got_type_;
   Got_offset_list* got_next_;
+#endif
 };
 
 // Object is an abstract base class which represents either a 32-bit
@@ -334,6 +386,9 @@ class Object
       is_dynamic_(is_dynamic), is_needed_(false), uses_split_stack_(false),
       has_no_split_stack_(false), no_export_(false),
       is_in_system_directory_(false), as_needed_(false), xindex_(NULL)
+#ifdef ENABLE_SYMBOL_HANDLES
+      , symbol_handle_(0)
+#endif
   {
     if (input_file != NULL)
       {
@@ -696,6 +751,19 @@ class Object
   is_in_system_directory() const
   { return this->is_in_system_directory_; }
 
+#ifdef ENABLE_SYMBOL_HANDLES
+  // Return the handle which symbols use to refer to this object, or 0
+  // if none has been allocated.
+  unsigned int
+  symbol_handle() const
+  { return this->symbol_handle_; }
+
+  // Set the handle which symbols use to refer to this object.
+  void
+  set_symbol_handle(unsigned int handle)
+  { this->symbol_handle_ = handle; }
+#endif
+
   // Set flag that this object was linked with --as-needed.
   void
   set_as_needed()
@@ -985,6 +1053,10 @@ class Object
   bool as_needed_ : 1;
   // Many sections for objects with more than SHN_LORESERVE sections.
   Xindex* xindex_;
+#ifdef ENABLE_SYMBOL_HANDLES
+  // The handle which symbols use to refer to this object.
+  unsigned int symbol_handle_;
+#endif
 };
 
 // A regular object (ET_REL).  This is an abstract base class itself.
@@ -1003,7 +1075,8 @@ class Relobj : public Object
       reloc_counts_(NULL),
       reloc_bases_(NULL),
       first_dyn_reloc_(0),
-      dyn_reloc_count_(0)
+      dyn_reloc_count_(0),
+      input_section_handle_(0)
   { }
 
   // During garbage collection, the Read_symbols_data pass for 
@@ -1051,6 +1124,12 @@ class Relobj : public Object
   gc_process_relocs(Symbol_table* symtab, Layout* layout, Read_relocs_data* rd)
   { return this->do_gc_process_relocs(symtab, layout, rd); }
 
+  // Prescan the relocs, to find the ones which may need to adjust the
+  // symbol table.  This may run for several objects at once.
+  void
+  prescan_relocs(Symbol_table* symtab, Layout* layout, Read_relocs_data* rd)
+  { return this->do_prescan_relocs(symtab, layout, rd); }
+
   // Scan the relocs and adjust the symbol table.
   void
   scan_relocs(Symbol_table* symtab, Layout* layout, Read_relocs_data* rd)
@@ -1153,11 +1232,44 @@ class Relobj : public Object
   dyn_reloc_count() const
   { return this->dyn_reloc_count_; }
 
+  // Return the handle used by Output_section::Input_section to refer
+  // to this object, or 0 if none has been assigned.
+  unsigned int
+  input_section_handle() const
+  { return this->input_section_handle_; }
+
+  // Set the handle used by Output_section::Input_section.
+  void
+  set_input_section_handle(unsigned int handle)
+  { this->input_section_handle_ = handle; }
+
   // Relocate the input sections and write out the local symbols.
   void
   relocate(const Symbol_table* symtab, const Layout* layout, Output_file* of)
   { return this->do_relocate(symtab, layout, of); }
 
+  // Relocate and write out only the input sections whose data starts
+  // at an output file offset, as returned by output_file_offset, in
+  // the range [START, END).  An END of -1 means no upper limit.  If
+  // WRITE_LOCAL_SYMBOLS is true, also write out the local symbols.
+  // This is used to split up relocation by output address.
+  void
+  relocate_range(const Symbol_table* symtab, const Layout* layout,
+		 Output_file* of, off_t start, off_t end,
+		 bool write_local_symbols)
+  {
+    this->do_relocate_range(symtab, layout, of, start, end,
+			    write_local_symbols);
+  }
+
+  // Return the offset in the output file at which the data of input
+  // section SHNDX starts, or -1 if it has no data in the output file.
+  // For a specially mapped section, such as a merge section, this is
+  // the offset of the output section.  This is only valid after the
+  // output section offsets are set.
+  off_t
+  output_file_offset(unsigned int shndx) const;
+
   // Return whether an input section is being included in the link.
   bool
   is_section_included(unsigned int shndx) const
@@ -1258,6 +1370,12 @@ class Relobj : public Object
   virtual void
   do_gc_process_relocs(Symbol_table*, Layout*, Read_relocs_data*) = 0;
 
+  // Prescan the relocs--may be implemented by child class.  By
+  // default all the relocs are left for do_scan_relocs.
+  virtual void
+  do_prescan_relocs(Symbol_table*, Layout*, Read_relocs_data*)
+  { }
+
   // Scan the relocs--implemented by child class.
   virtual void
   do_scan_relocs(Symbol_table*, Layout*, Read_relocs_data*) = 0;
@@ -1324,6 +1442,17 @@ class Relobj : public Object
   virtual void
   do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of) = 0;
 
+  // Relocate part of the input sections.  A child class which can not
+  // split up the work relocates everything along with the local
+  // symbols.
+  virtual void
+  do_relocate_range(const Symbol_table* symtab, const Layout* layout,
+		    Output_file* of, off_t, off_t, bool write_local_symbols)
+  {
+    if (write_local_symbols)
+      this->do_relocate(symtab, layout, of);
+  }
+
   // Set the offset of a section--implemented by child class.
   virtual void
   do_set_section_offset(unsigned int shndx, uint64_t off) = 0;
@@ -1443,6 +1572,8 @@ class Relobj : public Object
   unsigned int first_dyn_reloc_;
   // Count of dynamic relocations for this object.
   unsigned int dyn_reloc_count_;
+  // Handle used by Output_section::Input_section, or 0.
+  unsigned int input_section_handle_;
 };
 
 // This class is used to handle relocations against a section symbol
@@ -1545,9 +1676,10 @@ class Symbol_value
   typedef typename elfcpp::Elf_types<size>::Elf_Addr Value;
 
   Symbol_value()
-    : output_symtab_index_(0), output_dynsym_index_(-1U), input_shndx_(0),
-      is_ordinary_shndx_(false), is_section_symbol_(false),
-      is_tls_symbol_(false), is_ifunc_symbol_(false), has_output_value_(true)
+    : output_symtab_index_(0), input_shndx_(0), is_ordinary_shndx_(false),
+      is_section_symbol_(false), is_tls_symbol_(false),
+      is_ifunc_symbol_(false), has_output_value_(true),
+      needs_output_dynsym_entry_(false)
   { this->u_.value = 0; }
 
   ~Symbol_value()
@@ -1686,57 +1818,35 @@ class Symbol_value
     this->output_symtab_index_ = -2U;
   }
 
-  // Set the index in the output dynamic symbol table.
+  // Record that this symbol should go into the dynamic symbol table.
+  // Few local symbols do, so the index itself is kept by the object;
+  // see Sized_relobj_file::dynsym_index.
   void
   set_needs_output_dynsym_entry()
   {
     gold_assert(!this->is_section_symbol());
-    this->output_dynsym_index_ = 0;
+    this->needs_output_dynsym_entry_ = true;
   }
 
   // Return whether this symbol should go into the dynamic symbol
   // table.
   bool
   needs_output_dynsym_entry() const
-  {
-    return this->output_dynsym_index_ != -1U;
-  }
-
-  // Return whether this symbol has an entry in the dynamic symbol
-  // table.
-  bool
-  has_output_dynsym_entry() const
-  {
-    gold_assert(this->output_dynsym_index_ != 0);
-    return this->output_dynsym_index_ != -1U;
-  }
-
-  // Record that this symbol should go into the dynamic symbol table.
-  void
-  set_output_dynsym_index(unsigned int i)
-  {
-    gold_assert(this->output_dynsym_index_ == 0);
-    gold_assert(i != 0 && i != -1U);
-    this->output_dynsym_index_ = i;
-  }
+  { return this->needs_output_dynsym_entry_; }
 
-  // Return the index in the output dynamic symbol table.
-  unsigned int
-  output_dynsym_index() const
-  {
-    gold_assert(this->output_dynsym_index_ != 0
-                && this->output_dynsym_index_ != -1U);
-    return this->output_dynsym_index_;
-  }
+  // The largest input section index that can be recorded.  The
+  // caller must check section indexes against this before calling
+  // set_input_shndx.
+  static const unsigned int max_input_shndx = (1U << 26) - 1;
 
   // Set the index of the input section in the input file.
   void
   set_input_shndx(unsigned int i, bool is_ordinary)
   {
-    this->input_shndx_ = i;
     // input_shndx_ field is a bitfield, so make sure that the value
     // fits.
-    gold_assert(this->input_shndx_ == i);
+    gold_assert(i <= max_input_shndx);
+    this->input_shndx_ = i;
     this->is_ordinary_shndx_ = is_ordinary;
   }
 
@@ -1793,12 +1903,9 @@ class Symbol_value
   // the symbol table.  This will be -2U if the symbol must go into
   // the symbol table, but no index has been assigned yet.
   unsigned int output_symtab_index_;
-  // The index of this local symbol in the dynamic symbol table.  This
-  // will be -1U if the symbol should not go into the symbol table.
-  unsigned int output_dynsym_index_;
   // The section index in the input file in which this symbol is
   // defined.
-  unsigned int input_shndx_ : 27;
+  unsigned int input_shndx_ : 26;
   // Whether the section index is an ordinary index, not a special
   // value.
   bool is_ordinary_shndx_ : 1;
@@ -1814,6 +1921,8 @@ class Symbol_value
   // a merge section, as for such symbols we can not determine the
   // value to use in a relocation until we see the addend.
   bool has_output_value_ : 1;
+  // Whether this symbol should go into the dynamic symbol table.
+  bool needs_output_dynsym_entry_ : 1;
   union
   {
     // This is used if has_output_value_ is true.  Between
@@ -2112,13 +2221,9 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   }
 
   // Return the index of local symbol SYM in the dynamic symbol
-  // table.  A value of -1U means that the symbol is not being output.
+  // table.  The symbol must have a dynamic symbol table entry.
   unsigned int
-  dynsym_index(unsigned int sym) const
-  {
-    gold_assert(sym < this->local_values_.size());
-    return this->local_values_[sym].output_dynsym_index();
-  }
+  dynsym_index(unsigned int sym) const;
 
   // Return the input section index of local symbol SYM.
   unsigned int
@@ -2263,6 +2368,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_gc_process_relocs(Symbol_table*, Layout*, Read_relocs_data*);
 
+  // Prescan the relocs.
+  void
+  do_prescan_relocs(Symbol_table*, Layout*, Read_relocs_data*);
+
   // Scan the relocs and adjust the symbol table.
   void
   do_scan_relocs(Symbol_table*, Layout*, Read_relocs_data*);
@@ -2288,6 +2397,12 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   do_relocate(const Symbol_table* symtab, const Layout*, Output_file* of);
 
+  // Relocate the input sections in an output file range.
+  void
+  do_relocate_range(const Symbol_table* symtab, const Layout*,
+		    Output_file* of, off_t start, off_t end,
+		    bool write_local_symbols);
+
   // Get the size of a section.
   uint64_t
   do_section_size(unsigned int shndx)
@@ -2403,6 +2518,9 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
     bool is_input_output_view;
     bool is_postprocessing_view;
     bool is_ctors_reverse_view;
+    // True if the section is relocated by a different call to
+    // relocate_range, in which case view is NULL.
+    bool is_in_other_range;
   };
 
   typedef std::vector<View_size> Views;
@@ -2524,11 +2642,23 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 			  unsigned int shndx, const typename This::Shdr&,
 			  unsigned int reloc_shndx, unsigned int reloc_type);
 
-  // Write section data to the output file.  Record the views and
-  // sizes in VIEWS for use when relocating.
+  // Write section data to the output file for the sections in the
+  // output file range [START, END), as for relocate_range.  Record the
+  // views and sizes in VIEWS for use when relocating.
   void
   write_sections(const Layout*, const unsigned char* pshdrs, Output_file*,
-		 Views*);
+		 off_t start, off_t end, Views*);
+
+  // Return whether section SHNDX is in the output file range [START,
+  // END), as for relocate_range.
+  bool
+  is_in_relocate_range(unsigned int shndx, off_t start, off_t end) const
+  {
+    if (start == 0 && end == -1)
+      return true;
+    off_t off = this->output_file_offset(shndx);
+    return off >= start && (end == -1 || off < end);
+  }
 
   // Relocate the sections in the output file.
   void
@@ -2668,6 +2798,12 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   // The PLT offsets of local symbols.
   typedef Unordered_map<unsigned int, unsigned int> Local_plt_offsets;
 
+  // The dynamic symbol table indexes of the few local symbols which
+  // have one, as (local symbol index, dynsym index) pairs sorted by
+  // local symbol index.
+  typedef std::vector<std::pair<unsigned int, unsigned int> >
+    Local_dynsym_indexes;
+
   // Saved information for sections whose layout was deferred.
   struct Deferred_layout
   {
@@ -2709,8 +2845,13 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   off_t local_symbol_offset_;
   // File offset for local dynamic symbols (absolute).
   off_t local_dynsym_offset_;
-  // Values of local symbols.
+  // Values of local symbols, indexed by local symbol index.  This is
+  // dense rather than sparse: in a typical link most local symbols
+  // are either referenced by a relocation or written to the output
+  // symbol table, and a sparse entry costs more than a Symbol_value.
   Local_values local_values_;
+  // Dynamic symbol table indexes of local symbols.
+  Local_dynsym_indexes local_dynsym_indexes_;
   // PLT offsets for local symbols.
   Local_plt_offsets local_plt_offsets_;
   // Table mapping discarded comdat sections to corresponding kept sections.
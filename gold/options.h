@@ -645,6 +645,9 @@ class General_options
 	      N_("Allow unresolved references in shared libraries"),
 	      N_("Do not allow unresolved references in shared libraries"));
 
+  DEFINE_string(archive_index_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Cache archive symbol table indexes in DIR"), N_("DIR"));
+
   DEFINE_bool(as_needed, options::TWO_DASHES, '\0', false,
 	      N_("Only set DT_NEEDED for shared libraries if used"),
 	      N_("Always DT_NEEDED for shared libraries"));
@@ -732,6 +735,11 @@ class General_options
 		N_("Turn on debugging"),
 		N_("[all,files,script,task][,...]"));
 
+  DEFINE_bool(debug_names, options::TWO_DASHES, '\0', false,
+	      N_("Generate DWARF 5 .debug_names section, "
+		 "without type units"),
+	      N_("Do not generate .debug_names section"));
+
   DEFINE_special(defsym, options::TWO_DASHES, '\0',
 		 N_("Define a symbol"), N_("SYMBOL=EXPRESSION"));
 
@@ -904,6 +912,17 @@ class General_options
 	      N_("Keep files mapped across passes (default)"),
 	      N_("Release mapped files after each pass"));
 
+  DEFINE_uint64(max_mapped_input_memory, options::TWO_DASHES, '\0', 0,
+		N_("Unmap the least recently used parts of input files "
+		   "to keep no more than SIZE bytes mapped"), N_("SIZE"));
+
+  DEFINE_bool(prefetch_inputs, options::TWO_DASHES, '\0', false,
+	      N_("Start reading input files before they are needed"),
+	      N_("Do not read input files before they are needed (default)"));
+  DEFINE_uint64(prefetch_inputs_limit, options::TWO_DASHES, '\0', 64 << 20,
+		N_("With --prefetch-inputs, prefetch no more than SIZE bytes "
+		   "ahead of use"), N_("SIZE"));
+
   DEFINE_bool(ld_generated_unwind_info, options::TWO_DASHES, '\0', true,
 	      N_("Generate unwind information for PLT (default)"),
 	      N_("Do not generate unwind information for PLT"));
@@ -938,6 +957,25 @@ class General_options
 	      N_("Map the output file for writing (default)."),
 	      N_("Do not map the output file for writing."));
 
+  DEFINE_bool(pwrite_output_file, options::TWO_DASHES, '\0', false,
+	      N_("Write the output file with pwrite as it is completed"),
+	      N_("Write the output file as set by --mmap-output-file "
+		 "(default)"));
+
+  DEFINE_bool(prefault_output_file, options::TWO_DASHES, '\0', false,
+	      N_("Fault in the output file buffer before writing to it"),
+	      N_("Fault in the output file buffer as it is written "
+		 "(default)"));
+
+  DEFINE_bool(output_huge_pages, options::TWO_DASHES, '\0', false,
+	      N_("Ask for huge pages for the output file buffer"),
+	      N_("Use normal pages for the output file buffer (default)"));
+
+  DEFINE_bool(rename_output_file, options::TWO_DASHES, '\0', false,
+	      N_("Write the output to a temporary file and rename it "
+		 "into place when done"),
+	      N_("Write the output file in place (default)"));
+
   DEFINE_bool(print_map, options::TWO_DASHES, 'M', false,
 	      N_("Write map file on standard output"), NULL);
   DEFINE_string(Map, options::ONE_DASH, '\0', NULL, N_("Write map file"),
@@ -1029,6 +1067,11 @@ class General_options
   DEFINE_bool(relax, options::TWO_DASHES, '\0', false,
 	      N_("Relax branches on certain targets"), NULL);
 
+  DEFINE_enum(relocation_order, options::TWO_DASHES, '\0', "object",
+	      N_("With threads, split relocation work by input object "
+		 "or by output file address"),
+	      N_("[object,output]"), {"object", "output"});
+
   DEFINE_string(retain_symbols_file, options::TWO_DASHES, '\0', NULL,
 		N_("keep only symbols listed in this file"), N_("FILE"));
 
@@ -1149,7 +1192,9 @@ class General_options
   DEFINE_uint(thread_count_initial, options::TWO_DASHES, '\0', 0,
 	      N_("Number of threads to use in initial pass"), N_("COUNT"));
   DEFINE_uint(thread_count_middle, options::TWO_DASHES, '\0', 0,
-	      N_("Number of threads to use in middle pass"), N_("COUNT"));
+	      N_("Number of threads to use in middle pass "
+		 "(relocations are scanned in parallel only on x86_64)"),
+	      N_("COUNT"));
   DEFINE_uint(thread_count_final, options::TWO_DASHES, '\0', 0,
 	      N_("Number of threads to use in final pass"), N_("COUNT"));
 
@@ -2078,8 +2078,92 @@ Output_fill_debug_line::do_write(Output_file* of, off_t off, size_t len) const
   of->write_output_view(off, len, oview);
 }
 
+// Input_section_handles methods.
+
+// Return the handle for OBJECT, allocating one the first time we see
+// it.
+
+unsigned int
+Input_section_handles::object_handle(Relobj* object)
+{
+  Hold_lock hl(this->lock_);
+  unsigned int handle = object->input_section_handle();
+  if (handle == 0)
+    {
+      if (this->objects_.full())
+	gold_fatal(_("too many input objects with sections (the limit is %u)"),
+		   MAX_HANDLE);
+      handle = this->objects_.add(object);
+      object->set_input_section_handle(handle);
+    }
+  return handle;
+}
+
+// Return the handle for POSD, allocating one the first time we see
+// it.
+
+unsigned int
+Input_section_handles::data_handle(Output_section_data* posd)
+{
+  gold_assert(posd != NULL);
+  Hold_lock hl(this->lock_);
+  unsigned int handle = posd->input_section_handle();
+  if (handle == 0)
+    {
+      if (this->datas_.full())
+	gold_fatal(_("too many generated input sections (the limit is %u)"),
+		   MAX_HANDLE);
+      handle = this->datas_.add(posd);
+      posd->set_input_section_handle(handle);
+    }
+  return handle;
+}
+
+// Record the size of section SHNDX in OBJECT.
+
+void
+Input_section_handles::set_large_data_size(const Relobj* object,
+					   unsigned int shndx,
+					   off_t data_size)
+{
+  Hold_lock hl(this->lock_);
+  this->large_data_sizes_[Const_section_id(object, shndx)] = data_size;
+}
+
+// Return the size recorded for section SHNDX in OBJECT.
+
+off_t
+Input_section_handles::large_data_size(const Relobj* object,
+				       unsigned int shndx)
+{
+  Hold_lock hl(this->lock_);
+  Large_data_sizes::const_iterator p =
+    this->large_data_sizes_.find(Const_section_id(object, shndx));
+  gold_assert(p != this->large_data_sizes_.end());
+  return p->second;
+}
+
 // Output_section::Input_section methods.
 
+Input_section_handles* Output_section::Input_section::handles_;
+
+// Record the size of an ordinary input section.  Sizes which do not
+// fit in 32 bits are kept in a side table.
+
+void
+Output_section::Input_section::set_input_section_data_size(Relobj* object,
+							   unsigned int shndx,
+							   off_t data_size)
+{
+  if (static_cast<uint64_t>(data_size) < LARGE_DATA_SIZE)
+    this->u1_.data_size = data_size;
+  else
+    {
+      this->u1_.data_size = LARGE_DATA_SIZE;
+      handles_->set_large_data_size(object, shndx, data_size);
+    }
+}
+
 // Return the current data size.  For an input section we store the size here.
 // For an Output_section_data, we have to ask it for the size.
 
@@ -2087,11 +2171,12 @@ off_t
 Output_section::Input_section::current_data_size() const
 {
   if (this->is_input_section())
-    return this->u1_.data_size;
+    return this->data_size();
   else
     {
-      this->u2_.posd->pre_finalize_data_size();
-      return this->u2_.posd->current_data_size();
+      Output_section_data* posd = this->posd();
+      posd->pre_finalize_data_size();
+      return posd->current_data_size();
     }
 }
 
@@ -2101,10 +2186,30 @@ Output_section::Input_section::current_data_size() const
 off_t
 Output_section::Input_section::data_size() const
 {
-  if (this->is_input_section())
+  if (!this->is_input_section())
+    return this->posd()->data_size();
+  else if (this->u1_.data_size != LARGE_DATA_SIZE)
     return this->u1_.data_size;
   else
-    return this->u2_.posd->data_size();
+    return handles_->large_data_size(this->object(), this->shndx_);
+}
+
+// For a merge section, return the Output_merge_base pointer.
+
+Output_merge_base*
+Output_section::Input_section::output_merge_base() const
+{
+  gold_assert(this->is_merge_section());
+  return static_cast<Output_merge_base*>(this->posd());
+}
+
+// Return the Output_relaxed_input_section object.
+
+Output_relaxed_input_section*
+Output_section::Input_section::relaxed_input_section() const
+{
+  gold_assert(this->is_relaxed_input_section());
+  return static_cast<Output_relaxed_input_section*>(this->posd());
 }
 
 // Return the object for an input section.
@@ -2113,14 +2218,15 @@ Relobj*
 Output_section::Input_section::relobj() const
 {
   if (this->is_input_section())
-    return this->u2_.object;
+    return this->object();
   else if (this->is_merge_section())
     {
-      gold_assert(this->u2_.pomb->first_relobj() != NULL);
-      return this->u2_.pomb->first_relobj();
+      Output_merge_base* pomb = this->output_merge_base();
+      gold_assert(pomb->first_relobj() != NULL);
+      return pomb->first_relobj();
     }
   else if (this->is_relaxed_input_section())
-    return this->u2_.poris->relobj();
+    return this->relaxed_input_section()->relobj();
   else
     gold_unreachable();
 }
@@ -2134,11 +2240,12 @@ Output_section::Input_section::shndx() const
     return this->shndx_;
   else if (this->is_merge_section())
     {
-      gold_assert(this->u2_.pomb->first_relobj() != NULL);
-      return this->u2_.pomb->first_shndx();
+      Output_merge_base* pomb = this->output_merge_base();
+      gold_assert(pomb->first_relobj() != NULL);
+      return pomb->first_shndx();
     }
   else if (this->is_relaxed_input_section())
-    return this->u2_.poris->shndx();
+    return this->relaxed_input_section()->shndx();
   else
     gold_unreachable();
 }
@@ -2152,10 +2259,10 @@ Output_section::Input_section::set_address_and_file_offset(
     off_t section_file_offset)
 {
   if (this->is_input_section())
-    this->u2_.object->set_section_offset(this->shndx_,
-					 file_offset - section_file_offset);
+    this->object()->set_section_offset(this->shndx_,
+				       file_offset - section_file_offset);
   else
-    this->u2_.posd->set_address_and_file_offset(address, file_offset);
+    this->posd()->set_address_and_file_offset(address, file_offset);
 }
 
 // Reset the address and file offset.
@@ -2164,7 +2271,7 @@ void
 Output_section::Input_section::reset_address_and_file_offset()
 {
   if (!this->is_input_section())
-    this->u2_.posd->reset_address_and_file_offset();
+    this->posd()->reset_address_and_file_offset();
 }
 
 // Finalize the data size.
@@ -2173,7 +2280,7 @@ void
 Output_section::Input_section::finalize_data_size()
 {
   if (!this->is_input_section())
-    this->u2_.posd->finalize_data_size();
+    this->posd()->finalize_data_size();
 }
 
 // Try to turn an input offset into an output offset.  We want to
@@ -2188,10 +2295,10 @@ Output_section::Input_section::output_offset(
     section_offset_type* poutput) const
 {
   if (!this->is_input_section())
-    return this->u2_.posd->output_offset(object, shndx, offset, poutput);
+    return this->posd()->output_offset(object, shndx, offset, poutput);
   else
     {
-      if (this->shndx_ != shndx || this->u2_.object != object)
+      if (this->shndx_ != shndx || this->object() != object)
 	return false;
       *poutput = offset;
       return true;
@@ -2207,7 +2314,7 @@ Output_section::Input_section::is_merge_section_for(const Relobj* object,
 {
   if (this->is_input_section())
     return false;
-  return this->u2_.posd->is_merge_section_for(object, shndx);
+  return this->posd()->is_merge_section_for(object, shndx);
 }
 
 // Write out the data.  We don't have to do anything for an input
@@ -2218,7 +2325,7 @@ void
 Output_section::Input_section::write(Output_file* of)
 {
   if (!this->is_input_section())
-    this->u2_.posd->write(of);
+    this->posd()->write(of);
 }
 
 // Write the data to a buffer.  As for write(), we don't have to do
@@ -2228,7 +2335,7 @@ void
 Output_section::Input_section::write_to_buffer(unsigned char* buffer)
 {
   if (!this->is_input_section())
-    this->u2_.posd->write_to_buffer(buffer);
+    this->posd()->write_to_buffer(buffer);
 }
 
 // Print to a map file.
@@ -2241,7 +2348,7 @@ Output_section::Input_section::print_to_mapfile(Mapfile* mapfile) const
     case OUTPUT_SECTION_CODE:
     case MERGE_DATA_SECTION_CODE:
     case MERGE_STRING_SECTION_CODE:
-      this->u2_.posd->print_to_mapfile(mapfile);
+      this->posd()->print_to_mapfile(mapfile);
       break;
 
     case RELAXED_INPUT_SECTION_CODE:
@@ -2253,13 +2360,16 @@ Output_section::Input_section::print_to_mapfile(Mapfile* mapfile) const
       }
       break;
     default:
-      mapfile->print_input_section(this->u2_.object, this->shndx_);
+      mapfile->print_input_section(this->object(), this->shndx_);
       break;
     }
 }
 
 // Output_section methods.
 
+unsigned int Output_section::relaxed_layouts_reused;
+unsigned int Output_section::relaxed_layouts_redone;
+
 // Construct an Output_section.  NAME will point into a Stringpool.
 
 Output_section::Output_section(const char* name, elfcpp::Elf_Word type,
@@ -2305,6 +2415,7 @@ Output_section::Output_section(const char* name, elfcpp::Elf_Word type,
     is_noload_(false),
     always_keeps_input_sections_(false),
     has_fixed_layout_(false),
+    relaxed_layout_is_reusable_(false),
     is_patch_space_allowed_(false),
     is_unique_segment_(false),
     tls_offset_(0),
@@ -2314,7 +2425,13 @@ Output_section::Output_section(const char* name, elfcpp::Elf_Word type,
     lookup_maps_(new Output_section_lookup_maps),
     free_list_(),
     free_space_fill_(NULL),
-    patch_space_(0)
+    patch_space_(0),
+    relaxed_layout_offset_(0),
+    relaxed_layout_data_size_(0),
+    relaxed_layout_first_input_offset_(0),
+    relaxed_layout_count_(0),
+    relaxed_layout_addralign_(0),
+    section_order_indexes_()
 {
   // An unallocated section has no address.  Forcing this means that
   // we don't need special treatment for symbols defined in debug
@@ -2501,7 +2618,8 @@ Output_section::add_input_section(Layout* layout,
             layout->find_section_order_index(std::string(secname));
 	  if (section_order_index != 0)
             {
-              isecn.set_section_order_index(section_order_index);
+              this->set_section_order_index(object, shndx,
+					    section_order_index);
               this->set_input_section_order_specified();
             }
         }
@@ -2576,7 +2694,8 @@ Output_section::add_relaxed_input_section(Layout* layout,
         layout->find_section_order_index(name);
       if (section_order_index != 0)
         {
-          inp.set_section_order_index(section_order_index);
+          this->set_section_order_index(poris->relobj(), poris->shndx(),
+					section_order_index);
           this->set_input_section_order_specified();
         }
     }
@@ -2744,12 +2863,9 @@ Output_section::convert_input_sections_in_list_to_relaxed_sections(
       gold_assert(p != map.end());
       gold_assert((*input_sections)[p->second].is_input_section());
 
-      // Remember section order index of original input section
-      // if it is set.  Copy it to the relaxed input section.
-      unsigned int soi =
-	(*input_sections)[p->second].section_order_index();
+      // The section order index, if any, is recorded by section id,
+      // so the relaxed input section keeps it.
       (*input_sections)[p->second] = Input_section(poris);
-      (*input_sections)[p->second].set_section_order_index(soi);
     }
 }
 
@@ -2763,6 +2879,8 @@ Output_section::convert_input_sections_to_relaxed_sections(
 {
   gold_assert(parameters->target().may_relax());
 
+  this->invalidate_relaxed_layout();
+
   // We want to make sure that restore_states does not undo the effect of
   // this.  If there is no checkpoint active, just search the current
   // input section list and replace the sections there.  If there is
@@ -3105,19 +3223,59 @@ Output_section::set_final_data_size()
 	  || this->input_section_order_specified())
 	this->sort_attached_input_sections();
 
-      uint64_t address = this->address();
-      off_t startoff = this->offset();
-      off_t off = startoff + this->first_input_offset_;
-      for (Input_section_list::iterator p = this->input_sections_.begin();
-	   p != this->input_sections_.end();
-	   ++p)
+      if (this->can_reuse_relaxed_layout())
 	{
-	  off = align_address(off, p->addralign());
-	  p->set_address_and_file_offset(address + (off - startoff), off,
-					 startoff);
-	  off += p->data_size();
+	  // Nothing in this section changed since the last relaxation
+	  // pass, and it moved by a multiple of the alignment of every
+	  // input section, so each input section is at the same offset
+	  // within it as before.
+	  data_size = this->relaxed_layout_data_size_;
+	  ++Output_section::relaxed_layouts_reused;
+	}
+      else
+	{
+	  uint64_t address = this->address();
+	  off_t startoff = this->offset();
+	  off_t off = startoff + this->first_input_offset_;
+	  uint64_t max_addralign = 1;
+	  bool only_input_sections = true;
+	  for (Input_section_list::iterator p = this->input_sections_.begin();
+	       p != this->input_sections_.end();
+	       ++p)
+	    {
+	      off = align_address(off, p->addralign());
+	      p->set_address_and_file_offset(address + (off - startoff), off,
+					     startoff);
+	      off += p->data_size();
+	      if (p->addralign() > max_addralign)
+		max_addralign = p->addralign();
+	      if (!p->is_input_section())
+		only_input_sections = false;
+	    }
+	  data_size = off - startoff;
+
+	  // When relaxing, remember this layout so that the next pass
+	  // can skip the loop above if nothing changed.  We only do
+	  // this when all the entries are ordinary input sections,
+	  // since the target may change the size of anything else
+	  // behind our back.
+	  if (parameters->target().may_relax())
+	    {
+	      if (this->relaxed_layout_count_ != 0)
+		++Output_section::relaxed_layouts_redone;
+	      this->relaxed_layout_is_reusable_ =
+		(only_input_sections
+		 && !this->must_sort_attached_input_sections()
+		 && !this->input_section_order_specified()
+		 && !parameters->incremental());
+	      this->relaxed_layout_offset_ = startoff;
+	      this->relaxed_layout_data_size_ = data_size;
+	      this->relaxed_layout_first_input_offset_ =
+		this->first_input_offset_;
+	      this->relaxed_layout_count_ = this->input_sections_.size();
+	      this->relaxed_layout_addralign_ = max_addralign;
+	    }
 	}
-      data_size = off - startoff;
     }
 
   // For full incremental links, we want to allocate some patch space
@@ -3142,6 +3300,25 @@ Output_section::set_final_data_size()
   this->set_data_size(data_size);
 }
 
+// Return whether the layout of the input sections from the previous
+// relaxation pass is still valid.  It is if the input sections have
+// not changed, and the section has moved by a multiple of the largest
+// input section alignment.
+
+bool
+Output_section::can_reuse_relaxed_layout() const
+{
+  if (!this->relaxed_layout_is_reusable_
+      || this->relaxed_layout_count_ != this->input_sections_.size()
+      || this->relaxed_layout_first_input_offset_ != this->first_input_offset_)
+    return false;
+  off_t delta = this->offset() - this->relaxed_layout_offset_;
+  if (delta < 0)
+    delta = -delta;
+  return (static_cast<uint64_t>(delta) % this->relaxed_layout_addralign_
+	  == 0);
+}
+
 // Reset the address and file offset.
 
 void
@@ -3154,10 +3331,16 @@ Output_section::do_reset_address_and_file_offset()
   if (((this->flags_ & elfcpp::SHF_ALLOC) == 0) && !this->is_noload_)
      this->set_address(0);
 
-  for (Input_section_list::iterator p = this->input_sections_.begin();
-       p != this->input_sections_.end();
-       ++p)
-    p->reset_address_and_file_offset();
+  // If the layout can be reused, all the entries are ordinary input
+  // sections, and there is nothing to reset.
+  if (!this->relaxed_layout_is_reusable_
+      || this->relaxed_layout_count_ != this->input_sections_.size())
+    {
+      for (Input_section_list::iterator p = this->input_sections_.begin();
+	   p != this->input_sections_.end();
+	   ++p)
+	p->reset_address_and_file_offset();
+    }
 
   // Remove any patch space that was added in set_final_data_size.
   if (this->patch_space_ > 0)
@@ -3203,14 +3386,16 @@ class Output_section::Input_section_sort_entry
 {
  public:
   Input_section_sort_entry()
-    : input_section_(), index_(-1U), section_has_name_(false),
-      section_name_()
+    : input_section_(), index_(-1U), section_order_index_(0),
+      section_has_name_(false), section_name_()
   { }
 
   Input_section_sort_entry(const Input_section& input_section,
 			   unsigned int index,
+			   unsigned int section_order_index,
 			   bool must_sort_attached_input_sections)
     : input_section_(input_section), index_(index),
+      section_order_index_(section_order_index),
       section_has_name_(input_section.is_input_section()
 			|| input_section.is_relaxed_input_section())
   {
@@ -3249,6 +3434,12 @@ class Output_section::Input_section_sort_entry
     return this->index_;
   }
 
+  // The section order index of the Input_section, or 0 if it has
+  // none.
+  unsigned int
+  section_order_index() const
+  { return this->section_order_index_; }
+
   // Whether there is a section name.
   bool
   section_has_name() const
@@ -3319,8 +3510,8 @@ class Output_section::Input_section_sort_entry
   int
   compare_section_ordering(const Input_section_sort_entry& s) const
   {
-    unsigned int this_secn_index = this->input_section_.section_order_index();
-    unsigned int s_secn_index = s.input_section().section_order_index();
+    unsigned int this_secn_index = this->section_order_index_;
+    unsigned int s_secn_index = s.section_order_index();
     if (this_secn_index > 0 && s_secn_index > 0)
       {
         if (this_secn_index < s_secn_index)
@@ -3336,6 +3527,8 @@ class Output_section::Input_section_sort_entry
   Input_section input_section_;
   // The index of this Input_section in the original list.
   unsigned int index_;
+  // The section order index of this Input_section.
+  unsigned int section_order_index_;
   // Whether this Input_section has a section name--it won't if this
   // is some random Output_section_data.
   bool section_has_name_;
@@ -3480,8 +3673,8 @@ Output_section::Input_section_sort_section_order_index_compare::operator()(
     const Output_section::Input_section_sort_entry& s1,
     const Output_section::Input_section_sort_entry& s2) const
 {
-  unsigned int s1_secn_index = s1.input_section().section_order_index();
-  unsigned int s2_secn_index = s2.input_section().section_order_index();
+  unsigned int s1_secn_index = s1.section_order_index();
+  unsigned int s2_secn_index = s2.section_order_index();
 
   // Keep input order if section ordering cannot determine order.
   if (s1_secn_index == s2_secn_index)
@@ -3555,6 +3748,37 @@ Output_section::Input_section_sort_section_name_compare
   return s1.index() < s2.index();
 }
 
+// Return the section order index of input section IS.
+
+unsigned int
+Output_section::section_order_index(const Input_section& is) const
+{
+  if (this->section_order_indexes_.empty())
+    return 0;
+  const Relobj* object;
+  if (is.is_input_section())
+    object = is.relobj();
+  else if (is.is_relaxed_input_section())
+    object = is.relaxed_input_section()->relobj();
+  else
+    return 0;
+  Section_order_indexes::const_iterator p =
+    this->section_order_indexes_.find(Const_section_id(object, is.shndx()));
+  if (p == this->section_order_indexes_.end())
+    return 0;
+  return p->second;
+}
+
+// Record the section order index of the input section SHNDX in OBJECT.
+
+void
+Output_section::set_section_order_index(const Relobj* object,
+					unsigned int shndx,
+					unsigned int number)
+{
+  this->section_order_indexes_[Const_section_id(object, shndx)] = number;
+}
+
 // This updates the section order index of input sections according to the
 // the order specified in the mapping from Section id to order index.
 
@@ -3569,7 +3793,7 @@ Output_section::update_section_layout(
       if (p->is_input_section()
 	  || p->is_relaxed_input_section())
         {
-	  Object* obj = (p->is_input_section()
+	  Relobj* obj = (p->is_input_section()
 			 ? p->relobj()
 		         : p->relaxed_input_section()->relobj());
 	  unsigned int shndx = p->shndx();
@@ -3580,7 +3804,8 @@ Output_section::update_section_layout(
 	  unsigned int section_order_index = it->second;
 	  if (section_order_index != 0)
             {
-              p->set_section_order_index(section_order_index);
+              this->set_section_order_index(obj, shndx,
+					    section_order_index);
               this->set_input_section_order_specified();
 	    }
         }
@@ -3613,6 +3838,7 @@ Output_section::sort_attached_input_sections()
        p != this->input_sections_.end();
        ++p, ++i)
       sort_list.push_back(Input_section_sort_entry(*p, i,
+                            this->section_order_index(*p),
                             this->must_sort_attached_input_sections()));
 
   // Sort the input sections.
@@ -3641,6 +3867,7 @@ Output_section::sort_attached_input_sections()
     }
 
   // Copy the sorted input sections back to our list.
+  this->invalidate_relaxed_layout();
   this->input_sections_.clear();
   for (std::vector<Input_section_sort_entry>::iterator p = sort_list.begin();
        p != sort_list.end();
@@ -3759,6 +3986,25 @@ Output_section::do_write(Output_file* of)
     }
 }
 
+// Return the number of bytes which write will write out.
+
+off_t
+Output_section::output_section_data_size() const
+{
+  if (this->type_ == elfcpp::SHT_NOBITS)
+    return 0;
+
+  off_t size = 0;
+  for (Input_section_list::const_iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if (!p->is_input_section())
+	size += p->data_size();
+    }
+  return size;
+}
+
 // If a section requires postprocessing, create the buffer to use.
 
 void
@@ -3778,6 +4024,12 @@ Output_section::create_postprocessing_buffer()
 	{
 	  off = align_address(off, p->addralign());
 	  p->finalize_data_size();
+	  // As for a section which is not allocated, record the offset
+	  // of generic section data within the section as its address,
+	  // so that other sections can refer to it.
+	  if (p->is_output_section_data()
+	      && !p->output_section_data()->is_address_valid())
+	    p->output_section_data()->set_address(off);
 	  off += p->data_size();
 	}
       this->set_current_data_size_for_child(off);
@@ -3892,6 +4144,7 @@ Output_section::get_input_sections(
 
   this->input_sections_.swap(remaining);
   this->first_input_offset_ = 0;
+  this->invalidate_relaxed_layout();
 
   uint64_t data_size = address - orig_address;
   this->set_current_data_size_for_child(data_size);
@@ -3988,7 +4241,11 @@ Output_section::restore_states()
       // If we have not copied the input sections, just resize it.
       size_t old_size = checkpoint->input_sections_size();
       gold_assert(this->input_sections_.size() >= old_size);
-      this->input_sections_.resize(old_size);
+      if (this->input_sections_.size() != old_size)
+	{
+	  this->input_sections_.resize(old_size);
+	  this->invalidate_relaxed_layout();
+	}
     }
   else
     {
@@ -3997,6 +4254,7 @@ Output_section::restore_states()
       // objects.  We may need to re-think how we should pass sections
       // to scripts.
       this->input_sections_ = *checkpoint->input_sections();
+      this->invalidate_relaxed_layout();
     }
 
   this->attached_input_sections_are_sorted_ =
@@ -4028,6 +4286,18 @@ Output_section::adjust_section_offsets()
     }
 
   this->section_offsets_need_adjustment_ = false;
+  this->invalidate_relaxed_layout();
+}
+
+// Print statistics about relaxation passes to stderr.
+
+void
+Output_section::print_relaxation_stats()
+{
+  fprintf(stderr, _("%s: output sections laid out again when relaxing: %u\n"),
+	  program_name, Output_section::relaxed_layouts_redone);
+  fprintf(stderr, _("%s: output sections reused when relaxing: %u\n"),
+	  program_name, Output_section::relaxed_layouts_reused);
 }
 
 // Print to the map file.
@@ -4903,10 +5173,31 @@ Output_file::Output_file(const char* name)
     base_(NULL),
     map_is_anonymous_(false),
     map_is_allocated_(false),
-    is_temporary_(false)
+    is_temporary_(false),
+    start_writeback_(false),
+    pwrite_(false),
+    serial_(Output_file::next_serial++),
+    pending_writes_(),
+    pending_lock_(NULL)
 {
 }
 
+unsigned int Output_file::next_serial = 1;
+
+#ifdef HAVE_TLS
+__thread unsigned int Output_file::thread_pending_serial;
+__thread Output_file::Pending_write* Output_file::thread_pending_write;
+#endif
+
+// For --rename-output-file, the name of the temporary file while it
+// exists, and the name of the output file which it replaces.  When
+// gold exits, finish_temporary_output renames or removes it.
+static std::string temporary_output_name;
+static const char* final_output_name;
+
+// Whether we opened the output file itself for writing.
+static bool output_opened_in_place;
+
 // Try to open an existing file.  Returns false if the file doesn't
 // exist, has a size of 0 or can't be mmapped.  If BASE_NAME is not
 // NULL, open that file as the base for incremental linking, and
@@ -4982,6 +5273,8 @@ Output_file::open_base_file(const char* base_name, bool writable)
 	  bytes_to_read -= len;
 	}
       ::close(o);
+      if (this->pwrite_)
+	this->queue_write(0, s.st_size);
       return true;
     }
 
@@ -4996,6 +5289,9 @@ Output_file::open_base_file(const char* base_name, bool writable)
       return false;
     }
 
+  if (writable)
+    output_opened_in_place = true;
+
   return true;
 }
 
@@ -5019,12 +5315,18 @@ Output_file::open(off_t file_size)
   // If we fail, continue; this command is merely a best-effort attempt
   // to improve the odds for open().
 
+  // With --rename-output-file we instead write a new file and rename
+  // it over the old one when gold exits, so that anything still
+  // reading the old file is not disturbed, and a failed link leaves
+  // the old file alone.
+
   // We let the name "-" mean "stdout"
   if (!this->is_temporary_)
     {
       if (strcmp(this->name_, "-") == 0)
 	this->o_ = STDOUT_FILENO;
-      else
+      else if (!parameters->options().rename_output_file()
+	       || !this->open_temporary_output())
 	{
 	  struct stat s;
 	  if (::stat(this->name_, &s) == 0
@@ -5050,12 +5352,105 @@ Output_file::open(off_t file_size)
 	  if (o < 0)
 	    gold_fatal(_("%s: open: %s"), this->name_, strerror(errno));
 	  this->o_ = o;
+	  output_opened_in_place = true;
 	}
     }
 
   this->map();
 }
 
+// Open a temporary file to write to for --rename-output-file.  We
+// only do this if the output file does not exist or is a regular
+// file which we would have unlinked.  Return whether we opened it.
+
+bool
+Output_file::open_temporary_output()
+{
+  struct stat s;
+  if (::stat(this->name_, &s) == 0
+      && (!S_ISREG(s.st_mode) || s.st_size == 0))
+    return false;
+
+  std::string tmpname(std::string(this->name_) + ".XXXXXX");
+  std::vector<char> tmpbuf(tmpname.begin(), tmpname.end());
+  tmpbuf.push_back('\0');
+  int o = ::mkstemp(&tmpbuf[0]);
+  if (o < 0)
+    {
+      gold_info(_("%s: can not create temporary output file: %s"),
+		this->name_, strerror(errno));
+      return false;
+    }
+
+  // mkstemp creates the file with mode 0600; give it the mode we
+  // would have used for the output file.
+  int mode = parameters->options().relocatable() ? 0666 : 0777;
+  int mask = ::umask(0);
+  ::umask(mask);
+  if (::fchmod(o, mode & ~mask) < 0)
+    gold_warning(_("%s: fchmod: %s"), &tmpbuf[0], strerror(errno));
+
+  temporary_output_name = &tmpbuf[0];
+  final_output_name = this->name_;
+#ifdef HAVE_SYNC_FILE_RANGE
+  this->start_writeback_ = true;
+#endif
+  this->o_ = o;
+  return true;
+}
+
+// Rename the temporary file for --rename-output-file over the output
+// file if the link succeeded, or remove it if it failed.
+
+bool
+Output_file::finish_temporary_output(bool success)
+{
+  if (temporary_output_name.empty())
+    return true;
+
+  std::string name;
+  name.swap(temporary_output_name);
+  if (success)
+    {
+      if (::rename(name.c_str(), final_output_name) == 0)
+	return true;
+      gold_error(_("%s: rename from %s: %s"), final_output_name,
+		 name.c_str(), strerror(errno));
+    }
+  ::unlink(name.c_str());
+  return !success;
+}
+
+// Return true if we have not written to the output file itself, so
+// that a failed link should not remove it.
+
+bool
+Output_file::output_file_untouched()
+{
+  return (parameters->options().rename_output_file()
+	  && !output_opened_in_place);
+}
+
+// Start writing out a range of the output file, which will not be
+// changed again in the normal course of things.  This is called by
+// the threads which complete the views, and only starts the I/O, so
+// that close has little left to wait for.  Small ranges are left to
+// be written along with their neighbours.
+
+void
+Output_file::start_writeback(off_t start, size_t size)
+{
+#ifdef HAVE_SYNC_FILE_RANGE
+  if (this->map_is_anonymous_ || size < 64 * 1024)
+    return;
+  ::sync_file_range(this->o_, start, size, SYNC_FILE_RANGE_WRITE);
+#else
+  (void) start;
+  (void) size;
+  gold_unreachable();
+#endif
+}
+
 // Resize the output file.
 
 void
@@ -5083,8 +5478,16 @@ Output_file::resize(off_t file_size)
 	    memset(static_cast<char*>(base) + this->file_size_, 0,
 		   file_size - this->file_size_);
 	}
+      off_t old_size = this->file_size_;
       this->base_ = static_cast<unsigned char*>(base);
       this->file_size_ = file_size;
+      this->advise_map(old_size);
+      if (this->pwrite_ && file_size > old_size)
+	{
+	  int err = gold_fallocate(this->o_, old_size, file_size - old_size);
+	  if (err != 0)
+	    gold_fatal(_("%s: %s"), this->name_, strerror(err));
+	}
     }
   else
     {
@@ -5113,9 +5516,115 @@ Output_file::map_anonymous()
     }
   this->base_ = static_cast<unsigned char*>(base);
   this->map_is_anonymous_ = true;
+  this->advise_map(0);
+  return true;
+}
+
+// Allocate an anonymous buffer for --pwrite-output-file.  The threads
+// which complete views write them from the buffer to the file, so
+// that the writing is spread over the link rather than done by close.
+// Return false if the output file can not be written that way.
+
+bool
+Output_file::map_for_pwrite()
+{
+  const int o = this->o_;
+  struct stat statbuf;
+  if (o == STDOUT_FILENO || o == STDERR_FILENO
+      || ::fstat(o, &statbuf) != 0
+      || !S_ISREG(statbuf.st_mode)
+      || this->is_temporary_)
+    return false;
+
+  // As in map_no_anonymous, make sure that we have the disk space.
+  int err = gold_fallocate(o, 0, this->file_size_);
+  if (err != 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(err));
+
+  if (!this->map_anonymous())
+    return false;
+  this->pending_lock_ = new Lock();
+  this->pwrite_ = true;
   return true;
 }
 
+// Queue the range of SIZE bytes at START, which a view has just been
+// written to, to be written to the file.  Each thread collects
+// adjacent ranges, and writes them when they cover a large aligned
+// chunk, or when the thread moves on to some other part of the file.
+// Bytes may be written more than once, perhaps including some which
+// some other thread is still changing; that is harmless, since the
+// thread which changes a byte always queues it afterward, and close
+// writes everything which is still queued.
+
+void
+Output_file::queue_write(off_t start, size_t size)
+{
+  const off_t end = start + static_cast<off_t>(size);
+  gold_assert(start >= 0 && end <= this->file_size_);
+
+#ifdef HAVE_TLS
+  static const off_t chunk_size = 1024 * 1024;
+
+  Pending_write* pw;
+  if (thread_pending_serial == this->serial_)
+    pw = thread_pending_write;
+  else
+    {
+      pw = new Pending_write();
+      {
+	Hold_lock hl(*this->pending_lock_);
+	this->pending_writes_.push_back(pw);
+      }
+      thread_pending_serial = this->serial_;
+      thread_pending_write = pw;
+    }
+
+  if (pw->start < pw->end && start >= pw->start && start <= pw->end)
+    pw->end = std::max(pw->end, end);
+  else
+    {
+      this->pwrite_range(pw->start, pw->end);
+      pw->start = start;
+      pw->end = end;
+    }
+
+  if (pw->end - pw->start >= chunk_size)
+    {
+      off_t chunk_end = pw->end & ~(chunk_size - 1);
+      this->pwrite_range(pw->start, chunk_end);
+      pw->start = chunk_end;
+    }
+#else
+  this->pwrite_range(start, end);
+#endif
+}
+
+// Write the bytes from START to END of the buffer to the file.
+
+void
+Output_file::pwrite_range(off_t start, off_t end)
+{
+  while (start < end)
+    {
+      ssize_t bytes_written = ::pwrite(this->o_, this->base_ + start,
+				       end - start, start);
+      if (bytes_written == 0)
+	{
+	  gold_error(_("%s: pwrite: unexpected 0 return-value"), this->name_);
+	  return;
+	}
+      else if (bytes_written < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  gold_error(_("%s: pwrite: %s"), this->name_, strerror(errno));
+	  return;
+	}
+      start += bytes_written;
+    }
+}
+
 // Map the file into memory.  Return whether the mapping succeeded.
 // If WRITABLE is true, map with write access.
 
@@ -5163,14 +5672,65 @@ Output_file::map_no_anonymous(bool writable)
 
   this->map_is_anonymous_ = false;
   this->base_ = static_cast<unsigned char*>(base);
+  if (writable)
+    this->advise_map(0);
   return true;
 }
 
+// Give the kernel hints about the memory at base_.  With
+// --output-huge-pages, ask for transparent huge pages; this must be
+// done before the memory is faulted in.  With --prefault-output-file,
+// fault in all the pages for writing now, which is much cheaper than
+// taking a page fault on the first write to each page.  Note that
+// MAP_POPULATE is no help here, as for a shared file mapping it only
+// maps the pages for reading.  The first START bytes of an anonymous
+// buffer may already have been written; this happens when resize
+// grows it.
+
+void
+Output_file::advise_map(off_t start)
+{
+#ifdef HAVE_MMAP
+  if (this->map_is_allocated_)
+    return;
+
+#ifdef MADV_HUGEPAGE
+  if (parameters->options().output_huge_pages())
+    ::madvise(this->base_, this->file_size_, MADV_HUGEPAGE);
+#endif
+
+  if (!parameters->options().prefault_output_file())
+    return;
+
+#ifdef MADV_POPULATE_WRITE
+  if (::madvise(this->base_, this->file_size_, MADV_POPULATE_WRITE) == 0)
+    return;
+#endif
+
+  // The kernel can't do it for us.  Anonymous memory we can simply
+  // touch, since anything past START is still zero.  For a file we
+  // can at least get the pages into the page cache.
+  if (this->map_is_anonymous_)
+    {
+      for (off_t off = start; off < this->file_size_; off += 4096)
+	this->base_[off] = 0;
+    }
+#ifdef MADV_WILLNEED
+  else
+    ::madvise(this->base_, this->file_size_, MADV_WILLNEED);
+#endif
+#endif // defined(HAVE_MMAP)
+}
+
 // Map the file into memory.
 
 void
 Output_file::map()
 {
+  if (parameters->options().pwrite_output_file()
+      && this->map_for_pwrite())
+    return;
+
   if (parameters->options().mmap_output_file()
       && this->map_no_anonymous(true))
     return;
@@ -5211,8 +5771,28 @@ Output_file::unmap()
 void
 Output_file::close()
 {
+  // Write whatever the threads left queued.  The threads are all
+  // done with the file by now.
+  if (this->pwrite_)
+    {
+      for (std::vector<Pending_write*>::iterator p =
+	     this->pending_writes_.begin();
+	   p != this->pending_writes_.end();
+	   ++p)
+	{
+	  this->pwrite_range((*p)->start, (*p)->end);
+	  delete *p;
+	}
+      this->pending_writes_.clear();
+      delete this->pending_lock_;
+      this->pending_lock_ = NULL;
+
+      // resize may have shrunk the file.
+      if (::ftruncate(this->o_, this->file_size_) < 0)
+	gold_error(_("%s: ftruncate: %s"), this->name_, strerror(errno));
+    }
   // If the map isn't file-backed, we need to write it now.
-  if (this->map_is_anonymous_ && !this->is_temporary_)
+  else if (this->map_is_anonymous_ && !this->is_temporary_)
     {
       size_t bytes_to_write = this->file_size_;
       size_t offset = 0;
@@ -5231,6 +5811,14 @@ Output_file::close()
             }
         }
     }
+
+#ifdef HAVE_SYNC_FILE_RANGE
+  // Start writing whatever start_writeback skipped, so that little
+  // is left for the kernel to flush when we rename the file.
+  if (this->start_writeback_ && !this->map_is_anonymous_)
+    ::sync_file_range(this->o_, 0, 0, SYNC_FILE_RANGE_WRITE);
+#endif
+
   this->unmap();
 
   // We don't close stdout or stderr
@@ -5240,6 +5828,8 @@ Output_file::close()
     if (::close(this->o_) < 0)
       gold_error(_("%s: close: %s"), this->name_, strerror(errno));
   this->o_ = -1;
+  this->start_writeback_ = false;
+  this->pwrite_ = false;
 }
 
 // Instantiate the templates we need.  We could use the configure
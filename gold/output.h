@@ -633,7 +633,8 @@ class Output_section_data : public Output_data
  public:
   Output_section_data(off_t data_size, uint64_t addralign,
 		      bool is_data_size_fixed)
-    : Output_data(), output_section_(NULL), addralign_(addralign)
+    : Output_data(), output_section_(NULL), addralign_(addralign),
+      input_section_handle_(0)
   {
     this->set_data_size(data_size);
     if (is_data_size_fixed)
@@ -641,7 +642,8 @@ class Output_section_data : public Output_data
   }
 
   Output_section_data(uint64_t addralign)
-    : Output_data(), output_section_(NULL), addralign_(addralign)
+    : Output_data(), output_section_(NULL), addralign_(addralign),
+      input_section_handle_(0)
   { }
 
   // Return the output section.
@@ -694,6 +696,17 @@ class Output_section_data : public Output_data
   print_merge_stats(const char* section_name)
   { this->do_print_merge_stats(section_name); }
 
+  // Return the handle used by Output_section::Input_section to refer
+  // to this data, or 0 if none has been assigned.
+  unsigned int
+  input_section_handle() const
+  { return this->input_section_handle_; }
+
+  // Set the handle used by Output_section::Input_section.
+  void
+  set_input_section_handle(unsigned int handle)
+  { this->input_section_handle_ = handle; }
+
  protected:
   // The child class must implement do_write.
 
@@ -759,6 +772,8 @@ class Output_section_data : public Output_data
   Output_section* output_section_;
   // The required alignment.
   uint64_t addralign_;
+  // Handle used by Output_section::Input_section, or 0.
+  unsigned int input_section_handle_;
 };
 
 // Some Output_section_data classes build up their data step by step,
@@ -2712,13 +2727,17 @@ class Output_symtab_xindex : public Output_section_data
  public:
   Output_symtab_xindex(size_t symcount)
     : Output_section_data(symcount * 4, 4, true),
-      entries_()
+      entries_(), lock_()
   { }
 
-  // Add an entry: symbol number SYMNDX has section SHNDX.
+  // Add an entry: symbol number SYMNDX has section SHNDX.  This may
+  // be called by several threads at once.
   void
   add(unsigned int symndx, unsigned int shndx)
-  { this->entries_.push_back(std::make_pair(symndx, shndx)); }
+  {
+    Hold_lock hl(this->lock_);
+    this->entries_.push_back(std::make_pair(symndx, shndx));
+  }
 
  protected:
   void
@@ -2741,6 +2760,8 @@ class Output_symtab_xindex : public Output_section_data
 
   // The entries we need.
   Xindex_entries entries_;
+  // Lock for entries_.
+  Lock lock_;
 };
 
 // A relaxed input section.
@@ -3058,6 +3079,73 @@ class Output_fill_debug_line : public Output_fill
   static const size_t header_length = 19;
 };
 
+// The tables behind the handles stored in Output_section::Input_section.
+// A handle is a small integer standing for a Relobj or an
+// Output_section_data; handle H refers to entry H - 1.  This also
+// records the sizes of input sections which do not fit in 32 bits.
+// There is one instance, owned by the Layout.  Entries are kept in
+// fixed-size chunks which are never moved, so looking up a handle
+// which has already been returned needs no lock.  Allocating a handle
+// and using the size table take the lock.
+
+class Input_section_handles
+{
+ public:
+  // Handles are 25 bits wide.
+  static const int HANDLE_BITS = 25;
+
+  // The largest handle which can be allocated.
+  static const unsigned int MAX_HANDLE = (1U << HANDLE_BITS) - 1;
+
+  Input_section_handles()
+    : objects_(), datas_(), large_data_sizes_(), lock_()
+  { }
+
+  // Return the handle for OBJECT, allocating one if necessary.
+  unsigned int
+  object_handle(Relobj* object);
+
+  // Return the handle for POSD, allocating one if necessary.
+  unsigned int
+  data_handle(Output_section_data* posd);
+
+  // Return the object for HANDLE.
+  Relobj*
+  object(unsigned int handle) const
+  { return this->objects_.get(handle); }
+
+  // Return the Output_section_data for HANDLE.
+  Output_section_data*
+  data(unsigned int handle) const
+  { return this->datas_.get(handle); }
+
+  // Record the size of section SHNDX in OBJECT, which does not fit in
+  // 32 bits.
+  void
+  set_large_data_size(const Relobj* object, unsigned int shndx,
+		      off_t data_size);
+
+  // Return the size recorded for section SHNDX in OBJECT.
+  off_t
+  large_data_size(const Relobj* object, unsigned int shndx);
+
+ private:
+  Input_section_handles(const Input_section_handles&);
+  Input_section_handles& operator=(const Input_section_handles&);
+
+  typedef Unordered_map<Const_section_id, off_t, Const_section_id_hash>
+    Large_data_sizes;
+
+  // The objects referred to by handles.
+  Handle_table<Relobj, HANDLE_BITS> objects_;
+  // The Output_section_data instances referred to by handles.
+  Handle_table<Output_section_data, HANDLE_BITS> datas_;
+  // Sizes of input sections which do not fit in 32 bits.
+  Large_data_sizes large_data_sizes_;
+  // Lock for adding entries and for large_data_sizes_.
+  Lock lock_;
+};
+
 // An output section.  We don't expect to have too many output
 // sections, so we don't bother to do a template on the size.
 
@@ -3409,6 +3497,13 @@ class Output_section : public Output_data
   set_after_input_sections()
   { this->after_input_sections_ = true; }
 
+  // Return the number of bytes which write will write out for this
+  // section: the size of the Output_section_data objects, which
+  // unlike input sections are not written by Relocate_task.  This is
+  // only valid after the section size is final.
+  off_t
+  output_section_data_size() const;
+
   // Return whether this section requires postprocessing after all
   // relocations have been applied.
   bool
@@ -3520,75 +3615,62 @@ class Output_section : public Output_data
   // input sections will be written out when we process the object
   // file, and as such we don't need to track them here.  We do need
   // to track Output_section_data objects here.  We store instances of
-  // this structure in a std::vector, so it must be a POD.  There can
-  // be many instances of this structure, so we use a union to save
-  // some space.
+  // this structure in a std::vector, so it must be a POD.  With
+  // -ffunction-sections there can be tens of millions of instances of
+  // this structure, so rather than pointers we store handles into the
+  // Input_section_handles tables, packed with the alignment.  The
+  // section order index is kept by the Output_section.  This keeps an
+  // instance to 12 bytes.
   class Input_section
   {
    public:
     Input_section()
-      : shndx_(0), p2align_(0)
-    {
-      this->u1_.data_size = 0;
-      this->u2_.object = NULL;
-    }
+      : shndx_(0), handle_(0), p2align_(0)
+    { this->u1_.data_size = 0; }
 
     // For an ordinary input section.
     Input_section(Relobj* object, unsigned int shndx, off_t data_size,
 		  uint64_t addralign)
-      : shndx_(shndx),
-	p2align_(ffsll(static_cast<long long>(addralign))),
-	section_order_index_(0)
+      : shndx_(shndx), handle_(object_handle(object)),
+	p2align_(ffsll(static_cast<long long>(addralign)))
     {
       gold_assert(shndx != OUTPUT_SECTION_CODE
 		  && shndx != MERGE_DATA_SECTION_CODE
 		  && shndx != MERGE_STRING_SECTION_CODE
 		  && shndx != RELAXED_INPUT_SECTION_CODE);
-      this->u1_.data_size = data_size;
-      this->u2_.object = object;
+      this->set_input_section_data_size(object, shndx, data_size);
     }
 
     // For a non-merge output section.
     Input_section(Output_section_data* posd)
-      : shndx_(OUTPUT_SECTION_CODE), p2align_(0),
-	section_order_index_(0)
-    {
-      this->u1_.data_size = 0;
-      this->u2_.posd = posd;
-    }
+      : shndx_(OUTPUT_SECTION_CODE), handle_(data_handle(posd)),
+	p2align_(0)
+    { this->u1_.data_size = 0; }
 
     // For a merge section.
     Input_section(Output_section_data* posd, bool is_string, uint64_t entsize)
       : shndx_(is_string
 	       ? MERGE_STRING_SECTION_CODE
 	       : MERGE_DATA_SECTION_CODE),
-	p2align_(0),
-	section_order_index_(0)
+	handle_(data_handle(posd)),
+	p2align_(0)
     {
+      gold_assert(entsize == static_cast<uint32_t>(entsize));
       this->u1_.entsize = entsize;
-      this->u2_.posd = posd;
     }
 
     // For a relaxed input section.
     Input_section(Output_relaxed_input_section* psection)
-      : shndx_(RELAXED_INPUT_SECTION_CODE), p2align_(0),
-	section_order_index_(0)
-    {
-      this->u1_.data_size = 0;
-      this->u2_.poris = psection;
-    }
+      : shndx_(RELAXED_INPUT_SECTION_CODE),
+	handle_(data_handle(psection)),
+	p2align_(0)
+    { this->u1_.data_size = 0; }
 
-    unsigned int
-    section_order_index() const
-    {
-      return this->section_order_index_;
-    }
-
-    void
-    set_section_order_index(unsigned int number)
-    {
-      this->section_order_index_ = number;
-    }
+    // Set the tables which handles refer to.  This is called by the
+    // Layout, which owns them.
+    static void
+    set_handles(Input_section_handles* handles)
+    { handles_ = handles; }
 
     // The required alignment.
     uint64_t
@@ -3597,7 +3679,7 @@ class Output_section : public Output_data
       if (this->p2align_ != 0)
 	return static_cast<uint64_t>(1) << (this->p2align_ - 1);
       else if (!this->is_input_section())
-	return this->u2_.posd->addralign();
+	return this->posd()->addralign();
       else
 	return 0;
     }
@@ -3682,33 +3764,23 @@ class Output_section : public Output_data
     output_section_data() const
     {
       gold_assert(!this->is_input_section());
-      return this->u2_.posd;
+      return this->posd();
     }
 
     // For a merge section, return the Output_merge_base pointer.
     Output_merge_base*
-    output_merge_base() const
-    {
-      gold_assert(this->is_merge_section());
-      return this->u2_.pomb;
-    }
+    output_merge_base() const;
 
     // Return the Output_relaxed_input_section object.
     Output_relaxed_input_section*
-    relaxed_input_section() const
-    {
-      gold_assert(this->is_relaxed_input_section());
-      return this->u2_.poris;
-    }
+    relaxed_input_section() const;
 
     // Set the output section.
     void
     set_output_section(Output_section* os)
     {
       gold_assert(!this->is_input_section());
-      Output_section_data* posd =
-	this->is_relaxed_input_section() ? this->u2_.poris : this->u2_.posd;
-      posd->set_output_section(os);
+      this->posd()->set_output_section(os);
     }
 
     // Set the address and file offset.  This is called during
@@ -3732,7 +3804,7 @@ class Output_section : public Output_data
     {
       gold_assert(this->shndx_ == MERGE_DATA_SECTION_CODE
 		  || this->shndx_ == MERGE_STRING_SECTION_CODE);
-      return this->u2_.posd->add_input_section(object, shndx);
+      return this->posd()->add_input_section(object, shndx);
     }
 
     // Given an input OBJECT, an input section index SHNDX within that
@@ -3771,7 +3843,7 @@ class Output_section : public Output_data
     {
       if (this->shndx_ == MERGE_DATA_SECTION_CODE
 	  || this->shndx_ == MERGE_STRING_SECTION_CODE)
-	this->u2_.posd->print_merge_stats(section_name);
+	this->posd()->print_merge_stats(section_name);
     }
 
    private:
@@ -3791,37 +3863,73 @@ class Output_section : public Output_data
       RELAXED_INPUT_SECTION_CODE = -4U
     };
 
+    // The value stored in u1_.data_size for an input section whose
+    // size does not fit in 32 bits.  The real size is recorded in
+    // the Input_section_handles.
+    static const uint32_t LARGE_DATA_SIZE = 0xffffffff;
+
+    // Return the handle for OBJECT, allocating one if necessary.
+    static unsigned int
+    object_handle(Relobj* object)
+    {
+      if (object == NULL)
+	return 0;
+      gold_assert(handles_ != NULL);
+      return handles_->object_handle(object);
+    }
+
+    // Return the handle for POSD, allocating one if necessary.
+    static unsigned int
+    data_handle(Output_section_data* posd)
+    {
+      gold_assert(handles_ != NULL);
+      return handles_->data_handle(posd);
+    }
+
+    // Record the size of an ordinary input section.
+    void
+    set_input_section_data_size(Relobj* object, unsigned int shndx,
+				off_t data_size);
+
+    // Return the object for an ordinary input section.
+    Relobj*
+    object() const
+    {
+      gold_assert(this->is_input_section());
+      return this->handle_ == 0 ? NULL : handles_->object(this->handle_);
+    }
+
+    // Return the data for an Output_section_data.
+    Output_section_data*
+    posd() const
+    {
+      gold_assert(!this->is_input_section());
+      return handles_->data(this->handle_);
+    }
+
+    // The tables which handles refer to.
+    static Input_section_handles* handles_;
+
     // For an ordinary input section, this is the section index in the
     // input file.  For an Output_section_data, this is
     // OUTPUT_SECTION_CODE or MERGE_DATA_SECTION_CODE or
-    // MERGE_STRING_SECTION_CODE.
+    // MERGE_STRING_SECTION_CODE or RELAXED_INPUT_SECTION_CODE.
     unsigned int shndx_;
+    // For an ordinary input section, the handle of the object which
+    // holds the input section.  Otherwise, the handle of the data.
+    unsigned int handle_ : 25;
     // The required alignment, stored as a power of 2.
-    unsigned int p2align_;
+    unsigned int p2align_ : 7;
     union
     {
-      // For an ordinary input section, the section size.
-      off_t data_size;
+      // For an ordinary input section, the section size, or
+      // LARGE_DATA_SIZE.
+      uint32_t data_size;
       // For OUTPUT_SECTION_CODE or RELAXED_INPUT_SECTION_CODE, this is not
       // used.  For MERGE_DATA_SECTION_CODE or MERGE_STRING_SECTION_CODE, the
       // entity size.
-      uint64_t entsize;
+      uint32_t entsize;
     } u1_;
-    union
-    {
-      // For an ordinary input section, the object which holds the
-      // input section.
-      Relobj* object;
-      // For OUTPUT_SECTION_CODE or MERGE_DATA_SECTION_CODE or
-      // MERGE_STRING_SECTION_CODE, the data.
-      Output_section_data* posd;
-      Output_merge_base* pomb;
-      // For RELAXED_INPUT_SECTION_CODE, the data.
-      Output_relaxed_input_section* poris;
-    } u2_;
-    // The line number of the pattern it matches in the --section-ordering-file
-    // file.  It is 0 if does not match any pattern.
-    unsigned int section_order_index_;
   };
 
   // Store the list of input sections for this Output_section into the
@@ -3889,6 +3997,10 @@ class Output_section : public Output_data
   void
   adjust_section_offsets();
 
+  // Print statistics about relaxation passes to stderr.
+  static void
+  print_relaxation_stats();
+
   // Whether this is a NOLOAD section.
   bool
   is_noload() const
@@ -4254,6 +4366,23 @@ class Output_section : public Output_data
   // Input_section_list is a vector.
   typedef Unordered_map<Section_id, size_t, Section_id_hash> Relaxation_map;
 
+  // Map from an input section to the line number of the pattern it
+  // matches in the --section-ordering-file, or to the order given by a
+  // plugin.  Only sections with a nonzero index are recorded.
+  typedef Unordered_map<Const_section_id, unsigned int,
+			Const_section_id_hash> Section_order_indexes;
+
+  // Return the section order index of input section IS, or 0 if it
+  // has none.
+  unsigned int
+  section_order_index(const Input_section& is) const;
+
+  // Record the section order index of the input section SHNDX in
+  // OBJECT.
+  void
+  set_section_order_index(const Relobj* object, unsigned int shndx,
+			  unsigned int number);
+
   // Add a new output section by Input_section.
   void
   add_output_section_data(Input_section*);
@@ -4297,6 +4426,21 @@ class Output_section : public Output_data
   void
   build_lookup_maps() const;
 
+  // Return whether the layout of the input sections from the previous
+  // relaxation pass can be used again, given the current file offset.
+  bool
+  can_reuse_relaxed_layout() const;
+
+  // Forget the layout of the input sections from the previous
+  // relaxation pass.  This is called when the input sections change.
+  void
+  invalidate_relaxed_layout()
+  { this->relaxed_layout_is_reusable_ = false; }
+
+  // Statistics about relaxation, for --stats.
+  static unsigned int relaxed_layouts_reused;
+  static unsigned int relaxed_layouts_redone;
+
   // Most of these fields are only valid after layout.
 
   // The name of the section.  This will point into a Stringpool.
@@ -4412,6 +4556,9 @@ class Output_section : public Output_data
   bool always_keeps_input_sections_ : 1;
   // Whether this section has a fixed layout, for incremental update links.
   bool has_fixed_layout_ : 1;
+  // True if the relaxed_layout_* fields below describe a layout of
+  // the input sections which is still valid.
+  bool relaxed_layout_is_reusable_ : 1;
   // True if we can add patch space to this section.
   bool is_patch_space_allowed_ : 1;
   // True if this output section goes into a unique segment.
@@ -4436,6 +4583,17 @@ class Output_section : public Output_data
   Output_fill* free_space_fill_;
   // Amount added as patch space for incremental linking.
   off_t patch_space_;
+  // When relaxing, the file offset, data size, offset of the first
+  // input section, number of input sections and largest input section
+  // alignment the last time the input sections were laid out.
+  off_t relaxed_layout_offset_;
+  off_t relaxed_layout_data_size_;
+  off_t relaxed_layout_first_input_offset_;
+  size_t relaxed_layout_count_;
+  uint64_t relaxed_layout_addralign_;
+  // The section order indexes of the input sections.  A relaxed input
+  // section keeps the index of the input section it replaces.
+  Section_order_indexes section_order_indexes_;
 };
 
 // An output segment.  PT_LOAD segments are built from collections of
@@ -4778,12 +4936,18 @@ class Output_file
   { return this->name_; }
 
   // We currently always use mmap which makes the view handling quite
-  // simple.  In the future we may support other approaches.
+  // simple.  With --pwrite-output-file the views are still in one
+  // buffer, but the ranges which are written are queued to be written
+  // to the file with pwrite.
 
   // Write data to the output file.
   void
   write(off_t offset, const void* data, size_t len)
-  { memcpy(this->base_ + offset, data, len); }
+  {
+    memcpy(this->base_ + offset, data, len);
+    if (this->pwrite_)
+      this->queue_write(offset, len);
+  }
 
   // Get a buffer to use to write to the file, given the offset into
   // the file and the size.
@@ -4798,8 +4962,13 @@ class Output_file
   // VIEW must have been returned by get_output_view.  Write the
   // buffer to the file, passing in the offset and the size.
   void
-  write_output_view(off_t, size_t, unsigned char*)
-  { }
+  write_output_view(off_t start, size_t size, unsigned char*)
+  {
+    if (this->pwrite_)
+      this->queue_write(start, size);
+    else if (this->start_writeback_)
+      this->start_writeback(start, size);
+  }
 
   // Get a read/write buffer.  This is used when we want to write part
   // of the file, read it in, and write it again.
@@ -4809,8 +4978,13 @@ class Output_file
 
   // Write a read/write buffer back to the file.
   void
-  write_input_output_view(off_t, size_t, unsigned char*)
-  { }
+  write_input_output_view(off_t start, size_t size, unsigned char*)
+  {
+    if (this->pwrite_)
+      this->queue_write(start, size);
+    else if (this->start_writeback_)
+      this->start_writeback(start, size);
+  }
 
   // Get a read buffer.  This is used when we just want to read part
   // of the file back it in.
@@ -4823,7 +4997,30 @@ class Output_file
   free_input_view(off_t, size_t, const unsigned char*)
   { }
 
+  // If the output file is being written under a temporary name for
+  // --rename-output-file, rename it over the output file if SUCCESS,
+  // or remove it otherwise.  This is called when gold exits.  Return
+  // false if the rename failed.
+  static bool
+  finish_temporary_output(bool success);
+
+  // Return true if the output file itself has not been opened for
+  // writing, so that a failed link should leave it alone.  This is
+  // only the case with --rename-output-file.
+  static bool
+  output_file_untouched();
+
  private:
+  // Open a temporary file in the same directory as the output file,
+  // for --rename-output-file.  Return false if we should write the
+  // output file directly instead.
+  bool
+  open_temporary_output();
+
+  // Ask the kernel to start writing the data in the range to disk.
+  void
+  start_writeback(off_t start, size_t size);
+
   // Map the file into memory or, if that fails, allocate anonymous
   // memory.
   void
@@ -4833,10 +5030,40 @@ class Output_file
   bool
   map_anonymous();
 
+  // Allocate anonymous memory for --pwrite-output-file.
+  bool
+  map_for_pwrite();
+
+  // The range of the buffer which a thread has completed but not yet
+  // written to the file, for --pwrite-output-file.
+  struct Pending_write
+  {
+    Pending_write()
+      : start(0), end(0)
+    { }
+
+    off_t start;
+    off_t end;
+  };
+
+  // Queue the range of SIZE bytes at START to be written to the file.
+  void
+  queue_write(off_t start, size_t size);
+
+  // Write the bytes from START to END of the buffer to the file.
+  void
+  pwrite_range(off_t start, off_t end);
+
   // Map the file into memory.
   bool
   map_no_anonymous(bool);
 
+  // Give the kernel hints about how we will use the memory at base_,
+  // and fault it in for --prefault-output-file.  START is the number
+  // of bytes which have already been written.
+  void
+  advise_map(off_t start);
+
   // Unmap the file from memory (and flush to disk buffers).
   void
   unmap();
@@ -4855,6 +5082,27 @@ class Output_file
   bool map_is_allocated_;
   // True if this is a temporary file which should not be output.
   bool is_temporary_;
+  // True if we should start writing output views to disk as soon as
+  // they are complete.
+  bool start_writeback_;
+  // True if the threads write the buffer at base_ to the file with
+  // pwrite as they complete views, for --pwrite-output-file.
+  bool pwrite_;
+  // A number which identifies this file to queue_write.
+  unsigned int serial_;
+  // The serial number to give the next file.
+  static unsigned int next_serial;
+  // The writes which the threads have queued, one per thread.  These
+  // are written by close.
+  std::vector<Pending_write*> pending_writes_;
+  // Lock for pending_writes_.
+  Lock* pending_lock_;
+#ifdef HAVE_TLS
+  // The serial number of the file which thread_pending_write is for.
+  static __thread unsigned int thread_pending_serial;
+  // The writes queued by this thread.
+  static __thread Pending_write* thread_pending_write;
+#endif
 };
 
 } // End namespace gold.
@@ -72,6 +72,7 @@ dlerror(void)
 #include "readsyms.h"
 #include "symtab.h"
 #include "descriptors.h"
+#include "gold-threads.h"
 #include "elfcpp.h"
 
 namespace gold
@@ -87,6 +88,9 @@ extern "C"
 static enum ld_plugin_status
 register_claim_file(ld_plugin_claim_file_handler handler);
 
+static enum ld_plugin_status
+register_claim_file_thread_safe(ld_plugin_claim_file_handler handler);
+
 static enum ld_plugin_status
 register_all_symbols_read(ld_plugin_all_symbols_read_handler handler);
 
@@ -199,7 +203,7 @@ Plugin::load()
   sscanf(ver, "%d.%d", &major, &minor);
 
   // Allocate and populate a transfer vector.
-  const int tv_fixed_size = 26;
+  const int tv_fixed_size = 27;
 
   int tv_size = this->args_.size() + tv_fixed_size;
   ld_plugin_tv* tv = new ld_plugin_tv[tv_size];
@@ -321,6 +325,11 @@ Plugin::load()
   tv[i].tv_tag = LDPT_UNIQUE_SEGMENT_FOR_SECTIONS;
   tv[i].tv_u.tv_unique_segment_for_sections = unique_segment_for_sections;
 
+  ++i;
+  tv[i].tv_tag = LDPT_REGISTER_CLAIM_FILE_HOOK_THREAD_SAFE;
+  tv[i].tv_u.tv_register_claim_file_thread_safe
+    = register_claim_file_thread_safe;
+
   ++i;
   tv[i].tv_tag = LDPT_NULL;
   tv[i].tv_u.tv_val = 0;
@@ -427,6 +436,8 @@ Plugin_manager::~Plugin_manager()
        ++obj)
     delete *obj;
   this->objects_.clear();
+  delete this->lock_;
+  delete this->claim_lock_;
 }
 
 // Load all plugin libraries.
@@ -435,6 +446,11 @@ void
 Plugin_manager::load_plugins(Layout* layout)
 {
   this->layout_ = layout;
+  if (parameters->options().threads())
+    {
+      this->lock_ = new Lock();
+      this->claim_lock_ = new Lock();
+    }
   for (this->current_ = this->plugins_.begin();
        this->current_ != this->plugins_.end();
        ++this->current_)
@@ -450,39 +466,90 @@ Plugin_manager::claim_file(Input_file* input_file, off_t offset,
   if (this->in_replacement_phase_)
     return NULL;
 
-  unsigned int handle = this->objects_.size();
-  this->input_file_ = input_file;
-  this->plugin_input_file_.name = input_file->filename().c_str();
-  this->plugin_input_file_.fd = input_file->file().descriptor();
-  this->plugin_input_file_.offset = offset;
-  this->plugin_input_file_.filesize = filesize;
-  this->plugin_input_file_.handle = reinterpret_cast<void*>(handle);
-  if (elf_object != NULL)
+  // This may be called from several Read_symbols tasks at once, so
+  // reserve a handle for the file even if it is not an ELF object.
+  Pending_claim claim;
+  unsigned int handle;
+  {
+    Hold_optional_lock hl(this->lock_);
+    handle = this->objects_.size();
     this->objects_.push_back(elf_object);
-  this->in_claim_file_handler_ = true;
+    this->pending_claims_[handle] = &claim;
+  }
 
-  for (this->current_ = this->plugins_.begin();
-       this->current_ != this->plugins_.end();
-       ++this->current_)
+  claim.input_file = input_file;
+  claim.plugin_input_file.name = input_file->filename().c_str();
+  claim.plugin_input_file.fd = input_file->file().descriptor();
+  claim.plugin_input_file.offset = offset;
+  claim.plugin_input_file.filesize = filesize;
+  claim.plugin_input_file.handle = reinterpret_cast<void*>(handle);
+
+  Pluginobj* obj = NULL;
+  for (Plugin_list::iterator p = this->plugins_.begin();
+       p != this->plugins_.end();
+       ++p)
     {
-      if ((*this->current_)->claim_file(&this->plugin_input_file_))
-        {
-	  this->any_claimed_ = true;
-	  this->in_claim_file_handler_ = false;
+      bool claimed;
+      if ((*p)->claim_file_thread_safe())
+	claimed = (*p)->claim_file(&claim.plugin_input_file);
+      else
+	{
+	  Hold_optional_lock hl(this->claim_lock_);
+	  claimed = (*p)->claim_file(&claim.plugin_input_file);
+	}
 
-          if (this->objects_.size() > handle
-              && this->objects_[handle]->pluginobj() != NULL)
-            return this->objects_[handle]->pluginobj();
+      if (claimed)
+        {
+	  Object* o = this->object(handle);
+	  if (o != NULL)
+	    obj = o->pluginobj();
 
           // If the plugin claimed the file but did not call the
           // add_symbols callback, we need to create the Pluginobj now.
-          Pluginobj* obj = this->make_plugin_object(handle);
-          return obj;
+	  if (obj == NULL)
+	    obj = this->make_plugin_object(handle);
+	  break;
         }
     }
 
-  this->in_claim_file_handler_ = false;
-  return NULL;
+  Hold_optional_lock hl(this->lock_);
+  this->pending_claims_.erase(handle);
+  if (obj != NULL)
+    this->any_claimed_ = true;
+  return obj;
+}
+
+// Return whether the file with handle HANDLE is being offered to the
+// plugins.
+
+bool
+Plugin_manager::in_claim_file_handler(const void* handle)
+{
+  return this->pending_claim(
+      static_cast<unsigned int>(reinterpret_cast<intptr_t>(handle))) != NULL;
+}
+
+// Return the pending claim for HANDLE.
+
+const Plugin_manager::Pending_claim*
+Plugin_manager::pending_claim(unsigned int handle) const
+{
+  Hold_optional_lock hl(this->lock_);
+  Pending_claim_map::const_iterator p = this->pending_claims_.find(handle);
+  if (p == this->pending_claims_.end())
+    return NULL;
+  return p->second;
+}
+
+// Return the object associated with HANDLE.
+
+Object*
+Plugin_manager::object(unsigned int handle) const
+{
+  Hold_optional_lock hl(this->lock_);
+  if (handle >= this->objects_.size())
+    return NULL;
+  return this->objects_[handle];
 }
 
 // Save an archive.  This is used so that a plugin can add a file
@@ -718,22 +785,26 @@ Plugin_manager::cleanup()
 Pluginobj*
 Plugin_manager::make_plugin_object(unsigned int handle)
 {
-  // Make sure we aren't asked to make an object for the same handle twice.
-  if (this->objects_.size() != handle
-      && this->objects_[handle]->pluginobj() != NULL)
+  // We can only make an object for a file which is being claimed.
+  const Pending_claim* claim = this->pending_claim(handle);
+  if (claim == NULL)
     return NULL;
 
-  Pluginobj* obj = make_sized_plugin_object(this->input_file_,
-                                            this->plugin_input_file_.offset,
-                                            this->plugin_input_file_.filesize);
+  Hold_optional_lock hl(this->lock_);
 
+  // Make sure we aren't asked to make an object for the same handle twice.
+  if (this->objects_[handle] != NULL
+      && this->objects_[handle]->pluginobj() != NULL)
+    return NULL;
 
-  // If the elf object for this file was pushed into the objects_ vector, delete
-  // it to make room for the Pluginobj as this file is claimed.
-  if (this->objects_.size() != handle)
-    this->objects_.pop_back();
+  Pluginobj* obj = make_sized_plugin_object(claim->input_file,
+                                            claim->plugin_input_file.offset,
+                                            claim->plugin_input_file.filesize);
 
-  this->objects_.push_back(obj);
+  // If the elf object for this file was stored in the objects_
+  // vector, replace it with the Pluginobj as this file is claimed.
+  // The caller of claim_file deletes the elf object.
+  this->objects_[handle] = obj;
   return obj;
 }
 
@@ -744,6 +815,9 @@ ld_plugin_status
 Plugin_manager::get_input_file(unsigned int handle,
                                struct ld_plugin_input_file* file)
 {
+  if (this->object(handle) == NULL)
+    return LDPS_BAD_HANDLE;
+
   Pluginobj* obj = this->object(handle)->pluginobj();
   if (obj == NULL)
     return LDPS_BAD_HANDLE;
@@ -797,13 +871,14 @@ Plugin_manager::get_view(unsigned int handle, const void **viewp)
   off_t offset;
   size_t filesize;
   Input_file *input_file;
-  if (this->in_claim_file_handler_)
+  const Pending_claim* claim = this->pending_claim(handle);
+  if (claim != NULL)
     {
       // We are being called from the claim_file hook.
-      const struct ld_plugin_input_file &f = this->plugin_input_file_;
+      const struct ld_plugin_input_file &f = claim->plugin_input_file;
       offset = f.offset;
       filesize = f.filesize;
-      input_file = this->input_file_;
+      input_file = claim->input_file;
     }
   else
     {
@@ -851,6 +926,10 @@ Plugin_manager::add_input_file(const char* pathname, bool is_lib)
   if (parameters->incremental())
     gold_error(_("input files added by plug-ins in --incremental mode not "
 		 "supported yet"));
+  // Queue the file for reading right away, rather than waiting for
+  // the all-symbols-read handler to return.  When using threads, the
+  // file is read and laid out while the plugin is still producing the
+  // files that follow it; the blockers keep the files in order.
   this->workqueue_->queue_soon(new Read_symbols(this->input_objects_,
                                                 this->symtab_,
                                                 this->layout_,
@@ -1432,7 +1511,17 @@ static enum ld_plugin_status
 register_claim_file(ld_plugin_claim_file_handler handler)
 {
   gold_assert(parameters->options().has_plugins());
-  parameters->options().plugins()->set_claim_file_handler(handler);
+  parameters->options().plugins()->set_claim_file_handler(handler, false);
+  return LDPS_OK;
+}
+
+// Register a claim-file handler which may be called concurrently.
+
+static enum ld_plugin_status
+register_claim_file_thread_safe(ld_plugin_claim_file_handler handler)
+{
+  gold_assert(parameters->options().has_plugins());
+  parameters->options().plugins()->set_claim_file_handler(handler, true);
   return LDPS_OK;
 }
 
@@ -1600,7 +1689,7 @@ get_input_section_count(const void* handle, unsigned int* count)
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(handle))
     return LDPS_ERR;
 
   Object* obj = parameters->options().plugins()->get_elf_object(handle);
@@ -1622,7 +1711,7 @@ get_input_section_type(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1645,7 +1734,7 @@ get_input_section_name(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1674,7 +1763,7 @@ get_input_section_contents(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(section.handle))
     return LDPS_ERR;
 
   Object* obj
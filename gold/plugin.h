@@ -45,6 +45,7 @@ class Dirsearch;
 class Mapfile;
 class Task;
 class Task_token;
+class Lock;
 class Pluginobj;
 class Plugin_rescan;
 
@@ -58,6 +59,7 @@ class Plugin
       filename_(filename),
       args_(),
       claim_file_handler_(NULL),
+      claim_file_thread_safe_(false),
       all_symbols_read_handler_(NULL),
       cleanup_handler_(NULL),
       cleanup_done_(false)
@@ -82,10 +84,20 @@ class Plugin
   void
   cleanup();
 
-  // Register a claim-file handler.
+  // Register a claim-file handler.  THREAD_SAFE is true if the
+  // handler may be called for several files at once.
   void
-  set_claim_file_handler(ld_plugin_claim_file_handler handler)
-  { this->claim_file_handler_ = handler; }
+  set_claim_file_handler(ld_plugin_claim_file_handler handler,
+			 bool thread_safe)
+  {
+    this->claim_file_handler_ = handler;
+    this->claim_file_thread_safe_ = thread_safe;
+  }
+
+  // Whether the claim-file handler may be called concurrently.
+  bool
+  claim_file_thread_safe() const
+  { return this->claim_file_thread_safe_; }
 
   // Register an all-symbols-read handler.
   void
@@ -116,6 +128,9 @@ class Plugin
   std::vector<std::string> args_;
   // The plugin's event handlers.
   ld_plugin_claim_file_handler claim_file_handler_;
+  // Whether the plugin registered its claim-file handler as
+  // thread-safe.
+  bool claim_file_thread_safe_;
   ld_plugin_all_symbols_read_handler all_symbols_read_handler_;
   ld_plugin_cleanup_handler cleanup_handler_;
   // TRUE if the cleanup handlers have been called.
@@ -128,10 +143,9 @@ class Plugin_manager
 {
  public:
   Plugin_manager(const General_options& options)
-    : plugins_(), objects_(), deferred_layout_objects_(), input_file_(NULL),
-      plugin_input_file_(), rescannable_(), undefined_symbols_(),
+    : plugins_(), objects_(), deferred_layout_objects_(), pending_claims_(),
+      lock_(NULL), claim_lock_(NULL), rescannable_(), undefined_symbols_(),
       any_claimed_(false), in_replacement_phase_(false), any_added_(false),
-      in_claim_file_handler_(false),
       options_(options), workqueue_(NULL), task_(NULL), input_objects_(NULL),
       symtab_(NULL), layout_(NULL), dirpath_(NULL), mapfile_(NULL),
       this_blocker_(NULL), extra_search_path_()
@@ -166,10 +180,10 @@ class Plugin_manager
   Object*
   get_elf_object(const void* handle);
 
-  // True if the claim_file handler of the plugins is being called.
+  // True if the claim_file handlers of the plugins are being called
+  // for the file with handle HANDLE.
   bool
-  in_claim_file_handler()
-  { return in_claim_file_handler_; }
+  in_claim_file_handler(const void* handle);
 
   // Let the plugin manager save an archive for later rescanning.
   // This takes ownership of the Archive pointer.
@@ -201,12 +215,14 @@ class Plugin_manager
   void
   cleanup();
 
-  // Register a claim-file handler.
+  // Register a claim-file handler.  THREAD_SAFE is true if the
+  // plugin allows the handler to be called for several files at once.
   void
-  set_claim_file_handler(ld_plugin_claim_file_handler handler)
+  set_claim_file_handler(ld_plugin_claim_file_handler handler,
+			 bool thread_safe)
   {
     gold_assert(this->current_ != plugins_.end());
-    (*this->current_)->set_claim_file_handler(handler);
+    (*this->current_)->set_claim_file_handler(handler, thread_safe);
   }
 
   // Register an all-symbols-read handler.
@@ -232,12 +248,7 @@ class Plugin_manager
 
   // Return the object associated with the given HANDLE.
   Object*
-  object(unsigned int handle) const
-  {
-    if (handle >= this->objects_.size())
-      return NULL;
-    return this->objects_[handle];
-  }
+  object(unsigned int handle) const;
 
   // Return TRUE if any input files have been claimed by a plugin
   // and we are still in the initial input phase.
@@ -318,6 +329,22 @@ class Plugin_manager
   typedef std::vector<Rescannable> Rescannable_list;
   typedef std::vector<Symbol*> Undefined_symbol_list;
 
+  // A file which is currently being offered to the plugins.
+  struct Pending_claim
+  {
+    // The file.
+    Input_file* input_file;
+    // The description of the file that we pass to the plugins.
+    struct ld_plugin_input_file plugin_input_file;
+  };
+
+  typedef Unordered_map<unsigned int, const Pending_claim*> Pending_claim_map;
+
+  // Return the pending claim for HANDLE, or NULL if the file with
+  // that handle is not being offered to the plugins.
+  const Pending_claim*
+  pending_claim(unsigned int handle) const;
+
   // Rescan archives for undefined symbols.
   void
   rescan(Task*);
@@ -338,9 +365,17 @@ class Plugin_manager
   // The list of regular objects whose layout has been deferred.
   Deferred_layout_list deferred_layout_objects_;
 
-  // The file currently up for claim by the plugins.
-  Input_file* input_file_;
-  struct ld_plugin_input_file plugin_input_file_;
+  // The files currently up for claim by the plugins, indexed by
+  // handle.  Several files may be offered at once when reading input
+  // files in parallel.
+  Pending_claim_map pending_claims_;
+
+  // Lock for objects_ and pending_claims_ when using threads.
+  Lock* lock_;
+
+  // Lock used to serialize calls to claim-file handlers which were
+  // not registered as thread-safe.
+  Lock* claim_lock_;
 
   // A list of archives and input groups being saved for possible
   // later rescanning.
@@ -360,9 +395,6 @@ class Plugin_manager
   // Whether any input files or libraries were added by a plugin.
   bool any_added_;
 
-  // Set to true when the claim_file handler of a plugin is called.
-  bool in_claim_file_handler_;
-
   const General_options& options_;
   Workqueue* workqueue_;
   Task* task_;
@@ -500,7 +500,8 @@ class Target_powerpc : public Sized_target<size, big_endian>
   { return !parameters->options().relocatable(); }
 
   bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*);
 
   void
   do_plt_fde_location(const Output_data*, unsigned char*,
@@ -1107,19 +1108,60 @@ class Target_powerpc : public Sized_target<size, big_endian>
 		unsigned int r_sym,
 		Address addend)
       : object_(ppc_object), shndx_(data_shndx), offset_(r_offset),
-	r_type_(r_type), r_sym_(r_sym), addend_(addend)
+	r_type_(r_type), r_sym_(r_sym), addend_(addend), gsym_(NULL),
+	kind_(BRANCH_UNKNOWN), to_(0), range_(RANGE_UNCHECKED)
     { }
 
     ~Branch_info()
     { }
 
+    // Work out whether this branch may need a plt call stub or a long
+    // branch stub.  That does not depend on the layout, so it is done
+    // once, in the first relaxation pass.  Return false if the branch
+    // can never need a stub.
+    bool
+    classify(Symbol_table*);
+
+    // If this branch may need a long branch stub, work out whether its
+    // destination is in range.  This only reads the layout, so it may
+    // run in parallel with the same check for other branches.  If
+    // IN_TASK, a destination which can only be found by looking up a
+    // merge section or relaxed input section is left unchecked, since
+    // those lookups build their maps on demand.
+    void
+    check_range(Symbol_table*, bool in_task);
+
     // If this branch needs a plt call stub, or a long branch stub, make one.
     void
     make_stub(Stub_table<size, big_endian>*,
 	      Stub_table<size, big_endian>*,
-	      Symbol_table*) const;
+	      Symbol_table*);
 
    private:
+    // The kinds of stub a branch may need.
+    enum Branch_kind
+    {
+      // Not classified yet.
+      BRANCH_UNKNOWN,
+      // A plt call stub.
+      BRANCH_PLT_CALL,
+      // A long branch stub, if the destination is out of range.
+      BRANCH_LONG,
+      // No stub.
+      BRANCH_NONE
+    };
+
+    // The result of check_range.
+    enum Branch_range
+    {
+      // Not checked yet.
+      RANGE_UNCHECKED,
+      // The destination is in range, or has no value.
+      RANGE_OK,
+      // The destination, TO_, is out of range.
+      RANGE_STUB
+    };
+
     // The branch location..
     Powerpc_relobj<size, big_endian>* object_;
     unsigned int shndx_;
@@ -1128,6 +1170,100 @@ class Target_powerpc : public Sized_target<size, big_endian>
     unsigned int r_type_;
     unsigned int r_sym_;
     Address addend_;
+    // The global symbol of the destination, with any forwarding
+    // resolved, or NULL.  Set by classify.
+    const Sized_symbol<size>* gsym_;
+    // The kind of stub this branch may need.
+    Branch_kind kind_;
+    // The destination address and the result of check_range, for a
+    // branch which may need a long branch stub.
+    Address to_;
+    Branch_range range_;
+  };
+
+  typedef std::vector<Branch_info> Branches;
+
+  // Check the ranges of the branches which may need long branch stubs.
+  // The relaxation pass checks groups of branches until none are left,
+  // and may queue Branch_range_tasks to help it.  The pass then waits
+  // only for the groups which the helpers have already started, so it
+  // does not matter whether the helpers run before it finishes.  This
+  // is deleted when the pass and all the helpers are done with it.
+
+  class Branch_range_check
+  {
+   public:
+    Branch_range_check(Branches* branches, Symbol_table* symtab,
+		       unsigned int helpers)
+      : branches_(branches), count_(branches->size()), symtab_(symtab),
+	lock_(), condvar_(this->lock_), next_(0), active_(0),
+	refs_(helpers + 1)
+    { }
+
+    // Check groups of branches until there are none left.
+    void
+    run();
+
+    // Wait for the groups which other threads are checking.
+    void
+    wait();
+
+    // Drop a reference, and delete this if it was the last one.
+    void
+    release();
+
+    // The number of branches checked at a time.
+    static const size_t group_size = 4096;
+
+   private:
+    Branches* branches_;
+    // The number of branches, which does not change during the pass.
+    size_t count_;
+    Symbol_table* symtab_;
+    // Protects the fields below.
+    Lock lock_;
+    // Signalled when ACTIVE_ drops to zero.
+    Condvar condvar_;
+    // The index of the first branch which has not been claimed.
+    size_t next_;
+    // The number of groups being checked.
+    unsigned int active_;
+    // The number of references to this.
+    unsigned int refs_;
+  };
+
+  // A task which helps to check branch ranges.
+
+  class Branch_range_task : public Task
+  {
+   public:
+    Branch_range_task(Branch_range_check* check)
+      : check_(check)
+    { }
+
+    // The standard Task methods.
+
+    Task_token*
+    is_runnable()
+    { return NULL; }
+
+    void
+    locks(Task_locker*)
+    { }
+
+    void
+    run(Workqueue*)
+    {
+      this->check_->run();
+      this->check_->release();
+    }
+
+    std::string
+    get_name() const
+    { return "Target_powerpc::Branch_range_task"; }
+
+   private:
+    Branch_range_check* check_;
   };
 
   // Information about this specific target which we pass to the
@@ -1190,7 +1326,6 @@ class Target_powerpc : public Sized_target<size, big_endian>
   typedef Unordered_map<Address, unsigned int> Branch_lookup_table;
   Branch_lookup_table branch_lookup_table_;
 
-  typedef std::vector<Branch_info> Branches;
   Branches branch_info_;
 
   bool plt_thread_safe_;
@@ -2354,22 +2489,185 @@ Target_powerpc<size, big_endian>::group_sections(Layout* layout,
     }
 }
 
-// If this branch needs a plt call stub, or a long branch stub, make one.
+// Work out which kind of stub, if any, this branch may need.
 
 template<int size, bool big_endian>
-void
-Target_powerpc<size, big_endian>::Branch_info::make_stub(
-    Stub_table<size, big_endian>* stub_table,
-    Stub_table<size, big_endian>* ifunc_stub_table,
-    Symbol_table* symtab) const
+bool
+Target_powerpc<size, big_endian>::Branch_info::classify(Symbol_table* symtab)
 {
   Symbol* sym = this->object_->global_symbol(this->r_sym_);
   if (sym != NULL && sym->is_forwarder())
     sym = symtab->resolve_forwards(sym);
   const Sized_symbol<size>* gsym = static_cast<const Sized_symbol<size>*>(sym);
+  this->gsym_ = gsym;
   if (gsym != NULL
       ? use_plt_offset<size>(gsym, Scan::get_reference_flags(this->r_type_))
       : this->object_->local_has_plt_offset(this->r_sym_))
+    {
+      this->kind_ = BRANCH_PLT_CALL;
+      return true;
+    }
+
+  this->kind_ = BRANCH_NONE;
+  if (this->r_type_ != elfcpp::R_POWERPC_REL14
+      && this->r_type_ != elfcpp::R_POWERPC_REL14_BRTAKEN
+      && this->r_type_ != elfcpp::R_POWERPC_REL14_BRNTAKEN
+      && this->r_type_ != elfcpp::R_POWERPC_REL24
+      && this->r_type_ != elfcpp::R_PPC_PLTREL24
+      && this->r_type_ != elfcpp::R_PPC_LOCAL24PC)
+    return false;
+  if (gsym != NULL)
+    {
+      switch (gsym->source())
+	{
+	case Symbol::FROM_OBJECT:
+	  {
+	    Object* symobj = gsym->object();
+	    if (symobj->is_dynamic()
+		|| symobj->pluginobj() != NULL)
+	      return false;
+	    bool is_ordinary;
+	    unsigned int shndx = gsym->shndx(&is_ordinary);
+	    if (shndx == elfcpp::SHN_UNDEF)
+	      return false;
+	  }
+	  break;
+
+	case Symbol::IS_UNDEFINED:
+	  return false;
+
+	default:
+	  break;
+	}
+    }
+  this->kind_ = BRANCH_LONG;
+  return true;
+}
+
+// Return whether the output address of section SHNDX of OBJECT, or of
+// the section it was folded into, is known without looking up a merge
+// section or relaxed input section.
+
+static bool
+branch_dest_section_is_simple(const Symbol_table* symtab, Relobj* object,
+			      unsigned int shndx)
+{
+  if (shndx >= object->shnum())
+    return false;
+  if (symtab->is_section_folded(object, shndx))
+    {
+      Section_id folded = symtab->icf()->get_folded_section(object, shndx);
+      object = static_cast<Relobj*>(folded.first);
+      shndx = folded.second;
+    }
+  return (object->output_section(shndx) == NULL
+	  || object->output_section_offset(shndx) != -1ULL);
+}
+
+// Work out whether a branch which may need a long branch stub can
+// reach its destination.
+
+template<int size, bool big_endian>
+void
+Target_powerpc<size, big_endian>::Branch_info::check_range(
+    Symbol_table* symtab,
+    bool in_task)
+{
+  this->range_ = RANGE_UNCHECKED;
+  if (this->kind_ != BRANCH_LONG)
+    return;
+
+  const Sized_symbol<size>* gsym = this->gsym_;
+  if (in_task)
+    {
+      bool is_ordinary;
+      unsigned int shndx;
+      Relobj* dest_object;
+      if (gsym != NULL)
+	{
+	  shndx = gsym->shndx(&is_ordinary);
+	  dest_object = (gsym->source() == Symbol::FROM_OBJECT
+			 ? static_cast<Relobj*>(gsym->object())
+			 : NULL);
+	}
+      else
+	{
+	  shndx = this->object_->local_symbol(this->r_sym_)->input_shndx(
+	      &is_ordinary);
+	  dest_object = this->object_;
+	}
+      if (dest_object != NULL
+	  && is_ordinary
+	  && !branch_dest_section_is_simple(symtab, dest_object, shndx))
+	return;
+    }
+
+  unsigned int max_branch_offset;
+  if (this->r_type_ == elfcpp::R_POWERPC_REL14
+      || this->r_type_ == elfcpp::R_POWERPC_REL14_BRTAKEN
+      || this->r_type_ == elfcpp::R_POWERPC_REL14_BRNTAKEN)
+    max_branch_offset = 1 << 15;
+  else
+    max_branch_offset = 1 << 25;
+  Address from = this->object_->get_output_section_offset(this->shndx_);
+  gold_assert(from != invalid_address);
+  from += (this->object_->output_section(this->shndx_)->address()
+	   + this->offset_);
+  Address to;
+  this->range_ = RANGE_OK;
+  if (gsym != NULL)
+    {
+      Symbol_table::Compute_final_value_status status;
+      to = symtab->compute_final_value<size>(gsym, &status);
+      if (status != Symbol_table::CFVS_OK)
+	return;
+    }
+  else
+    {
+      const Symbol_value<size>* psymval
+	= this->object_->local_symbol(this->r_sym_);
+      Symbol_value<size> symval;
+      typedef Sized_relobj_file<size, big_endian> ObjType;
+      typename ObjType::Compute_final_local_value_status status
+	= this->object_->compute_final_local_value(this->r_sym_, psymval,
+						   &symval, symtab);
+      if (status != ObjType::CFLV_OK
+	  || !symval.has_output_value())
+	return;
+      to = symval.value(this->object_, 0);
+    }
+  to += this->addend_;
+  if (size == 64 && is_branch_reloc(this->r_type_))
+    {
+      unsigned int dest_shndx;
+      Target_powerpc<size, big_endian>* target =
+	static_cast<Target_powerpc<size, big_endian>*>(
+	    parameters->sized_target<size, big_endian>());
+      to = target->symval_for_branch(symtab, to, gsym,
+				     this->object_, &dest_shndx);
+    }
+  Address delta = to - from;
+  if (delta + max_branch_offset >= 2 * max_branch_offset)
+    {
+      this->to_ = to;
+      this->range_ = RANGE_STUB;
+    }
+}
+
+// If this branch needs a plt call stub, or a long branch stub, make one.
+// For a long branch stub, this uses the result of check_range, and
+// does the check itself if it was left undone.
+
+template<int size, bool big_endian>
+void
+Target_powerpc<size, big_endian>::Branch_info::make_stub(
+    Stub_table<size, big_endian>* stub_table,
+    Stub_table<size, big_endian>* ifunc_stub_table,
+    Symbol_table* symtab)
+{
+  gold_assert(this->kind_ != BRANCH_UNKNOWN);
+  const Sized_symbol<size>* gsym = this->gsym_;
+  if (this->kind_ == BRANCH_PLT_CALL)
     {
       if (stub_table == NULL)
 	stub_table = this->object_->stub_table(this->shndx_);
@@ -2386,102 +2684,96 @@ Target_powerpc<size, big_endian>::Branch_info::make_stub(
 	stub_table->add_plt_call_entry(this->object_, this->r_sym_,
 				       this->r_type_, this->addend_);
     }
-  else
+  else if (this->kind_ == BRANCH_LONG)
     {
-      unsigned int max_branch_offset;
-      if (this->r_type_ == elfcpp::R_POWERPC_REL14
-	  || this->r_type_ == elfcpp::R_POWERPC_REL14_BRTAKEN
-	  || this->r_type_ == elfcpp::R_POWERPC_REL14_BRNTAKEN)
-	max_branch_offset = 1 << 15;
-      else if (this->r_type_ == elfcpp::R_POWERPC_REL24
-	       || this->r_type_ == elfcpp::R_PPC_PLTREL24
-	       || this->r_type_ == elfcpp::R_PPC_LOCAL24PC)
-	max_branch_offset = 1 << 25;
-      else
+      if (this->range_ == RANGE_UNCHECKED)
+	this->check_range(symtab, false);
+      if (this->range_ != RANGE_STUB)
 	return;
-      Address from = this->object_->get_output_section_offset(this->shndx_);
-      gold_assert(from != invalid_address);
-      from += (this->object_->output_section(this->shndx_)->address()
-	       + this->offset_);
-      Address to;
-      if (gsym != NULL)
-	{
-	  switch (gsym->source())
-	    {
-	    case Symbol::FROM_OBJECT:
-	      {
-		Object* symobj = gsym->object();
-		if (symobj->is_dynamic()
-		    || symobj->pluginobj() != NULL)
-		  return;
-		bool is_ordinary;
-		unsigned int shndx = gsym->shndx(&is_ordinary);
-		if (shndx == elfcpp::SHN_UNDEF)
-		  return;
-	      }
-	      break;
-
-	    case Symbol::IS_UNDEFINED:
-	      return;
-
-	    default:
-	      break;
-	    }
-	  Symbol_table::Compute_final_value_status status;
-	  to = symtab->compute_final_value<size>(gsym, &status);
-	  if (status != Symbol_table::CFVS_OK)
-	    return;
-	}
-      else
-	{
-	  const Symbol_value<size>* psymval
-	    = this->object_->local_symbol(this->r_sym_);
-	  Symbol_value<size> symval;
-	  typedef Sized_relobj_file<size, big_endian> ObjType;
-	  typename ObjType::Compute_final_local_value_status status
-	    = this->object_->compute_final_local_value(this->r_sym_, psymval,
-						       &symval, symtab);
-	  if (status != ObjType::CFLV_OK
-	      || !symval.has_output_value())
-	    return;
-	  to = symval.value(this->object_, 0);
-	}
-      to += this->addend_;
       if (stub_table == NULL)
 	stub_table = this->object_->stub_table(this->shndx_);
-      if (size == 64 && is_branch_reloc(this->r_type_))
-	{
-	  unsigned int dest_shndx;
-	  Target_powerpc<size, big_endian>* target =
-	    static_cast<Target_powerpc<size, big_endian>*>(
-		parameters->sized_target<size, big_endian>());
-	  to = target->symval_for_branch(symtab, to, gsym,
-					 this->object_, &dest_shndx);
-	}
-      Address delta = to - from;
-      if (delta + max_branch_offset >= 2 * max_branch_offset)
+      if (stub_table == NULL)
 	{
-	  if (stub_table == NULL)
-	    {
-	      gold_warning(_("%s:%s: branch in non-executable section,"
-			     " no long branch stub for you"),
-			   this->object_->name().c_str(),
-			   this->object_->section_name(this->shndx_).c_str());
-	      return;
-	    }
-	  stub_table->add_long_branch_entry(this->object_, to);
+	  gold_warning(_("%s:%s: branch in non-executable section,"
+			 " no long branch stub for you"),
+		       this->object_->name().c_str(),
+		       this->object_->section_name(this->shndx_).c_str());
+	  return;
 	}
+      stub_table->add_long_branch_entry(this->object_, this->to_);
+    }
+}
+
+// Check groups of branch ranges until none are left.
+
+template<int size, bool big_endian>
+void
+Target_powerpc<size, big_endian>::Branch_range_check::run()
+{
+  const size_t group = group_size;
+  while (true)
+    {
+      size_t start;
+      {
+	Hold_lock hl(this->lock_);
+	if (this->next_ >= this->count_)
+	  break;
+	start = this->next_;
+	this->next_ += group;
+	++this->active_;
+      }
+
+      size_t end = std::min(start + group, this->count_);
+      for (size_t i = start; i < end; ++i)
+	(*this->branches_)[i].check_range(this->symtab_, true);
+
+      {
+	Hold_lock hl(this->lock_);
+	--this->active_;
+	if (this->active_ == 0)
+	  this->condvar_.broadcast();
+      }
     }
 }
 
+// Wait for the groups which other threads are checking.  This is only
+// called after run, when no more groups will be started.
+
+template<int size, bool big_endian>
+void
+Target_powerpc<size, big_endian>::Branch_range_check::wait()
+{
+  Hold_lock hl(this->lock_);
+  while (this->active_ != 0)
+    this->condvar_.wait();
+}
+
+// Drop a reference.
+
+template<int size, bool big_endian>
+void
+Target_powerpc<size, big_endian>::Branch_range_check::release()
+{
+  bool last;
+  {
+    Hold_lock hl(this->lock_);
+    gold_assert(this->refs_ > 0);
+    --this->refs_;
+    last = this->refs_ == 0;
+  }
+  if (last)
+    delete this;
+}
+
 // Relaxation hook.  This is where we do stub generation.
 
 template<int size, bool big_endian>
 bool
 Target_powerpc<size, big_endian>::do_relax(int pass,
-					   const Input_objects*,
+					   const Input_objects* input_objects,
 					   Symbol_table* symtab,
 					   Layout* layout,
+					   Workqueue* workqueue,
 					   const Task* task)
 {
   unsigned int prev_brlt_size = 0;
@@ -2528,6 +2820,16 @@ Target_powerpc<size, big_endian>::do_relax(int pass,
 	}
       this->plt_thread_safe_ = thread_safe;
       this->group_sections(layout, task);
+
+      // Work out which branches may need stubs.  That does not change
+      // from one pass to the next, so only keep those branches.
+      typename Branches::iterator to = this->branch_info_.begin();
+      for (typename Branches::iterator b = this->branch_info_.begin();
+	   b != this->branch_info_.end();
+	   ++b)
+	if (b->classify(symtab))
+	  *to++ = *b;
+      this->branch_info_.erase(to, this->branch_info_.end());
     }
 
   // We need address of stub tables valid for make_stub.
@@ -2556,12 +2858,34 @@ Target_powerpc<size, big_endian>::do_relax(int pass,
 	}
     }
 
-  // Build all the stubs.
+  // Check which branches are out of range.  This only reads the
+  // layout, so when there are enough branches other threads help.
+  size_t group_count = ((this->branch_info_.size()
+			 + Branch_range_check::group_size - 1)
+			/ Branch_range_check::group_size);
+  unsigned int helpers = 0;
+  if (parameters->options().threads() && group_count > 1)
+    {
+      int thread_count = parameters->options().thread_count_middle();
+      if (thread_count == 0)
+	thread_count = std::max(2, input_objects->number_of_input_objects());
+      helpers = std::min(group_count, static_cast<size_t>(thread_count)) - 1;
+    }
+  Branch_range_check* check
+    = new Branch_range_check(&this->branch_info_, symtab, helpers);
+  for (unsigned int i = 0; i < helpers; ++i)
+    workqueue->queue_soon(new Branch_range_task(check));
+  check->run();
+  check->wait();
+  check->release();
+
+  // Build all the stubs, in the order of the branches, so that the
+  // stub tables do not depend on which thread checked which branch.
   Stub_table<size, big_endian>* ifunc_stub_table
     = this->stub_tables_.size() == 0 ? NULL : this->stub_tables_[0];
   Stub_table<size, big_endian>* one_stub_table
     = this->stub_tables_.size() != 1 ? NULL : ifunc_stub_table;
-  for (typename Branches::const_iterator b = this->branch_info_.begin();
+  for (typename Branches::iterator b = this->branch_info_.begin();
        b != this->branch_info_.end();
        b++)
     {
@@ -4095,6 +4419,7 @@ Stub_table<size, big_endian>::do_write(Output_file* of)
 	    }
 	}
     }
+  of->write_output_view(off, oview_size, oview);
 }
 
 // Write out .glink.
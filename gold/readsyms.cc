@@ -23,6 +23,8 @@
 #include "gold.h"
 
 #include <cstring>
+#include <algorithm>
+#include <limits>
 
 #include "elfcpp.h"
 #include "options.h"
@@ -35,6 +37,8 @@
 #include "plugin.h"
 #include "layout.h"
 #include "incremental.h"
+#include "gold-threads.h"
+#include "fileread.h"
 
 namespace gold
 {
@@ -167,6 +171,8 @@ Read_symbols::run(Workqueue* workqueue)
   if (!this->do_read_symbols(workqueue) && this->member_ == NULL)
     workqueue->queue_soon(new Unblock_token(this->this_blocker_,
 					    this->next_blocker_));
+
+  Prefetch_inputs::queue_more(workqueue);
 }
 
 // Handle a whole lib group. Other than collecting statistics, this just
@@ -556,6 +562,100 @@ Read_symbols::get_name() const
     }
 }
 
+// Class Prefetch_inputs.
+
+// A lock for the Prefetch_inputs static variables.
+static Lock* prefetch_inputs_lock = NULL;
+static Initialize_lock prefetch_inputs_initialize_lock(&prefetch_inputs_lock);
+
+// The input files to prefetch, in command line order.
+static std::vector<std::string> prefetch_inputs_files;
+
+// The index of the next file to prefetch.
+static size_t prefetch_inputs_next;
+
+// Whether the last task stopped because it reached the limit.
+static bool prefetch_inputs_stopped;
+
+// Add the names of the plain input files in the range [P, PEND) to
+// FILES.  Libraries found via -l are skipped, as we don't know which
+// file will be used until the search path is examined.
+
+template<typename Iterator>
+static void
+add_prefetch_files(Iterator p, Iterator pend, std::vector<std::string>* files)
+{
+  for (; p != pend; ++p)
+    {
+      if (p->is_group())
+	add_prefetch_files(p->group()->begin(), p->group()->end(), files);
+      else if (p->is_lib())
+	add_prefetch_files(p->lib()->begin(), p->lib()->end(), files);
+      else if (!p->file().is_lib() && !p->file().is_searched_file())
+	files->push_back(p->file().name());
+    }
+}
+
+void
+Prefetch_inputs::queue_initial(Workqueue* workqueue,
+			       const Command_line& cmdline)
+{
+  prefetch_inputs_initialize_lock.initialize();
+  add_prefetch_files(cmdline.begin(), cmdline.end(), &prefetch_inputs_files);
+  if (!prefetch_inputs_files.empty())
+    workqueue->queue(new Prefetch_inputs());
+}
+
+void
+Prefetch_inputs::queue_more(Workqueue* workqueue)
+{
+  if (!parameters->options().prefetch_inputs())
+    return;
+
+  // An incremental update reads its input files without calling
+  // queue_initial, so the lock may not have been created yet.
+  prefetch_inputs_initialize_lock.initialize();
+  Hold_lock hl(*prefetch_inputs_lock);
+  if (!prefetch_inputs_stopped)
+    return;
+  uint64_t limit = parameters->options().prefetch_inputs_limit();
+  if (static_cast<uint64_t>(Input_prefetch::outstanding_bytes()) > limit / 2)
+    return;
+  prefetch_inputs_stopped = false;
+  workqueue->queue_soon(new Prefetch_inputs());
+}
+
+// Prefetch files until we run out or reach the limit.
+
+void
+Prefetch_inputs::run(Workqueue*)
+{
+  uint64_t limit = parameters->options().prefetch_inputs_limit();
+  while (true)
+    {
+      std::string name;
+      off_t budget;
+      {
+	Hold_lock hl(*prefetch_inputs_lock);
+	if (prefetch_inputs_next >= prefetch_inputs_files.size())
+	  return;
+	off_t outstanding = Input_prefetch::outstanding_bytes();
+	if (static_cast<uint64_t>(outstanding) >= limit)
+	  {
+	    prefetch_inputs_stopped = true;
+	    return;
+	  }
+	name = prefetch_inputs_files[prefetch_inputs_next];
+	++prefetch_inputs_next;
+	uint64_t left = limit - outstanding;
+	const uint64_t max_budget = std::numeric_limits<off_t>::max();
+	budget = static_cast<off_t>(std::min(left, max_budget));
+      }
+
+      Input_prefetch::prefetch(name, budget);
+    }
+}
+
 // Class Add_symbols.
 
 Add_symbols::~Add_symbols()
@@ -841,20 +941,38 @@ Finish_group::locks(Task_locker* tl)
 void
 Finish_group::run(Workqueue*)
 {
+  // The first time through, each archive looks at all of its
+  // symbols.  After that, the only objects added to the link are the
+  // ones we include from the archives of the group, so each archive
+  // only looks at the symbols mentioned by the objects included since
+  // it was last searched.  This finds the same members in the same
+  // order as searching every archive completely each time.
+  std::vector<Object*> included;
+  std::vector<size_t> searched;
+  bool search_all = true;
   size_t saw_undefined = this->saw_undefined_;
   while (saw_undefined != this->symtab_->saw_undefined())
     {
       saw_undefined = this->symtab_->saw_undefined();
 
+      size_t i = 0;
       for (Input_group::const_iterator p = this->input_group_->begin();
 	   p != this->input_group_->end();
-	   ++p)
+	   ++p, ++i)
 	{
 	  Task_lock_obj<Archive> tl(this, *p);
 
-	  (*p)->add_symbols(this->symtab_, this->layout_,
-			    this->input_objects_, this->mapfile_);
+	  size_t start = search_all ? 0 : searched[i];
+	  (*p)->add_group_symbols(this->symtab_, this->layout_,
+				  this->input_objects_, this->mapfile_,
+				  search_all, &included, start);
+	  if (search_all)
+	    searched.push_back(included.size());
+	  else
+	    searched[i] = included.size();
 	}
+
+      search_all = false;
     }
 
   // Now that we're done with the archives, record the incremental
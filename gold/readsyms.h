@@ -32,6 +32,7 @@
 namespace gold
 {
 
+class Command_line;
 class Input_objects;
 class Symbol_table;
 class Input_group;
@@ -126,6 +127,49 @@ class Read_symbols : public Task
   Task_token* next_blocker_;
 };
 
+// This Task is used for --prefetch-inputs.  It asks the kernel to
+// start reading the headers and symbol tables of the input files
+// named on the command line, in order, so that the data is in memory
+// by the time the Read_symbols tasks get to them.  It stops once
+// --prefetch-inputs-limit bytes have been prefetched but not yet
+// opened; Read_symbols queues a new one when enough of those files
+// have been opened.  Without --threads this task runs ahead of the
+// Read_symbols tasks on the same thread, so it then only gives the
+// kernel hints and never waits for a read.
+
+class Prefetch_inputs : public Task
+{
+ public:
+  Prefetch_inputs()
+  { }
+
+  // Queue the first task for the input files in CMDLINE.
+  static void
+  queue_initial(Workqueue*, const Command_line&);
+
+  // Queue another task if the last one stopped at the limit and
+  // enough of the files have since been opened.
+  static void
+  queue_more(Workqueue*);
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable()
+  { return NULL; }
+
+  void
+  locks(Task_locker*)
+  { }
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Prefetch_inputs"; }
+};
+
 // This Task handles adding the symbols to the symbol table.  These
 // tasks must be run in the same order as the arguments appear on the
 // command line.
@@ -59,6 +59,8 @@ Read_relocs::locks(Task_locker* tl)
   Task_token* token = this->object_->token();
   if (token != NULL)
     tl->add(this, token);
+  if (this->prescan_blocker_ != NULL)
+    tl->add(this, this->prescan_blocker_);
 }
 
 // Read the relocations and then start a Scan_relocs_task.
@@ -69,6 +71,8 @@ Read_relocs::run(Workqueue* workqueue)
   Read_relocs_data* rd = new Read_relocs_data;
   this->object_->read_relocs(rd);
   this->object_->set_relocs_data(rd);
+  if (this->prescan_blocker_ != NULL)
+    this->object_->prescan_relocs(this->symtab_, this->layout_, rd);
   this->object_->release();
 
   // If garbage collection or identical comdat folding is desired, we  
@@ -236,11 +240,13 @@ Relocate_task::locks(Task_locker* tl)
 void
 Relocate_task::run(Workqueue*)
 {
-  this->object_->relocate(this->symtab_, this->layout_, this->of_);
+  this->object_->relocate_range(this->symtab_, this->layout_, this->of_,
+				this->start_, this->end_, this->is_last_);
 
   // This is normally the last thing we will do with an object, so
   // uncache all views.
-  this->object_->clear_view_cache_marks();
+  if (this->is_last_)
+    this->object_->clear_view_cache_marks();
 
   this->object_->release();
 }
@@ -418,6 +424,47 @@ Sized_relobj_file<size, big_endian>::do_gc_process_relocs(Symbol_table* symtab,
 }
 
 
+// Prescan the relocs.  This runs for several objects at once, after
+// the symbols have been resolved and before any relocs are scanned.
+// For each allocated section, the target copies the relocs which may
+// require a GOT or PLT entry or a dynamic reloc, or which otherwise
+// change the symbol table, so that do_scan_relocs, which runs for one
+// object at a time, only has to look at those.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_prescan_relocs(Symbol_table* symtab,
+						       Layout*,
+						       Read_relocs_data* rd)
+{
+  Sized_target<size, big_endian>* target =
+    parameters->sized_target<size, big_endian>();
+
+  const unsigned char* local_symbols;
+  if (rd->local_symbols == NULL)
+    local_symbols = NULL;
+  else
+    local_symbols = rd->local_symbols->data();
+
+  for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
+       p != rd->relocs.end();
+       ++p)
+    {
+      // Relocs in a section whose offsets are not mapped as usual
+      // may have to be dropped, which is decided by the output
+      // section; leave those for do_scan_relocs.
+      if (!p->is_data_section_allocated || p->needs_special_offset_handling)
+	continue;
+      p->deferred = new std::vector<unsigned char>();
+      p->deferred_count = target->prescan_relocs(symtab, this, p->data_shndx,
+						 p->sh_type,
+						 p->contents->data(),
+						 p->reloc_count,
+						 this->local_symbol_count_,
+						 local_symbols, p->deferred);
+    }
+}
+
 // Scan the relocs and adjust the symbol table.  This looks for
 // relocations which require GOT/PLT/COPY relocations.
 
@@ -457,8 +504,22 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 	{
 	  // As noted above, when not generating an object file, we
 	  // only scan allocated sections.  We may see a non-allocated
-	  // section here if we are emitting relocs.
-	  if (p->is_data_section_allocated)
+	  // section here if we are emitting relocs.  If the relocs
+	  // were prescanned, we only need to scan the ones which were
+	  // deferred.
+	  if (p->deferred != NULL)
+	    {
+	      if (p->deferred_count > 0)
+		target->scan_relocs(symtab, layout, this, p->data_shndx,
+				    p->sh_type, &(*p->deferred)[0],
+				    p->deferred_count, p->output_section,
+				    p->needs_special_offset_handling,
+				    this->local_symbol_count_,
+				    local_symbols);
+	      delete p->deferred;
+	      p->deferred = NULL;
+	    }
+	  else if (p->is_data_section_allocated)
 	    target->scan_relocs(symtab, layout, this, p->data_shndx,
 				p->sh_type, p->contents->data(),
 				p->reloc_count, p->output_section,
@@ -644,6 +705,22 @@ void
 Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
 						 const Layout* layout,
 						 Output_file* of)
+{
+  this->do_relocate_range(symtab, layout, of, 0, -1, true);
+}
+
+// Relocate the input sections in the output file range [START, END),
+// and write out the local symbols if WRITE_LOCAL_SYMBOLS.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::do_relocate_range(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    off_t start,
+    off_t end,
+    bool write_local_symbols)
 {
   unsigned int shnum = this->shnum();
 
@@ -659,7 +736,7 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
   // section data to the output file.  The second one applies
   // relocations.
 
-  this->write_sections(layout, pshdrs, of, &views);
+  this->write_sections(layout, pshdrs, of, start, end, &views);
 
   // To speed up relocations, we set up hash tables for fast lookup of
   // input offsets to output addresses.
@@ -694,9 +771,11 @@ Sized_relobj_file<size, big_endian>::do_relocate(const Symbol_table* symtab,
     }
 
   // Write out the local symbols.
-  this->write_local_symbols(of, layout->sympool(), layout->dynpool(),
-			    layout->symtab_xindex(), layout->dynsym_xindex(),
-			    layout->symtab_section_offset());
+  if (write_local_symbols)
+    this->write_local_symbols(of, layout->sympool(), layout->dynpool(),
+			      layout->symtab_xindex(),
+			      layout->dynsym_xindex(),
+			      layout->symtab_section_offset());
 }
 
 // Sort a Read_multiple vector by file offset.
@@ -708,15 +787,17 @@ struct Read_multiple_compare
   { return rme1.file_offset < rme2.file_offset; }
 };
 
-// Write section data to the output file.  PSHDRS points to the
-// section headers.  Record the views in *PVIEWS for use when
-// relocating.
+// Write section data to the output file for the sections in the
+// output file range [START, END).  PSHDRS points to the section
+// headers.  Record the views in *PVIEWS for use when relocating.
 
 template<int size, bool big_endian>
 void
 Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
 						    const unsigned char* pshdrs,
 						    Output_file* of,
+						    off_t start,
+						    off_t end,
 						    Views* pviews)
 {
   unsigned int shnum = this->shnum();
@@ -732,6 +813,7 @@ Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
       View_size* pvs = &(*pviews)[i];
 
       pvs->view = NULL;
+      pvs->is_in_other_range = false;
 
       const Output_section* os = out_sections[i];
       if (os == NULL)
@@ -769,6 +851,12 @@ Sized_relobj_file<size, big_endian>::write_sections(const Layout* layout,
 	  continue;
 	}
 
+      if (!this->is_in_relocate_range(i, start, end))
+	{
+	  pvs->is_in_other_range = true;
+	  continue;
+	}
+
       // In the normal case, this input section is simply mapped to
       // the output section at offset OUTPUT_OFFSET.
 
@@ -950,6 +1038,11 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
 	}
       Address output_offset = out_offsets[index];
 
+      // The section may be relocated by a different call to
+      // relocate_range.
+      if ((*pviews)[index].is_in_other_range)
+	continue;
+
       gold_assert((*pviews)[index].view != NULL);
       if (parameters->options().relocatable())
 	gold_assert((*pviews)[i].view != NULL);
@@ -1155,7 +1248,8 @@ Sized_relobj_file<size, big_endian>::incremental_relocs_write_reltype(
       elfcpp::Swap<32, big_endian>::writeval(pov + 4, out_shndx);
       elfcpp::Swap<size, big_endian>::writeval(pov + 8, offset);
       elfcpp::Swap<size, big_endian>::writeval(pov + 8 + sizeof_addr, addend);
-      of->write_output_view(pov - view, incr_reloc_size, view);
+      of->write_output_view(relocs_off + (pov - view), incr_reloc_size,
+			    pov);
     }
 }
 
@@ -1666,6 +1760,14 @@ Sized_relobj_file<32, false>::do_scan_relocs(Symbol_table* symtab,
 					     Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+void
+Sized_relobj_file<32, false>::do_prescan_relocs(Symbol_table* symtab,
+						Layout* layout,
+						Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_32_BIG
 template
 void
@@ -1674,6 +1776,14 @@ Sized_relobj_file<32, true>::do_scan_relocs(Symbol_table* symtab,
 					    Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_32_BIG
+template
+void
+Sized_relobj_file<32, true>::do_prescan_relocs(Symbol_table* symtab,
+					       Layout* layout,
+					       Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_64_LITTLE
 template
 void
@@ -1682,6 +1792,14 @@ Sized_relobj_file<64, false>::do_scan_relocs(Symbol_table* symtab,
 					     Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_64_LITTLE
+template
+void
+Sized_relobj_file<64, false>::do_prescan_relocs(Symbol_table* symtab,
+						Layout* layout,
+						Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_64_BIG
 template
 void
@@ -1690,6 +1808,14 @@ Sized_relobj_file<64, true>::do_scan_relocs(Symbol_table* symtab,
 					    Read_relocs_data* rd);
 #endif
 
+#ifdef HAVE_TARGET_64_BIG
+template
+void
+Sized_relobj_file<64, true>::do_prescan_relocs(Symbol_table* symtab,
+					       Layout* layout,
+					       Read_relocs_data* rd);
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 void
@@ -1698,6 +1824,18 @@ Sized_relobj_file<32, false>::do_relocate(const Symbol_table* symtab,
 					  Output_file* of);
 #endif
 
+#ifdef HAVE_TARGET_32_LITTLE
+template
+void
+Sized_relobj_file<32, false>::do_relocate_range(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    off_t start,
+    off_t end,
+    bool write_local_symbols);
+#endif
+
 #ifdef HAVE_TARGET_32_BIG
 template
 void
@@ -1706,6 +1844,18 @@ Sized_relobj_file<32, true>::do_relocate(const Symbol_table* symtab,
 					 Output_file* of);
 #endif
 
+#ifdef HAVE_TARGET_32_BIG
+template
+void
+Sized_relobj_file<32, true>::do_relocate_range(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    off_t start,
+    off_t end,
+    bool write_local_symbols);
+#endif
+
 #ifdef HAVE_TARGET_64_LITTLE
 template
 void
@@ -1714,6 +1864,18 @@ Sized_relobj_file<64, false>::do_relocate(const Symbol_table* symtab,
 					  Output_file* of);
 #endif
 
+#ifdef HAVE_TARGET_64_LITTLE
+template
+void
+Sized_relobj_file<64, false>::do_relocate_range(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    off_t start,
+    off_t end,
+    bool write_local_symbols);
+#endif
+
 #ifdef HAVE_TARGET_64_BIG
 template
 void
@@ -1722,6 +1884,18 @@ Sized_relobj_file<64, true>::do_relocate(const Symbol_table* symtab,
 					 Output_file* of);
 #endif
 
+#ifdef HAVE_TARGET_64_BIG
+template
+void
+Sized_relobj_file<64, true>::do_relocate_range(
+    const Symbol_table* symtab,
+    const Layout* layout,
+    Output_file* of,
+    off_t start,
+    off_t end,
+    bool write_local_symbols);
+#endif
+
 #ifdef HAVE_TARGET_32_LITTLE
 template
 void
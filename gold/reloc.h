@@ -65,11 +65,15 @@ class Read_relocs : public Task
  public:
   //   THIS_BLOCKER and NEXT_BLOCKER are passed along to a Scan_relocs
   // or Gc_process_relocs task, so that they run in a deterministic
-  // order.
+  // order.  If PRESCAN_BLOCKER is not NULL, we also prescan the
+  // relocs, and unblock PRESCAN_BLOCKER when done; the first
+  // Scan_relocs task must wait for it.
   Read_relocs(Symbol_table* symtab, Layout* layout, Relobj* object,
-	      Task_token* this_blocker, Task_token* next_blocker)
+	      Task_token* this_blocker, Task_token* next_blocker,
+	      Task_token* prescan_blocker)
     : symtab_(symtab), layout_(layout), object_(object),
-      this_blocker_(this_blocker), next_blocker_(next_blocker)
+      this_blocker_(this_blocker), next_blocker_(next_blocker),
+      prescan_blocker_(prescan_blocker)
   { }
 
   // The standard Task methods.
@@ -92,6 +96,7 @@ class Read_relocs : public Task
   Relobj* object_;
   Task_token* this_blocker_;
   Task_token* next_blocker_;
+  Task_token* prescan_blocker_;
 };
 
 // Process the relocs to figure out which sections are garbage.
@@ -176,16 +181,21 @@ class Scan_relocs : public Task
   Task_token* next_blocker_;
 };
 
-// A class to perform all the relocations for an object file.
+// A class to perform the relocations for an object file.  Normally
+// one task does all of them.  When relocation is split up by output
+// address, each task does only the input sections in the output file
+// range [START, END), and the task with IS_LAST set also writes out
+// the local symbols.
 
 class Relocate_task : public Task
 {
  public:
   Relocate_task(const Symbol_table* symtab, const Layout* layout,
-		Relobj* object, Output_file* of,
-		Task_token* input_sections_blocker,
+		Relobj* object, Output_file* of, off_t start, off_t end,
+		bool is_last, Task_token* input_sections_blocker,
 		Task_token* output_sections_blocker, Task_token* final_blocker)
     : symtab_(symtab), layout_(layout), object_(object), of_(of),
+      start_(start), end_(end), is_last_(is_last),
       input_sections_blocker_(input_sections_blocker),
       output_sections_blocker_(output_sections_blocker),
       final_blocker_(final_blocker)
@@ -210,6 +220,9 @@ class Relocate_task : public Task
   const Layout* layout_;
   Relobj* object_;
   Output_file* of_;
+  off_t start_;
+  off_t end_;
+  bool is_last_;
   Task_token* input_sections_blocker_;
   Task_token* output_sections_blocker_;
   Task_token* final_blocker_;
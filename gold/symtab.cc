@@ -45,8 +45,145 @@
 namespace gold
 {
 
+#ifdef ENABLE_SYMBOL_HANDLES
+
+// Class Symbol_handles.
+
+Symbol_handles::Symbol_handles()
+  : objects_(), output_datas_(), output_segments_(), versions_(),
+    got_entries_(), output_data_handles_(), output_segment_handles_(),
+    version_handles_(), lock_()
+{
+}
+
+Symbol_handles::~Symbol_handles()
+{
+  for (unsigned int i = 1; i <= this->got_entries_.size(); ++i)
+    delete this->got_entries_.get(i);
+}
+
+// Allocate a handle for OBJECT.
+
+unsigned int
+Symbol_handles::new_object_handle(Object* object)
+{
+  Hold_lock hl(this->lock_);
+  unsigned int handle = object->symbol_handle();
+  if (handle == 0)
+    {
+      if (this->objects_.full())
+	gold_fatal(_("too many input objects with symbols (the limit is %u)"),
+		   this->objects_.MAX_HANDLE);
+      handle = this->objects_.add(object);
+      object->set_symbol_handle(handle);
+    }
+  return handle;
+}
+
+// Return the handle for OD, allocating one the first time we see it.
+
+unsigned int
+Symbol_handles::output_data_handle(Output_data* od)
+{
+  if (od == NULL)
+    return 0;
+  Hold_lock hl(this->lock_);
+  std::pair<Output_data_handles::iterator, bool> ins =
+    this->output_data_handles_.insert(std::make_pair(od, 0U));
+  if (ins.second)
+    {
+      if (this->output_datas_.full())
+	gold_fatal(_("too many output sections with symbols "
+		     "(the limit is %u)"),
+		   this->output_datas_.MAX_HANDLE);
+      ins.first->second = this->output_datas_.add(od);
+    }
+  return ins.first->second;
+}
+
+// Return the handle for OS, allocating one the first time we see it.
+
+unsigned int
+Symbol_handles::output_segment_handle(Output_segment* os)
+{
+  if (os == NULL)
+    return 0;
+  Hold_lock hl(this->lock_);
+  std::pair<Output_segment_handles::iterator, bool> ins =
+    this->output_segment_handles_.insert(std::make_pair(os, 0U));
+  if (ins.second)
+    {
+      if (this->output_segments_.full())
+	gold_fatal(_("too many output segments with symbols "
+		     "(the limit is %u)"),
+		   this->output_segments_.MAX_HANDLE);
+      ins.first->second = this->output_segments_.add(os);
+    }
+  return ins.first->second;
+}
+
+// Return the handle for VERSION, allocating one the first time we
+// see it.  Versions are canonical strings in the symbol table's
+// Stringpool, so we can compare pointers.
+
+unsigned int
+Symbol_handles::new_version_handle(const char* version)
+{
+  Hold_lock hl(this->lock_);
+  std::pair<Version_handles::iterator, bool> ins =
+    this->version_handles_.insert(std::make_pair(version, 0U));
+  if (ins.second)
+    {
+      if (this->versions_.full())
+	gold_fatal(_("too many symbol versions (the limit is %u)"),
+		   this->versions_.MAX_HANDLE);
+      ins.first->second = this->versions_.add(version);
+    }
+  return ins.first->second;
+}
+
+// Allocate a new entry for a GOT offset list.
+
+unsigned int
+Symbol_handles::new_got_entry(unsigned int got_type, unsigned int got_offset)
+{
+  Hold_lock hl(this->lock_);
+  if (this->got_entries_.full())
+    gold_fatal(_("too many symbols with several GOT entries "
+		 "(the limit is %u)"),
+	       this->got_entries_.MAX_HANDLE);
+  return this->got_entries_.add(new Got_offset_list(got_type, got_offset));
+}
+
+// Class Got_offset_list.
+
+// Return the entry for the handle NEXT.
+
+Got_offset_list*
+Got_offset_list::next_entry(unsigned int next)
+{
+  return Symbol::handles()->got_entry(next);
+}
+
+// Add a new entry after this one.
+
+void
+Got_offset_list::add_entry(unsigned int got_type, unsigned int got_offset)
+{
+  unsigned int handle = Symbol::handles()->new_got_entry(got_type,
+							 got_offset);
+  Symbol::handles()->got_entry(handle)->got_next_ = this->got_next_;
+  this->got_next_ = handle;
+}
+
+#endif // defined(ENABLE_SYMBOL_HANDLES)
+
 // Class Symbol.
 
+#ifdef ENABLE_SYMBOL_HANDLES
+Symbol_handles* Symbol::handles_;
+#endif
+
 // Initialize fields in Symbol.  This initializes everything except u_
 // and source_.
 
@@ -56,7 +193,7 @@ Symbol::init_fields(const char* name, const char* version,
 		    elfcpp::STV visibility, unsigned char nonvis)
 {
   this->name_ = name;
-  this->version_ = version;
+  this->version_ = make_version_ref(version);
   this->symtab_index_ = 0;
   this->dynsym_index_ = 0;
   this->got_offsets_.init();
@@ -118,7 +255,7 @@ Symbol::init_base_object(const char* name, const char* version, Object* object,
 {
   this->init_fields(name, version, sym.get_st_type(), sym.get_st_bind(),
 		    sym.get_st_visibility(), sym.get_st_nonvis());
-  this->u_.from_object.object = object;
+  this->u_.from_object.object = make_object_ref(object);
   this->u_.from_object.shndx = st_shndx;
   this->is_ordinary_shndx_ = is_ordinary;
   this->source_ = FROM_OBJECT;
@@ -138,7 +275,7 @@ Symbol::init_base_output_data(const char* name, const char* version,
 			      bool is_predefined)
 {
   this->init_fields(name, version, type, binding, visibility, nonvis);
-  this->u_.in_output_data.output_data = od;
+  this->u_.in_output_data.output_data = make_output_data_ref(od);
   this->u_.in_output_data.offset_is_from_end = offset_is_from_end;
   this->source_ = IN_OUTPUT_DATA;
   this->in_reg_ = true;
@@ -158,7 +295,7 @@ Symbol::init_base_output_segment(const char* name, const char* version,
 				 bool is_predefined)
 {
   this->init_fields(name, version, type, binding, visibility, nonvis);
-  this->u_.in_output_segment.output_segment = os;
+  this->u_.in_output_segment.output_segment = make_output_segment_ref(os);
   this->u_.in_output_segment.offset_base = offset_base;
   this->source_ = IN_OUTPUT_SEGMENT;
   this->in_reg_ = true;
@@ -204,7 +341,7 @@ Symbol::allocate_base_common(Output_data* od)
 {
   gold_assert(this->is_common());
   this->source_ = IN_OUTPUT_DATA;
-  this->u_.in_output_data.output_data = od;
+  this->u_.in_output_data.output_data = make_output_data_ref(od);
   this->u_.in_output_data.offset_is_from_end = false;
 }
 
@@ -299,12 +436,13 @@ Sized_symbol<size>::init_undefined(const char* name, const char* version,
 std::string
 Symbol::versioned_name() const
 {
-  gold_assert(this->version_ != NULL);
+  const char* version = this->version();
+  gold_assert(version != NULL);
   std::string ret = this->name_;
   ret.push_back('@');
   if (this->is_def_)
     ret.push_back('@');
-  ret += this->version_;
+  ret += version;
   return ret;
 }
 
@@ -481,16 +619,18 @@ Symbol::output_section() const
 	unsigned int shndx = this->u_.from_object.shndx;
 	if (shndx != elfcpp::SHN_UNDEF && this->is_ordinary_shndx_)
 	  {
-	    gold_assert(!this->u_.from_object.object->is_dynamic());
-	    gold_assert(this->u_.from_object.object->pluginobj() == NULL);
-	    Relobj* relobj = static_cast<Relobj*>(this->u_.from_object.object);
+	    Object* object = get_object(this->u_.from_object.object);
+	    gold_assert(!object->is_dynamic());
+	    gold_assert(object->pluginobj() == NULL);
+	    Relobj* relobj = static_cast<Relobj*>(object);
 	    return relobj->output_section(shndx);
 	  }
 	return NULL;
       }
 
     case IN_OUTPUT_DATA:
-      return this->u_.in_output_data.output_data->output_section();
+      return get_output_data(this->u_.in_output_data.output_data)
+	->output_section();
 
     case IN_OUTPUT_SEGMENT:
     case IS_CONSTANT:
@@ -517,7 +657,7 @@ Symbol::set_output_section(Output_section* os)
       break;
     case IS_CONSTANT:
       this->source_ = IN_OUTPUT_DATA;
-      this->u_.in_output_data.output_data = os;
+      this->u_.in_output_data.output_data = make_output_data_ref(os);
       this->u_.in_output_data.offset_is_from_end = false;
       break;
     case IN_OUTPUT_SEGMENT:
@@ -531,16 +671,70 @@ Symbol::set_output_section(Output_section* os)
 
 Symbol_table::Symbol_table(unsigned int count,
                            const Version_script_info& version_script)
-  : saw_undefined_(0), offset_(0), table_(count), namepool_(),
-    forwarders_(), commons_(), tls_commons_(), small_commons_(),
-    large_commons_(), forced_locals_(), warnings_(),
-    version_script_(version_script), gc_(NULL), icf_(NULL)
+  : saw_undefined_(0), undefined_symbols_(), offset_(0), table_(count),
+    namepool_(), forwarders_(), commons_(), tls_commons_(), small_commons_(),
+    large_commons_(), forced_locals_(), output_symbols_(),
+    undefined_dynobj_symbols_(), warnings_(),
+    version_script_(version_script), gc_(NULL), icf_(NULL),
+    symbol_blocks_(), symbol_block_next_(NULL), symbol_block_left_(0)
+#ifdef ENABLE_SYMBOL_HANDLES
+    , handles_(new Symbol_handles())
+#endif
 {
   namepool_.reserve(count);
+#ifdef ENABLE_SYMBOL_HANDLES
+  Symbol::set_handles(this->handles_);
+#endif
 }
 
 Symbol_table::~Symbol_table()
 {
+  for (std::vector<unsigned char*>::iterator p = this->symbol_blocks_.begin();
+       p != this->symbol_blocks_.end();
+       ++p)
+    delete[] *p;
+#ifdef ENABLE_SYMBOL_HANDLES
+  Symbol::set_handles(NULL);
+  delete this->handles_;
+#endif
+}
+
+// Return SIZE bytes of memory for a new symbol.  We never free
+// individual symbols, so this is a simple bump allocator over blocks
+// of symbol_block_size bytes.  Symbols are only created while adding
+// symbols and defining special symbols, which happen one task at a
+// time, so no locking is needed.
+
+void*
+Symbol_table::allocate_symbol_memory(size_t size)
+{
+  static const size_t symbol_block_size = 128 * 1024;
+  const size_t align = sizeof(uint64_t);
+  size = (size + align - 1) & ~(align - 1);
+  gold_assert(size <= symbol_block_size);
+  if (size > this->symbol_block_left_)
+    {
+      unsigned char* block = new unsigned char[symbol_block_size];
+      this->symbol_blocks_.push_back(block);
+      this->symbol_block_next_ = block;
+      this->symbol_block_left_ = symbol_block_size;
+    }
+  void* ret = this->symbol_block_next_;
+  this->symbol_block_next_ += size;
+  this->symbol_block_left_ -= size;
+  return ret;
+}
+
+// Discard a new symbol which turned out not to be needed.  A symbol
+// made by the target was allocated with new.  A symbol from
+// allocate_symbol stays in its block until the symbol table is
+// destroyed; this only happens for a few special symbols.
+
+void
+Symbol_table::discard_symbol(Symbol* sym)
+{
+  if (parameters->target().has_make_symbol())
+    delete sym;
 }
 
 // The symbol table key equality function.  This is called with
@@ -994,7 +1188,7 @@ Symbol_table::add_from_object(Object* object,
 	  Sized_target<size, big_endian>* target =
 	    parameters->sized_target<size, big_endian>();
 	  if (!target->has_make_symbol())
-	    ret = new Sized_symbol<size>();
+	    ret = this->allocate_symbol<size>();
 	  else
 	    {
 	      ret = target->make_symbol();
@@ -1036,6 +1230,7 @@ Symbol_table::add_from_object(Object* object,
   if (!was_undefined && ret->is_undefined())
     {
       ++this->saw_undefined_;
+      this->undefined_symbols_.push_back(ret);
       if (parameters->options().has_plugins())
 	parameters->options().plugins()->new_undefined_symbol(ret);
     }
@@ -1778,7 +1973,7 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
 
   const Target& target = parameters->target();
   if (!target.has_make_symbol())
-    sym = new Sized_symbol<size>();
+    sym = this->allocate_symbol<size>();
   else
     {
       Sized_target<size, big_endian>* sized_target =
@@ -1912,7 +2107,7 @@ Symbol_table::do_define_in_output_data(
     return sym;
   else
     {
-      delete sym;
+      this->discard_symbol(sym);
       return oldsym;
     }
 }
@@ -2026,7 +2221,7 @@ Symbol_table::do_define_in_output_segment(
     return sym;
   else
     {
-      delete sym;
+      this->discard_symbol(sym);
       return oldsym;
     }
 }
@@ -2145,7 +2340,7 @@ Symbol_table::do_define_as_constant(
     return sym;
   else
     {
-      delete sym;
+      this->discard_symbol(sym);
       return oldsym;
     }
 }
@@ -2355,6 +2550,7 @@ Symbol_table::add_undefined_symbol_from_command_line(const char* name)
   sym->init_undefined(name, version, elfcpp::STT_NOTYPE, elfcpp::STB_GLOBAL,
 		      elfcpp::STV_DEFAULT, 0);
   ++this->saw_undefined_;
+  this->undefined_symbols_.push_back(sym);
 }
 
 // Set the dynamic symbol indexes.  INDEX is the index of the first
@@ -2487,6 +2683,7 @@ Symbol_table::add_to_final_symtab(Symbol* sym, Stringpool* pool,
 				  unsigned int* pindex, off_t* poff)
 {
   sym->set_symtab_index(*pindex);
+  this->output_symbols_.push_back(sym);
   if (sym->version() == NULL || !parameters->options().relocatable())
     pool->add(sym->name(), false, NULL);
   else
@@ -2510,6 +2707,9 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
   unsigned int index = *plocal_symcount;
   const unsigned int orig_index = index;
 
+  this->output_symbols_.clear();
+  this->undefined_dynobj_symbols_.clear();
+
   // First do all the symbols which have been forced to be local, as
   // they must appear before all global symbols.
   for (Forced_locals::iterator p = this->forced_locals_.begin();
@@ -2525,7 +2725,11 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
 	}
     }
 
-  // Now do all the remaining symbols.
+  // Now do all the remaining symbols.  The default version of a
+  // symbol may appear twice in the table, so note which symbols that
+  // only go into the dynsym we have already seen.
+  Output_symbols dynsym_only;
+  std::vector<bool> dynsym_only_seen;
   for (Symbol_table_type::iterator p = this->table_.begin();
        p != this->table_.end();
        ++p)
@@ -2533,9 +2737,33 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
       Symbol* sym = p->second;
       if (this->sized_finalize_symbol<size>(sym))
 	this->add_to_final_symtab<size>(sym, pool, &index, &off);
+      else if (sym->symtab_index() == -1U
+	       && sym->has_dynsym_index()
+	       && sym->dynsym_index() != -1U)
+	{
+	  unsigned int i = (sym->dynsym_index()
+			    - this->first_dynamic_global_index_);
+	  gold_assert(i < this->dynamic_count_);
+	  if (dynsym_only_seen.empty())
+	    dynsym_only_seen.resize(this->dynamic_count_);
+	  if (!dynsym_only_seen[i])
+	    {
+	      dynsym_only_seen[i] = true;
+	      dynsym_only.push_back(sym);
+	    }
+	}
+
+      bool dummy;
+      if (sym->source() == Symbol::FROM_OBJECT
+	  && sym->object()->is_dynamic()
+	  && sym->shndx(&dummy) == elfcpp::SHN_UNDEF)
+	this->undefined_dynobj_symbols_.push_back(sym);
     }
 
   this->output_count_ = index - orig_index;
+  gold_assert(this->output_symbols_.size() == this->output_count_);
+  this->output_symbols_.insert(this->output_symbols_.end(),
+			       dynsym_only.begin(), dynsym_only.end());
 
   return off;
 }
@@ -2768,32 +2996,32 @@ Symbol_table::write_globals(const Stringpool* sympool,
 			    const Stringpool* dynpool,
 			    Output_symtab_xindex* symtab_xindex,
 			    Output_symtab_xindex* dynsym_xindex,
-			    Output_file* of) const
+			    Output_file* of, size_t start, size_t end) const
 {
   switch (parameters->size_and_endianness())
     {
 #ifdef HAVE_TARGET_32_LITTLE
     case Parameters::TARGET_32_LITTLE:
       this->sized_write_globals<32, false>(sympool, dynpool, symtab_xindex,
-					   dynsym_xindex, of);
+					   dynsym_xindex, of, start, end);
       break;
 #endif
 #ifdef HAVE_TARGET_32_BIG
     case Parameters::TARGET_32_BIG:
       this->sized_write_globals<32, true>(sympool, dynpool, symtab_xindex,
-					  dynsym_xindex, of);
+					  dynsym_xindex, of, start, end);
       break;
 #endif
 #ifdef HAVE_TARGET_64_LITTLE
     case Parameters::TARGET_64_LITTLE:
       this->sized_write_globals<64, false>(sympool, dynpool, symtab_xindex,
-					   dynsym_xindex, of);
+					   dynsym_xindex, of, start, end);
       break;
 #endif
 #ifdef HAVE_TARGET_64_BIG
     case Parameters::TARGET_64_BIG:
       this->sized_write_globals<64, true>(sympool, dynpool, symtab_xindex,
-					  dynsym_xindex, of);
+					  dynsym_xindex, of, start, end);
       break;
 #endif
     default:
@@ -2801,7 +3029,9 @@ Symbol_table::write_globals(const Stringpool* sympool,
     }
 }
 
-// Write out the global symbols.
+// Write out the global symbols from START to END in the list built
+// by finalize.  The symbols are in the list only once, so writers of
+// different ranges touch different entries.
 
 template<int size, bool big_endian>
 void
@@ -2809,7 +3039,8 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
 				  const Stringpool* dynpool,
 				  Output_symtab_xindex* symtab_xindex,
 				  Output_symtab_xindex* dynsym_xindex,
-				  Output_file* of) const
+				  Output_file* of, size_t start,
+				  size_t end) const
 {
   const Target& target = parameters->target();
 
@@ -2834,14 +3065,23 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
   else
     dynamic_view = of->get_output_view(this->dynamic_offset_, dynamic_size);
 
-  for (Symbol_table_type::const_iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
+  // Possibly warn about unresolved symbols in shared libraries.  The
+  // writer of the first range does this, so that the warnings always
+  // come out in the same order.
+  if (start == 0)
     {
-      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
+      for (Output_symbols::const_iterator p =
+	     this->undefined_dynobj_symbols_.begin();
+	   p != this->undefined_dynobj_symbols_.end();
+	   ++p)
+	this->warn_about_undefined_dynobj_symbol(*p);
+    }
 
-      // Possibly warn about unresolved symbols in shared libraries.
-      this->warn_about_undefined_dynobj_symbol(sym);
+  gold_assert(start <= end && end <= this->output_symbols_.size());
+  for (size_t i = start; i < end; ++i)
+    {
+      Sized_symbol<size>* sym =
+	static_cast<Sized_symbol<size>*>(this->output_symbols_[i]);
 
       unsigned int sym_index = sym->symtab_index();
       unsigned int dynsym_index;
@@ -3157,6 +3397,8 @@ Symbol_table::print_stats() const
   fprintf(stderr, _("%s: symbol table entries: %zu\n"),
 	  program_name, this->table_.size());
 #endif
+  fprintf(stderr, _("%s: symbol table memory blocks: %zu\n"),
+	  program_name, this->symbol_blocks_.size());
   this->namepool_.print_stats("symbol table stringpool");
 }
 
@@ -26,6 +26,7 @@
 #ifndef GOLD_SYMTAB_H
 #define GOLD_SYMTAB_H
 
+#include <new>
 #include <string>
 #include <utility>
 #include <vector>
@@ -61,6 +62,127 @@ class Output_symtab_xindex;
 class Garbage_collection;
 class Icf;
 
+#ifdef ENABLE_SYMBOL_HANDLES
+
+// When gold is configured with --enable-symbol-handles, a Symbol
+// stores 32-bit handles rather than pointers for its version, for
+// the object, Output_data or Output_segment which defines it, and for
+// the extra entries of its GOT offset list.  This class holds the
+// tables which map the handles back to pointers.  There is one
+// instance, owned by the Symbol_table.  Looking up a handle needs no
+// lock; allocating one takes the lock.
+
+class Symbol_handles
+{
+ public:
+  // Handles are 24 bits wide, to fit next to the GOT type in a
+  // Got_offset_list.
+  static const int HANDLE_BITS = 24;
+
+  Symbol_handles();
+
+  ~Symbol_handles();
+
+  // Return the handle for OBJECT, which may be NULL.
+  unsigned int
+  object_handle(Object* object)
+  {
+    if (object == NULL)
+      return 0;
+    // The handle of an object is only set once, by the task adding
+    // its symbols.
+    unsigned int handle = object->symbol_handle();
+    if (handle != 0)
+      return handle;
+    return this->new_object_handle(object);
+  }
+
+  // Return the object for HANDLE.
+  Object*
+  object(unsigned int handle) const
+  { return handle == 0 ? NULL : this->objects_.get(handle); }
+
+  // Return the handle for OD, which may be NULL.
+  unsigned int
+  output_data_handle(Output_data* od);
+
+  // Return the Output_data for HANDLE.
+  Output_data*
+  output_data(unsigned int handle) const
+  { return handle == 0 ? NULL : this->output_datas_.get(handle); }
+
+  // Return the handle for OS, which may be NULL.
+  unsigned int
+  output_segment_handle(Output_segment* os);
+
+  // Return the Output_segment for HANDLE.
+  Output_segment*
+  output_segment(unsigned int handle) const
+  { return handle == 0 ? NULL : this->output_segments_.get(handle); }
+
+  // Return the handle for VERSION, which may be NULL.
+  unsigned int
+  version_handle(const char* version)
+  {
+    if (version == NULL)
+      return 0;
+    return this->new_version_handle(version);
+  }
+
+  // Return the version string for HANDLE.
+  const char*
+  version(unsigned int handle) const
+  { return handle == 0 ? NULL : this->versions_.get(handle); }
+
+  // Allocate a new entry for a GOT offset list, and return its
+  // handle.
+  unsigned int
+  new_got_entry(unsigned int got_type, unsigned int got_offset);
+
+  // Return the GOT offset list entry for HANDLE.
+  Got_offset_list*
+  got_entry(unsigned int handle) const
+  { return this->got_entries_.get(handle); }
+
+ private:
+  Symbol_handles(const Symbol_handles&);
+  Symbol_handles& operator=(const Symbol_handles&);
+
+  // Allocate a handle for OBJECT.
+  unsigned int
+  new_object_handle(Object* object);
+
+  // Return the handle for VERSION, allocating one if necessary.
+  unsigned int
+  new_version_handle(const char* version);
+
+  typedef Unordered_map<const Output_data*, unsigned int> Output_data_handles;
+  typedef Unordered_map<const Output_segment*, unsigned int>
+    Output_segment_handles;
+  typedef Unordered_map<const char*, unsigned int> Version_handles;
+
+  // The objects referred to by handles.
+  Handle_table<Object, HANDLE_BITS> objects_;
+  // The Output_data instances referred to by handles.
+  Handle_table<Output_data, HANDLE_BITS> output_datas_;
+  // The Output_segments referred to by handles.
+  Handle_table<Output_segment, HANDLE_BITS> output_segments_;
+  // The version strings referred to by handles.
+  Handle_table<const char, HANDLE_BITS> versions_;
+  // The extra entries of GOT offset lists.  These are owned here.
+  Handle_table<Got_offset_list, HANDLE_BITS> got_entries_;
+  // Maps from pointers to handles.  Only a few symbols are defined
+  // in an Output_data or Output_segment, and there are few distinct
+  // versions.
+  Output_data_handles output_data_handles_;
+  Output_segment_handles output_segment_handles_;
+  Version_handles version_handles_;
+  // Lock for allocating handles.
+  Lock lock_;
+};
+
+#endif // defined(ENABLE_SYMBOL_HANDLES)
+
 // The base class of an entry in the symbol table.  The symbol table
 // can have a lot of entries, so we don't want this class too big.
 // Size dependent fields can be found in the template class
@@ -103,6 +225,19 @@ class Symbol
     SEGMENT_BSS
   };
 
+#ifdef ENABLE_SYMBOL_HANDLES
+  // Return the tables which handles refer to.
+  static Symbol_handles*
+  handles()
+  { return handles_; }
+
+  // Set the tables which handles refer to.  This is called by the
+  // Symbol_table, which owns them.
+  static void
+  set_handles(Symbol_handles* handles)
+  { handles_ = handles; }
+#endif
+
   // Return the symbol name.
   const char*
   name() const
@@ -119,11 +254,11 @@ class Symbol
   // unversioned symbol.
   const char*
   version() const
-  { return this->version_; }
+  { return get_version(this->version_); }
 
   void
   clear_version()
-  { this->version_ = NULL; }
+  { this->version_ = make_version_ref(NULL); }
 
   // Return whether this version is the default for this symbol name
   // (eg, "foo@@V2" is a default version; "foo@V1" is not).  Only
@@ -131,7 +266,7 @@ class Symbol
   bool
   is_default() const
   {
-    gold_assert(this->version_ != NULL);
+    gold_assert(this->version() != NULL);
     return this->is_def_;
   }
 
@@ -154,7 +289,7 @@ class Symbol
   object() const
   {
     gold_assert(this->source_ == FROM_OBJECT);
-    return this->u_.from_object.object;
+    return get_object(this->u_.from_object.object);
   }
 
   // Return the index of the section in the input relocatable or
@@ -174,7 +309,7 @@ class Symbol
   output_data() const
   {
     gold_assert(this->source_ == IN_OUTPUT_DATA);
-    return this->u_.in_output_data.output_data;
+    return get_output_data(this->u_.in_output_data.output_data);
   }
 
   // If this symbol was defined with respect to an output data
@@ -193,7 +328,7 @@ class Symbol
   output_segment() const
   {
     gold_assert(this->source_ == IN_OUTPUT_SEGMENT);
-    return this->u_.in_output_segment.output_segment;
+    return get_output_segment(this->u_.in_output_segment.output_segment);
   }
 
   // If this symbol was defined with respect to an output segment,
@@ -894,11 +1029,92 @@ class Symbol
   Symbol(const Symbol&);
   Symbol& operator=(const Symbol&);
 
+#ifdef ENABLE_SYMBOL_HANDLES
+  typedef unsigned int Version_ref;
+  typedef unsigned int Object_ref;
+  typedef unsigned int Output_data_ref;
+  typedef unsigned int Output_segment_ref;
+
+  static Version_ref
+  make_version_ref(const char* version)
+  { return handles_->version_handle(version); }
+
+  static const char*
+  get_version(Version_ref ref)
+  { return handles_->version(ref); }
+
+  static Object_ref
+  make_object_ref(Object* object)
+  { return handles_->object_handle(object); }
+
+  static Object*
+  get_object(Object_ref ref)
+  { return handles_->object(ref); }
+
+  static Output_data_ref
+  make_output_data_ref(Output_data* od)
+  { return handles_->output_data_handle(od); }
+
+  static Output_data*
+  get_output_data(Output_data_ref ref)
+  { return handles_->output_data(ref); }
+
+  static Output_segment_ref
+  make_output_segment_ref(Output_segment* os)
+  { return handles_->output_segment_handle(os); }
+
+  static Output_segment*
+  get_output_segment(Output_segment_ref ref)
+  { return handles_->output_segment(ref); }
+#else
+  typedef const char* Version_ref;
+  typedef Object* Object_ref;
+  typedef Output_data* Output_data_ref;
+  typedef Output_segment* Output_segment_ref;
+
+  static Version_ref
+  make_version_ref(const char* version)
+  { return version; }
+
+  static const char*
+  get_version(Version_ref ref)
+  { return ref; }
+
+  static Object_ref
+  make_object_ref(Object* object)
+  { return object; }
+
+  static Object*
+  get_object(Object_ref ref)
+  { return ref; }
+
+  static Output_data_ref
+  make_output_data_ref(Output_data* od)
+  { return od; }
+
+  static Output_data*
+  get_output_data(Output_data_ref ref)
+  { return ref; }
+
+  static Output_segment_ref
+  make_output_segment_ref(Output_segment* os)
+  { return os; }
+
+  static Output_segment*
+  get_output_segment(Output_segment_ref ref)
+  { return ref; }
+#endif
+
+#ifdef ENABLE_SYMBOL_HANDLES
+  // The tables which handles refer to.
+  static Symbol_handles* handles_;
+#endif
+
   // Symbol name (expected to point into a Stringpool).
   const char* name_;
   // Symbol version (expected to point into a Stringpool).  This may
   // be NULL.
-  const char* version_;
+  Version_ref version_;
 
   union
   {
@@ -907,7 +1123,7 @@ class Symbol
     {
       // Object in which symbol is defined, or in which it was first
       // seen.
-      Object* object;
+      Object_ref object;
       // Section number in object_ in which symbol is defined.
       unsigned int shndx;
     } from_object;
@@ -918,7 +1134,7 @@ class Symbol
       // Output_data in which symbol is defined.  Before
       // Layout::finalize the symbol's value is an offset within the
       // Output_data.
-      Output_data* output_data;
+      Output_data_ref output_data;
       // True if the offset is from the end, false if the offset is
       // from the beginning.
       bool offset_is_from_end;
@@ -929,7 +1145,7 @@ class Symbol
     {
       // Output_segment in which the symbol is defined.  Before
       // Layout::finalize the symbol's value is an offset.
-      Output_segment* output_segment;
+      Output_segment_ref output_segment;
       // The base to use for the offset before Layout::finalize.
       Segment_offset_base offset_base;
     } in_output_segment;
@@ -1463,6 +1679,14 @@ class Symbol_table
   saw_undefined() const
   { return this->saw_undefined_; }
 
+  // The undefined symbols seen, in the order we saw them.  Some of
+  // them may have been defined since.
+  typedef std::vector<Symbol*> Undefined_symbols;
+
+  const Undefined_symbols&
+  undefined_symbols() const
+  { return this->undefined_symbols_; }
+
   // Allocate the common symbols
   void
   allocate_commons(Layout*, Mapfile*);
@@ -1559,11 +1783,19 @@ class Symbol_table
   output_count() const
   { return this->output_count_; }
 
-  // Write out the global symbols.
+  // Return the number of global symbols which write_globals will
+  // write out.  This is only valid after finalize.
+  size_t
+  output_symbol_count() const
+  { return this->output_symbols_.size(); }
+
+  // Write out the global symbols from START up to but not including
+  // END, counting as in output_symbol_count.  Separate ranges may be
+  // written at the same time by different threads.
   void
   write_globals(const Stringpool*, const Stringpool*,
 		Output_symtab_xindex*, Output_symtab_xindex*,
-		Output_file*) const;
+		Output_file*, size_t start, size_t end) const;
 
   // Write out a section symbol.  Return the updated offset.
   void
@@ -1713,6 +1945,25 @@ class Symbol_table
   void
   record_weak_aliases(std::vector<Sized_symbol<size>*>*);
 
+  // Allocate a new symbol for a target which does not make its own.
+  // Symbols live as long as the symbol table, so rather than calling
+  // new for each one we carve them out of large blocks.
+  template<int size>
+  Sized_symbol<size>*
+  allocate_symbol()
+  {
+    void* p = this->allocate_symbol_memory(sizeof(Sized_symbol<size>));
+    return new (p) Sized_symbol<size>();
+  }
+
+  // Return SIZE bytes of memory for a new symbol.
+  void*
+  allocate_symbol_memory(size_t size);
+
+  // Discard a new symbol SYM which turned out not to be needed.
+  void
+  discard_symbol(Symbol* sym);
+
   // Define a special symbol.
   template<int size, bool big_endian>
   Sized_symbol<size>*
@@ -1817,7 +2068,7 @@ class Symbol_table
   void
   sized_write_globals(const Stringpool*, const Stringpool*,
 		      Output_symtab_xindex*, Output_symtab_xindex*,
-		      Output_file*) const;
+		      Output_file*, size_t, size_t) const;
 
   // Write out a symbol to P.
   template<int size, bool big_endian>
@@ -1840,6 +2091,9 @@ class Symbol_table
   // The type of the list of symbols which have been forced local.
   typedef std::vector<Symbol*> Forced_locals;
 
+  // The type of the lists of symbols built by finalize.
+  typedef std::vector<Symbol*> Output_symbols;
+
   // A map from symbols with COPY relocs to the dynamic objects where
   // they are defined.
   typedef Unordered_map<const Symbol*, Dynobj*> Copied_symbol_dynobjs;
@@ -1847,6 +2101,8 @@ class Symbol_table
   // We increment this every time we see a new undefined symbol, for
   // use in archive groups.
   size_t saw_undefined_;
+  // The undefined symbols we have seen, for use in archives.
+  Undefined_symbols undefined_symbols_;
   // The index of the first global symbol in the output file.
   unsigned int first_global_index_;
   // The file offset within the output symtab section where we should
@@ -1887,6 +2143,14 @@ class Symbol_table
   // expect there to be very many of them, so we keep a list of them
   // rather than walking the whole table to find them.
   Forced_locals forced_locals_;
+  // The global symbols to write out, built by finalize.  The symbols
+  // in the symtab come first, in symtab index order, followed by the
+  // symbols which only appear in the dynsym.  Each symbol appears
+  // once, so the list may be split up among several writers.
+  Output_symbols output_symbols_;
+  // Symbols which a shared library refers to but does not define,
+  // in hash table order; write_globals may warn about these.
+  Output_symbols undefined_dynobj_symbols_;
   // Manage symbol warnings.
   Warnings warnings_;
   // Manage potential One Definition Rule (ODR) violations.
@@ -1902,6 +2166,16 @@ class Symbol_table
   const Version_script_info& version_script_;
   Garbage_collection* gc_;
   Icf* icf_;
+  // The blocks of memory from which allocate_symbol carves symbols.
+  std::vector<unsigned char*> symbol_blocks_;
+  // The next free byte in the last block.
+  unsigned char* symbol_block_next_;
+  // The number of free bytes in the last block.
+  size_t symbol_block_left_;
+#ifdef ENABLE_SYMBOL_HANDLES
+  // The tables which the handles stored in symbols refer to.
+  Symbol_handles* handles_;
+#endif
 };
 
 // We inline get_sized_symbol for efficiency.
@@ -115,6 +115,76 @@ scan_relocs(
     }
 }
 
+// This function implements the generic part of prescanning relocs,
+// for targets which scan the relocs of several objects in parallel.
+// The template parameter Scan must also provide two functions,
+// local_reloc_may_be_skipped() and global_reloc_may_be_skipped(),
+// which return true if local() or global() would do nothing for the
+// reloc.  Those functions are called by several threads at once, so
+// they must not change anything.  The relocs which must still be
+// scanned are copied to DEFERRED, in order, and we return how many
+// there are.
+
+template<int size, bool big_endian, int sh_type, typename Scan>
+inline size_t
+prescan_relocs(
+    Symbol_table* symtab,
+    Sized_relobj_file<size, big_endian>* object,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    size_t local_count,
+    const unsigned char* plocal_syms,
+    std::vector<unsigned char>* deferred)
+{
+  typedef typename Reloc_types<sh_type, size, big_endian>::Reloc Reltype;
+  const int reloc_size = Reloc_types<sh_type, size, big_endian>::reloc_size;
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  Scan scan;
+  size_t count = 0;
+
+  for (size_t i = 0; i < reloc_count; ++i, prelocs += reloc_size)
+    {
+      Reltype reloc(prelocs);
+
+      typename elfcpp::Elf_types<size>::Elf_WXword r_info = reloc.get_r_info();
+      unsigned int r_sym = elfcpp::elf_r_sym<size>(r_info);
+      unsigned int r_type = elfcpp::elf_r_type<size>(r_info);
+
+      bool skip;
+      if (r_sym < local_count)
+	{
+	  gold_assert(plocal_syms != NULL);
+	  typename elfcpp::Sym<size, big_endian> lsym(plocal_syms
+						      + r_sym * sym_size);
+	  unsigned int shndx = lsym.get_st_shndx();
+	  bool is_ordinary;
+	  shndx = object->adjust_sym_shndx(r_sym, shndx, &is_ordinary);
+	  // This must match scan_relocs, above.
+	  bool is_discarded = (is_ordinary
+			       && shndx != elfcpp::SHN_UNDEF
+			       && !object->is_section_included(shndx)
+			       && !symtab->is_section_folded(object, shndx));
+	  skip = scan.local_reloc_may_be_skipped(r_type, lsym, is_discarded);
+	}
+      else
+	{
+	  Symbol* gsym = object->global_symbol(r_sym);
+	  gold_assert(gsym != NULL);
+	  if (gsym->is_forwarder())
+	    gsym = symtab->resolve_forwards(gsym);
+	  skip = scan.global_reloc_may_be_skipped(r_type, gsym);
+	}
+
+      if (!skip)
+	{
+	  deferred->insert(deferred->end(), prelocs, prelocs + reloc_size);
+	  ++count;
+	}
+    }
+
+  return count;
+}
+
 // Behavior for relocations to discarded comdat sections.
 
 enum Comdat_behavior
@@ -61,6 +61,7 @@ class Output_data_got_base;
 class Output_section;
 class Input_objects;
 class Task;
+class Workqueue;
 struct Symbol_location;
 
 // The abstract class for target specific handling.
@@ -299,6 +300,12 @@ class Target
   can_check_for_function_pointers() const
   { return this->do_can_check_for_function_pointers(); }
 
+  // Return whether this target can prescan the relocs of several
+  // objects in parallel; see Sized_target::prescan_relocs.
+  bool
+  can_prescan_relocs() const
+  { return this->do_can_prescan_relocs(); }
+
   // Return whether a relocation to a merged section can be processed
   // to retrieve the contents.
   bool
@@ -369,15 +376,18 @@ class Target
   }
 
   // Perform a relaxation pass.  Return true if layout may be changed.
+  // WORKQUEUE may be used to queue tasks which help with the pass,
+  // but the pass must not wait for them to start.
   bool
   relax(int pass, const Input_objects* input_objects, Symbol_table* symtab,
-	Layout* layout, const Task* task)
+	Layout* layout, Workqueue* workqueue, const Task* task)
   {
     // Run the dummy relaxation pass twice if relaxation debugging is enabled.
     if (is_debugging_enabled(DEBUG_RELAXATION))
       return pass < 2;
 
-    return this->do_relax(pass, input_objects, symtab, layout, task);
+    return this->do_relax(pass, input_objects, symtab, layout, workqueue,
+			  task);
   }
 
   // Return the target-specific name of attributes section.  This is
@@ -590,6 +600,11 @@ class Target
   do_can_check_for_function_pointers() const
   { return false; }
 
+  // Virtual function which may be overridden by the child class.
+  virtual bool
+  do_can_prescan_relocs() const
+  { return false; }
+
   // Virtual function which may be overridden by the child class.  We
   // recognize some default sections for which we don't care whether
   // they have function pointers.
@@ -672,7 +687,8 @@ class Target
 
   // Virtual function which may be overridden by the child class.
   virtual bool
-  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*)
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, Workqueue*,
+	   const Task*)
   { return false; }
 
   // A function for targets to call.  Return whether BYTES/LEN matches
@@ -810,6 +826,26 @@ class Sized_target : public Target
 	      size_t local_symbol_count,
 	      const unsigned char* plocal_symbols) = 0;
 
+  // Prescan the relocs for a section.  This is called for several
+  // objects at once, before scan_relocs is called for any of them, so
+  // it must not change anything.  Copy to *DEFERRED, in order, the
+  // relocs for which scan_relocs may have to do something, such as
+  // create a GOT or PLT entry or a dynamic reloc, and return the
+  // number of relocs copied.  Only scan_relocs of those relocs is
+  // then needed.  This is only called if can_prescan_relocs returns
+  // true.  The parameters are like scan_relocs.
+  virtual size_t
+  prescan_relocs(Symbol_table*,
+		 Sized_relobj_file<size, big_endian>*,
+		 unsigned int /* data_shndx */,
+		 unsigned int /* sh_type */,
+		 const unsigned char* /* prelocs */,
+		 size_t /* reloc_count */,
+		 size_t /* local_symbol_count */,
+		 const unsigned char* /* plocal_symbols */,
+		 std::vector<unsigned char>* /* deferred */)
+  { gold_unreachable(); }
+
   // Relocate section data.  SH_TYPE is the type of the relocation
   // section, SHT_REL or SHT_RELA.  PRELOCS points to the relocation
   // information.  RELOC_COUNT is the number of relocs.
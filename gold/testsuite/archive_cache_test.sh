@@ -0,0 +1,108 @@
+#!/bin/sh
+
+# archive_cache_test.sh -- test --archive-index-cache.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# archive_cache_test.stdout has the output of "ls -i" on the cache
+# directory after each link with --archive-index-cache, with each line
+# prefixed by the number of the link.  gold writes a new cache file,
+# with a new inode, whenever it can't use the old one.  The cache file
+# is named for the archive's resolved file name, device and inode.
+# Links 5 to 7 use the same relative archive name in two directories,
+# which must not share a cache file.
+
+check()
+{
+    if ! eval "$2"; then
+	echo "$1"
+	echo "actual output:"
+	cat archive_cache_test.stdout
+	exit 1
+    fi
+}
+
+# The number of cache files after link $1.
+files()
+{
+    grep -c "^$1 " archive_cache_test.stdout
+}
+
+# The inode of cache file $2 after link $1.
+inode()
+{
+    sed -n -e "s/^$1 *\([0-9]*\) $2\$/\1/p" archive_cache_test.stdout
+}
+
+# The name of the only cache file after link $1.
+name()
+{
+    sed -n -e "s/^$1 *[0-9]* \(.*\)\$/\1/p" archive_cache_test.stdout
+}
+
+check "link 1 did not write one cache file" 'test "`files 1`" = 1'
+name1=`name 1`
+inode1=`inode 1 $name1`
+inode2=`inode 2 $name1`
+inode3=`inode 3 $name1`
+check "link 2 did not use the cache" 'test -n "$inode1" -a "$inode1" = "$inode2"'
+check "link after touch used the stale cache" \
+    'test -n "$inode3" -a "$inode2" != "$inode3"'
+# The rewritten archive may or may not get the old inode back.
+check "link after rewrite used the stale cache" \
+    'test "`files 4`" = 2 -o "`inode 4 $name1`" != "$inode3"'
+
+check "link 5 did not write one cache file" 'test "`files 5`" = 1'
+name5=`name 5`
+inode5=`inode 5 $name5`
+check "archives in two directories share a cache file" \
+    'test "`files 6`" = 2 -a "`files 7`" = 2'
+check "link in the second directory replaced the first cache file" \
+    'test -n "$inode5" -a "`inode 6 $name5`" = "$inode5"'
+check "link 7 did not use the cache" 'test "`inode 7 $name5`" = "$inode5"'
+
+# The members included are listed at the start of the map file, up to
+# the first blank line.
+members()
+{
+    sed -e '/^$/q' $1
+}
+
+status=0
+compare()
+{
+    if ! cmp -s $1 $2; then
+	echo "$1 and $2 differ"
+	status=1
+    fi
+    if test "`members $1.map`" != "`members $2.map`"; then
+	echo "$2 included different archive members"
+	status=1
+    fi
+}
+
+for n in 1 2 3; do
+    compare archive_cache_test_ref archive_cache_test_$n
+done
+for n in 4 5 6 7; do
+    compare archive_cache_test_ref4 archive_cache_test_$n
+done
+
+exit $status
@@ -0,0 +1,67 @@
+#!/bin/sh
+
+# archive_parallel_test.sh -- test reading archive members in parallel.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# Each archive_parallel_test_N was linked with --threads, and
+# archive_parallel_test_N_ref without.  The output and the members
+# included, which are listed at the start of the map file up to the
+# first blank line, must be the same.
+
+status=0
+
+members()
+{
+    sed -e '/^$/q' $1
+}
+
+for n in 1 2 3 4; do
+    f=archive_parallel_test_$n
+    if ! cmp -s $f ${f}_ref; then
+	echo "$f and ${f}_ref differ"
+	status=1
+    fi
+    if test "`members $f.map`" != "`members ${f}_ref.map`"; then
+	echo "$f included different archive members"
+	status=1
+    fi
+done
+
+# Unless gold was built without threads, the links of the ordinary
+# and thin archives, whose --stats output is in
+# archive_parallel_test.stdout, must have read some members in
+# parallel.
+counts=`sed -n -e 's/.*archive members read in parallel: \([0-9]*\).*/\1/p' archive_parallel_test.stdout`
+if test `echo $counts | wc -w` -ne 2; then
+    echo "missing statistics in archive_parallel_test.stdout:"
+    cat archive_parallel_test.stdout
+    status=1
+elif ! grep -q "ignoring --threads" archive_parallel_test.stdout; then
+    for count in $counts; do
+	if test "$count" -eq 0; then
+	    echo "no archive members were read in parallel"
+	    cat archive_parallel_test.stdout
+	    status=1
+	fi
+    done
+fi
+
+exit $status
@@ -0,0 +1,254 @@
+#!/bin/sh
+
+# debug_names_test.sh -- a test case for the --debug-names option.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The readelf in this tree does not know how to display a .debug_names
+# section, so we decode a hex dump of the section here.  We check the
+# header, the CU list, the hash table, the name table, the
+# abbreviation table and the entry pool, and list each index entry as
+# "NAME TAG CU DIE_OFFSET", looking up the names in a dump of
+# .debug_str.
+
+STDOUT=debug_names_test.stdout
+STRINGS=debug_names_test_str.stdout
+ENTRIES=debug_names_test.entries
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_count()
+{
+    if test "`grep -c "$2" "$1"`" != "$3"
+    then
+	echo "Expected $3 lines matching:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+if ! awk '
+function fail(msg) {
+  print "debug_names_test: " msg > "/dev/stderr"
+  failed = 1
+  exit 1
+}
+function u32(off,  v) {
+  if (off + 4 > nbytes)
+    fail("read past end of section at " off)
+  if (little)
+    v = b[off] + b[off + 1] * 256 + b[off + 2] * 65536 \
+	+ b[off + 3] * 16777216
+  else
+    v = b[off + 3] + b[off + 2] * 256 + b[off + 1] * 65536 \
+	+ b[off] * 16777216
+  return v
+}
+function u16(off) {
+  if (little)
+    return b[off] + b[off + 1] * 256
+  return b[off + 1] + b[off] * 256
+}
+function uleb(off,  v, m) {
+  v = 0
+  m = 1
+  while (1) {
+    if (off >= nbytes)
+      fail("read past end of section at " off)
+    v += (b[off] % 128) * m
+    m *= 128
+    if (b[off++] < 128)
+      break
+  }
+  pos = off
+  return v
+}
+# The DJB hash of a name, after case folding.
+function djb(s,  h, i) {
+  h = 5381
+  s = tolower(s)
+  for (i = 1; i <= length(s); ++i)
+    h = (h * 33 + ord[substr(s, i, 1)]) % 4294967296
+  return h
+}
+BEGIN {
+  for (i = 0; i < 16; ++i)
+    hex[substr("0123456789abcdef", i + 1, 1)] = i
+  for (i = 1; i < 256; ++i)
+    ord[sprintf("%c", i)] = i
+  nbytes = 0
+}
+FILENAME == ARGV[1] && /Data:.*little endian/ { little = 1 }
+FILENAME == ARGV[1] && /^  0x[0-9a-f]+ / {
+  s = substr($0, 14, 35)
+  gsub(/ /, "", s)
+  for (i = 1; i < length(s); i += 2)
+    b[nbytes++] = hex[substr(s, i, 1)] * 16 + hex[substr(s, i + 1, 1)]
+}
+FILENAME == ARGV[2] && /^ *\[ *[0-9a-f]+\]  / {
+  o = $0
+  sub(/^ *\[ */, "", o)
+  sub(/\].*/, "", o)
+  s = $0
+  sub(/^ *\[ *[0-9a-f]+\]  /, "", s)
+  v = 0
+  for (i = 1; i <= length(o); ++i)
+    v = v * 16 + hex[substr(o, i, 1)]
+  str[v] = s
+}
+END {
+  if (failed)
+    exit 1
+  if (nbytes == 0)
+    fail("no .debug_names section")
+
+  # The header.
+  if (u32(0) + 4 != nbytes)
+    fail("unit length " u32(0) " does not match section size " nbytes)
+  if (u16(4) != 5)
+    fail("bad version " u16(4))
+  if (u16(6) != 0)
+    fail("bad padding " u16(6))
+  cu_count = u32(8)
+  if (cu_count < 1)
+    fail("no compilation units")
+  if (u32(12) != 0 || u32(16) != 0)
+    fail("unexpected type units")
+  bucket_count = u32(20)
+  name_count = u32(24)
+  abbrev_size = u32(28)
+  if (bucket_count < 1 || name_count < 1)
+    fail("empty hash table")
+  if (u32(32) != 0)
+    fail("unexpected augmentation string")
+
+  # The CU list.  The offsets must increase from zero.
+  off = 36
+  for (i = 0; i < cu_count; ++i) {
+    cu = u32(off + i * 4)
+    if ((i == 0 && cu != 0) || (i > 0 && cu <= last_cu))
+      fail("bad CU offset " cu)
+    last_cu = cu
+  }
+  off += cu_count * 4
+
+  # The buckets hold the one-based index of the first name in each
+  # bucket, and the names of a bucket must be contiguous.
+  buckets = off
+  hashes = buckets + bucket_count * 4
+  strs = hashes + name_count * 4
+  entries = strs + name_count * 4
+  abbrevs = entries + name_count * 4
+  pool = abbrevs + abbrev_size
+  for (i = 1; i <= name_count; ++i) {
+    h = u32(hashes + (i - 1) * 4)
+    bucket = h % bucket_count
+    first = u32(buckets + bucket * 4)
+    if (first == 0 || first > i)
+      fail("name " i " is not in bucket " bucket)
+    if (i > 1 && bucket != last_bucket && first != i)
+      fail("names of bucket " bucket " are not contiguous")
+    last_bucket = bucket
+    name = str[u32(strs + (i - 1) * 4)]
+    if (name == "")
+      fail("name " i " has no string")
+    if (djb(name) != h)
+      fail("bad hash for " name)
+    names[i] = name
+  }
+
+  # The abbreviation table.  Each abbreviation gives the compilation
+  # unit index and the DIE offset.
+  pos = abbrevs
+  while (1) {
+    code = uleb(pos)
+    if (code == 0)
+      break
+    tag[code] = uleb(pos)
+    if (uleb(pos) != 1 || uleb(pos) != 15 \
+	|| uleb(pos) != 3 || uleb(pos) != 19 \
+	|| uleb(pos) != 0 || uleb(pos) != 0)
+      fail("unexpected attributes for abbreviation " code)
+  }
+  if (pos != pool)
+    fail("abbreviation table size " abbrev_size " is wrong")
+
+  # The entry pool.  Each name has a list of entries ending with a
+  # zero code.
+  for (i = 1; i <= name_count; ++i) {
+    pos = pool + u32(entries + (i - 1) * 4)
+    n = 0
+    while (1) {
+      code = uleb(pos)
+      if (code == 0)
+	break
+      if (!(code in tag))
+	fail("bad abbreviation code " code " for " names[i])
+      cu = uleb(pos)
+      if (cu >= cu_count)
+	fail("bad CU index " cu " for " names[i])
+      die = u32(pos)
+      pos += 4
+      if (die == 0)
+	fail("bad DIE offset for " names[i])
+      printf "%s 0x%x %d 0x%x\n", names[i], tag[code], cu, die
+      ++n
+    }
+    if (n == 0)
+      fail("no entries for " names[i])
+  }
+}' $STDOUT $STRINGS > $ENTRIES
+then
+    exit 1
+fi
+
+# Some of the names we expect to find, with their tags.
+check $ENTRIES "^main 0x2e 0 "
+check $ENTRIES "^c1_count 0x34 0 "
+check $ENTRIES "^c1v 0x34 0 "
+check $ENTRIES "^anonymous_union_var 0x34 0 "
+check $ENTRIES "^one 0x39 0 "
+check $ENTRIES "^two 0x39 0 "
+check $ENTRIES "^(anonymous namespace) 0x39 0 "
+check $ENTRIES "^G_A 0x28 0 "
+check $ENTRIES "^F_A 0x28 0 "
+check $ENTRIES "^inline_func_1 0x2e 0 "
+
+# A name used by several DIEs has an entry for each of them, all
+# listed under the same name.
+check $ENTRIES "^c1 0x2 0 "
+check $ENTRIES "^c1 0x2e 0 "
+check_count $ENTRIES "^c1 " 2
+
+exit 0
@@ -0,0 +1,59 @@
+# A .dwo file with two compilation units, for testing how dwp reads
+# the names of truncated units.  The first unit ends in the middle of
+# the ULEB128 value of DW_AT_language.  The second unit is complete.
+# The type unit is there because dwp can only update a package with a
+# .debug_types.dwo section.
+
+	.section	.debug_info.dwo,"e",@progbits
+	.long	.Linfo0_end - .Linfo0_start
+.Linfo0_start:
+	.value	0x4
+	.long	0
+	.byte	0x8
+	.uleb128 0x1
+	.quad	0x1122334455667788
+	.byte	0x80
+.Linfo0_end:
+	.long	.Linfo1_end - .Linfo1_start
+.Linfo1_start:
+	.value	0x4
+	.long	0
+	.byte	0x8
+	.uleb128 0x1
+	.quad	0x2233445566778899
+	.uleb128 0x4
+	.string	"dwp_test_8.cc"
+.Linfo1_end:
+
+	.section	.debug_types.dwo,"G",@progbits,wt.99aabbccddeeff00,comdat
+	.long	.Ltypes0_end - .Ltypes0_start
+.Ltypes0_start:
+	.value	0x4
+	.long	0
+	.byte	0x8
+	.quad	0x99aabbccddeeff00
+	.long	0x17
+	.uleb128 0x3
+.Ltypes0_end:
+
+	.section	.debug_abbrev.dwo,"e",@progbits
+	.uleb128 0x1
+	.uleb128 0x11
+	.byte	0
+	.uleb128 0x2131
+	.uleb128 0x7
+	.uleb128 0x13
+	.uleb128 0xf
+	.uleb128 0x3
+	.uleb128 0x8
+	.byte	0
+	.byte	0
+	.uleb128 0x3
+	.uleb128 0x41
+	.byte	0
+	.byte	0
+	.byte	0
+
+	.section	.debug_str_offsets.dwo,"e",@progbits
+
+	.section	.debug_str.dwo,"MSe",@progbits,1
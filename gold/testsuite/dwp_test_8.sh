@@ -0,0 +1,66 @@
+#!/bin/sh
+
+# dwp_test_8.sh -- test dwp --update with truncated units.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output:"
+	echo "   $2"
+	echo ""
+	echo "Actual error output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_num()
+{
+    n=$(grep -c "$2" "$1")
+    if test "$n" -ne "$3"
+    then
+	echo "Found $n occurrences (should find $3):"
+	echo "   $2"
+	echo ""
+	echo "Actual error output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+# dwp_test_8.dwo has a truncated unit and a complete one, whose DWO
+# ids appear in both the offset and the size table of the index.
+# dwp_test_9.stdout is from the package of dwp_test_8.dwo updated with
+# dwp_test_1.dwo, and dwp_test_10.stdout is from dwp_test_1.dwp
+# updated with dwp_test_8.dwo.  No unit is replaced by name.
+
+for STDOUT in dwp_test_9.stdout dwp_test_10.stdout
+do
+    check $STDOUT "^Contents of the .debug_cu_index section"
+    check_num $STDOUT "0x1122334455667788" 2
+    check_num $STDOUT "0x2233445566778899" 2
+done
+check dwp_test_9.stdout "Number of used entries:  3$"
+check dwp_test_10.stdout "Number of used entries:  6$"
+
+exit 0
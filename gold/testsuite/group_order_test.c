@@ -0,0 +1,86 @@
+/* group_order_test.c -- a test case for gold
+
+   Copyright 2013 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* Test the order in which archive members are included from a
+   --start-group and from --start-lib.  This file is compiled once
+   for each object, with a different macro defined.  The objects
+   refer to each other in a cycle which takes several passes to
+   resolve, and both a2 and c2 define the symbol a2, so the result
+   depends on the order in which the members are searched.  */
+
+#ifdef MAIN
+extern int a1 (void);
+extern int d1 (void);
+
+int
+main (void)
+{
+  return a1 () + d1 () != 9;
+}
+#endif
+
+#ifdef A1
+extern int b1 (void);
+int a1 (void) { return b1 () + 1; }
+#endif
+
+#ifdef A2
+extern int b2 (void);
+int a2 (void) { return b2 () + 1; }
+#endif
+
+#ifdef A3
+int a3 (void) { return 1; }
+#endif
+
+#ifdef B1
+extern int a2 (void);
+int b1 (void) { return a2 () + 1; }
+#endif
+
+#ifdef B2
+extern int c1 (void);
+int b2 (void) { return c1 () + 1; }
+#endif
+
+#ifdef C1
+extern int a3 (void);
+int c1 (void) { return a3 () + 1; }
+#endif
+
+#ifdef C2
+extern int b2 (void);
+int a2 (void) { return b2 () + 1; }
+#endif
+
+#ifdef D1
+extern int d2 (void);
+int d1 (void) { return d2 () + 1; }
+#endif
+
+#ifdef D2
+extern int d3 (void);
+int d2 (void) { return d3 () + 1; }
+#endif
+
+#ifdef D3
+int d3 (void) { return 1; }
+#endif
@@ -0,0 +1,63 @@
+#!/bin/sh
+
+# group_order_test.sh -- test archive member order in groups.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# group_order_test_1 was linked with archives in a --start-group, and
+# group_order_test_2 with the same objects in a --start-lib.  The
+# objects included are listed in the map files, in the order they
+# were included, by their .text sections.  They must be the ones a
+# full search of each archive on each pass would include.
+
+included()
+{
+    sed -n -e 's/^ \.text  *0x[0-9a-f]*  *0x[0-9a-f]* \(.*group_order_test_[a-d][0-9]\.o)*\)$/\1/p' $1
+}
+
+expected="libgroup_order_test_a.a(group_order_test_a1.o)
+libgroup_order_test_b.a(group_order_test_b1.o)
+libgroup_order_test_c.a(group_order_test_c2.o)
+libgroup_order_test_b.a(group_order_test_b2.o)
+libgroup_order_test_c.a(group_order_test_c1.o)
+libgroup_order_test_a.a(group_order_test_a3.o)
+libgroup_order_test_d.a(group_order_test_d1.o)
+libgroup_order_test_d.a(group_order_test_d2.o)
+libgroup_order_test_d.a(group_order_test_d3.o)"
+
+status=0
+check()
+{
+    actual=`included $1`
+    if test "$actual" != "$2"; then
+	echo "$1 includes the wrong objects"
+	echo "expected:"
+	echo "$2"
+	echo "actual:"
+	echo "$actual"
+	status=1
+    fi
+}
+
+check group_order_test_1.map "$expected"
+check group_order_test_2.map \
+    "`echo "$expected" | sed -e 's/^libgroup_order_test_.\.a(\(.*\))$/\1/'`"
+
+exit $status
@@ -0,0 +1,46 @@
+#!/bin/sh
+
+# max_mapped_memory_test.sh -- test --max-mapped-input-memory.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# max_mapped_memory_test was linked with --max-mapped-input-memory=1,
+# so gold evicted every input view it was allowed to.  The output
+# must not change.
+
+if ! cmp -s max_mapped_memory_test max_mapped_memory_test_ref; then
+    echo "max_mapped_memory_test and max_mapped_memory_test_ref differ"
+    exit 1
+fi
+
+count=`sed -n -e 's/.*input views evicted: \([0-9]*\).*/\1/p' max_mapped_memory_test.stats`
+if test -z "$count"; then
+    echo "no eviction statistics in max_mapped_memory_test.stats:"
+    cat max_mapped_memory_test.stats
+    exit 1
+fi
+
+if test "$count" -eq 0; then
+    echo "no input views were evicted"
+    cat max_mapped_memory_test.stats
+    exit 1
+fi
+
+exit 0
@@ -27,6 +27,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef ENABLE_THREADS
+#include <pthread.h>
+#endif
 #include "plugin-api.h"
 
 struct claimed_file
@@ -51,7 +54,15 @@ struct sym_info
 static struct claimed_file* first_claimed_file = NULL;
 static struct claimed_file* last_claimed_file = NULL;
 
+#ifdef ENABLE_THREADS
+/* Protects the list of claimed files when the claim file hook is
+   registered as thread-safe.  */
+static pthread_mutex_t claimed_file_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 static ld_plugin_register_claim_file register_claim_file_hook = NULL;
+static ld_plugin_register_claim_file_thread_safe
+  register_claim_file_thread_safe_hook = NULL;
 static ld_plugin_register_all_symbols_read register_all_symbols_read_hook = NULL;
 static ld_plugin_register_cleanup register_cleanup_hook = NULL;
 static ld_plugin_add_symbols add_symbols = NULL;
@@ -87,6 +98,7 @@ onload(struct ld_plugin_tv *tv)
   struct ld_plugin_tv *entry;
   int api_version = 0;
   int gold_version = 0;
+  int thread_safe_claim = 0;
   int i;
 
   for (entry = tv; entry->tv_tag != LDPT_NULL; ++entry)
@@ -108,6 +120,10 @@ onload(struct ld_plugin_tv *tv)
         case LDPT_REGISTER_CLAIM_FILE_HOOK:
           register_claim_file_hook = entry->tv_u.tv_register_claim_file;
           break;
+        case LDPT_REGISTER_CLAIM_FILE_HOOK_THREAD_SAFE:
+          register_claim_file_thread_safe_hook =
+            entry->tv_u.tv_register_claim_file_thread_safe;
+          break;
         case LDPT_REGISTER_ALL_SYMBOLS_READ_HOOK:
           register_all_symbols_read_hook =
             entry->tv_u.tv_register_all_symbols_read;
@@ -187,9 +203,28 @@ onload(struct ld_plugin_tv *tv)
   (*message)(LDPL_INFO, "gold version:  %d", gold_version);
 
   for (i = 0; i < nopts; ++i)
-    (*message)(LDPL_INFO, "option: %s", opts[i]);
+    {
+      (*message)(LDPL_INFO, "option: %s", opts[i]);
+      if (strcmp(opts[i], "thread_safe_claim") == 0)
+        thread_safe_claim = 1;
+    }
 
-  if ((*register_claim_file_hook)(claim_file_hook) != LDPS_OK)
+  if (thread_safe_claim)
+    {
+      if (register_claim_file_thread_safe_hook == NULL)
+        {
+          fprintf(stderr, "tv_register_claim_file_thread_safe_hook "
+                  "interface missing\n");
+          return LDPS_ERR;
+        }
+      if ((*register_claim_file_thread_safe_hook)(claim_file_hook) != LDPS_OK)
+        {
+          (*message)(LDPL_ERROR, "error registering claim file hook");
+          return LDPS_ERR;
+        }
+      (*message)(LDPL_INFO, "claim file hook registered as thread-safe");
+    }
+  else if ((*register_claim_file_hook)(claim_file_hook) != LDPS_OK)
     {
       (*message)(LDPL_ERROR, "error registering claim file hook");
       return LDPS_ERR;
@@ -365,11 +400,17 @@ claim_file_hook (const struct ld_plugin_input_file* file, int* claimed)
   claimed_file->nsyms = nsyms;
   claimed_file->syms = syms;
   claimed_file->next = NULL;
+#ifdef ENABLE_THREADS
+  pthread_mutex_lock(&claimed_file_lock);
+#endif
   if (last_claimed_file == NULL)
     first_claimed_file = claimed_file;
   else
     last_claimed_file->next = claimed_file;
   last_claimed_file = claimed_file;
+#ifdef ENABLE_THREADS
+  pthread_mutex_unlock(&claimed_file_lock);
+#endif
 
   (*message)(LDPL_INFO, "%s: claiming file, adding %d symbols",
              file->name, nsyms);
@@ -0,0 +1,41 @@
+#!/bin/sh
+
+# prefault_output_test.sh -- test --prefault-output-file and
+# --output-huge-pages.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# Each of these was linked like flagstest_compress_debug_sections,
+# but with --prefault-output-file or --output-huge-pages.  Those
+# options only change how gold gets memory for the output file, so
+# the output must be the same.
+
+status=0
+for f in flagstest_prefault_compress_debug_sections \
+	 flagstest_prefault_mmap_compress_debug_sections \
+	 flagstest_huge_pages_compress_debug_sections \
+	 flagstest_huge_pages_mmap_compress_debug_sections; do
+    if ! cmp -s flagstest_compress_debug_sections $f; then
+	echo "flagstest_compress_debug_sections and $f differ"
+	status=1
+    fi
+done
+
+exit $status
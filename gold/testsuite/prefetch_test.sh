@@ -0,0 +1,58 @@
+#!/bin/sh
+
+# prefetch_test.sh -- test --prefetch-inputs.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# prefetch_test was linked with --prefetch-inputs-limit=1, so the
+# prefetch task stops after the first file it reads.  Each later file
+# is only prefetched if a new task is queued once the earlier files
+# have been opened.  prefetch_test_threads was linked the same way
+# with --threads, where the prefetch task also reads the section
+# headers.  The output must not change.
+
+check()
+{
+    if ! cmp -s $1 prefetch_test_ref; then
+	echo "$1 and prefetch_test_ref differ"
+	exit 1
+    fi
+
+    count=`sed -n -e 's/.*input files prefetched: \([0-9]*\).*/\1/p' $1.stats`
+    if test -z "$count"; then
+	echo "no prefetch statistics in $1.stats:"
+	cat $1.stats
+	exit 1
+    fi
+
+    # Without posix_fadvise nothing is prefetched.  Otherwise,
+    # prefetching only the first file means that the task was never
+    # queued again.
+    if test "$count" -eq 1; then
+	echo "only one file was prefetched; the prefetch task was not requeued"
+	cat $1.stats
+	exit 1
+    fi
+}
+
+check prefetch_test
+check prefetch_test_threads
+
+exit 0
@@ -0,0 +1,170 @@
+/* prescan_test.c -- a test case for gold
+
+   Copyright 2013 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* Test that scanning relocations in parallel with --threads gives the
+   same output as --no-threads.  This file is compiled once with
+   PRESCAN_PART_1 defined and once with PRESCAN_PART_2 defined, for
+   each of non-PIC, PIE and PIC code.  Each object refers to
+   preemptible, protected and hidden symbols, to an IFUNC, and to TLS
+   variables defined in the other object, so that the relocation scan
+   has to create GOT and PLT entries and dynamic relocations.  */
+
+#ifdef PRESCAN_PART_1
+#define DEFINE_PART(name) name##_1
+#define OTHER_PART(name) name##_2
+#define IFUNC_RESOLVER "ifunc_resolver_1"
+#else
+#define DEFINE_PART(name) name##_2
+#define OTHER_PART(name) name##_1
+#define IFUNC_RESOLVER "ifunc_resolver_2"
+#endif
+
+/* A preemptible function and variable.  */
+
+extern int OTHER_PART (preemptible_fn) (int);
+extern int OTHER_PART (preemptible_var);
+
+int DEFINE_PART (preemptible_var) = 1;
+
+int
+DEFINE_PART (preemptible_fn) (int i)
+{
+  return i + OTHER_PART (preemptible_var);
+}
+
+/* A protected function and variable.  */
+
+extern int OTHER_PART (protected_fn) (int)
+  __attribute__ ((visibility ("protected")));
+extern int OTHER_PART (protected_var)
+  __attribute__ ((visibility ("protected")));
+
+int DEFINE_PART (protected_var) __attribute__ ((visibility ("protected")))
+  = 2;
+
+int __attribute__ ((visibility ("protected")))
+DEFINE_PART (protected_fn) (int i)
+{
+  return i + DEFINE_PART (protected_var);
+}
+
+/* A hidden function and variable.  */
+
+extern int OTHER_PART (hidden_fn) (int)
+  __attribute__ ((visibility ("hidden")));
+extern int OTHER_PART (hidden_var)
+  __attribute__ ((visibility ("hidden")));
+
+int DEFINE_PART (hidden_var) __attribute__ ((visibility ("hidden"))) = 3;
+
+int __attribute__ ((visibility ("hidden")))
+DEFINE_PART (hidden_fn) (int i)
+{
+  return i + DEFINE_PART (hidden_var);
+}
+
+/* A TLS variable.  */
+
+extern __thread int OTHER_PART (tls_var);
+
+__thread int DEFINE_PART (tls_var) = 4;
+
+/* An IFUNC.  Only x86_64 scans relocations in parallel, so the
+   other targets just use an ordinary function here.  */
+
+extern int OTHER_PART (ifunc_fn) (int);
+
+#ifdef __x86_64__
+
+static int
+DEFINE_PART (ifunc_impl) (int i)
+{
+  return i + 5;
+}
+
+static void *
+DEFINE_PART (ifunc_resolver) (void)
+{
+  return (void *) DEFINE_PART (ifunc_impl);
+}
+
+int DEFINE_PART (ifunc_fn) (int)
+  __attribute__ ((ifunc (IFUNC_RESOLVER)));
+
+#else
+
+int
+DEFINE_PART (ifunc_fn) (int i)
+{
+  return i + 5;
+}
+
+#endif
+
+/* Function pointers and addresses of data, which need absolute or
+   GOT relocations depending on how the object was compiled.  */
+
+extern int (*OTHER_PART (fn_ptrs)[]) (int);
+extern int *OTHER_PART (var_ptrs)[];
+
+int (*DEFINE_PART (fn_ptrs)[]) (int) =
+{
+  OTHER_PART (preemptible_fn),
+  OTHER_PART (protected_fn),
+  OTHER_PART (hidden_fn),
+  OTHER_PART (ifunc_fn)
+};
+
+int *DEFINE_PART (var_ptrs)[] =
+{
+  &OTHER_PART (preemptible_var),
+  &OTHER_PART (protected_var),
+  &OTHER_PART (hidden_var)
+};
+
+int
+DEFINE_PART (call_other) (int i)
+{
+  return (OTHER_PART (preemptible_fn) (i)
+	  + OTHER_PART (protected_fn) (i)
+	  + OTHER_PART (hidden_fn) (i)
+	  + OTHER_PART (ifunc_fn) (i)
+	  + OTHER_PART (preemptible_var)
+	  + OTHER_PART (protected_var)
+	  + OTHER_PART (hidden_var)
+	  + OTHER_PART (tls_var)
+	  + *OTHER_PART (var_ptrs)[0]);
+}
+
+#ifdef PRESCAN_PART_1
+extern int call_other_2 (int);
+
+int
+main (void)
+{
+  int i;
+  int sum = 0;
+
+  for (i = 0; i < 4; ++i)
+    sum += fn_ptrs_2[i] (i);
+  return call_other_1 (sum) == call_other_2 (sum) ? 0 : 1;
+}
+#endif
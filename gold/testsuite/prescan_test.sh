@@ -0,0 +1,42 @@
+#!/bin/sh
+
+# prescan_test.sh -- test relocation scanning with --threads.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# Each prescan_test output was linked with --threads and
+# --thread-count-middle 3, which scans the relocations of the input
+# objects in parallel on x86_64.  The matching _nothreads output was
+# linked with --no-threads.  The outputs must be the same.
+
+check()
+{
+    if ! cmp -s $1 $2; then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+check prescan_test prescan_test_nothreads
+check prescan_test_pie prescan_test_pie_nothreads
+check prescan_test.so prescan_test_nothreads.so
+check prescan_test_emit_relocs prescan_test_emit_relocs_nothreads
+
+exit 0
@@ -0,0 +1,56 @@
+/* relocation_order_test.c -- a test case for gold
+
+   Copyright 2013 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.  */
+
+/* Test --relocation-order=output.  The array is large enough that
+   the output file is split into more than one range, so that this
+   object is relocated by more than one task, and there are
+   relocations on both sides of it.  */
+
+int
+relocation_order_f1 (void)
+{
+  return 1;
+}
+
+int
+relocation_order_f2 (void)
+{
+  return 2;
+}
+
+int (*relocation_order_before[]) (void) =
+{
+  relocation_order_f1, relocation_order_f2
+};
+
+char relocation_order_big[9 * 1024 * 1024] = { 1 };
+
+int (*relocation_order_after[]) (void) =
+{
+  relocation_order_f2, relocation_order_f1
+};
+
+int
+main (void)
+{
+  return (relocation_order_before[0] () + relocation_order_after[0] ()
+	  + relocation_order_big[0] != 4);
+}
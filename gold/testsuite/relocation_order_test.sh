@@ -0,0 +1,39 @@
+#!/bin/sh
+
+# relocation_order_test.sh -- test --relocation-order=output.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# Each pair of files was linked with and without
+# --relocation-order=output, and must be the same.
+
+status=0
+check()
+{
+    if ! cmp -s $1 $2; then
+	echo "$1 and $2 differ"
+	status=1
+    fi
+}
+
+check relocation_order_test relocation_order_test_ref
+check relocation_order_test_r.o relocation_order_test_r_ref.o
+
+exit $status
@@ -0,0 +1,60 @@
+#!/bin/sh
+
+# rename_output_test.sh -- test --rename-output-file.
+
+# Copyright 2013 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# rename_output_test.stdout has the output of "ls -il" on
+# rename_output_test after a normal link, after a failed link with
+# --rename-output-file, and after a successful link with
+# --rename-output-file.  The failed link must leave the old file alone.
+# The successful link must write a new file, which gets a new inode,
+# and give it the usual permissions.
+
+check()
+{
+    if ! eval "$2"; then
+	echo "$1"
+	echo "actual output:"
+	cat rename_output_test.stdout
+	exit 1
+    fi
+}
+
+if ! cmp -s rename_output_test.old rename_output_test.kept; then
+    echo "failed link with --rename-output-file changed the output file"
+    exit 1
+fi
+
+inode1=`sed -n -e '1s/^ *\([0-9]*\) .*/\1/p' rename_output_test.stdout`
+inode2=`sed -n -e '2s/^ *\([0-9]*\) .*/\1/p' rename_output_test.stdout`
+inode3=`sed -n -e '3s/^ *\([0-9]*\) .*/\1/p' rename_output_test.stdout`
+mode3=`sed -n -e '3s/^ *[0-9]* *\([^ ]*\) .*/\1/p' rename_output_test.stdout`
+
+check "missing output from ls" 'test -n "$inode1" -a -n "$inode2" -a -n "$inode3"'
+check "failed link replaced the output file" 'test "$inode1" = "$inode2"'
+check "successful link did not write a new output file" \
+    'test "$inode2" != "$inode3"'
+case "$mode3" in
+-rwxr-xr-x*) ;;
+*) check "output file has the wrong permissions" false ;;
+esac
+
+exit 0
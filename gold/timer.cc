@@ -28,6 +28,10 @@
 #include <sys/times.h>
 #endif
 
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
 #include "libiberty.h"
 
 #include "timer.h"
@@ -42,6 +46,8 @@ Timer::Timer()
   this->start_time_.wall = 0;
   this->start_time_.user = 0;
   this->start_time_.sys = 0;
+  this->start_time_.minor_faults = 0;
+  this->start_time_.major_faults = 0;
 }
 
 // Start counting the time.
@@ -102,6 +108,18 @@ Timer::get_time(TimeStats *now)
   now->user = 0;
   now->sys = 0;
 #endif
+
+#ifdef HAVE_GETRUSAGE
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru) == 0)
+    {
+      now->minor_faults = ru.ru_minflt;
+      now->major_faults = ru.ru_majflt;
+      return;
+    }
+#endif
+  now->minor_faults = 0;
+  now->major_faults = 0;
 }
 
 // Return the stats since start was called.
@@ -114,6 +132,8 @@ Timer::get_elapsed_time()
   delta.wall = now.wall - this->start_time_.wall;
   delta.user = now.user - this->start_time_.user;
   delta.sys = now.sys - this->start_time_.sys;
+  delta.minor_faults = now.minor_faults - this->start_time_.minor_faults;
+  delta.major_faults = now.major_faults - this->start_time_.major_faults;
   return delta;
 }
 
@@ -127,6 +147,8 @@ Timer::get_pass_time(int n)
   thispass.wall -= lastpass.wall;
   thispass.user -= lastpass.user;
   thispass.sys -= lastpass.sys;
+  thispass.minor_faults -= lastpass.minor_faults;
+  thispass.major_faults -= lastpass.major_faults;
   return thispass;
 }
 
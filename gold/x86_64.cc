@@ -432,6 +432,18 @@ class Target_x86_64 : public Sized_target<size, false>
 	      size_t local_symbol_count,
 	      const unsigned char* plocal_symbols);
 
+  // Prescan the relocations, in parallel with other objects.
+  size_t
+  prescan_relocs(Symbol_table* symtab,
+		 Sized_relobj_file<size, false>* object,
+		 unsigned int data_shndx,
+		 unsigned int sh_type,
+		 const unsigned char* prelocs,
+		 size_t reloc_count,
+		 size_t local_symbol_count,
+		 const unsigned char* plocal_symbols,
+		 std::vector<unsigned char>* deferred);
+
   // Finalize the sections.
   void
   do_finalize_sections(Layout*, const Input_objects*, Symbol_table*);
@@ -527,6 +539,12 @@ class Target_x86_64 : public Sized_target<size, false>
   do_can_check_for_function_pointers() const
   { return !parameters->options().pie(); }
 
+  // We can prescan relocations; see Scan::local_reloc_may_be_skipped
+  // and Scan::global_reloc_may_be_skipped.
+  bool
+  do_can_prescan_relocs() const
+  { return true; }
+
   // Return the base for a DW_EH_PE_datarel encoding.
   uint64_t
   do_ehframe_datarel_base() const;
@@ -707,6 +725,14 @@ class Target_x86_64 : public Sized_target<size, false>
 					 unsigned int r_type,
 					 Symbol* gsym);
 
+    inline bool
+    local_reloc_may_be_skipped(unsigned int r_type,
+			       const elfcpp::Sym<size, false>& lsym,
+			       bool is_discarded);
+
+    inline bool
+    global_reloc_may_be_skipped(unsigned int r_type, Symbol* gsym);
+
   private:
     static void
     unsupported_reloc_local(Sized_relobj_file<size, false>*,
@@ -2668,6 +2694,95 @@ Target_x86_64<size>::Scan::global_reloc_may_be_function_pointer(
 	  || possible_function_pointer_reloc(r_type));
 }
 
+// Return true if local() would do nothing for a relocation of type
+// R_TYPE against LSYM.  This is called while prescanning relocations,
+// for several objects at once, so it must not change anything.
+
+template<int size>
+inline bool
+Target_x86_64<size>::Scan::local_reloc_may_be_skipped(
+    unsigned int r_type,
+    const elfcpp::Sym<size, false>& lsym,
+    bool is_discarded)
+{
+  if (is_discarded)
+    return true;
+
+  // A local STT_GNU_IFUNC symbol may require a PLT entry.
+  if (lsym.get_st_type() == elfcpp::STT_GNU_IFUNC)
+    return false;
+
+  switch (r_type)
+    {
+    case elfcpp::R_X86_64_NONE:
+    case elfcpp::R_X86_64_GNU_VTINHERIT:
+    case elfcpp::R_X86_64_GNU_VTENTRY:
+    case elfcpp::R_X86_64_PC64:
+    case elfcpp::R_X86_64_PC32:
+    case elfcpp::R_X86_64_PC16:
+    case elfcpp::R_X86_64_PC8:
+    case elfcpp::R_X86_64_PLT32:
+      return true;
+
+    case elfcpp::R_X86_64_64:
+    case elfcpp::R_X86_64_32:
+    case elfcpp::R_X86_64_32S:
+    case elfcpp::R_X86_64_16:
+    case elfcpp::R_X86_64_8:
+      // These need a dynamic relocation in position-independent
+      // output.
+      return !parameters->options().output_is_position_independent();
+
+    default:
+      return false;
+    }
+}
+
+// Return true if global() would do nothing for a relocation of type
+// R_TYPE against GSYM.  This is called while prescanning relocations,
+// for several objects at once, so it must not change anything, and it
+// may only look at properties of GSYM which scanning does not change.
+
+template<int size>
+inline bool
+Target_x86_64<size>::Scan::global_reloc_may_be_skipped(unsigned int r_type,
+						       Symbol* gsym)
+{
+  // A STT_GNU_IFUNC symbol may require a PLT entry.
+  if (gsym->type() == elfcpp::STT_GNU_IFUNC)
+    return false;
+
+  switch (r_type)
+    {
+    case elfcpp::R_X86_64_NONE:
+    case elfcpp::R_X86_64_GNU_VTINHERIT:
+    case elfcpp::R_X86_64_GNU_VTENTRY:
+      return true;
+
+    case elfcpp::R_X86_64_64:
+    case elfcpp::R_X86_64_32:
+    case elfcpp::R_X86_64_32S:
+    case elfcpp::R_X86_64_16:
+    case elfcpp::R_X86_64_8:
+      if (parameters->options().output_is_position_independent())
+	return false;
+      // Fall through.
+    case elfcpp::R_X86_64_PC64:
+    case elfcpp::R_X86_64_PC32:
+    case elfcpp::R_X86_64_PC16:
+    case elfcpp::R_X86_64_PC8:
+    case elfcpp::R_X86_64_PLT32:
+      // A symbol defined in this link which can not be preempted
+      // needs neither a PLT entry nor a dynamic relocation.
+      return (gsym->is_defined()
+	      && !gsym->is_from_dynobj()
+	      && !gsym->is_preemptible());
+
+    default:
+      return false;
+    }
+}
+
 // Scan a relocation for a global symbol.
 
 template<int size>
@@ -3107,6 +3222,41 @@ Target_x86_64<size>::scan_relocs(Symbol_table* symtab,
     plocal_symbols);
 }
 
+// Prescan relocations for a section.
+
+template<int size>
+size_t
+Target_x86_64<size>::prescan_relocs(Symbol_table* symtab,
+				    Sized_relobj_file<size, false>* object,
+				    unsigned int,
+				    unsigned int sh_type,
+				    const unsigned char* prelocs,
+				    size_t reloc_count,
+				    size_t local_symbol_count,
+				    const unsigned char* plocal_symbols,
+				    std::vector<unsigned char>* deferred)
+{
+  // scan_relocs will report an error for a REL section, so leave
+  // all the relocs for it.
+  if (sh_type == elfcpp::SHT_REL)
+    {
+      const int reloc_size =
+	Reloc_types<elfcpp::SHT_REL, size, false>::reloc_size;
+      deferred->assign(prelocs, prelocs + reloc_count * reloc_size);
+      return reloc_count;
+    }
+
+  return gold::prescan_relocs<size, false, elfcpp::SHT_RELA,
+			      typename Target_x86_64<size>::Scan>(
+    symtab,
+    object,
+    prelocs,
+    reloc_count,
+    local_symbol_count,
+    plocal_symbols,
+    deferred);
+}
+
 // Finalize the sections.
 
 template<int size>
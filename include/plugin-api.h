@@ -190,6 +190,17 @@ typedef
 enum ld_plugin_status
 (*ld_plugin_register_claim_file) (ld_plugin_claim_file_handler handler);
 
+/* The linker's interface for registering a "claim file" handler which
+   may be called concurrently for different input files.  A plugin
+   which registers its handler this way must not rely on the linker to
+   serialize the calls; the linker may then read the input files in
+   parallel.  The handler may be called from any thread.  */
+
+typedef
+enum ld_plugin_status
+(*ld_plugin_register_claim_file_thread_safe) (
+  ld_plugin_claim_file_handler handler);
+
 /* The linker's interface for registering the "all symbols read" handler.  */
 
 typedef
@@ -384,7 +395,8 @@ enum ld_plugin_tag
   LDPT_ALLOW_SECTION_ORDERING = 24,
   LDPT_GET_SYMBOLS_V2 = 25,
   LDPT_ALLOW_UNIQUE_SEGMENT_FOR_SECTIONS = 26,
-  LDPT_UNIQUE_SEGMENT_FOR_SECTIONS = 27
+  LDPT_UNIQUE_SEGMENT_FOR_SECTIONS = 27,
+  LDPT_REGISTER_CLAIM_FILE_HOOK_THREAD_SAFE = 28
 };
 
 /* The plugin transfer vector.  */
@@ -416,6 +428,8 @@ struct ld_plugin_tv
     ld_plugin_allow_section_ordering tv_allow_section_ordering;
     ld_plugin_allow_unique_segment_for_sections tv_allow_unique_segment_for_sections; 
     ld_plugin_unique_segment_for_sections tv_unique_segment_for_sections;
+    ld_plugin_register_claim_file_thread_safe
+      tv_register_claim_file_thread_safe;
   } tv_u;
 };
 